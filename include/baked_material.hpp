@@ -0,0 +1,122 @@
+/**
+ * @file baked_material.hpp
+ * @brief This header file defines materials whose texture blend is baked
+ *        into a single texture.
+ *
+ * The scene mixes two textures with a constant factor, so every fragment
+ * fetches both. As long as the sources and the factor do not change, the
+ * mix is the same every frame: it is rendered once into a texture through
+ * a framebuffer, and the scene samples that texture with the single
+ * texture shader variant. The mix is linear, so the mipmaps generated
+ * from the baked level 0 equal the mix of the sources' mipmaps and only
+ * level 0 is rendered.
+ */
+
+#pragma once
+#include <renderer.hpp> // For the bake program.
+
+
+namespace Renderer
+{
+    /**
+     * @namespace MaterialConstants
+     * @brief Contains the defaults of baked materials.
+     */
+    namespace MaterialConstants
+    {
+        // The weight of the second texture, the MIX_FACTOR default of
+        // shader.fs.
+        constexpr float DEFAULT_MIX_FACTOR = 0.78f;
+        // The format of the baked texture, color renderable.
+        constexpr GLint BAKED_FORMAT = GL_RGBA8;
+    };
+
+    /**
+     * @struct MaterialSource
+     * @brief A source texture of a material and its size.
+     *
+     * The handle tells apart textures that get the same recycled name, it
+     * is invalid for textures outside a GpuResources.
+     */
+    struct MaterialSource
+    {
+        GLuint texture = 0;
+        GLsizei width = 0;
+        GLsizei height = 0;
+        TextureHandle handle;
+    };
+
+    /**
+     * @class BakedMaterial
+     * @brief Keeps the mix of two textures baked into one, re-baking it
+     *        when a source or the factor changes.
+     *
+     * Changes only mark the material dirty, the next bake() renders it.
+     */
+    class BakedMaterial
+    {
+    public:
+        /**
+         * @brief Creates the bake program, framebuffer and texture.
+         * @param device The device the material is baked on.
+         * @param mixFactor The weight of the second source.
+         * @throws std::runtime_error If the bake shaders fail to compile or
+         *         link.
+         */
+        explicit BakedMaterial(Device& device,
+            float mixFactor = MaterialConstants::DEFAULT_MIX_FACTOR);
+
+        /** @brief Deletes the framebuffer, texture and vertex array. */
+        ~BakedMaterial();
+
+        // Delete copy constructor and copy assignment operator
+        BakedMaterial(const BakedMaterial&) = delete;
+        BakedMaterial& operator=(const BakedMaterial&) = delete;
+
+        /** @brief Sets the weight of the second source. */
+        void setMixFactor(float mixFactor);
+
+        /**
+         * @brief Sets the source textures, the baked texture has the larger
+         *        size of the two in each dimension.
+         */
+        void setSources(const MaterialSource& first,
+            const MaterialSource& second);
+
+        /**
+         * @brief Re-bakes the texture if anything changed since the last
+         *        bake.
+         *
+         * A bake leaves the window's framebuffer bound with the viewport of
+         * the baked texture, and the texture bound to the active unit.
+         *
+         * @return True if the texture was baked.
+         * @throws std::runtime_error If the bake framebuffer is incomplete.
+         */
+        bool bake();
+
+        /*** @brief Gets the baked texture, valid after the first bake(). */
+        GLuint getTexture() const { return texture_; }
+
+        /*** @brief Gets the number of bakes so far. */
+        std::uint64_t getBakeCount() const { return bakes_; }
+
+    private:
+        /** @brief Allocates the baked texture at the size of the sources. */
+        void allocate(GLsizei width, GLsizei height);
+
+        Device& device_;
+        std::unique_ptr<ShaderProgram> program_;
+        GLuint framebuffer_;
+        GLuint texture_;
+        // The bake draw has no attributes, but a vertex array must be bound
+        GLuint vertexArray_;
+        GLsizei width_;
+        GLsizei height_;
+        MaterialSource first_;
+        MaterialSource second_;
+        float mixFactor_;
+        bool dirty_;
+        std::uint64_t bakes_;
+    };
+}
@@ -0,0 +1,201 @@
+/**
+ * @file capture.hpp
+ * @brief This header file defines the capture of rendered frames to image
+ *        sequences and video files.
+ *
+ * Frames are read back asynchronously: the read of frame N is queued into a
+ * pixel buffer object together with a fence and only mapped at frame N + 2,
+ * when the GPU has long finished it, so the frame loop never waits on the
+ * transfer. The mapped pixels are handed to writer threads that flip and
+ * encode them, either as a numbered PNG sequence or as a raw Y4M stream.
+ *
+ * @note When the writers fall behind and every staging buffer is in use,
+ *       frames are dropped instead of stalling the renderer and reported in
+ *       the CaptureStats.
+ */
+
+#pragma once
+#include <window.hpp>           // For the OpenGL types and functions.
+#include <array>                // For the ring of pixel buffers.
+#include <atomic>               // For the statistics shared with writers.
+#include <condition_variable>   // For waking up the writer threads.
+#include <cstdint>              // For the pixel bytes.
+#include <deque>                // For the queue of frames to encode.
+#include <fstream>              // For the Y4M output stream.
+#include <mutex>                // For guarding the queue and buffer pool.
+#include <string>               // For the output path.
+#include <thread>               // For the writer threads.
+#include <vector>               // For the pixel staging buffers.
+
+
+namespace Renderer
+{
+    /**
+     * @namespace CaptureConstants
+     * @brief Contains the configuration of the frame capture pipeline.
+     */
+    namespace CaptureConstants
+    {
+        // The number of frames between queuing a read and mapping it.
+        constexpr std::size_t READBACK_LATENCY = 2;
+        // The number of pixel buffer objects, one per frame in flight.
+        constexpr std::size_t RING_SIZE = READBACK_LATENCY + 1;
+        // The number of staging buffers frames wait in for the writers.
+        constexpr std::size_t STAGING_BUFFERS = 8;
+        // The bytes per captured RGBA8 pixel.
+        constexpr std::size_t BYTES_PER_PIXEL = 4;
+    };
+
+    /**
+     * @enum CaptureFormat
+     * @brief The file format captured frames are written in.
+     */
+    enum class CaptureFormat : std::uint8_t
+    {
+        PNG_SEQUENCE = 0, ///< One numbered PNG file per frame
+        Y4M,              ///< A single uncompressed YUV 4:2:0 video stream
+    };
+
+    /**
+     * @struct CaptureStats
+     * @brief Counts what happened to the frames of a capture.
+     */
+    struct CaptureStats
+    {
+        // Frames whose read back was queued.
+        std::uint64_t captured = 0;
+        // Frames discarded because no staging buffer was free.
+        std::uint64_t dropped = 0;
+        // Frames whose fence was not yet signaled when they were mapped.
+        std::uint64_t stalls = 0;
+        // Frames encoded and written to disk.
+        std::uint64_t written = 0;
+        // Frames that could not be written.
+        std::uint64_t failed = 0;
+    };
+
+    /**
+     * @class FrameCapture
+     * @brief Reads back the default framebuffer through a ring of pixel
+     *        buffer objects and writes the frames on background threads.
+     */
+    class FrameCapture
+    {
+    public:
+        /**
+         * @brief Creates the pixel buffers and starts the writer threads.
+         *
+         * The format follows the extension of the path: `.y4m` writes a
+         * video stream, anything else a PNG sequence named after the path
+         * with the frame number appended, e.g. `cube_000042.png`.
+         *
+         * @param path The output file, or the pattern of the image files.
+         * @param width The width of the captured region in pixels.
+         * @param height The height of the captured region in pixels.
+         * @param framesPerSecond The frame rate stored in a Y4M header.
+         * @throws std::runtime_error If the output file cannot be created.
+         */
+        FrameCapture(const std::string& path, unsigned int width,
+            unsigned int height, unsigned int framesPerSecond);
+
+        /**
+         * @brief Finishes the capture, see finish().
+         */
+        ~FrameCapture();
+
+        // Delete copy constructor and copy assignment operator
+        FrameCapture(const FrameCapture&) = delete;
+        FrameCapture& operator=(const FrameCapture&) = delete;
+
+        /**
+         * @brief Queues the read back of the current frame and hands the
+         *        frame queued READBACK_LATENCY frames ago to the writers.
+         *
+         * Call it after the frame is rendered and before it is displayed.
+         */
+        void capture();
+
+        /**
+         * @brief Maps the frames still in flight, waits until every frame
+         *        is written and stops the writer threads.
+         * @return The statistics of the whole capture.
+         */
+        CaptureStats finish();
+
+        /*** @brief Gets the format frames are written in. */
+        CaptureFormat getFormat() const { return format_; }
+        /*** @brief Gets the width of the captured region in pixels. */
+        unsigned int getWidth() const { return width_; }
+        /*** @brief Gets the height of the captured region in pixels. */
+        unsigned int getHeight() const { return height_; }
+
+    private:
+        /**
+         * @struct Slot
+         * @brief A pixel buffer object and the fence of its pending read.
+         */
+        struct Slot
+        {
+            GLuint buffer = 0;
+            GLsync fence = nullptr;
+            std::uint64_t frame = 0;
+        };
+
+        /**
+         * @struct PendingFrame
+         * @brief A read back frame waiting to be encoded.
+         */
+        struct PendingFrame
+        {
+            std::uint64_t frame;
+            std::vector<std::uint8_t> pixels;
+        };
+
+        /** @brief Maps a slot and moves its pixels to the writer queue. */
+        void consume(Slot& slot);
+
+        /** @brief Encodes queued frames until the capture is finished. */
+        void writerLoop();
+
+        /** @brief Writes a frame as a PNG file, returns false on failure. */
+        bool writePng(const PendingFrame& pending) const;
+
+        /** @brief Appends a frame to the Y4M stream, returns false on failure. */
+        bool writeY4m(const PendingFrame& pending);
+
+        CaptureFormat format_;
+        std::string path_;
+        unsigned int width_;
+        unsigned int height_;
+        std::size_t frameSize_;
+        std::array<Slot, CaptureConstants::RING_SIZE> slots_;
+        std::uint64_t frameIndex_;
+        bool finished_;
+
+        // Writer side, guarded by mutex_
+        std::mutex mutex_;
+        std::condition_variable queueReady_;
+        std::deque<PendingFrame> queue_;
+        std::vector<std::vector<std::uint8_t>> freeBuffers_;
+        bool stopping_;
+        std::vector<std::thread> writers_;
+        std::ofstream video_;
+        // Scratch planes of the Y4M conversion, used by the only writer
+        std::vector<std::uint8_t> yuv_;
+
+        CaptureStats stats_;
+        std::atomic<std::uint64_t> written_;
+        std::atomic<std::uint64_t> failed_;
+    };
+
+    /**
+     * @brief Names the output of a capture restarted at a new size, as a
+     *        Y4M stream cannot change its size.
+     * @param path The output given for the first capture.
+     * @param segment The number of the restart, from 1.
+     * @return The path with the number appended before the extension, e.g.
+     *         `cube_1.y4m` for `cube.y4m`.
+     */
+    std::string numberCapturePath(const std::string& path,
+        unsigned int segment);
+}
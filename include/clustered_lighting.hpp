@@ -0,0 +1,185 @@
+/**
+ * @file clustered_lighting.hpp
+ * @brief This header file defines clustered forward lighting, which shades
+ *        every fragment with only the point lights that reach it.
+ *
+ * The view frustum is split into a grid of clusters: tiles of the screen
+ * times slices of the view depth that grow exponentially thicker. Every
+ * frame one compute shader moves the lights along their paths and into
+ * view space, and a second one tests the lights against the bounding box
+ * of every cluster and appends the indices of those that reach it to one
+ * compact list. The CLUSTERED_LIGHTING variant of the scene shaders then
+ * finds the cluster of its fragment and loops over that cluster's lights
+ * only, so the cost per fragment follows the lights near it instead of
+ * the lights in the scene.
+ *
+ * @note Needs compute shaders and storage buffers from OpenGL 4.3.
+ */
+
+#pragma once
+#include <query_ring.hpp>     // For timing the stages.
+#include <shader_library.hpp> // For the shading variant.
+#include <vector>             // For the lights.
+
+
+namespace Renderer
+{
+    /**
+     * @namespace ClusterConstants
+     * @brief Contains the cluster grid and the layout shared with the
+     *        lighting shaders.
+     */
+    namespace ClusterConstants
+    {
+        // The tiles across and down the screen and the depth slices.
+        constexpr GLuint CLUSTERS_X = 16;
+        constexpr GLuint CLUSTERS_Y = 9;
+        constexpr GLuint CLUSTERS_Z = 24;
+        constexpr GLuint CLUSTER_COUNT = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+        // The light indices the list holds per cluster on average, the
+        // clusters past a full list get no lights.
+        constexpr GLuint AVERAGE_LIGHTS_PER_CLUSTER = 64;
+        // The most lights a scene may have.
+        constexpr GLuint MAX_LIGHTS = 16384;
+        // The work group size of move_lights.comp and assign_lights.comp.
+        constexpr GLuint MOVE_GROUP_SIZE = 64;
+        constexpr GLuint ASSIGN_GROUP_SIZE = 64;
+        // The storage buffer bindings of the lighting shaders.
+        constexpr GLuint LIGHTS_BINDING = 0;
+        constexpr GLuint VIEW_LIGHTS_BINDING = 1;
+        constexpr GLuint CLUSTERS_BINDING = 2;
+        constexpr GLuint INDICES_BINDING = 3;
+        // The number of timer queries in flight per stage.
+        constexpr std::size_t TIMER_QUERIES = 4;
+    };
+
+    /**
+     * @struct PointLight
+     * @brief A light moving around a point, laid out like the std430 Light
+     *        struct of move_lights.comp.
+     */
+    struct PointLight
+    {
+        /** @brief The center of the light's path in world space, w is the
+         *         radius the light reaches. */
+        glm::vec4 position;
+        /** @brief The color, w is the phase along the path. */
+        glm::vec4 color;
+    };
+
+    /**
+     * @struct StageTiming
+     * @brief The GPU time of a lighting stage, measured a few frames late.
+     */
+    struct StageTiming
+    {
+        /** @brief The number of frames measured. */
+        std::uint64_t frames = 0;
+        /** @brief The milliseconds over all measured frames. */
+        double totalMs = 0.0;
+        /** @brief The milliseconds of the last measured frame. */
+        double lastMs = 0.0;
+    };
+
+    /**
+     * @struct LightingTimings
+     * @brief The GPU time of every stage of clustered lighting.
+     */
+    struct LightingTimings
+    {
+        /** @brief Moving the lights into view space. */
+        StageTiming move;
+        /** @brief Assigning the lights to the clusters. */
+        StageTiming assign;
+        /** @brief Drawing the scene with the lights of each cluster. */
+        StageTiming shade;
+    };
+
+    /**
+     * @class ClusteredLighting
+     * @brief Sorts moving point lights into the clusters of the view and
+     *        binds them for shading.
+     *
+     * Every frame call move(), assign() and then draw between
+     * beginShading() and endShading(). Each stage writes what the next one
+     * reads from storage buffers, the barriers between them are placed by
+     * the render graph.
+     */
+    class ClusteredLighting
+    {
+    public:
+        /**
+         * @brief Creates the programs and uploads the lights.
+         * @param device The device the stages run on.
+         * @param lights The lights, at most ClusterConstants::MAX_LIGHTS.
+         * @param nearPlane The distance of the near plane of the view.
+         * @param farPlane The distance of the far plane of the view.
+         * @param timeShading Whether the shading is timed, which a timer
+         *        query around the whole scene pass rules out.
+         * @throws std::invalid_argument If there are no lights or too many.
+         * @throws std::runtime_error If a shader fails to compile or link.
+         */
+        ClusteredLighting(Device& device,
+            const std::vector<PointLight>& lights, float nearPlane,
+            float farPlane, bool timeShading);
+
+        /** @brief Deletes the buffers. */
+        ~ClusteredLighting();
+
+        // Delete copy constructor and copy assignment operator
+        ClusteredLighting(const ClusteredLighting&) = delete;
+        ClusteredLighting& operator=(const ClusteredLighting&) = delete;
+
+        /**
+         * @brief Moves the lights along their paths into view space and
+         *        empties the index list.
+         * @param seconds The time elapsed since the scene started.
+         * @param view The view matrix of the frame.
+         */
+        void move(float seconds, const glm::mat4& view);
+
+        /**
+         * @brief Writes the lights of every cluster.
+         * @param projection The symmetric perspective projection of the
+         *        frame, with the near and far plane given at construction.
+         */
+        void assign(const glm::mat4& projection);
+
+        /**
+         * @brief Binds the lights and clusters for a program of the
+         *        CLUSTERED_LIGHTING permutation and starts timing the
+         *        shading.
+         * @param program The program, in use.
+         */
+        void beginShading(const ShaderProgram& program);
+
+        /** @brief Stops timing the shading. */
+        void endShading();
+
+        /*** @brief Gets the number of lights. */
+        GLsizei getLightCount() const { return lightCount_; }
+
+        /*** @brief Gets the stage timings. */
+        const LightingTimings& getTimings() const { return timings_; }
+
+    private:
+        /** @brief Adds the stage timings the GPU has finished. */
+        void collectTimings();
+
+        Device& device_;
+        GLsizei lightCount_;
+        float nearPlane_;
+        float farPlane_;
+        std::unique_ptr<ShaderProgram> moveProgram_;
+        std::unique_ptr<ShaderProgram> assignProgram_;
+        GLuint lightBuffer_;
+        GLuint viewLightBuffer_;
+        GLuint clusterBuffer_;
+        GLuint indexBuffer_;
+        QueryRing moveTimer_;
+        QueryRing assignTimer_;
+        // Null when the shading is not timed
+        std::unique_ptr<QueryRing> shadeTimer_;
+        LightingTimings timings_;
+    };
+}
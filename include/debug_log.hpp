@@ -0,0 +1,290 @@
+/**
+ * @file debug_log.hpp
+ * @brief This header file defines the asynchronous logging of OpenGL debug
+ *        messages.
+ *
+ * The driver calls the debug callback on its own threads, often in the
+ * middle of a draw call. The callback therefore only filters the message
+ * and copies it into a lock-free ring; a logger thread drains the ring,
+ * folds repeats of the same message into counts and rate limits the lines
+ * written to stderr, so a chatty driver cannot stall the frame loop.
+ */
+
+#pragma once
+#include <window.hpp>         // For the OpenGL types and enums.
+#include <array>              // For the message text and the ring slots.
+#include <atomic>             // For the ring positions and the filters.
+#include <chrono>             // For the rate limit.
+#include <condition_variable> // For waking up the logger to stop.
+#include <cstdint>            // For the counters and message keys.
+#include <memory>             // For owning the ring slots.
+#include <mutex>              // For the stop condition.
+#include <thread>             // For the logger thread.
+#include <unordered_map>      // For counting repeats per message.
+
+
+namespace Renderer
+{
+    /**
+     * @namespace DebugLogConstants
+     * @brief Contains the sizing and pacing of the debug message log.
+     */
+    namespace DebugLogConstants
+    {
+        // The number of messages the ring holds, a power of two.
+        constexpr std::size_t RING_SIZE = 256;
+        // The characters kept of a message, longer ones are cut.
+        constexpr std::size_t MAX_MESSAGE_LENGTH = 255;
+        // The milliseconds the logger waits between drains.
+        constexpr unsigned int DRAIN_INTERVAL_MS = 20;
+        // The lines written per second before further lines are dropped.
+        constexpr unsigned int DEFAULT_LINES_PER_SECOND = 20;
+        // The number of debug message sources, GL_DEBUG_SOURCE_API to
+        // GL_DEBUG_SOURCE_OTHER.
+        constexpr unsigned int SOURCE_COUNT = 6;
+        // Every source enabled.
+        constexpr std::uint32_t ALL_SOURCES = (1u << SOURCE_COUNT) - 1;
+    };
+
+    /**
+     * @enum DebugSeverity
+     * @brief The severities of debug messages from least to most severe,
+     *        used as the threshold of the log.
+     */
+    enum class DebugSeverity : std::uint8_t
+    {
+        NOTIFICATION = 0, ///< GL_DEBUG_SEVERITY_NOTIFICATION
+        LOW,              ///< GL_DEBUG_SEVERITY_LOW
+        MEDIUM,           ///< GL_DEBUG_SEVERITY_MEDIUM
+        HIGH,             ///< GL_DEBUG_SEVERITY_HIGH
+        OFF,              ///< No message passes, debug output is disabled
+    };
+
+    /**
+     * @brief Maps an OpenGL debug severity to a DebugSeverity.
+     * @param severity A GL_DEBUG_SEVERITY_ enum.
+     * @return The matching severity, HIGH for unknown values.
+     */
+    DebugSeverity toDebugSeverity(GLenum severity);
+
+    /**
+     * @brief Gets the bit of a debug message source in a source mask.
+     * @param source A GL_DEBUG_SOURCE_ enum.
+     * @return The bit of the source, 0 for unknown sources.
+     */
+    std::uint32_t debugSourceBit(GLenum source);
+
+    /**
+     * @struct DebugLogSettings
+     * @brief Configures which debug messages are logged.
+     */
+    struct DebugLogSettings
+    {
+        /** @brief The least severe message logged (`--gl-debug`), OFF
+         *         disables GL_DEBUG_OUTPUT entirely. Debug builds skip
+         *         notifications, release builds log nothing unless asked
+         *         to. */
+#ifdef NDEBUG
+        DebugSeverity minimumSeverity = DebugSeverity::OFF;
+#else
+        DebugSeverity minimumSeverity = DebugSeverity::LOW;
+#endif
+        /** @brief The sources logged, one debugSourceBit() each
+         *         (`--gl-debug-sources`). */
+        std::uint32_t sources = DebugLogConstants::ALL_SOURCES;
+        /** @brief The lines written per second, the rest are counted
+         *         (`--gl-debug-rate`). */
+        unsigned int linesPerSecond =
+            DebugLogConstants::DEFAULT_LINES_PER_SECOND;
+    };
+
+    /**
+     * @struct DebugLogStats
+     * @brief Counts what happened to the debug messages.
+     */
+    struct DebugLogStats
+    {
+        // Messages the driver reported.
+        std::uint64_t received = 0;
+        // Messages below the severity or from a disabled source.
+        std::uint64_t filtered = 0;
+        // Messages lost because the ring was full.
+        std::uint64_t dropped = 0;
+        // Messages that repeated an earlier one.
+        std::uint64_t repeated = 0;
+        // Lines not written because of the rate limit.
+        std::uint64_t limited = 0;
+        // Lines written to stderr.
+        std::uint64_t written = 0;
+    };
+
+    /**
+     * @struct DebugMessage
+     * @brief A debug message copied out of the driver callback.
+     */
+    struct DebugMessage
+    {
+        GLenum source;
+        GLenum type;
+        GLuint id;
+        GLenum severity;
+        std::array<char, DebugLogConstants::MAX_MESSAGE_LENGTH + 1> text;
+    };
+
+    /**
+     * @class DebugMessageRing
+     * @brief A bounded lock-free queue of debug messages with any number
+     *        of producers and one consumer.
+     *
+     * Each slot carries a sequence number that tells producers whether it
+     * is free and the consumer whether it is written, so neither side ever
+     * waits for the other. A full ring rejects the message.
+     */
+    class DebugMessageRing
+    {
+    public:
+        DebugMessageRing();
+
+        // Delete copy constructor and copy assignment operator
+        DebugMessageRing(const DebugMessageRing&) = delete;
+        DebugMessageRing& operator=(const DebugMessageRing&) = delete;
+
+        /**
+         * @brief Adds a message, callable from any thread.
+         * @return False if the ring is full and the message was not added.
+         */
+        bool push(const DebugMessage& message);
+
+        /**
+         * @brief Takes the oldest message, only called by the consumer.
+         * @return False if the ring is empty.
+         */
+        bool pop(DebugMessage& message);
+
+    private:
+        /**
+         * @struct Slot
+         * @brief A message and the sequence number guarding it.
+         */
+        struct Slot
+        {
+            std::atomic<std::size_t> sequence;
+            DebugMessage message;
+        };
+
+        std::unique_ptr<Slot[]> slots_;
+        // The next position written by a producer
+        std::atomic<std::size_t> tail_;
+        // The next position read by the consumer
+        std::size_t head_;
+    };
+
+    /**
+     * @class DebugLog
+     * @brief Receives the OpenGL debug messages and writes them to stderr
+     *        from a logger thread.
+     *
+     * The first occurrence of a message, identified by its source, type
+     * and ID, is written in full. Repeats are only counted and reported as
+     * one line per message and second. Lines beyond the rate limit of a
+     * second are counted and reported once the limit allows again; only
+     * the first occurrence of an error is never limited. The sources and
+     * the rate limit are fixed at startup, the severity can be changed at
+     * any time from any thread.
+     */
+    class DebugLog
+    {
+    public:
+        /**
+         * @brief Starts the logger thread.
+         * @param settings The initial filters and rate limit.
+         */
+        explicit DebugLog(const DebugLogSettings& settings);
+
+        /**
+         * @brief Writes the remaining messages and a summary, then stops
+         *        the logger thread.
+         * @note The callback must be removed from the driver first.
+         */
+        ~DebugLog();
+
+        // Delete copy constructor and copy assignment operator
+        DebugLog(const DebugLog&) = delete;
+        DebugLog& operator=(const DebugLog&) = delete;
+
+        /**
+         * @brief The callback installed with glDebugMessageCallback, the
+         *        user parameter is the DebugLog.
+         */
+        static void GLAPIENTRY callback(GLenum source, GLenum type, GLuint id,
+            GLenum severity, GLsizei length, const GLchar* message,
+            const void* userParam);
+
+        /*** @brief Gets the least severe message logged. */
+        DebugSeverity getMinimumSeverity() const;
+
+        /**
+         * @brief Sets the least severe message logged.
+         * @note OFF only filters every message, the driver keeps reporting
+         *       them to the callback.
+         */
+        void setMinimumSeverity(DebugSeverity severity);
+
+        /**
+         * @brief Gets the message counts, the ones counted by the logger
+         *        thread as of its last drain.
+         */
+        DebugLogStats getStats() const;
+
+    private:
+        /** @brief Filters a message and queues it for the logger. */
+        void receive(GLenum source, GLenum type, GLuint id, GLenum severity,
+            GLsizei length, const GLchar* message);
+
+        /** @brief Drains the ring until stopped. */
+        void run();
+
+        /** @brief Writes or counts the messages in the ring. */
+        void drain();
+
+        /** @brief Reports the repeats and limited lines of the last second
+         *         and starts a new second. */
+        void report();
+
+        /**
+         * @brief Takes a line from the budget of the current second.
+         * @return False if the rate limit is reached.
+         */
+        bool takeLine();
+
+        DebugMessageRing ring_;
+
+        // Written by any thread, read by the callback
+        std::atomic<DebugSeverity> minimumSeverity_;
+        // The sources logged, read by the callback
+        const std::uint32_t sources_;
+        // The lines written per second, read by the logger
+        const unsigned int linesPerSecond_;
+
+        // Counted by the callback
+        std::atomic<std::uint64_t> received_;
+        std::atomic<std::uint64_t> filtered_;
+        std::atomic<std::uint64_t> dropped_;
+        // Counted by the logger thread, published after each drain
+        std::atomic<std::uint64_t> repeated_;
+        std::atomic<std::uint64_t> limited_;
+        std::atomic<std::uint64_t> written_;
+
+        // Owned by the logger thread: the repeats since the last report of
+        // every message written, keyed by source, type and ID
+        std::unordered_map<std::uint64_t, std::uint64_t> repeats_;
+        std::chrono::steady_clock::time_point secondStart_;
+        unsigned int linesThisSecond_;
+        std::uint64_t limitedThisSecond_;
+
+        std::mutex mutex_;
+        std::condition_variable wakeUp_;
+        bool stopping_;
+        std::thread logger_;
+    };
+}
@@ -0,0 +1,689 @@
+/**
+ * @file device.hpp
+ * @brief This header file defines the Device interface that every OpenGL
+ *        call of the renderer goes through, and its implementations.
+ *
+ * GlDevice forwards the calls to the driver. NullDevice never touches a
+ * driver: it tracks the objects and bindings the calls would create,
+ * validates each call against them and counts the calls, so the CPU cost of
+ * building a frame can be measured in isolation and without a GPU.
+ */
+
+#pragma once
+#include <window.hpp>       // For the OpenGL types.
+#include <debug_log.hpp>    // For the debug messages of GlDevice.
+#include <array>            // For the per-category call counters.
+#include <cstdint>          // For fixed-width counters.
+#include <memory>           // For owning the debug log.
+#include <string>           // For shader sources and info logs.
+#include <unordered_map>    // For the objects tracked by NullDevice.
+#include <unordered_set>    // For the objects tracked by NullDevice.
+#include <vector>           // For the shaders attached to a program.
+
+// The query targets of ARB_pipeline_statistics_query, core in OpenGL 4.6
+// under the same values, for loaders generated for an older version
+#ifndef GL_VERTICES_SUBMITTED
+#define GL_VERTICES_SUBMITTED 0x82EE
+#define GL_PRIMITIVES_SUBMITTED 0x82EF
+#define GL_VERTEX_SHADER_INVOCATIONS 0x82F0
+#define GL_FRAGMENT_SHADER_INVOCATIONS 0x82F4
+#define GL_CLIPPING_INPUT_PRIMITIVES 0x82F6
+#define GL_CLIPPING_OUTPUT_PRIMITIVES 0x82F7
+#endif
+
+namespace Renderer
+{
+    /**
+     * @enum DeviceCall
+     * @brief Categories of device calls, used for statistics.
+     */
+    enum class DeviceCall : std::uint8_t
+    {
+        BUFFER = 0, ///< Vertex arrays, buffers and vertex attributes
+        TEXTURE,    ///< Texture creation, binding and uploads
+        SHADER,     ///< Shader creation and compilation
+        PROGRAM,    ///< Program linking and binding
+        UNIFORM,    ///< Uniform lookups and updates
+        STATE,      ///< Fixed-function state and clears
+        DRAW,       ///< Draw calls
+        COMPUTE,    ///< Compute dispatches and memory barriers
+        FRAMEBUFFER,///< Framebuffers, renderbuffers and blits
+        QUERY,      ///< Timer, primitive and pipeline statistics queries,
+                    ///< and fences
+        COUNT       ///< The number of categories
+    };
+
+    /**
+     * @brief Gets a printable name for a call category.
+     * @param call The call category.
+     * @return The lower-case name of the category.
+     */
+    const char* toString(DeviceCall call);
+
+    /**
+     * @brief Gets the size of one pixel of uncompressed client image data.
+     * @param format The pixel format, e.g. GL_RGB.
+     * @param type The component type, e.g. GL_UNSIGNED_BYTE.
+     * @return The number of bytes per pixel.
+     */
+    std::size_t pixelSize(GLenum format, GLenum type);
+
+    /**
+     * @brief Estimates the GPU memory one texel or renderbuffer sample of an
+     *        internal format occupies.
+     *
+     * Drivers pad three component formats to four bytes, so GL_RGB counts
+     * like GL_RGBA8.
+     *
+     * @param internalFormat The internal format, e.g. GL_RGBA8.
+     * @return The estimated number of bytes per texel.
+     */
+    std::size_t texelSize(GLint internalFormat);
+
+    /**
+     * @struct DeviceStats
+     * @brief Counters of the calls issued to a device.
+     */
+    struct DeviceStats
+    {
+        /** @brief The number of calls per DeviceCall category. */
+        std::array<std::uint64_t, static_cast<std::size_t>(DeviceCall::COUNT)>
+            calls{};
+        /** @brief The number of vertices submitted by draw calls. */
+        std::uint64_t vertices = 0;
+        /** @brief The number of bytes uploaded to buffers and textures. */
+        std::uint64_t uploadedBytes = 0;
+
+        /**
+         * @brief Gets the number of calls over all categories.
+         * @return The total number of calls.
+         */
+        std::uint64_t totalCalls() const;
+    };
+
+    /**
+     * @class Device
+     * @brief Interface over the OpenGL calls the renderer makes.
+     *
+     * The functions mirror their OpenGL counterparts. Object names are
+     * plain GLuint values so that they can be stored like the names returned
+     * by the driver.
+     */
+    class Device
+    {
+    public:
+        Device() = default;
+        virtual ~Device() = default;
+
+        // Delete copy constructor and copy assignment operator
+        Device(const Device&) = delete;
+        Device& operator=(const Device&) = delete;
+
+        /**
+         * @brief Gets the debug log to change its severity at runtime.
+         * @return The log, nullptr if the device has none.
+         */
+        virtual DebugLog* getDebugLog() const { return nullptr; }
+
+        // Vertex arrays and buffers
+        virtual GLuint createVertexArray() = 0;
+        virtual void bindVertexArray(GLuint vertexArray) = 0;
+        virtual void deleteVertexArray(GLuint vertexArray) = 0;
+        virtual GLuint createBuffer() = 0;
+        virtual void bindBuffer(GLenum target, GLuint buffer) = 0;
+        virtual void deleteBuffer(GLuint buffer) = 0;
+        virtual void bufferData(GLenum target, GLsizeiptr size,
+            const void* data, GLenum usage) = 0;
+        virtual void vertexAttribPointer(GLuint index, GLint size,
+            GLenum type, GLsizei stride, std::size_t offset) = 0;
+        virtual void enableVertexAttribArray(GLuint index) = 0;
+        virtual void vertexAttribDivisor(GLuint index, GLuint divisor) = 0;
+        virtual void bindBufferBase(GLenum target, GLuint index,
+            GLuint buffer) = 0;
+
+        // Textures
+        virtual GLuint createTexture() = 0;
+        virtual void activeTexture(GLenum unit) = 0;
+        virtual void bindTexture(GLenum target, GLuint texture) = 0;
+        virtual void deleteTexture(GLuint texture) = 0;
+        virtual void texParameter(GLenum target, GLenum name,
+            GLint value) = 0;
+        virtual void texImage2D(GLenum target, GLint level,
+            GLint internalFormat, GLsizei width, GLsizei height,
+            GLenum format, GLenum type, const void* pixels) = 0;
+        virtual void generateMipmap(GLenum target) = 0;
+        virtual void bindImageTexture(GLuint unit, GLuint texture,
+            GLint level, GLenum access, GLenum format) = 0;
+
+        // Shaders and programs
+        virtual GLuint createShader(GLenum type) = 0;
+        virtual void shaderSource(GLuint shader,
+            const std::string& source) = 0;
+        virtual void compileShader(GLuint shader) = 0;
+        /**
+         * @brief Queries whether a shader compiled successfully.
+         * @param shader The shader to query.
+         * @param infoLog Receives the compiler log on failure.
+         * @return True if the shader compiled.
+         */
+        virtual bool getCompileStatus(GLuint shader,
+            std::string& infoLog) = 0;
+        virtual void deleteShader(GLuint shader) = 0;
+        virtual GLuint createProgram() = 0;
+        virtual void attachShader(GLuint program, GLuint shader) = 0;
+        virtual void linkProgram(GLuint program) = 0;
+        /**
+         * @brief Queries whether a program linked successfully.
+         * @param program The program to query.
+         * @param infoLog Receives the linker log on failure.
+         * @return True if the program linked.
+         */
+        virtual bool getLinkStatus(GLuint program, std::string& infoLog) = 0;
+        virtual void useProgram(GLuint program) = 0;
+        virtual void deleteProgram(GLuint program) = 0;
+
+        // Uniforms of the program in use
+        virtual GLint getUniformLocation(GLuint program,
+            const char* name) = 0;
+        virtual void uniform1i(GLint location, GLint value) = 0;
+        virtual void uniform1f(GLint location, GLfloat value) = 0;
+        virtual void uniformMatrix4fv(GLint location,
+            const GLfloat* value) = 0;
+
+        // Fixed-function state and draws
+        virtual void viewport(GLint x, GLint y, GLsizei width,
+            GLsizei height) = 0;
+        virtual void enable(GLenum capability) = 0;
+        virtual void disable(GLenum capability) = 0;
+        virtual void blendFunc(GLenum sourceFactor, GLenum destFactor) = 0;
+        virtual void clearColor(GLfloat red, GLfloat green, GLfloat blue,
+            GLfloat alpha) = 0;
+        virtual void clear(GLbitfield mask) = 0;
+        virtual void drawArrays(GLenum mode, GLint first, GLsizei count) = 0;
+        virtual void drawElements(GLenum mode, GLsizei count, GLenum type,
+            std::size_t offset) = 0;
+        /**
+         * @brief Issues draws whose parameters are read from the bound
+         *        GL_DRAW_INDIRECT_BUFFER.
+         * @param mode The primitive type.
+         * @param offset The byte offset of the first command in the buffer.
+         * @param drawCount The number of commands.
+         * @param stride The distance between commands, 0 if packed.
+         */
+        virtual void multiDrawArraysIndirect(GLenum mode, std::size_t offset,
+            GLsizei drawCount, GLsizei stride) = 0;
+
+        // Compute
+        virtual void dispatchCompute(GLuint groupsX, GLuint groupsY,
+            GLuint groupsZ) = 0;
+        virtual void memoryBarrier(GLbitfield barriers) = 0;
+
+        // Framebuffers and renderbuffers
+        virtual GLuint createFramebuffer() = 0;
+        virtual void bindFramebuffer(GLenum target, GLuint framebuffer) = 0;
+        virtual void deleteFramebuffer(GLuint framebuffer) = 0;
+        virtual GLuint createRenderbuffer() = 0;
+        virtual void bindRenderbuffer(GLuint renderbuffer) = 0;
+        virtual void deleteRenderbuffer(GLuint renderbuffer) = 0;
+        /**
+         * @brief Allocates the storage of the bound renderbuffer.
+         * @param samples The number of samples, 0 for a single sample.
+         * @param internalFormat The sized format, e.g. GL_RGBA8.
+         * @param width The width in pixels.
+         * @param height The height in pixels.
+         */
+        virtual void renderbufferStorage(GLsizei samples,
+            GLenum internalFormat, GLsizei width, GLsizei height) = 0;
+        virtual void framebufferRenderbuffer(GLenum target,
+            GLenum attachment, GLuint renderbuffer) = 0;
+        virtual void framebufferTexture2D(GLenum target, GLenum attachment,
+            GLuint texture, GLint level) = 0;
+        virtual GLenum checkFramebufferStatus(GLenum target) = 0;
+        virtual void blitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1,
+            GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1,
+            GLbitfield mask, GLenum filter) = 0;
+
+        // Queries
+        virtual GLuint createQuery() = 0;
+        virtual void deleteQuery(GLuint query) = 0;
+        virtual void beginQuery(GLenum target, GLuint query) = 0;
+        virtual void endQuery(GLenum target) = 0;
+        /**
+         * @brief Reads the result of a query without waiting for the GPU.
+         * @param query The query to read.
+         * @param result Receives the result if it is available.
+         * @return True if the result was available.
+         */
+        virtual bool getQueryResult(GLuint query, GLuint64& result) = 0;
+
+        // Fences
+        /**
+         * @brief Inserts a fence after the commands issued so far.
+         * @return The name of the fence, like the names of objects.
+         */
+        virtual GLuint createFence() = 0;
+        /**
+         * @brief Checks a fence without waiting for the GPU.
+         * @return True once the commands before the fence finished.
+         */
+        virtual bool isFenceSignaled(GLuint fence) = 0;
+        virtual void deleteFence(GLuint fence) = 0;
+    };
+
+    /**
+     * @class GlDevice
+     * @brief Forwards every call to the OpenGL driver of the current
+     *        context.
+     */
+    class GlDevice final : public Device
+    {
+    public:
+        /**
+         * @brief Enables OpenGL debug output and routes the messages into a
+         *        DebugLog, or disables debug output if the settings turn it
+         *        off.
+         * @param debugLog The filters and rate limit of the debug log.
+         * @note Requires a current OpenGL context with loaded functions.
+         */
+        explicit GlDevice(const DebugLogSettings& debugLog =
+            DebugLogSettings());
+
+        /**
+         * @brief Removes the message callback, then stops the debug log.
+         */
+        ~GlDevice() override;
+
+        // Delete copy constructor and copy assignment operator
+        GlDevice(const GlDevice&) = delete;
+        GlDevice& operator=(const GlDevice&) = delete;
+
+        /**
+         * @brief Gets the debug log to change its severity at runtime.
+         * @return The log, nullptr if debug output is disabled.
+         */
+        DebugLog* getDebugLog() const override { return debugLog_.get(); }
+
+        GLuint createVertexArray() override;
+        void bindVertexArray(GLuint vertexArray) override;
+        void deleteVertexArray(GLuint vertexArray) override;
+        GLuint createBuffer() override;
+        void bindBuffer(GLenum target, GLuint buffer) override;
+        void deleteBuffer(GLuint buffer) override;
+        void bufferData(GLenum target, GLsizeiptr size, const void* data,
+            GLenum usage) override;
+        void vertexAttribPointer(GLuint index, GLint size, GLenum type,
+            GLsizei stride, std::size_t offset) override;
+        void enableVertexAttribArray(GLuint index) override;
+        void vertexAttribDivisor(GLuint index, GLuint divisor) override;
+        void bindBufferBase(GLenum target, GLuint index,
+            GLuint buffer) override;
+
+        GLuint createTexture() override;
+        void activeTexture(GLenum unit) override;
+        void bindTexture(GLenum target, GLuint texture) override;
+        void deleteTexture(GLuint texture) override;
+        void texParameter(GLenum target, GLenum name, GLint value) override;
+        void texImage2D(GLenum target, GLint level, GLint internalFormat,
+            GLsizei width, GLsizei height, GLenum format, GLenum type,
+            const void* pixels) override;
+        void generateMipmap(GLenum target) override;
+        void bindImageTexture(GLuint unit, GLuint texture, GLint level,
+            GLenum access, GLenum format) override;
+
+        GLuint createShader(GLenum type) override;
+        void shaderSource(GLuint shader, const std::string& source) override;
+        void compileShader(GLuint shader) override;
+        bool getCompileStatus(GLuint shader, std::string& infoLog) override;
+        void deleteShader(GLuint shader) override;
+        GLuint createProgram() override;
+        void attachShader(GLuint program, GLuint shader) override;
+        void linkProgram(GLuint program) override;
+        bool getLinkStatus(GLuint program, std::string& infoLog) override;
+        void useProgram(GLuint program) override;
+        void deleteProgram(GLuint program) override;
+
+        GLint getUniformLocation(GLuint program, const char* name) override;
+        void uniform1i(GLint location, GLint value) override;
+        void uniform1f(GLint location, GLfloat value) override;
+        void uniformMatrix4fv(GLint location, const GLfloat* value) override;
+
+        void viewport(GLint x, GLint y, GLsizei width,
+            GLsizei height) override;
+        void enable(GLenum capability) override;
+        void disable(GLenum capability) override;
+        void blendFunc(GLenum sourceFactor, GLenum destFactor) override;
+        void clearColor(GLfloat red, GLfloat green, GLfloat blue,
+            GLfloat alpha) override;
+        void clear(GLbitfield mask) override;
+        void drawArrays(GLenum mode, GLint first, GLsizei count) override;
+        void drawElements(GLenum mode, GLsizei count, GLenum type,
+            std::size_t offset) override;
+        void multiDrawArraysIndirect(GLenum mode, std::size_t offset,
+            GLsizei drawCount, GLsizei stride) override;
+
+        void dispatchCompute(GLuint groupsX, GLuint groupsY,
+            GLuint groupsZ) override;
+        void memoryBarrier(GLbitfield barriers) override;
+
+        GLuint createFramebuffer() override;
+        void bindFramebuffer(GLenum target, GLuint framebuffer) override;
+        void deleteFramebuffer(GLuint framebuffer) override;
+        GLuint createRenderbuffer() override;
+        void bindRenderbuffer(GLuint renderbuffer) override;
+        void deleteRenderbuffer(GLuint renderbuffer) override;
+        void renderbufferStorage(GLsizei samples, GLenum internalFormat,
+            GLsizei width, GLsizei height) override;
+        void framebufferRenderbuffer(GLenum target, GLenum attachment,
+            GLuint renderbuffer) override;
+        void framebufferTexture2D(GLenum target, GLenum attachment,
+            GLuint texture, GLint level) override;
+        GLenum checkFramebufferStatus(GLenum target) override;
+        void blitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1,
+            GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1,
+            GLbitfield mask, GLenum filter) override;
+
+        GLuint createQuery() override;
+        void deleteQuery(GLuint query) override;
+        void beginQuery(GLenum target, GLuint query) override;
+        void endQuery(GLenum target) override;
+        bool getQueryResult(GLuint query, GLuint64& result) override;
+
+        GLuint createFence() override;
+        bool isFenceSignaled(GLuint fence) override;
+        void deleteFence(GLuint fence) override;
+
+    private:
+        // Null when debug output is disabled
+        std::unique_ptr<DebugLog> debugLog_;
+        // The sync objects behind the fence names
+        std::unordered_map<GLuint, GLsync> fences_;
+        GLuint nextFence_;
+    };
+
+    /**
+     * @class NullDevice
+     * @brief A device that validates and counts calls without a driver.
+     *
+     * Object names are handed out sequentially for each object type, like
+     * a driver does, so names of different types overlap. The bindings are
+     * tracked like the OpenGL state machine would. Calls that would be
+     * invalid on a real driver, such as binding an unknown name or drawing
+     * without a program, throw instead of being silently ignored.
+     *
+     * @note Every call is counted in the DeviceStats, see getStats().
+     */
+    class NullDevice final : public Device
+    {
+    public:
+        NullDevice();
+        ~NullDevice() override = default;
+
+        /**
+         * @brief Gets the counters accumulated since the last reset.
+         * @return The call statistics.
+         */
+        const DeviceStats& getStats() const { return stats_; }
+
+        /**
+         * @brief Resets every counter to zero, keeping the tracked objects.
+         */
+        void resetStats();
+
+        GLuint createVertexArray() override;
+        void bindVertexArray(GLuint vertexArray) override;
+        void deleteVertexArray(GLuint vertexArray) override;
+        GLuint createBuffer() override;
+        void bindBuffer(GLenum target, GLuint buffer) override;
+        void deleteBuffer(GLuint buffer) override;
+        void bufferData(GLenum target, GLsizeiptr size, const void* data,
+            GLenum usage) override;
+        void vertexAttribPointer(GLuint index, GLint size, GLenum type,
+            GLsizei stride, std::size_t offset) override;
+        void enableVertexAttribArray(GLuint index) override;
+        void vertexAttribDivisor(GLuint index, GLuint divisor) override;
+        void bindBufferBase(GLenum target, GLuint index,
+            GLuint buffer) override;
+
+        GLuint createTexture() override;
+        void activeTexture(GLenum unit) override;
+        void bindTexture(GLenum target, GLuint texture) override;
+        void deleteTexture(GLuint texture) override;
+        void texParameter(GLenum target, GLenum name, GLint value) override;
+        void texImage2D(GLenum target, GLint level, GLint internalFormat,
+            GLsizei width, GLsizei height, GLenum format, GLenum type,
+            const void* pixels) override;
+        void generateMipmap(GLenum target) override;
+        void bindImageTexture(GLuint unit, GLuint texture, GLint level,
+            GLenum access, GLenum format) override;
+
+        GLuint createShader(GLenum type) override;
+        void shaderSource(GLuint shader, const std::string& source) override;
+        void compileShader(GLuint shader) override;
+        bool getCompileStatus(GLuint shader, std::string& infoLog) override;
+        void deleteShader(GLuint shader) override;
+        GLuint createProgram() override;
+        void attachShader(GLuint program, GLuint shader) override;
+        void linkProgram(GLuint program) override;
+        bool getLinkStatus(GLuint program, std::string& infoLog) override;
+        void useProgram(GLuint program) override;
+        void deleteProgram(GLuint program) override;
+
+        GLint getUniformLocation(GLuint program, const char* name) override;
+        void uniform1i(GLint location, GLint value) override;
+        void uniform1f(GLint location, GLfloat value) override;
+        void uniformMatrix4fv(GLint location, const GLfloat* value) override;
+
+        void viewport(GLint x, GLint y, GLsizei width,
+            GLsizei height) override;
+        void enable(GLenum capability) override;
+        void disable(GLenum capability) override;
+        void blendFunc(GLenum sourceFactor, GLenum destFactor) override;
+        void clearColor(GLfloat red, GLfloat green, GLfloat blue,
+            GLfloat alpha) override;
+        void clear(GLbitfield mask) override;
+        void drawArrays(GLenum mode, GLint first, GLsizei count) override;
+        void drawElements(GLenum mode, GLsizei count, GLenum type,
+            std::size_t offset) override;
+        void multiDrawArraysIndirect(GLenum mode, std::size_t offset,
+            GLsizei drawCount, GLsizei stride) override;
+
+        void dispatchCompute(GLuint groupsX, GLuint groupsY,
+            GLuint groupsZ) override;
+        void memoryBarrier(GLbitfield barriers) override;
+
+        GLuint createFramebuffer() override;
+        void bindFramebuffer(GLenum target, GLuint framebuffer) override;
+        void deleteFramebuffer(GLuint framebuffer) override;
+        GLuint createRenderbuffer() override;
+        void bindRenderbuffer(GLuint renderbuffer) override;
+        void deleteRenderbuffer(GLuint renderbuffer) override;
+        void renderbufferStorage(GLsizei samples, GLenum internalFormat,
+            GLsizei width, GLsizei height) override;
+        void framebufferRenderbuffer(GLenum target, GLenum attachment,
+            GLuint renderbuffer) override;
+        void framebufferTexture2D(GLenum target, GLenum attachment,
+            GLuint texture, GLint level) override;
+        GLenum checkFramebufferStatus(GLenum target) override;
+        void blitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1,
+            GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1,
+            GLbitfield mask, GLenum filter) override;
+
+        GLuint createQuery() override;
+        void deleteQuery(GLuint query) override;
+        void beginQuery(GLenum target, GLuint query) override;
+        void endQuery(GLenum target) override;
+        bool getQueryResult(GLuint query, GLuint64& result) override;
+
+        GLuint createFence() override;
+        bool isFenceSignaled(GLuint fence) override;
+        void deleteFence(GLuint fence) override;
+
+    private:
+        /**
+         * @enum NameSpace
+         * @brief The object types numbered apart; shaders and programs
+         *        share their names as in OpenGL.
+         */
+        enum class NameSpace : std::uint8_t
+        {
+            VERTEX_ARRAY = 0,
+            BUFFER,
+            TEXTURE,
+            SHADER_OR_PROGRAM,
+            FRAMEBUFFER,
+            RENDERBUFFER,
+            QUERY,
+            FENCE,
+            COUNT
+        };
+
+        /**
+         * @struct VertexArrayRecord
+         * @brief The tracked state of a vertex array object.
+         */
+        struct VertexArrayRecord
+        {
+            // The GL_ELEMENT_ARRAY_BUFFER binding, part of the vertex array
+            GLuint elementBuffer;
+        };
+
+        /**
+         * @struct ShaderRecord
+         * @brief The tracked state of a shader object.
+         */
+        struct ShaderRecord
+        {
+            GLenum type;
+            bool hasSource;
+            bool compiled;
+        };
+
+        /**
+         * @struct ProgramRecord
+         * @brief The tracked state of a program object.
+         */
+        struct ProgramRecord
+        {
+            std::vector<GLuint> shaders;
+            bool linked;
+            // Whether the program was linked from a compute shader
+            bool compute;
+            // Uniform locations handed out by getUniformLocation
+            std::unordered_map<std::string, GLint> uniforms;
+        };
+
+        /**
+         * @struct RenderbufferRecord
+         * @brief The tracked storage of a renderbuffer object.
+         */
+        struct RenderbufferRecord
+        {
+            bool allocated;
+            GLsizei samples;
+        };
+
+        /**
+         * @struct Attachment
+         * @brief A renderbuffer or texture attached to a framebuffer.
+         */
+        struct Attachment
+        {
+            GLuint name;
+            bool texture;
+        };
+
+        /**
+         * @struct FramebufferRecord
+         * @brief The images attached to a framebuffer object.
+         */
+        struct FramebufferRecord
+        {
+            Attachment color;
+            Attachment depth;
+        };
+
+        /** @brief Counts a call in the given category. */
+        void count(DeviceCall call) { ++stats_.calls[static_cast<std::size_t>(call)]; }
+
+        /**
+         * @brief Throws if a validation condition does not hold.
+         * @throws std::logic_error With the given message if condition is
+         *         false.
+         */
+        void require(bool condition, const char* message) const;
+
+        /** @brief Gets the buffer bound to a buffer target. */
+        GLuint& boundBuffer(GLenum target);
+
+        /** @brief Gets the query active on a query target. */
+        GLuint& activeQuery(GLenum target);
+
+        /** @brief Gets whether a query is active on any target. */
+        bool isQueryActive(GLuint query) const;
+
+        /** @brief Checks that a uniform update has a linked program. */
+        void requireUniformTarget(GLint location) const;
+
+        /**
+         * @brief Gets the framebuffer bound to a framebuffer target,
+         *        GL_FRAMEBUFFER gets the draw framebuffer.
+         */
+        GLuint boundFramebuffer(GLenum target) const;
+
+        /** @brief Gets the sample count of a framebuffer, 0 for the window. */
+        GLsizei framebufferSamples(GLuint framebuffer) const;
+
+        /** @brief Gets the element buffer of the bound vertex array. */
+        GLuint& boundElementBuffer();
+
+        /** @brief Takes the next name of a name space. */
+        GLuint nextName(NameSpace space);
+
+        /** @brief Checks that the program in use has the given kind. */
+        void requireProgram(bool compute, const char* message) const;
+
+        /** @brief Attaches an image to the framebuffer bound to a target. */
+        void attach(GLenum target, GLenum attachment,
+            const Attachment& image);
+
+        /** @brief Detaches a deleted image from every framebuffer. */
+        void detach(const Attachment& image);
+
+        DeviceStats stats_;
+        // The next object name of each name space
+        std::array<GLuint, static_cast<std::size_t>(NameSpace::COUNT)>
+            nextNames_;
+
+        std::unordered_map<GLuint, VertexArrayRecord> vertexArrays_;
+        std::unordered_set<GLuint> buffers_;
+        std::unordered_set<GLuint> textures_;
+        std::unordered_map<GLuint, ShaderRecord> shaders_;
+        std::unordered_map<GLuint, ProgramRecord> programs_;
+        std::unordered_map<GLuint, FramebufferRecord> framebuffers_;
+        std::unordered_map<GLuint, RenderbufferRecord> renderbuffers_;
+        std::unordered_set<GLuint> queries_;
+        std::unordered_set<GLuint> fences_;
+
+        GLuint boundVertexArray_;
+        GLuint boundArrayBuffer_;
+        // The element buffer of the default vertex array, the others keep
+        // theirs in their record
+        GLuint defaultElementBuffer_;
+        GLuint boundStorageBuffer_;
+        GLuint boundIndirectBuffer_;
+        GLuint currentProgram_;
+        // The index of the active texture unit
+        std::size_t activeUnit_;
+        // The texture bound to GL_TEXTURE_2D on each texture unit
+        std::array<GLuint, 32> boundTextures_;
+        GLuint boundDrawFramebuffer_;
+        GLuint boundReadFramebuffer_;
+        GLuint boundRenderbuffer_;
+        // The queries between beginQuery and endQuery per target, 0 if
+        // there is none
+        std::unordered_map<GLenum, GLuint> activeQueries_;
+        // Holds the name of a uniform lookup, reused so that looking up a
+        // known name does not allocate
+        std::string uniformName_;
+    };
+}
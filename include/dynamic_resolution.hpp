@@ -0,0 +1,175 @@
+/**
+ * @file dynamic_resolution.hpp
+ * @brief This header file defines dynamic resolution scaling, which keeps
+ *        the GPU frame time at a target by changing the number of pixels
+ *        the scene is rendered at.
+ *
+ * The scene is rendered into transient targets of the render graph, sized
+ * at the largest allowed scale of the window size; every frame only the
+ * part covered by the current scale is used. GPU timer queries measure each
+ * frame, and a controller turns the filtered frame time into the scale of
+ * the next frames. The rendered part is resolved and stretched over the
+ * window with a bilinear blit.
+ */
+
+#pragma once
+#include <device.hpp>   // For the Device the framebuffers are created on.
+#include <query_ring.hpp> // For timing frames without waiting on the GPU.
+#include <render_graph.hpp> // For the description of the targets.
+
+
+namespace Renderer
+{
+    /**
+     * @namespace ResolutionConstants
+     * @brief Contains the configuration of the resolution controller.
+     */
+    namespace ResolutionConstants
+    {
+        // The number of timer queries in flight, the GPU runs this many
+        // frames behind at most before a measurement is skipped.
+        constexpr std::size_t TIMER_QUERIES = 4;
+        // The weight of a new measurement in the filtered frame time.
+        constexpr double FILTER_WEIGHT = 0.2;
+        // Relative frame time error that does not change the scale.
+        constexpr double DEAD_BAND = 0.05;
+        // The largest relative change of the scale per frame.
+        constexpr float MAX_SCALE_STEP = 0.05f;
+        // The number of MSAA samples of the offscreen framebuffer, matching
+        // WindowAttributes::getSettings.
+        constexpr GLsizei SAMPLES = 4;
+    };
+
+    /**
+     * @struct ResolutionSettings
+     * @brief The bounds and target of dynamic resolution scaling.
+     *
+     * Scales are relative to the window size in each dimension.
+     */
+    struct ResolutionSettings
+    {
+        /** @brief Whether the scene is rendered at a dynamic resolution. */
+        bool enabled = false;
+        /** @brief The smallest scale (`--min-scale`). */
+        float minScale = 0.5f;
+        /** @brief The largest scale (`--max-scale`). */
+        float maxScale = 1.0f;
+        /** @brief The GPU frame time to hold, in ms (`--target-ms`). */
+        float targetMilliseconds = 14.0f;
+    };
+
+    /**
+     * @class ResolutionController
+     * @brief Chooses the render scale from measured GPU frame times.
+     *
+     * The cost of a frame grows with its pixel count, the square of the
+     * scale, so the scale is corrected by the square root of the ratio
+     * between target and filtered frame time. Small errors are ignored and
+     * large ones are applied over several frames to avoid oscillation.
+     */
+    class ResolutionController
+    {
+    public:
+        /**
+         * @brief Starts at the largest scale.
+         * @param settings The bounds and the frame time target.
+         */
+        explicit ResolutionController(const ResolutionSettings& settings);
+
+        /**
+         * @brief Feeds a GPU frame time measurement.
+         * @param milliseconds The GPU time of a finished frame.
+         * @return The scale for the next frame.
+         */
+        float update(double milliseconds);
+
+        /*** @brief Gets the current scale. */
+        float getScale() const { return scale_; }
+
+        /*** @brief Gets the filtered GPU frame time in milliseconds. */
+        double getFilteredMilliseconds() const { return filtered_; }
+
+    private:
+        ResolutionSettings settings_;
+        float scale_;
+        // Exponential moving average of the measurements, 0 before the first
+        double filtered_;
+    };
+
+    /**
+     * @class DynamicResolution
+     * @brief Renders frames offscreen at a scale chosen by a
+     *        ResolutionController and upscales them to the window.
+     */
+    class DynamicResolution
+    {
+    public:
+        /**
+         * @brief Creates the timer queries.
+         * @param device The device the frames are rendered on.
+         * @param settings The bounds and the frame time target.
+         * @param width The width of the window in pixels.
+         * @param height The height of the window in pixels.
+         */
+        DynamicResolution(Device& device, const ResolutionSettings& settings,
+            GLsizei width, GLsizei height);
+
+        // Delete copy constructor and copy assignment operator
+        DynamicResolution(const DynamicResolution&) = delete;
+        DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+        /**
+         * @brief Sizes the targets of the next frames for a new window size.
+         */
+        void resize(GLsizei width, GLsizei height);
+
+        /**
+         * @brief Describes a target of the scene, at the largest scale.
+         * @param format The format of the renderbuffer.
+         * @param samples The samples, ResolutionConstants::SAMPLES for the
+         *        scene and 0 for the resolved copy.
+         */
+        TargetDesc getTargetDesc(GLenum format, GLsizei samples) const;
+
+        /**
+         * @brief Updates the scale, binds the scene's framebuffer with a
+         *        matching viewport and starts the GPU timer.
+         * @param sceneFramebuffer The multisampled color and depth targets.
+         */
+        void beginFrame(GLuint sceneFramebuffer);
+
+        /**
+         * @brief Resolves the samples of the rendered part.
+         * @param sceneFramebuffer The framebuffer passed to beginFrame().
+         * @param resolveFramebuffer A single sampled color target.
+         */
+        void resolve(GLuint sceneFramebuffer, GLuint resolveFramebuffer);
+
+        /**
+         * @brief Upscales the resolved frame into the window's framebuffer,
+         *        which is left bound, and stops the GPU timer.
+         * @param resolveFramebuffer The framebuffer passed to resolve().
+         */
+        void upscale(GLuint resolveFramebuffer);
+
+        /*** @brief Gets the scale of the current frame. */
+        float getScale() const { return controller_.getScale(); }
+
+        /*** @brief Gets the pixels the current frame is rendered at. */
+        std::uint64_t getRenderPixels() const
+        {
+            return static_cast<std::uint64_t>(renderWidth_) * renderHeight_;
+        }
+
+    private:
+        Device& device_;
+        ResolutionSettings settings_;
+        ResolutionController controller_;
+        QueryRing timer_;
+        GLsizei windowWidth_;
+        GLsizei windowHeight_;
+        // The size the current frame is rendered at
+        GLsizei renderWidth_;
+        GLsizei renderHeight_;
+    };
+}
@@ -0,0 +1,169 @@
+/**
+ * @file frame_arena.hpp
+ * @brief This header file defines the per-frame linear arena for transient
+ *        data and the counting of heap allocations.
+ *
+ * Data that only lives for one frame is carved out of a FrameArena, which
+ * is reset at the start of every frame instead of freeing each piece.
+ * Containers use it through ArenaAllocator. Heap allocations made through
+ * the global operator new are counted per thread, so a frame loop can
+ * verify that its steady-state frames do not touch the heap.
+ */
+
+#pragma once
+#include <cstddef> // For byte sizes and alignment.
+#include <cstdint> // For the allocation count.
+#include <memory>  // For owning the arena blocks.
+#include <new>     // For std::bad_alloc.
+#include <vector>  // For the overflow blocks and FrameVector.
+
+
+namespace Renderer
+{
+    /**
+     * @namespace FrameArenaConstants
+     * @brief Contains the sizing of the frame arena.
+     */
+    namespace FrameArenaConstants
+    {
+        // The initial capacity of the arena in bytes.
+        constexpr std::size_t DEFAULT_CAPACITY = 64 * 1024;
+    };
+
+    /**
+     * @brief Gets the number of heap allocations the calling thread has
+     *        made through the global operator new.
+     *
+     * The count only grows; the allocations of a frame are the difference
+     * of the counts taken before and after it. Threads are counted apart,
+     * so writer threads do not show up in the frames of the render thread.
+     *
+     * @return The number of allocations since the thread started.
+     */
+    std::uint64_t getAllocationCount();
+
+    /**
+     * @class FrameArena
+     * @brief A linear allocator whose memory is given back all at once.
+     *
+     * Allocation bumps an offset into one block. A frame that needs more
+     * than the block holds gets its extra allocations from the heap, and
+     * the next reset() grows the block to the most the arena held, so the
+     * arena settles after the largest frame and allocates nothing more.
+     *
+     * @note The arena is not thread-safe, each thread needs its own.
+     */
+    class FrameArena
+    {
+    public:
+        /**
+         * @param capacity The initial size of the block in bytes.
+         */
+        explicit FrameArena(
+            std::size_t capacity = FrameArenaConstants::DEFAULT_CAPACITY);
+        ~FrameArena();
+
+        // Delete copy constructor and copy assignment operator
+        FrameArena(const FrameArena&) = delete;
+        FrameArena& operator=(const FrameArena&) = delete;
+
+        /**
+         * @brief Allocates memory that stays valid until the next reset().
+         * @param bytes The size of the allocation.
+         * @param alignment The alignment, a power of two.
+         * @return The allocated memory, never null.
+         * @throws std::bad_alloc If the heap cannot satisfy an overflow.
+         */
+        void* allocate(std::size_t bytes,
+            std::size_t alignment = alignof(std::max_align_t));
+
+        /**
+         * @brief Gives back every allocation at once.
+         *
+         * Objects in the arena are not destroyed, only trivially
+         * destructible data or containers that are gone belong in it.
+         */
+        void reset();
+
+        /*** @brief Gets the bytes allocated since the last reset. */
+        std::size_t getUsed() const { return used_; }
+
+        /*** @brief Gets the size of the block. */
+        std::size_t getCapacity() const { return capacity_; }
+
+        /*** @brief Gets the most bytes allocated between two resets. */
+        std::size_t getPeak() const { return peak_; }
+
+    private:
+        /** @brief Replaces the block with one of the given size. */
+        void allocateBlock(std::size_t capacity);
+
+        std::unique_ptr<std::byte[]> block_;
+        std::size_t capacity_;
+        // The offset of the next allocation in the block
+        std::size_t offset_;
+        // The bytes of this frame, including the overflow
+        std::size_t used_;
+        std::size_t peak_;
+        // Allocations that did not fit the block, freed on reset
+        std::vector<std::unique_ptr<std::byte[]>> overflow_;
+    };
+
+    /**
+     * @class ArenaAllocator
+     * @brief Lets standard containers allocate from a FrameArena.
+     *
+     * Deallocation does nothing; the memory comes back when the arena is
+     * reset, so a container must not outlive the frame it was filled in.
+     *
+     * @tparam T The type of the allocated elements.
+     */
+    template <typename T>
+    class ArenaAllocator
+    {
+    public:
+        using value_type = T;
+
+        explicit ArenaAllocator(FrameArena& arena) : arena_{ &arena } {}
+
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other) :
+            arena_{ other.getArena() } {}
+
+        T* allocate(std::size_t count)
+        {
+            if (count > static_cast<std::size_t>(-1) / sizeof(T))
+            {
+                throw std::bad_alloc();
+            }
+            return static_cast<T*>(arena_->allocate(count * sizeof(T),
+                alignof(T)));
+        }
+
+        void deallocate(T*, std::size_t) {}
+
+        FrameArena* getArena() const { return arena_; }
+
+        template <typename U>
+        bool operator==(const ArenaAllocator<U>& other) const
+        {
+            return arena_ == other.getArena();
+        }
+
+        template <typename U>
+        bool operator!=(const ArenaAllocator<U>& other) const
+        {
+            return arena_ != other.getArena();
+        }
+
+    private:
+        FrameArena* arena_;
+    };
+
+    /**
+     * @brief A vector that lives in a frame arena, construct it with an
+     *        ArenaAllocator.
+     */
+    template <typename T>
+    using FrameVector = std::vector<T, ArenaAllocator<T>>;
+}
@@ -0,0 +1,150 @@
+/**
+ * @file frame_pacer.hpp
+ * @brief This header file defines the pacing of the window loop for low
+ *        input latency and the measurement of that latency.
+ *
+ * The driver may queue several frames before the GPU runs them, and
+ * every queued frame delays what the user sees of the input it was built
+ * from. In low latency mode a fence is inserted after each swap, and before
+ * the input of the next frame is read the pacer waits until at most the
+ * allowed number of frames are in flight. The wait therefore happens
+ * before the input is sampled instead of blocking inside the swap with
+ * the input already read.
+ *
+ * With a delayed frame start, the frame rate limit also sleeps before the
+ * input is read rather than after the swap: the start is pushed back to
+ * the latest moment at which the predicted cost of the frame still meets
+ * the next frame deadline.
+ *
+ * Both modes measure the time from reading the input to the return of the
+ * swap for every frame, so runs with and without low latency compare.
+ * SFML does not timestamp events, so an event counts as received when the
+ * loop reads it.
+ */
+
+#pragma once
+#include <window.hpp> // For the OpenGL fences.
+#include <chrono>     // For the frame timings.
+#include <cstddef>    // For the sample count.
+#include <cstdint>    // For the counters.
+#include <deque>      // For the fences of the frames in flight.
+#include <string>     // For the summary.
+#include <vector>     // For the latency samples.
+
+
+namespace Renderer
+{
+    /**
+     * @namespace LatencyConstants
+     * @brief Contains the limits and tuning of the frame pacer.
+     */
+    namespace LatencyConstants
+    {
+        // The frames in flight of low latency mode unless given.
+        constexpr unsigned int DEFAULT_FRAMES_IN_FLIGHT = 1;
+        // The most frames in flight that can be asked for.
+        constexpr unsigned int MAX_FRAMES_IN_FLIGHT = 4;
+        // The nanoseconds a fence is waited for before giving up.
+        constexpr GLuint64 FENCE_TIMEOUT = 100'000'000;
+        // The weight of a new measurement in the predicted frame cost.
+        constexpr double COST_WEIGHT = 0.1;
+        // The factor and milliseconds added to the predicted frame cost
+        // before delaying, so a slower frame still meets the deadline.
+        constexpr double COST_MARGIN = 1.25;
+        constexpr double COST_SLACK_MS = 1.0;
+        // The latest frames the latency percentiles are taken over, kept
+        // in a ring allocated once.
+        constexpr std::size_t LATENCY_SAMPLES = 8192;
+    };
+
+    /**
+     * @struct LatencySettings
+     * @brief Configures the low latency mode of the window loop.
+     */
+    struct LatencySettings
+    {
+        /** @brief Whether frames in flight are limited (`--low-latency`). */
+        bool enabled = false;
+        /** @brief The most frames queued on the GPU (`--low-latency=N`). */
+        unsigned int framesInFlight =
+            LatencyConstants::DEFAULT_FRAMES_IN_FLIGHT;
+        /** @brief Whether the frame start is delayed by the predicted frame
+         *         cost (`--frame-delay`), implies enabled. */
+        bool delayFrameStart = false;
+    };
+
+    /**
+     * @class FramePacer
+     * @brief Limits the frames in flight, delays frame starts and measures
+     *        input to swap latency.
+     *
+     * Every frame calls beginFrame() before reading input, inputRead() once
+     * it has, and endFrame() right after the swap.
+     *
+     * @note Needs the OpenGL context of the window current.
+     */
+    class FramePacer
+    {
+    public:
+        /**
+         * @brief Creates a pacer, measuring only unless settings enable it.
+         * @param settings The low latency settings.
+         * @param framePeriodMs The frame time of the frame rate limit, used
+         *        for delayed frame starts.
+         */
+        FramePacer(const LatencySettings& settings, double framePeriodMs);
+
+        /** @brief Deletes the fences still pending. */
+        ~FramePacer();
+
+        // Delete copy constructor and copy assignment operator
+        FramePacer(const FramePacer&) = delete;
+        FramePacer& operator=(const FramePacer&) = delete;
+
+        /**
+         * @brief Waits until a frame may be queued and, with a delayed
+         *        start, until the predicted start of the frame.
+         */
+        void beginFrame();
+
+        /** @brief Records that the input of the frame was read. */
+        void inputRead();
+
+        /**
+         * @brief Records the swap of the frame and inserts its fence.
+         */
+        void endFrame();
+
+        /**
+         * @brief Summarizes the latency percentiles and the time spent
+         *        waiting.
+         * @return The summary lines, each ending in a newline, empty if no
+         *         frame was measured.
+         */
+        std::string getSummary() const;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        /** @brief Waits for the oldest fence and deletes it. */
+        void waitOldestFence();
+
+        LatencySettings settings_;
+        Clock::duration framePeriod_;
+        // The fences of the frames queued on the GPU, oldest first
+        std::deque<GLsync> fences_;
+        Clock::time_point frameStart_;
+        Clock::time_point inputTime_;
+        Clock::time_point lastSwap_;
+        bool swapped_;
+        // The filtered milliseconds from frame start to swap
+        double predictedCostMs_;
+        // The latencies of the latest frames, overwritten oldest first
+        std::vector<double> latenciesMs_;
+        std::uint64_t measuredFrames_;
+        double maxLatencyMs_;
+        double fenceWaitMs_;
+        double delayMs_;
+        std::uint64_t fenceTimeouts_;
+    };
+}
@@ -0,0 +1,236 @@
+/**
+ * @file frame_stream.hpp
+ * @brief This header file defines the server that streams the rendered
+ *        frames to a remote viewer over TCP.
+ *
+ * Frames are read back like captured frames: into a ring of pixel buffer
+ * objects, mapped two frames later so the frame loop does not wait on the
+ * transfer. Mapped frames wait in a bounded queue for a sender thread that
+ * only ever sends the newest one. Frames the sender has no time for are
+ * stale by the time it would get to them and are dropped, so a slow link
+ * lowers the frame rate of the viewer instead of adding latency.
+ *
+ * The sender keeps a copy of the frame the viewer has and only sends the
+ * tiles that changed, encoded with the codec of stream_protocol.hpp. A
+ * receiver thread accepts one viewer at a time and queues its input events
+ * for the frame loop. The viewer acknowledges every frame it displays, and
+ * the time from the read back of a frame to its acknowledgement is reported
+ * as its latency.
+ *
+ * @note Nothing is read back while no viewer is connected.
+ */
+
+#pragma once
+#include <window.hpp>          // For the OpenGL types and functions.
+#include <stream_protocol.hpp> // For the messages and the tile codec.
+#include <SFML/Network.hpp>    // For the sockets.
+#include <array>               // For the ring of pixel buffers.
+#include <atomic>              // For the connection state.
+#include <chrono>              // For the frame timestamps.
+#include <condition_variable>  // For waking up the sender thread.
+#include <cstdint>             // For the pixel bytes.
+#include <deque>               // For the frame and input queues.
+#include <mutex>               // For guarding the queues.
+#include <string>              // For the summary.
+#include <thread>              // For the network threads.
+#include <vector>              // For the pixel staging buffers.
+
+
+namespace Renderer
+{
+    /**
+     * @namespace StreamServerConstants
+     * @brief Contains the configuration of the frame streaming server.
+     */
+    namespace StreamServerConstants
+    {
+        // The number of frames between queuing a read and mapping it.
+        constexpr std::size_t READBACK_LATENCY = 2;
+        // The number of pixel buffer objects, one per frame in flight.
+        constexpr std::size_t RING_SIZE = READBACK_LATENCY + 1;
+        // The number of frames waiting for the sender, older ones are
+        // dropped as stale.
+        constexpr std::size_t QUEUED_FRAMES = 2;
+        // The staging buffers of the queued frames and the one being sent.
+        constexpr std::size_t STAGING_BUFFERS = QUEUED_FRAMES + 1;
+        // The milliseconds the receiver waits for data before checking
+        // whether the server stops.
+        constexpr std::int32_t POLL_INTERVAL_MS = 50;
+        // The bytes read from the socket at once.
+        constexpr std::size_t RECEIVE_CHUNK = 4096;
+    };
+
+    /**
+     * @class FrameStreamServer
+     * @brief Serves the frames of the window to one remote viewer at a time
+     *        and collects the input events it sends back.
+     *
+     * @note capture(), resize() and finish() need the OpenGL context of the
+     *       window current.
+     */
+    class FrameStreamServer
+    {
+    public:
+        /**
+         * @brief Creates the pixel buffers, listens on a port and starts the
+         *        network threads.
+         * @param port The TCP port, 0 for any free port.
+         * @param width The width of the streamed frames in pixels.
+         * @param height The height of the streamed frames in pixels.
+         * @throws std::runtime_error If the port cannot be listened on.
+         */
+        FrameStreamServer(unsigned short port, unsigned int width,
+            unsigned int height);
+
+        /**
+         * @brief Stops the server, see finish().
+         */
+        ~FrameStreamServer();
+
+        // Delete copy constructor and copy assignment operator
+        FrameStreamServer(const FrameStreamServer&) = delete;
+        FrameStreamServer& operator=(const FrameStreamServer&) = delete;
+
+        /**
+         * @brief Queues the read back of the current frame if a viewer is
+         *        connected and queues the frame read READBACK_LATENCY frames
+         *        ago for sending.
+         *
+         * Call it after the frame is rendered and before it is displayed.
+         */
+        void capture();
+
+        /**
+         * @brief Streams frames of a new size, dropping the reads in flight.
+         */
+        void resize(unsigned int width, unsigned int height);
+
+        /**
+         * @brief Takes the next input event of the viewer.
+         *
+         * Frames read back after an event was taken report it as applied,
+         * which the viewer uses to measure its input latency.
+         *
+         * @param input Receives the event.
+         * @return False if no event is waiting.
+         */
+        bool pollInput(StreamInput& input);
+
+        /**
+         * @brief Disconnects the viewer, stops the network threads and
+         *        deletes the pixel buffers.
+         */
+        void finish();
+
+        /**
+         * @brief Summarizes the frames, bandwidth and latency of the stream.
+         * @return The summary lines, each ending in a newline, empty if no
+         *         frame was sent. Complete once the server is finished.
+         */
+        std::string getSummary() const;
+
+        /*** @brief Gets the port the server listens on. */
+        unsigned short getPort() const { return port_; }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        /**
+         * @struct Slot
+         * @brief A pixel buffer object and the fence of its pending read.
+         */
+        struct Slot
+        {
+            GLuint buffer = 0;
+            GLsync fence = nullptr;
+            std::uint64_t frame = 0;
+            std::uint64_t timestamp = 0;
+            std::uint32_t inputSequence = 0;
+        };
+
+        /**
+         * @struct PendingFrame
+         * @brief A read back frame waiting to be sent.
+         */
+        struct PendingFrame
+        {
+            FrameHeader header;
+            std::vector<std::uint8_t> pixels;
+        };
+
+        /** @brief Maps a slot and moves its pixels to the send queue. */
+        void consume(Slot& slot);
+
+        /** @brief Allocates the pixel buffers at the frame size. */
+        void allocateBuffers();
+
+        /** @brief Accepts viewers and receives their messages. */
+        void receiveLoop();
+
+        /** @brief Handles a message received from the viewer. */
+        void handleMessage(StreamMessage type, const std::uint8_t* payload,
+            std::size_t size);
+
+        /** @brief Sends the newest queued frame until the server stops. */
+        void senderLoop();
+
+        /** @brief Encodes the changed tiles of a frame and sends them. */
+        void sendFrame(const PendingFrame& pending);
+
+        /** @brief Sends a built message, returns false on failure. */
+        bool send(const std::vector<std::uint8_t>& message);
+
+        /** @brief Closes the connection to the viewer. */
+        void disconnect();
+
+        // Render thread
+        unsigned int width_;
+        unsigned int height_;
+        std::size_t frameSize_;
+        std::array<Slot, StreamServerConstants::RING_SIZE> slots_;
+        std::uint64_t frameIndex_;
+        std::uint32_t appliedInput_;
+        Clock::time_point epoch_;
+        std::uint64_t captured_;
+        std::uint64_t stalls_;
+        bool finished_;
+
+        // Sockets, the listener and the receive side belong to the receiver
+        // thread, sends and disconnects are guarded by sendMutex_
+        sf::TcpListener listener_;
+        sf::TcpSocket socket_;
+        sf::SocketSelector selector_;
+        unsigned short port_;
+        std::mutex sendMutex_;
+        std::atomic<bool> connected_;
+        bool viewerReset_;
+        MessageAssembler assembler_;
+        std::vector<double> latenciesMs_;
+        std::uint64_t connections_;
+
+        // Queues shared with the network threads, guarded by mutex_
+        std::mutex mutex_;
+        std::condition_variable queueReady_;
+        std::deque<PendingFrame> queue_;
+        std::vector<std::vector<std::uint8_t>> freeBuffers_;
+        std::deque<StreamInput> inputs_;
+        std::uint64_t dropped_;
+        std::atomic<bool> stopping_;
+        std::thread receiver_;
+        std::thread sender_;
+
+        // Sender thread: the frame the viewer has and the message buffers
+        TileGrid grid_;
+        std::vector<std::uint8_t> reference_;
+        std::vector<std::uint8_t> tileScratch_;
+        MessageWriter writer_;
+        std::uint64_t sent_;
+        std::uint64_t tilesSent_;
+        std::uint64_t tilesTotal_;
+        std::uint64_t bytesSent_;
+        std::uint64_t rawBytes_;
+        double encodeMs_;
+        Clock::time_point firstSend_;
+        Clock::time_point lastSend_;
+    };
+}
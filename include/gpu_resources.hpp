@@ -0,0 +1,202 @@
+/**
+ * @file gpu_resources.hpp
+ * @brief This header file defines the pools of textures and buffers whose
+ *        deletion waits for the GPU.
+ *
+ * Owners hold a TextureHandle or BufferHandle instead of the OpenGL name.
+ * Releasing a handle makes it stale at once, but the name is only retired
+ * once a fence placed at the end of the frame has passed, because frames
+ * still queued on the GPU may read the object. Retired names are kept for
+ * the next object of their kind rather than deleted, so assets streaming
+ * in and out do not churn driver allocations.
+ */
+
+#pragma once
+#include <device.hpp>      // For the Device the objects belong to.
+#include <handle_pool.hpp> // For the generational handles.
+#include <cstdint>         // For the counters.
+#include <deque>           // For the frames waiting on their fence.
+#include <string>          // For the summary.
+#include <vector>          // For the released and recycled names.
+
+
+namespace Renderer
+{
+    /**
+     * @namespace GpuResourceConstants
+     * @brief Contains the limits of the resource pools.
+     */
+    namespace GpuResourceConstants
+    {
+        // The retired names of each kind kept for reuse, the ones beyond
+        // are deleted. A kept name holds its storage until its next owner
+        // specifies new storage.
+        constexpr std::size_t RECYCLED_NAMES = 16;
+    };
+
+    struct TextureTag;
+    struct BufferTag;
+    using TextureHandle = Handle<TextureTag>;
+    using BufferHandle = Handle<BufferTag>;
+
+    /**
+     * @struct GpuResourceStats
+     * @brief The counters of a GpuResources.
+     */
+    struct GpuResourceStats
+    {
+        /** @brief Names created on the device. */
+        std::uint64_t created = 0;
+        /** @brief Objects that got a recycled name. */
+        std::uint64_t reused = 0;
+        /** @brief Names deleted on the device. */
+        std::uint64_t deleted = 0;
+    };
+
+    /**
+     * @class GpuResources
+     * @brief Creates textures and buffers behind generational handles and
+     *        retires them once the GPU is done with them.
+     *
+     * Call collect() at the start of a frame and endFrame() after its last
+     * draw. Objects are created like with Device::createTexture, their
+     * storage and parameters are up to the owner.
+     *
+     * @note Not thread-safe, use it on the thread of its context.
+     */
+    class GpuResources
+    {
+    public:
+        /**
+         * @param device The device the objects are created on.
+         */
+        explicit GpuResources(Device& device);
+
+        /**
+         * @brief Deletes every name, live, pending or recycled, without
+         *        waiting for the GPU.
+         */
+        ~GpuResources();
+
+        // Delete copy constructor and copy assignment operator
+        GpuResources(const GpuResources&) = delete;
+        GpuResources& operator=(const GpuResources&) = delete;
+
+        /**
+         * @brief Creates a texture, on a recycled name if there is one.
+         * @return The handle of the texture.
+         */
+        TextureHandle createTexture();
+
+        /**
+         * @brief Creates a buffer, on a recycled name if there is one.
+         * @return The handle of the buffer.
+         */
+        BufferHandle createBuffer();
+
+        /**
+         * @brief Gets the OpenGL name of a texture.
+         * @throws std::logic_error If the handle was released.
+         */
+        GLuint get(TextureHandle texture) const;
+
+        /**
+         * @brief Gets the OpenGL name of a buffer.
+         * @throws std::logic_error If the handle was released.
+         */
+        GLuint get(BufferHandle buffer) const;
+
+        /**
+         * @brief Releases a texture, its name is retired after the frames
+         *        issued so far.
+         * @throws std::logic_error If the handle was released before.
+         */
+        void release(TextureHandle texture);
+
+        /**
+         * @brief Releases a buffer, its name is retired after the frames
+         *        issued so far.
+         * @throws std::logic_error If the handle was released before.
+         */
+        void release(BufferHandle buffer);
+
+        /**
+         * @brief Places a fence after the frame, if it released anything.
+         */
+        void endFrame();
+
+        /**
+         * @brief Retires the names of the frames whose fence has passed,
+         *        without waiting for the GPU.
+         */
+        void collect();
+
+        /*** @brief Gets the device the objects are created on. */
+        Device& getDevice() const { return device_; }
+
+        /*** @brief Gets the counters. */
+        const GpuResourceStats& getStats() const { return stats_; }
+
+        /**
+         * @brief Gets the live, pending and recycled objects and the
+         *        counters, one line.
+         */
+        std::string getSummary() const;
+
+    private:
+        /**
+         * @enum Kind
+         * @brief The object types of the pools.
+         */
+        enum class Kind : std::uint8_t
+        {
+            TEXTURE = 0,
+            BUFFER,
+        };
+
+        /**
+         * @struct Released
+         * @brief A name whose handle was released.
+         */
+        struct Released
+        {
+            Kind kind;
+            GLuint name;
+        };
+
+        /**
+         * @struct PendingFrame
+         * @brief The names released during a frame, and the fence after it.
+         */
+        struct PendingFrame
+        {
+            GLuint fence;
+            std::vector<Released> names;
+        };
+
+        /** @brief Takes a recycled name of a kind or creates one. */
+        GLuint acquire(Kind kind);
+
+        /** @brief Keeps a name for reuse, or deletes it if enough are. */
+        void retire(const Released& released);
+
+        /** @brief Deletes a name of a kind. */
+        void destroy(Kind kind, GLuint name);
+
+        /** @brief Gets the recycled names of a kind. */
+        std::vector<GLuint>& recycled(Kind kind);
+
+        Device& device_;
+        HandlePool<GLuint, TextureTag> textures_;
+        HandlePool<GLuint, BufferTag> buffers_;
+        // Released since the last endFrame(), not yet behind a fence
+        std::vector<Released> released_;
+        // Oldest first, fences pass in order
+        std::deque<PendingFrame> pending_;
+        // Emptied lists of collected frames, reused by endFrame()
+        std::vector<std::vector<Released>> spareNames_;
+        std::vector<GLuint> recycledTextures_;
+        std::vector<GLuint> recycledBuffers_;
+        GpuResourceStats stats_;
+    };
+}
@@ -0,0 +1,133 @@
+/**
+ * @file grid_scene.hpp
+ * @brief This header file defines the dense grid benchmark scene.
+ *
+ * The grid is a solid block of textured cubes with a camera orbiting
+ * around it. From outside only the cubes on the faces towards the camera
+ * can be seen, so most of the scene is hidden at any time, and as the
+ * camera moves, cubes on the sides that were hidden become visible. All
+ * cubes are instances of one mesh, drawn with a single indirect multi
+ * draw whose commands the OcclusionCuller writes when culling is enabled.
+ */
+
+#pragma once
+#include <occlusion_culling.hpp> // For culling the hidden cubes.
+#include <query_ring.hpp>        // For counting the drawn cubes.
+
+
+namespace Renderer
+{
+    /**
+     * @namespace GridConstants
+     * @brief Contains the layout and camera path of the grid scene.
+     */
+    namespace GridConstants
+    {
+        // The number of cubes along each axis of the block.
+        constexpr int DIMENSION = 24;
+        // The distance of neighbouring cube centers, the cubes touch so the
+        // faces of the block are closed.
+        constexpr float SPACING = 1.0f;
+        // The camera distance from the center in multiples of DIMENSION.
+        constexpr float ORBIT_RADIUS = 1.4f;
+        // The camera height above the center in multiples of DIMENSION.
+        constexpr float ORBIT_HEIGHT = 0.5f;
+        // The orbit speed of the camera in degrees per second.
+        constexpr float ORBIT_SPEED = 12.0f;
+        // The number of primitive queries in flight.
+        constexpr std::size_t PRIMITIVE_QUERIES = 4;
+        // The triangles of one cube, to turn primitives into cubes.
+        constexpr GLuint TRIANGLES_PER_CUBE = Geometry::CUBE_VERTEX_COUNT / 3;
+    };
+
+    /**
+     * @struct CullStats
+     * @brief The number of cubes drawn, measured on the GPU a few frames
+     *        late.
+     */
+    struct CullStats
+    {
+        /** @brief The number of cubes in the scene. */
+        std::uint64_t objects = 0;
+        /** @brief The number of frames measured. */
+        std::uint64_t frames = 0;
+        /** @brief The cubes drawn over all measured frames. */
+        std::uint64_t drawn = 0;
+        /** @brief The cubes drawn by the last measured frame. */
+        std::uint64_t lastDrawn = 0;
+    };
+
+    /**
+     * @class GridScene
+     * @brief Renders the grid of cubes, culling the hidden ones.
+     */
+    class GridScene
+    {
+    public:
+        /**
+         * @brief Uploads the instance data and creates the culler.
+         * @param device The device the scene is drawn on.
+         * @param shaders The scene shaders, the cubes are drawn with their
+         *        instanced permutation.
+         * @param scene Whether hidden cubes are culled, otherwise every
+         *        cube is drawn, and the debug view of the cubes.
+         * @param width The width of the window in pixels.
+         * @param height The height of the window in pixels.
+         * @throws std::runtime_error If a shader fails to compile or link.
+         */
+        GridScene(Device& device, ShaderLibrary& shaders,
+            const SceneSettings& scene, GLsizei width, GLsizei height);
+
+        /** @brief Deletes the vertex array and the buffers. */
+        ~GridScene();
+
+        // Delete copy constructor and copy assignment operator
+        GridScene(const GridScene&) = delete;
+        GridScene& operator=(const GridScene&) = delete;
+
+        /** @brief Resizes the depth target of the occluder pass. */
+        void resize(GLsizei width, GLsizei height);
+
+        /**
+         * @brief Moves the camera and culls the cubes for the frame.
+         *
+         * Call it before the scene's framebuffer is bound, culling renders
+         * into its own target and leaves the window's framebuffer bound.
+         *
+         * @param seconds The time elapsed since the scene started.
+         * @param aspectRatio The width of the viewport divided by its height.
+         */
+        void update(float seconds, float aspectRatio);
+
+        /**
+         * @brief Draws the cubes selected by update() into the bound
+         *        framebuffer.
+         *
+         * The textures the fragment shader mixes are expected on texture
+         * units 0 and 1.
+         */
+        void draw();
+
+        /*** @brief Gets the number of cubes drawn so far. */
+        const CullStats& getStats() const { return stats_; }
+
+        /*** @brief Gets whether hidden cubes are culled. */
+        bool isCulling() const { return culler_ != nullptr; }
+
+    private:
+        Device& device_;
+        ShaderLibrary& shaders_;
+        // The permutation the cubes are drawn with
+        PermutationKey features_;
+        GLuint vertexArray_;
+        GLuint vertexBuffer_;
+        GLuint instanceBuffer_;
+        // Draws every cube, used when culling is disabled
+        GLuint drawAllBuffer_;
+        std::unique_ptr<OcclusionCuller> culler_;
+        QueryRing primitives_;
+        CullStats stats_;
+        glm::mat4 view_;
+        glm::mat4 projection_;
+    };
+}
@@ -0,0 +1,178 @@
+/**
+ * @file handle_pool.hpp
+ * @brief This header file defines typed generational handles and the dense
+ *        pool they index.
+ *
+ * A handle is a slot index and the generation the slot had when the value
+ * was inserted. Removing a value bumps the generation of its slot, so a
+ * handle kept past the removal no longer matches and is caught instead of
+ * reaching whatever value reuses the slot. The tag type keeps handles of
+ * different pools apart at compile time.
+ */
+
+#pragma once
+#include <cstdint>   // For the index and generation of a handle.
+#include <limits>    // For the index of an invalid handle.
+#include <stdexcept> // For std::logic_error on stale handles.
+#include <utility>   // For moving values in and out.
+#include <vector>    // For the dense slots.
+
+
+namespace Renderer
+{
+    /**
+     * @struct Handle
+     * @brief Refers to a value of a HandlePool with the same tag.
+     * @tparam Tag An empty type naming what the handle refers to.
+     */
+    template <typename Tag>
+    struct Handle
+    {
+        static constexpr std::uint32_t INVALID_INDEX =
+            std::numeric_limits<std::uint32_t>::max();
+
+        std::uint32_t index = INVALID_INDEX;
+        std::uint32_t generation = 0;
+
+        /*** @brief Whether the handle was returned by a pool at all. */
+        bool isValid() const { return index != INVALID_INDEX; }
+
+        friend bool operator==(const Handle& lhs, const Handle& rhs)
+        {
+            return lhs.index == rhs.index && lhs.generation == rhs.generation;
+        }
+        friend bool operator!=(const Handle& lhs, const Handle& rhs)
+        {
+            return !(lhs == rhs);
+        }
+    };
+
+    /**
+     * @class HandlePool
+     * @brief Stores values in dense slots and hands out generational handles
+     *        to them.
+     *
+     * Lookups are an index and a compare. The slots of removed values are
+     * reused, newest first, so the storage stays as large as the most
+     * values held at once.
+     *
+     * @tparam T The type of the values.
+     * @tparam Tag The tag of the handles, see Handle.
+     */
+    template <typename T, typename Tag>
+    class HandlePool
+    {
+    public:
+        using HandleType = Handle<Tag>;
+
+        /**
+         * @brief Stores a value.
+         * @return The handle of the value.
+         */
+        HandleType insert(T value)
+        {
+            std::uint32_t index;
+            if (freeSlots_.empty())
+            {
+                index = static_cast<std::uint32_t>(values_.size());
+                values_.push_back(std::move(value));
+                generations_.push_back(0);
+                live_.push_back(true);
+            }
+            else
+            {
+                index = freeSlots_.back();
+                freeSlots_.pop_back();
+                values_[index] = std::move(value);
+                live_[index] = true;
+            }
+            ++size_;
+            return { index, generations_[index] };
+        }
+
+        /**
+         * @brief Checks whether a handle refers to a stored value.
+         * @return False for invalid handles and handles of removed values.
+         */
+        bool contains(HandleType handle) const
+        {
+            return handle.index < values_.size() && live_[handle.index] &&
+                generations_[handle.index] == handle.generation;
+        }
+
+        /**
+         * @brief Gets the value of a handle.
+         * @throws std::logic_error If the handle is invalid or stale.
+         */
+        T& get(HandleType handle)
+        {
+            requireLive(handle);
+            return values_[handle.index];
+        }
+
+        /**
+         * @brief Gets the value of a handle.
+         * @throws std::logic_error If the handle is invalid or stale.
+         */
+        const T& get(HandleType handle) const
+        {
+            requireLive(handle);
+            return values_[handle.index];
+        }
+
+        /**
+         * @brief Removes a value, which makes every copy of its handle
+         *        stale.
+         * @return The removed value.
+         * @throws std::logic_error If the handle is invalid or stale.
+         */
+        T remove(HandleType handle)
+        {
+            requireLive(handle);
+            T value = std::move(values_[handle.index]);
+            ++generations_[handle.index];
+            live_[handle.index] = false;
+            freeSlots_.push_back(handle.index);
+            --size_;
+            return value;
+        }
+
+        /**
+         * @brief Calls a function with every stored value.
+         * @param function Called as function(T&).
+         */
+        template <typename Function>
+        void forEach(Function&& function)
+        {
+            for (std::size_t index = 0; index < values_.size(); ++index)
+            {
+                if (live_[index])
+                {
+                    function(values_[index]);
+                }
+            }
+        }
+
+        /*** @brief Gets the number of stored values. */
+        std::size_t size() const { return size_; }
+
+        /*** @brief Gets the number of slots, stored values or free. */
+        std::size_t getSlotCount() const { return values_.size(); }
+
+    private:
+        void requireLive(HandleType handle) const
+        {
+            if (!contains(handle))
+            {
+                throw std::logic_error("ERROR::HANDLE_POOL::STALE HANDLE");
+            }
+        }
+
+        std::vector<T> values_;
+        std::vector<std::uint32_t> generations_;
+        std::vector<bool> live_;
+        // The slots of removed values, reused last removed first
+        std::vector<std::uint32_t> freeSlots_;
+        std::size_t size_ = 0;
+    };
+}
@@ -0,0 +1,212 @@
+/**
+ * @file image_pipeline.hpp
+ * @brief This header file defines the preparation of decoded images for
+ *        upload: conversion to RGBA8 and a mipmap chain built on the CPU.
+ *
+ * A TextureImage decodes a file, expands it to four channels, optionally
+ * premultiplies the alpha and filters every mipmap level down to 1x1 into
+ * one allocation, so it can be made on a worker thread and uploading it on
+ * the context is a plain copy of each level. RGBA8 rows are always a
+ * multiple of 4 bytes, the default GL_UNPACK_ALIGNMENT, whatever the width.
+ *
+ * The expansion, the premultiplication and the box filter of linear images
+ * have SSE2 kernels where the compiler targets SSE2, with scalar versions
+ * for other targets; both give the same bytes.
+ */
+
+#pragma once
+#include <device.hpp> // For the GL types and formats.
+#include <cstddef>    // For std::size_t.
+#include <cstdint>    // For fixed-width integer types.
+#include <string>     // For image paths.
+#include <vector>     // For the pixels and the levels.
+
+
+namespace Renderer
+{
+    /**
+     * @namespace ImageConstants
+     * @brief Contains the layout and filters of prepared images.
+     */
+    namespace ImageConstants
+    {
+        // The channels of a prepared image, RGBA8.
+        constexpr int CHANNELS = 4;
+        // The source texels of the Kaiser filter along each axis, centered
+        // on the pair a box filter averages.
+        constexpr int KAISER_TAPS = 8;
+        // The shape parameter of the Kaiser window, higher trades
+        // sharpness for less ringing.
+        constexpr float KAISER_BETA = 4.0f;
+        // The entries of the table that encodes linear values to sRGB.
+        constexpr std::size_t SRGB_ENCODE_ENTRIES = 4096;
+    };
+
+    /**
+     * @enum ColorSpace
+     * @brief How the color channels of an image are encoded.
+     */
+    enum class ColorSpace : std::uint8_t
+    {
+        LINEAR, ///< Filtered as stored, sampled through GL_RGBA8
+        SRGB    ///< Filtered in linear light, sampled through GL_SRGB8_ALPHA8
+    };
+
+    /**
+     * @enum MipFilter
+     * @brief The filter each mipmap level is reduced with.
+     */
+    enum class MipFilter : std::uint8_t
+    {
+        BOX,   ///< The average of 2x2 texels, like glGenerateMipmap
+        KAISER ///< A Kaiser-windowed sinc, sharper levels with repeat wrapping
+    };
+
+    /**
+     * @struct ImageSettings
+     * @brief How a decoded image is prepared for upload.
+     */
+    struct ImageSettings
+    {
+        /** @brief The encoding of the color channels; alpha is always
+         *         linear. */
+        ColorSpace colorSpace = ColorSpace::LINEAR;
+        /** @brief Whether the color channels are multiplied by alpha
+         *         before the levels are filtered, in the encoded values. */
+        bool premultiplyAlpha = false;
+        /** @brief The filter of the mipmap levels. */
+        MipFilter mipFilter = MipFilter::BOX;
+        /** @brief Whether the SSE2 kernels are used where they are
+         *         compiled in, off to measure the scalar ones. */
+        bool simd = true;
+    };
+
+    /**
+     * @struct ImageTimings
+     * @brief The CPU time of the stages that prepared an image.
+     */
+    struct ImageTimings
+    {
+        /** @brief Reading and decoding the file, 0 for pixels in memory. */
+        double decodeMs = 0.0;
+        /** @brief The expansion to RGBA8 and the premultiplication. */
+        double convertMs = 0.0;
+        /** @brief Filtering the mipmap levels below the base. */
+        double mipMs = 0.0;
+    };
+
+    /**
+     * @class TextureImage
+     * @brief An RGBA8 image with its full mipmap chain, ready for upload.
+     *
+     * @note The levels are accounted for as MemoryCategory::IMAGE while the
+     *       image exists.
+     */
+    class TextureImage
+    {
+    public:
+        /**
+         * @brief Decodes an image file and prepares it.
+         * @param imagePath The file path to the image.
+         * @param settings How the image is converted and filtered.
+         * @throws std::domain_error If the image cannot be read from the
+         *         path.
+         */
+        TextureImage(const std::string& imagePath,
+            const ImageSettings& settings);
+
+        /**
+         * @brief Prepares decoded pixels.
+         * @param pixels The rows of the image, tightly packed.
+         * @param width The width of the image in pixels.
+         * @param height The height of the image in pixels.
+         * @param channels The channels of a pixel: grey, grey and alpha,
+         *        RGB or RGBA.
+         * @param settings How the image is converted and filtered.
+         * @throws std::domain_error If the size or the channel count is not
+         *         supported.
+         */
+        TextureImage(const unsigned char* pixels, int width, int height,
+            int channels, const ImageSettings& settings);
+
+        /**
+         * @brief Takes over the levels of another image, which is left
+         *        without any.
+         */
+        TextureImage(TextureImage&& other) noexcept;
+        ~TextureImage();
+
+        // Delete copy constructor and assignment operators
+        TextureImage(const TextureImage&) = delete;
+        TextureImage& operator=(const TextureImage&) = delete;
+        TextureImage& operator=(TextureImage&&) = delete;
+
+        /*** @brief Gets the width of the base level in pixels. */
+        int getWidth() const { return levels_.front().width; }
+        /*** @brief Gets the height of the base level in pixels. */
+        int getHeight() const { return levels_.front().height; }
+        /*** @brief Gets the number of levels, down to 1x1. */
+        int getLevelCount() const { return static_cast<int>(levels_.size()); }
+        /*** @brief Gets the width of a level in pixels. */
+        int getLevelWidth(int level) const { return levels_[level].width; }
+        /*** @brief Gets the height of a level in pixels. */
+        int getLevelHeight(int level) const { return levels_[level].height; }
+        /*** @brief Gets the RGBA8 rows of a level. */
+        const unsigned char* getLevelData(int level) const
+        {
+            return pixels_.data() + levels_[level].offset;
+        }
+        /*** @brief Gets the bytes of every level together. */
+        std::size_t getByteSize() const { return pixels_.size(); }
+        /*** @brief Gets how the image was prepared. */
+        const ImageSettings& getSettings() const { return settings_; }
+        /*** @brief Gets the time each stage took. */
+        const ImageTimings& getTimings() const { return timings_; }
+
+        /**
+         * @brief Gets the internal format the levels are uploaded as,
+         *        GL_SRGB8_ALPHA8 for sRGB images and GL_RGBA8 otherwise.
+         */
+        GLint getInternalFormat() const;
+
+    private:
+        /**
+         * @struct Level
+         * @brief Where a mipmap level lies in the pixels.
+         */
+        struct Level
+        {
+            std::size_t offset;
+            int width;
+            int height;
+        };
+
+        /** @brief Converts the pixels into the base level and filters the
+         *         levels below it. */
+        void prepare(const unsigned char* pixels, int width, int height,
+            int channels);
+
+        ImageSettings settings_;
+        ImageTimings timings_;
+        std::vector<Level> levels_;
+        std::vector<unsigned char> pixels_;
+    };
+
+    /**
+     * @brief Decodes and prepares images concurrently, one task each.
+     * @param imagePaths The files to decode.
+     * @param settings How every image is converted and filtered.
+     * @param workers The threads the images are shared between.
+     * @return The images, in the order of their paths.
+     * @throws std::domain_error If an image cannot be read.
+     */
+    std::vector<TextureImage> decodeTextureImages(
+        const std::vector<std::string>& imagePaths,
+        const ImageSettings& settings, std::size_t workers);
+
+    /**
+     * @brief Tells whether the SSE2 kernels were compiled in, otherwise
+     *        ImageSettings::simd has no effect.
+     */
+    bool hasImageSimd();
+}
@@ -0,0 +1,126 @@
+/**
+ * @file light_scene.hpp
+ * @brief This header file defines the many lights benchmark scene.
+ *
+ * A field of textured cubes of random heights on a ground slab, lit by
+ * thousands of point lights that circle between them, with a camera
+ * orbiting above. The lights are assigned to the clusters of the view on
+ * the GPU every frame, see ClusteredLighting, and the cubes are instances
+ * of one mesh drawn with a single indirect draw.
+ */
+
+#pragma once
+#include <clustered_lighting.hpp> // For lighting the cubes.
+#include <string>                 // For the summary.
+
+
+namespace Renderer
+{
+    /**
+     * @namespace LightSceneConstants
+     * @brief Contains the layout, lights and camera path of the light scene.
+     */
+    namespace LightSceneConstants
+    {
+        // The number of cubes along each side of the field.
+        constexpr int DIMENSION = 64;
+        // The distance of neighbouring cube centers, leaving room between
+        // the cubes for the lights.
+        constexpr float SPACING = 2.0f;
+        // The range of the cube heights.
+        constexpr float MIN_HEIGHT = 0.5f;
+        constexpr float MAX_HEIGHT = 3.0f;
+        // The thickness of the ground slab under the cubes.
+        constexpr float GROUND_THICKNESS = 0.1f;
+        // The range of the heights of the light paths above the ground.
+        constexpr float MIN_LIGHT_HEIGHT = 0.75f;
+        constexpr float MAX_LIGHT_HEIGHT = 4.0f;
+        // The range of the distances the lights reach.
+        constexpr float MIN_LIGHT_RADIUS = 2.0f;
+        constexpr float MAX_LIGHT_RADIUS = 5.0f;
+        // The seed of the cube heights and the lights, so every run
+        // measures the same scene.
+        constexpr unsigned int SEED = 46;
+        // The camera distance from the center and height above it in
+        // multiples of the field size.
+        constexpr float ORBIT_RADIUS = 0.7f;
+        constexpr float ORBIT_HEIGHT = 0.3f;
+        // The orbit speed of the camera in degrees per second.
+        constexpr float ORBIT_SPEED = 8.0f;
+        // The clip planes, which also bound the depth slices of the
+        // clusters.
+        constexpr float NEAR_PLANE = 0.5f;
+        constexpr float FAR_PLANE = 250.0f;
+    };
+
+    /**
+     * @class LightScene
+     * @brief Renders the field of cubes lit by moving point lights.
+     */
+    class LightScene
+    {
+    public:
+        /**
+         * @brief Uploads the instance data and the lights.
+         * @param device The device the scene is drawn on.
+         * @param shaders The scene shaders, the cubes are drawn with their
+         *        instanced, clustered lighting permutation.
+         * @param scene The number of lights and the debug view of the
+         *        cubes.
+         * @param timeShading Whether the drawing of the cubes is timed,
+         *        see ClusteredLighting.
+         * @throws std::invalid_argument If the light count is not supported.
+         * @throws std::runtime_error If a shader fails to compile or link.
+         */
+        LightScene(Device& device, ShaderLibrary& shaders,
+            const SceneSettings& scene, bool timeShading);
+
+        /** @brief Deletes the vertex array and the buffers. */
+        ~LightScene();
+
+        // Delete copy constructor and copy assignment operator
+        LightScene(const LightScene&) = delete;
+        LightScene& operator=(const LightScene&) = delete;
+
+        /**
+         * @brief Moves the camera and the lights for the frame.
+         * @param seconds The time elapsed since the scene started.
+         * @param aspectRatio The width of the viewport divided by its height.
+         */
+        void update(float seconds, float aspectRatio);
+
+        /** @brief Assigns the lights moved by update() to the clusters. */
+        void assignLights();
+
+        /**
+         * @brief Draws the cubes lit by the lights of their clusters into
+         *        the bound framebuffer.
+         *
+         * The textures the fragment shader mixes are expected on texture
+         * units 0 and 1.
+         */
+        void draw();
+
+        /*** @brief Gets the lights and their timings. */
+        const ClusteredLighting& getLighting() const { return *lighting_; }
+
+        /**
+         * @brief Gets the lights, clusters and stage timings, one line.
+         */
+        std::string getSummary() const;
+
+    private:
+        Device& device_;
+        ShaderLibrary& shaders_;
+        // The permutation the cubes are drawn with
+        PermutationKey features_;
+        GLsizei instanceCount_;
+        GLuint vertexArray_;
+        GLuint vertexBuffer_;
+        GLuint instanceBuffer_;
+        GLuint commandBuffer_;
+        std::unique_ptr<ClusteredLighting> lighting_;
+        glm::mat4 view_;
+        glm::mat4 projection_;
+    };
+}
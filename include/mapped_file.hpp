@@ -0,0 +1,83 @@
+/**
+ * @file mapped_file.hpp
+ * @brief This header file defines the read-only memory mapping of a file
+ *        and the hash its contents are identified by.
+ *
+ * A mapped file is paged in by the operating system as it is read, so a
+ * large file is neither copied into a buffer nor read before its bytes are
+ * used. Windows maps files with CreateFileMapping and MapViewOfFile, every
+ * other platform with mmap.
+ */
+
+#pragma once
+#include <cstddef> // For the mapping size.
+#include <cstdint> // For the bytes and the hash.
+#include <string>  // For the file path.
+
+
+namespace Renderer
+{
+    /**
+     * @class MappedFile
+     * @brief Maps a whole file read-only into the address space.
+     *
+     * The mapping stays valid, and the file open, until the object is
+     * destroyed or moved from.
+     */
+    class MappedFile
+    {
+    public:
+        /** @brief Creates an object that maps no file. */
+        MappedFile();
+
+        /**
+         * @brief Maps a file.
+         * @param path The file to map.
+         * @throws std::runtime_error If the file cannot be opened or mapped.
+         */
+        explicit MappedFile(const std::string& path);
+
+        /** @brief Takes over the mapping of another object. */
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        /** @brief Unmaps the file. */
+        ~MappedFile();
+
+        // Delete copy constructor and copy assignment operator
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /*** @brief Gets the first byte, null for an empty or no file. */
+        const std::uint8_t* getData() const { return data_; }
+        /*** @brief Gets the size of the file in bytes. */
+        std::size_t getSize() const { return size_; }
+
+    private:
+        /** @brief Unmaps and closes the file, leaving no mapping. */
+        void close();
+
+        const std::uint8_t* data_;
+        std::size_t size_;
+#ifdef _WIN32
+        // The HANDLEs of the file and its mapping object
+        void* file_;
+        void* mapping_;
+#endif
+    };
+
+    /**
+     * @brief Hashes bytes eight at a time, fast enough to identify files of
+     *        gigabytes at the speed they are read.
+     *
+     * The hash is not cryptographic, it detects changed files, not
+     * malicious ones.
+     *
+     * @param data The bytes.
+     * @param size The number of bytes.
+     * @param seed Chains hashes, pass the hash of what came before.
+     * @return The 64 bit hash.
+     */
+    std::uint64_t hashBytes(const void* data, std::size_t size,
+        std::uint64_t seed = 0);
+}
@@ -0,0 +1,297 @@
+/**
+ * @file memory_tracker.hpp
+ * @brief This header file defines the accounting of the CPU and GPU memory
+ *        the renderer holds.
+ *
+ * CPU allocations are reported by the code that owns them, tagged with a
+ * MemoryCategory. GPU memory is estimated by a MemoryTrackingDevice from
+ * the sizes passed to the device calls that create storage, since OpenGL
+ * has no portable way to query it. Every category keeps its current size
+ * and its high-water mark, the report can be read at any time and written
+ * as JSON.
+ *
+ * @note The counters are atomic, allocations may be reported from any
+ *       thread.
+ */
+
+#pragma once
+#include <device.hpp>   // For the Device interface.
+#include <array>        // For the per-category counters.
+#include <cstdint>      // For fixed-width byte counts.
+#include <memory>       // For owning the wrapped device.
+#include <ostream>      // For writing the JSON report.
+#include <string>       // For the report path.
+#include <unordered_map>// For the storage size of each object.
+#include <vector>       // For the texture levels.
+
+
+namespace Renderer
+{
+    /**
+     * @enum MemoryCategory
+     * @brief Categories of the memory the renderer accounts for.
+     */
+    enum class MemoryCategory : std::uint8_t
+    {
+        IMAGE = 0,        ///< Decoded image pixels on the CPU
+        SHADER_SOURCE,    ///< Shader sources read from disk
+        GEOMETRY,         ///< Vertex data on the CPU before upload
+        CAPTURE,          ///< Frame capture staging memory
+        FRAME_ARENA,      ///< The blocks of the per-frame arenas
+        GPU_BUFFER,       ///< Buffer objects
+        GPU_TEXTURE,      ///< Texture levels
+        GPU_RENDERBUFFER, ///< Renderbuffer storage, all samples
+        GPU_PROGRAM,      ///< Linked programs, estimated from their sources
+        COUNT             ///< The number of categories
+    };
+
+    /**
+     * @brief Gets a printable name for a memory category.
+     * @param category The memory category.
+     * @return The lower-case name of the category.
+     */
+    const char* toString(MemoryCategory category);
+
+    /**
+     * @brief Gets whether a category accounts for GPU memory.
+     * @param category The memory category.
+     * @return True for the GPU_ categories.
+     */
+    bool isGpuMemory(MemoryCategory category);
+
+    /**
+     * @struct MemoryUsage
+     * @brief The bytes held now and at most.
+     */
+    struct MemoryUsage
+    {
+        /** @brief The bytes currently held. */
+        std::uint64_t current = 0;
+        /** @brief The most bytes held at any time. */
+        std::uint64_t peak = 0;
+    };
+
+    /**
+     * @struct MemoryReport
+     * @brief A snapshot of the memory accounting.
+     */
+    struct MemoryReport
+    {
+        /** @brief The usage per MemoryCategory. */
+        std::array<MemoryUsage, static_cast<std::size_t>(
+            MemoryCategory::COUNT)> categories{};
+        /** @brief The usage over all CPU categories. */
+        MemoryUsage cpu;
+        /** @brief The usage over all GPU categories. */
+        MemoryUsage gpu;
+    };
+
+    /**
+     * @brief Accounts for memory taken by a category.
+     * @param category The category of the memory.
+     * @param bytes The number of bytes taken.
+     */
+    void trackAllocation(MemoryCategory category, std::uint64_t bytes);
+
+    /**
+     * @brief Accounts for memory given back by a category.
+     * @param category The category of the memory.
+     * @param bytes The number of bytes given back, at most the bytes the
+     *        category holds.
+     */
+    void trackRelease(MemoryCategory category, std::uint64_t bytes);
+
+    /**
+     * @brief Takes a snapshot of the accounting.
+     * @return The current and peak usage of every category.
+     */
+    MemoryReport getMemoryReport();
+
+    /**
+     * @brief Writes a report as a JSON object.
+     *
+     * The object holds "cpu" and "gpu" totals and a "categories" object
+     * keyed by category name, each with "current" and "peak" byte counts.
+     *
+     * @param stream The stream to write to.
+     * @param report The report to write.
+     */
+    void writeMemoryReport(std::ostream& stream, const MemoryReport& report);
+
+    /**
+     * @brief Writes a snapshot of the accounting to a JSON file.
+     * @param path The path of the file to create.
+     * @throws std::runtime_error If the file cannot be written.
+     */
+    void saveMemoryReport(const std::string& path);
+
+    /**
+     * @class MemoryTrackingDevice
+     * @brief A device that estimates the GPU memory of the objects created
+     *        through it and forwards every call to the wrapped device.
+     *
+     * Buffers count the size of their data store, textures the texels of
+     * every level at the size of their internal format, renderbuffers every
+     * sample and programs the size of the sources attached to them, as
+     * drivers do not report the size of their compiled code.
+     *
+     * @note Objects that are still alive when the device is destroyed stay
+     *       accounted for, so a report written afterwards shows them as
+     *       leaks.
+     */
+    class MemoryTrackingDevice final : public Device
+    {
+    public:
+        /**
+         * @param device The device every call is forwarded to.
+         */
+        explicit MemoryTrackingDevice(std::unique_ptr<Device> device);
+        ~MemoryTrackingDevice() override = default;
+
+        /*** @brief Gets the debug log of the wrapped device. */
+        DebugLog* getDebugLog() const override
+        {
+            return device_->getDebugLog();
+        }
+
+        GLuint createVertexArray() override;
+        void bindVertexArray(GLuint vertexArray) override;
+        void deleteVertexArray(GLuint vertexArray) override;
+        GLuint createBuffer() override;
+        void bindBuffer(GLenum target, GLuint buffer) override;
+        void deleteBuffer(GLuint buffer) override;
+        void bufferData(GLenum target, GLsizeiptr size, const void* data,
+            GLenum usage) override;
+        void vertexAttribPointer(GLuint index, GLint size, GLenum type,
+            GLsizei stride, std::size_t offset) override;
+        void enableVertexAttribArray(GLuint index) override;
+        void vertexAttribDivisor(GLuint index, GLuint divisor) override;
+        void bindBufferBase(GLenum target, GLuint index,
+            GLuint buffer) override;
+
+        GLuint createTexture() override;
+        void activeTexture(GLenum unit) override;
+        void bindTexture(GLenum target, GLuint texture) override;
+        void deleteTexture(GLuint texture) override;
+        void texParameter(GLenum target, GLenum name, GLint value) override;
+        void texImage2D(GLenum target, GLint level, GLint internalFormat,
+            GLsizei width, GLsizei height, GLenum format, GLenum type,
+            const void* pixels) override;
+        void generateMipmap(GLenum target) override;
+        void bindImageTexture(GLuint unit, GLuint texture, GLint level,
+            GLenum access, GLenum format) override;
+
+        GLuint createShader(GLenum type) override;
+        void shaderSource(GLuint shader, const std::string& source) override;
+        void compileShader(GLuint shader) override;
+        bool getCompileStatus(GLuint shader, std::string& infoLog) override;
+        void deleteShader(GLuint shader) override;
+        GLuint createProgram() override;
+        void attachShader(GLuint program, GLuint shader) override;
+        void linkProgram(GLuint program) override;
+        bool getLinkStatus(GLuint program, std::string& infoLog) override;
+        void useProgram(GLuint program) override;
+        void deleteProgram(GLuint program) override;
+
+        GLint getUniformLocation(GLuint program, const char* name) override;
+        void uniform1i(GLint location, GLint value) override;
+        void uniform1f(GLint location, GLfloat value) override;
+        void uniformMatrix4fv(GLint location, const GLfloat* value) override;
+
+        void viewport(GLint x, GLint y, GLsizei width,
+            GLsizei height) override;
+        void enable(GLenum capability) override;
+        void disable(GLenum capability) override;
+        void blendFunc(GLenum sourceFactor, GLenum destFactor) override;
+        void clearColor(GLfloat red, GLfloat green, GLfloat blue,
+            GLfloat alpha) override;
+        void clear(GLbitfield mask) override;
+        void drawArrays(GLenum mode, GLint first, GLsizei count) override;
+        void drawElements(GLenum mode, GLsizei count, GLenum type,
+            std::size_t offset) override;
+        void multiDrawArraysIndirect(GLenum mode, std::size_t offset,
+            GLsizei drawCount, GLsizei stride) override;
+
+        void dispatchCompute(GLuint groupsX, GLuint groupsY,
+            GLuint groupsZ) override;
+        void memoryBarrier(GLbitfield barriers) override;
+
+        GLuint createFramebuffer() override;
+        void bindFramebuffer(GLenum target, GLuint framebuffer) override;
+        void deleteFramebuffer(GLuint framebuffer) override;
+        GLuint createRenderbuffer() override;
+        void bindRenderbuffer(GLuint renderbuffer) override;
+        void deleteRenderbuffer(GLuint renderbuffer) override;
+        void renderbufferStorage(GLsizei samples, GLenum internalFormat,
+            GLsizei width, GLsizei height) override;
+        void framebufferRenderbuffer(GLenum target, GLenum attachment,
+            GLuint renderbuffer) override;
+        void framebufferTexture2D(GLenum target, GLenum attachment,
+            GLuint texture, GLint level) override;
+        GLenum checkFramebufferStatus(GLenum target) override;
+        void blitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1,
+            GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1,
+            GLbitfield mask, GLenum filter) override;
+
+        GLuint createQuery() override;
+        void deleteQuery(GLuint query) override;
+        void beginQuery(GLenum target, GLuint query) override;
+        void endQuery(GLenum target) override;
+        bool getQueryResult(GLuint query, GLuint64& result) override;
+
+        GLuint createFence() override;
+        bool isFenceSignaled(GLuint fence) override;
+        void deleteFence(GLuint fence) override;
+
+    private:
+        /**
+         * @struct TextureRecord
+         * @brief The estimated storage of a texture object.
+         */
+        struct TextureRecord
+        {
+            // The bytes of each level
+            std::vector<std::uint64_t> levels;
+            GLsizei width;
+            GLsizei height;
+            std::size_t texelSize;
+        };
+
+        /**
+         * @brief Gets the buffer bound to a buffer target, or nullptr for
+         *        targets whose bindings are not tracked.
+         */
+        GLuint* boundBuffer(GLenum target);
+
+        /**
+         * @brief Sets the accounted size of an object, releasing the size
+         *        it had before.
+         */
+        static void resize(MemoryCategory category,
+            std::unordered_map<GLuint, std::uint64_t>& sizes, GLuint name,
+            std::uint64_t bytes);
+
+        /** @brief Sets the bytes of one level of a texture. */
+        static void resizeLevel(TextureRecord& record, std::size_t level,
+            std::uint64_t bytes);
+
+        std::unique_ptr<Device> device_;
+
+        GLuint boundArrayBuffer_;
+        GLuint boundElementBuffer_;
+        GLuint boundStorageBuffer_;
+        GLuint boundIndirectBuffer_;
+        // The index of the active texture unit
+        std::size_t activeUnit_;
+        // The texture bound to GL_TEXTURE_2D on each texture unit
+        std::array<GLuint, 32> boundTextures_;
+        GLuint boundRenderbuffer_;
+
+        std::unordered_map<GLuint, std::uint64_t> buffers_;
+        std::unordered_map<GLuint, TextureRecord> textures_;
+        std::unordered_map<GLuint, std::uint64_t> renderbuffers_;
+        // The source size of each shader and the size of each program
+        std::unordered_map<GLuint, std::uint64_t> shaders_;
+        std::unordered_map<GLuint, std::uint64_t> programs_;
+    };
+}
@@ -0,0 +1,281 @@
+/**
+ * @file mesh.hpp
+ * @brief This header file defines the import of OBJ and glTF 2.0 meshes,
+ *        their binary cache and the meshes uploaded from it.
+ *
+ * Parsing a text or JSON mesh of millions of triangles takes longer than
+ * uploading it, so a mesh is converted once: the first load imports the
+ * source and writes a cache file next to it, holding the vertex and index
+ * streams exactly as they are uploaded, the bounds and the submesh ranges.
+ * Later loads map the cache and upload straight from the mapping, without
+ * parsing or copying. A cache records the hash of its source files and is
+ * converted again when they change, or when the cache format changes.
+ *
+ * Vertices are laid out like the cube's, see VerticeDataVector, and indexed
+ * with 32 bit indices. Every OBJ group, object or material and every glTF
+ * primitive becomes a submesh.
+ */
+
+#pragma once
+#include <renderer.hpp>    // For the device and the vertex layout.
+#include <mapped_file.hpp> // For mapping the cache.
+#include <cstdint>         // For the cache fields and indices.
+#include <string>          // For the file paths.
+#include <vector>          // For imported streams.
+
+
+namespace Renderer
+{
+    /**
+     * @namespace MeshConstants
+     * @brief Contains the format of the mesh cache.
+     */
+    namespace MeshConstants
+    {
+        // Bumped whenever the cache layout or the import changes.
+        constexpr std::uint32_t CACHE_VERSION = 1;
+        // Appended to the source path to name its cache.
+        constexpr const char* CACHE_EXTENSION = ".meshcache";
+        // The alignment of every stream in the cache, in bytes.
+        constexpr std::size_t CACHE_ALIGNMENT = 16;
+        // The bytes of one vertex.
+        constexpr std::size_t VERTEX_SIZE =
+            VerticeDataVector::STRIDE * sizeof(float);
+    };
+
+    /**
+     * @struct MeshBounds
+     * @brief The axis-aligned box around the vertices of a mesh.
+     */
+    struct MeshBounds
+    {
+        glm::vec3 min{ 0.0f };
+        glm::vec3 max{ 0.0f };
+    };
+
+    /**
+     * @struct Submesh
+     * @brief A range of the indices of a mesh, drawn with one material.
+     */
+    struct Submesh
+    {
+        std::uint32_t firstIndex = 0;
+        std::uint32_t indexCount = 0;
+    };
+
+    /**
+     * @struct MeshData
+     * @brief An imported mesh on the CPU.
+     */
+    struct MeshData
+    {
+        /** @brief Interleaved vertices, VerticeDataVector::STRIDE floats
+         *         each. */
+        std::vector<float> vertices;
+        /** @brief Three indices per triangle. */
+        std::vector<std::uint32_t> indices;
+        /** @brief The index ranges, in order and covering every index. */
+        std::vector<Submesh> submeshes;
+        MeshBounds bounds;
+    };
+
+    /**
+     * @brief Imports a Wavefront OBJ mesh.
+     *
+     * Reads positions, texture coordinates and faces, which are fanned into
+     * triangles. Vertices sharing a position and texture coordinate are
+     * merged. `o`, `g` and `usemtl` lines start a new submesh; normals and
+     * materials are ignored.
+     *
+     * @param text The contents of the file.
+     * @param size The size of the contents in bytes.
+     * @return The mesh.
+     * @throws std::runtime_error If a face refers to a missing vertex.
+     */
+    MeshData importObj(const char* text, std::size_t size);
+
+    /**
+     * @brief Imports the triangles of a glTF 2.0 model, either a `.gltf`
+     *        file with external or embedded buffers or a binary `.glb`.
+     *
+     * The nodes of the default scene are flattened with their transforms,
+     * every triangle primitive becomes a submesh. Positions and the first
+     * texture coordinates are read, other attributes are ignored.
+     *
+     * @param path The path of the model, external buffers are relative to
+     *        it.
+     * @param data The contents of the file.
+     * @param size The size of the contents in bytes.
+     * @return The mesh.
+     * @throws std::runtime_error If the model is malformed or uses a
+     *         feature that is not supported.
+     */
+    MeshData importGltf(const std::string& path, const std::uint8_t* data,
+        std::size_t size);
+
+    /**
+     * @brief Lists the files a mesh is imported from besides itself: the
+     *        external buffers of a `.gltf` file.
+     * @param path The path of the mesh.
+     * @param data The contents of the file.
+     * @param size The size of the contents in bytes.
+     * @return The paths, empty for other formats.
+     */
+    std::vector<std::string> getMeshDependencies(const std::string& path,
+        const std::uint8_t* data, std::size_t size);
+
+    /**
+     * @brief Writes a mesh cache, through a temporary file that replaces
+     *        the cache once complete.
+     * @param path The cache file.
+     * @param mesh The imported mesh.
+     * @param sourceHash The hash of the source files.
+     * @throws std::runtime_error If the file cannot be written.
+     */
+    void writeMeshCache(const std::string& path, const MeshData& mesh,
+        std::uint64_t sourceHash);
+
+    /**
+     * @struct MeshLoadStats
+     * @brief Where the time of loading a mesh went.
+     */
+    struct MeshLoadStats
+    {
+        /** @brief Whether a valid cache was mapped. */
+        bool cacheHit = false;
+        /** @brief Whether a new cache was written after importing. */
+        bool cacheWritten = false;
+        /** @brief The bytes of the source files. */
+        std::uint64_t sourceBytes = 0;
+        double hashMs = 0.0;
+        double importMs = 0.0;
+        double writeMs = 0.0;
+    };
+
+    /**
+     * @class MeshCache
+     * @brief The streams of a mesh ready for upload: mapped from its cache
+     *        file, or held in memory if no cache could be written.
+     */
+    class MeshCache
+    {
+    public:
+        /**
+         * @brief Loads a mesh through its cache, importing it and writing
+         *        the cache if the cache is missing, stale or corrupt.
+         *
+         * Needs no OpenGL context, so it can run on any thread.
+         *
+         * @param sourcePath The OBJ, glTF or GLB file.
+         * @throws std::runtime_error If the source cannot be read or
+         *         imported.
+         */
+        explicit MeshCache(const std::string& sourcePath);
+
+        /** @brief Unmaps the cache or frees the imported mesh. */
+        ~MeshCache();
+
+        // Delete copy constructor and copy assignment operator
+        MeshCache(const MeshCache&) = delete;
+        MeshCache& operator=(const MeshCache&) = delete;
+
+        /*** @brief Gets the interleaved vertices. */
+        const void* getVertexData() const { return vertices_; }
+        /*** @brief Gets the number of vertices. */
+        std::uint64_t getVertexCount() const { return vertexCount_; }
+        /*** @brief Gets the 32 bit indices. */
+        const void* getIndexData() const { return indices_; }
+        /*** @brief Gets the number of indices. */
+        std::uint64_t getIndexCount() const { return indexCount_; }
+        /*** @brief Gets the index ranges. */
+        const std::vector<Submesh>& getSubmeshes() const { return submeshes_; }
+        /*** @brief Gets the box around the vertices. */
+        const MeshBounds& getBounds() const { return bounds_; }
+        /*** @brief Gets where the time of the load went. */
+        const MeshLoadStats& getStats() const { return stats_; }
+
+    private:
+        /**
+         * @brief Maps a cache file and points the streams into it.
+         * @return False if the file is missing, of another version or
+         *         source, or truncated.
+         */
+        bool map(const std::string& path, std::uint64_t sourceHash);
+
+        /** @brief Points the streams into the imported mesh. */
+        void adopt(MeshData&& mesh);
+
+        MappedFile mapping_;
+        // Holds the mesh if it is not mapped
+        MeshData imported_;
+        const void* vertices_;
+        std::uint64_t vertexCount_;
+        const void* indices_;
+        std::uint64_t indexCount_;
+        std::vector<Submesh> submeshes_;
+        MeshBounds bounds_;
+        MeshLoadStats stats_;
+    };
+
+    /**
+     * @class Mesh
+     * @brief A mesh uploaded into a vertex and an index buffer.
+     */
+    class Mesh
+    {
+    public:
+        /**
+         * @brief Uploads the streams of a cache and sets up a vertex array
+         *        with the cube's attribute layout.
+         * @param resources The pool the buffers are created in.
+         * @param cache The streams, only needed during the upload.
+         */
+        Mesh(GpuResources& resources, const MeshCache& cache);
+
+        /**
+         * @brief Deletes the vertex array and releases the buffers to the
+         *        pool.
+         */
+        ~Mesh();
+
+        // Delete copy constructor and copy assignment operator
+        Mesh(const Mesh&) = delete;
+        Mesh& operator=(const Mesh&) = delete;
+
+        /**
+         * @brief Draws every submesh with the program in use, in one call
+         *        as they are contiguous and share it.
+         */
+        void draw() const;
+
+        /**
+         * @brief Gets the transform that centers the mesh and scales its
+         *        longest side to 1, the size of the cube it replaces.
+         */
+        glm::mat4 getFitTransform() const;
+
+        /*** @brief Gets the number of triangles. */
+        std::uint64_t getTriangleCount() const { return indexCount_ / 3; }
+        /*** @brief Gets the number of vertices. */
+        std::uint64_t getVertexCount() const { return vertexCount_; }
+        /*** @brief Gets the number of submeshes. */
+        std::size_t getSubmeshCount() const { return submeshes_.size(); }
+        /*** @brief Gets where the time of loading the cache went. */
+        const MeshLoadStats& getLoadStats() const { return loadStats_; }
+        /*** @brief Gets the milliseconds the upload took on the CPU. */
+        double getUploadMs() const { return uploadMs_; }
+
+    private:
+        GpuResources& resources_;
+        Device& device_;
+        GLuint vao_;
+        BufferHandle vbo_;
+        BufferHandle ebo_;
+        std::uint64_t vertexCount_;
+        std::uint64_t indexCount_;
+        std::vector<Submesh> submeshes_;
+        MeshBounds bounds_;
+        MeshLoadStats loadStats_;
+        double uploadMs_;
+    };
+}
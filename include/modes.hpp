@@ -0,0 +1,94 @@
+/**
+ * @file modes.hpp
+ * @brief This header file declares the run modes of the application that
+ *        replace the interactive window loop.
+ */
+
+#pragma once
+#include <options.hpp> // For the launch options of a mode.
+
+
+namespace Modes
+{
+    /**
+     * @brief Renders frames headless on a NullDevice and reports the CPU
+     *        cost of building them.
+     *
+     * No window or OpenGL context is created, so the run is deterministic
+     * and works on machines without a GPU or display. For every frame the
+     * calls GL_State issues are validated and counted; the report lists the
+     * CPU time per frame and the calls per frame for each category.
+     *
+     * @param options The launch options, `frames` sets the frame count.
+     * @return The process exit code, nonzero if a call failed validation.
+     */
+    int runNullBenchmark(const Options::LaunchOptions& options);
+
+    /**
+     * @brief Renders the images of a job file offscreen, without a window,
+     *        and reports the images per second.
+     *
+     * Every line of the job file is one image: the scene time in seconds,
+     * the camera yaw, pitch and distance, the size as WIDTHxHEIGHT and the
+     * PNG file to write, for example `1.5 90 20 3 512x512 out/side.png`.
+     * Empty lines and everything after a `#` are ignored.
+     *
+     * The textures are decoded and uploaded once, on a context the render
+     * workers share objects with. Each worker renders on its own offscreen
+     * context and claims the next job as soon as it has issued the last
+     * one, so workers stay busy however the image sizes vary. Frames are
+     * read back into pixel buffers and mapped two jobs later, and the
+     * mapped pixels wait in a bounded queue for encoder threads that write
+     * the PNG files; a full queue holds the workers back instead of
+     * growing.
+     *
+     * @param options The launch options, `batchPath` names the job file and
+     *        `workers` sets the number of render contexts.
+     * @return The process exit code, nonzero if the job file is malformed,
+     *         rendering failed or an image could not be written.
+     */
+    int runBatchRender(const Options::LaunchOptions& options);
+
+    /**
+     * @brief Decodes and prepares images for upload in several ways and
+     *        reports the CPU time of each, without a window.
+     *
+     * The baseline is the decoding the textures had before TextureImage:
+     * one image after the other at their own channel count, leaving the
+     * conversion and the mipmaps to the driver. Against it run the images
+     * prepared one after the other with the scalar and the SSE2 kernels,
+     * and all of them at once on worker threads, with linear and sRGB
+     * colors and box and Kaiser filtered mipmaps. Every way runs a few
+     * rounds and reports its fastest. Last, the kernels alone convert and
+     * filter a large generated image, which must give the same bytes with
+     * both kernels.
+     *
+     * @param options The launch options, `benchmarkImages` names the
+     *        images and `workers` sets the decode threads.
+     * @return The process exit code, nonzero if an image cannot be read or
+     *         the kernels disagree.
+     */
+    int runImageBenchmark(const Options::LaunchOptions& options);
+
+    /**
+     * @brief Renders frames with the software rasterizer at every worker
+     *        count from 1 to N, without a window, and reports the frames
+     *        per second of each and the speedup over one worker.
+     *
+     * Every worker count first renders the same frame, which must come
+     * out identical, as the tiles are rasterized in submission order
+     * whichever worker claims them. Given a reference PNG, that frame is
+     * compared with it: a pixel matches if no color channel differs by
+     * more than 2, and at most 0.1% of the pixels may not match. Without
+     * the file, the frame is written as the reference, so a frame from a
+     * trusted build or from the OpenGL backend can be checked later.
+     *
+     * @param options The launch options, `frames` sets the frames timed
+     *        per worker count, `workers` the largest worker count and
+     *        `softwareReferencePath` the reference image.
+     * @return The process exit code, nonzero if the worker counts
+     *         disagree, the frame differs from the reference or the
+     *         textures or the reference cannot be read.
+     */
+    int runSoftwareBenchmark(const Options::LaunchOptions& options);
+};
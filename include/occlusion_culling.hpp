@@ -0,0 +1,175 @@
+/**
+ * @file occlusion_culling.hpp
+ * @brief This header file defines GPU occlusion culling against a
+ *        hierarchical depth (Hi-Z) pyramid.
+ *
+ * Every frame starts with an occluder pass: the objects that were visible
+ * in the previous frame are drawn depth only, with the matrices of the
+ * current frame. A compute shader reduces that depth buffer into a pyramid
+ * whose texels hold the farthest depth of the area they cover. A second
+ * compute shader then projects the bounding box of every object, reads the
+ * pyramid level at which the box covers at most 2x2 texels and writes an
+ * indirect draw command that draws the object only if its nearest point
+ * is in front of that depth.
+ *
+ * The test is conservative: the occluders are a subset of the scene, so
+ * their depth is never in front of the true depth, and an object that
+ * becomes visible is never hidden by objects that were not drawn. The
+ * visible set of one frame is the occluder set of the next.
+ *
+ * @note Needs compute shaders and indirect draws from OpenGL 4.3.
+ */
+
+#pragma once
+#include <shader_library.hpp> // For the program of the occluder pass.
+#include <array>              // For the pair of command buffers.
+#include <utility>            // For the pyramid level sizes.
+#include <vector>             // For the bounds and pyramid levels.
+
+
+namespace Renderer
+{
+    /**
+     * @namespace OcclusionConstants
+     * @brief Contains the layout shared with the culling shaders.
+     */
+    namespace OcclusionConstants
+    {
+        // The work group size of hiz.comp in each dimension.
+        constexpr GLuint PYRAMID_GROUP_SIZE = 8;
+        // The work group size of cull.comp.
+        constexpr GLuint CULL_GROUP_SIZE = 64;
+        // The storage buffer bindings of cull.comp.
+        constexpr GLuint BOUNDS_BINDING = 0;
+        constexpr GLuint COMMANDS_BINDING = 1;
+        // The image unit hiz.comp writes the pyramid level through.
+        constexpr GLuint PYRAMID_IMAGE_UNIT = 0;
+        // The permutation of the scene shaders the occluders are drawn
+        // with.
+        constexpr PermutationKey OCCLUDER_FEATURES =
+            featureBit(ShaderFeature::INSTANCED) |
+            featureBit(ShaderFeature::DEPTH_ONLY);
+    };
+
+    /**
+     * @struct ObjectBounds
+     * @brief The world space bounding box of an object, laid out like the
+     *        std430 Bounds struct of cull.comp.
+     */
+    struct ObjectBounds
+    {
+        /** @brief The center of the box, w is unused. */
+        glm::vec4 center;
+        /** @brief Half the size of the box on each axis, w is unused. */
+        glm::vec4 extent;
+    };
+
+    /**
+     * @struct DrawCommand
+     * @brief The parameters of one draw of glMultiDrawArraysIndirect.
+     */
+    struct DrawCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint first;
+        GLuint baseInstance;
+    };
+
+    /**
+     * @brief Fills draw commands that draw every object once.
+     * @param objectCount The number of objects.
+     * @param vertexCount The vertex count of the shared mesh.
+     * @return One command per object, object i is instance i.
+     */
+    std::vector<DrawCommand> drawAllCommands(GLsizei objectCount,
+        GLsizei vertexCount);
+
+    /**
+     * @class OcclusionCuller
+     * @brief Decides on the GPU which instances of a mesh are drawn.
+     *
+     * The objects are the instances of a single mesh, object i is drawn by
+     * command i with base instance i.
+     */
+    class OcclusionCuller
+    {
+    public:
+        /**
+         * @brief Creates the programs, buffers, depth target and pyramid.
+         * @param device The device the passes run on.
+         * @param shaders The scene shaders, the occluder pass draws with
+         *        their depth only permutation.
+         * @param bounds The bounding box of every object.
+         * @param vertexCount The vertex count of the shared mesh.
+         * @param width The width of the occluder pass in pixels.
+         * @param height The height of the occluder pass in pixels.
+         * @throws std::runtime_error If a shader fails to compile or link,
+         *         or the depth framebuffer is incomplete.
+         */
+        OcclusionCuller(Device& device, ShaderLibrary& shaders,
+            const std::vector<ObjectBounds>& bounds, GLsizei vertexCount,
+            GLsizei width, GLsizei height);
+
+        /** @brief Deletes the buffers, textures and framebuffer. */
+        ~OcclusionCuller();
+
+        // Delete copy constructor and copy assignment operator
+        OcclusionCuller(const OcclusionCuller&) = delete;
+        OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+        /**
+         * @brief Reallocates the depth target and pyramid for a new size.
+         * @throws std::runtime_error If the depth framebuffer is incomplete.
+         */
+        void resize(GLsizei width, GLsizei height);
+
+        /**
+         * @brief Runs the occluder pass, builds the pyramid and writes the
+         *        draw commands of this frame.
+         *
+         * Leaves the window's framebuffer bound with a viewport of the
+         * occluder pass size. The commands need a GL_COMMAND_BARRIER_BIT
+         * barrier before they are drawn, which the render graph places.
+         *
+         * @param vertexArray The vertex array of the mesh, with the instance
+         *        attributes the occluder program reads.
+         * @param view The view matrix of the frame.
+         * @param projection The projection matrix of the frame.
+         */
+        void cull(GLuint vertexArray, const glm::mat4& view,
+            const glm::mat4& projection);
+
+        /**
+         * @brief Gets the buffer holding the draw commands written by the
+         *        last cull(), to be bound to GL_DRAW_INDIRECT_BUFFER.
+         */
+        GLuint getCommandBuffer() const { return commandBuffers_[current_]; }
+
+    private:
+        /** @brief Allocates the depth target and pyramid at the size. */
+        void allocate();
+
+        /** @brief Reduces the depth target into every pyramid level. */
+        void buildPyramid();
+
+        Device& device_;
+        GLsizei objectCount_;
+        GLsizei vertexCount_;
+        GLsizei width_;
+        GLsizei height_;
+        ShaderLibrary& shaders_;
+        std::unique_ptr<ShaderProgram> pyramidProgram_;
+        std::unique_ptr<ShaderProgram> cullProgram_;
+        GLuint boundsBuffer_;
+        // The commands of the current frame and the previous one, whose
+        // visible objects are the occluders of the current frame
+        std::array<GLuint, 2> commandBuffers_;
+        std::size_t current_;
+        GLuint depthFramebuffer_;
+        GLuint depthTexture_;
+        GLuint pyramidTexture_;
+        // The size of each pyramid level, level 0 is half the depth target
+        std::vector<std::pair<GLsizei, GLsizei>> levelSizes_;
+    };
+}
@@ -0,0 +1,171 @@
+/**
+ * @file options.hpp
+ * @brief This header file defines the command line options of the
+ *        application.
+ *
+ * Options are given as `--name=value` or as a bare `--name` flag.
+ */
+
+#pragma once
+#include <renderer.hpp>        // For the backend types.
+#include <frame_pacer.hpp>     // For the low latency settings.
+#include <stream_protocol.hpp> // For the default stream port.
+#include <string>              // For option names and values.
+#include <vector>              // For the benchmarked images.
+
+
+namespace Options
+{
+    /**
+     * @struct LaunchOptions
+     * @brief The configuration selected on the command line at startup.
+     */
+    struct LaunchOptions
+    {
+        /** @brief The backend that renders the scene (`--backend`). */
+        Renderer::BackendType backend = Renderer::BackendType::OPENGL;
+        /** @brief The number of frames of a headless run (`--frames`). */
+        unsigned int frames = 1000;
+        /** @brief The trace file to record the OpenGL calls into (`--record`),
+         *         empty to not record. */
+        std::string recordPath;
+        /** @brief The number of frames recorded after the setup
+         *         (`--record-frames`). */
+        unsigned int recordFrames = 300;
+        /** @brief The file rendered frames are captured to (`--capture`),
+         *         empty to not capture. */
+        std::string capturePath;
+        /** @brief Dynamic resolution scaling of the OpenGL backends
+         *         (`--dynamic-resolution`, `--min-scale`, `--max-scale`,
+         *         `--target-ms`). */
+        Renderer::ResolutionSettings resolution;
+        /** @brief The scene of the OpenGL backends (`--scene`,
+         *         `--lights`, `--no-occlusion-culling`,
+         *         `--no-material-bake`, `--debug-view`). */
+        Renderer::SceneSettings scene;
+        /** @brief The JSON file the memory report is written to when the
+         *         application ends (`--memory-report`), empty to not write
+         *         it. */
+        std::string memoryReportPath;
+        /** @brief The OpenGL debug messages logged (`--gl-debug*`). */
+        Renderer::DebugLogSettings debugLog;
+        /** @brief Whether frames are only drawn when something changed
+         *         (`--on-demand`). */
+        bool onDemand = false;
+        /** @brief The frame pacing of the window loop (`--low-latency`,
+         *         `--frame-delay`). */
+        Renderer::LatencySettings latency;
+        /** @brief Whether frames are streamed to a remote viewer
+         *         (`--stream`). */
+        bool stream = false;
+        /** @brief The TCP port frames are streamed on (`--stream=port`). */
+        unsigned short streamPort = Renderer::StreamConstants::DEFAULT_PORT;
+        /** @brief The job file rendered offscreen (`--batch`), empty to
+         *         open the window. */
+        std::string batchPath;
+        /** @brief The render contexts of a batch, the decode threads of
+         *         the image benchmark or the most tile workers of the
+         *         software benchmark (`--workers`), 0 for the default. */
+        unsigned int workers = 0;
+        /** @brief Whether image decoding is benchmarked instead of opening
+         *         the window (`--image-benchmark`). */
+        bool imageBenchmark = false;
+        /** @brief The images decoded by the benchmark
+         *         (`--image-benchmark=paths`). */
+        std::vector<std::string> benchmarkImages = {
+            Env::SHELF_TEXTURE_PATH, Env::DUCKY_TEXTURE_PATH };
+        /** @brief Whether the software rasterizer is benchmarked instead
+         *         of opening the window (`--software-benchmark`). */
+        bool softwareBenchmark = false;
+        /** @brief The image its frame is compared with
+         *         (`--software-benchmark=path`), empty to not compare. */
+        std::string softwareReferencePath;
+    };
+
+    /**
+     * @brief Parses the command line arguments into launch options.
+     *
+     * Recognized options:
+     * @note `--backend=opengl|software|null` selects the rendering backend.
+     *       The null backend runs headless without creating a window.
+     * @note `--frames=N` sets the number of frames of a headless run.
+     * @note `--record=path` records the setup and the first frames of the
+     *       OpenGL backend into a trace for `hello_3d_replay`.
+     * @note `--record-frames=N` sets the number of recorded frames.
+     * @note `--capture=path` writes every displayed frame to a Y4M video
+     *       if the path ends in `.y4m`, otherwise to numbered PNG files.
+     * @note `--dynamic-resolution` renders the scene offscreen at a scale
+     *       between `--min-scale=S` and `--max-scale=S` (0 < S <= 1) that
+     *       holds the GPU frame time at `--target-ms=T`.
+     * @note `--scene=cube|grid|lights` selects the scene of the OpenGL
+     *       backends. The grid is a dense block of cubes for benchmarking
+     *       occlusion culling, the lights scene a field of cubes lit by
+     *       moving point lights for benchmarking clustered lighting. Both
+     *       need OpenGL 4.3.
+     * @note `--lights=N` sets the point lights of the lights scene, 4096
+     *       by default and at most 16384.
+     * @note `--mesh=path` draws an OBJ, glTF or GLB mesh in place of the
+     *       cube, through a binary cache written next to it, see
+     *       Renderer::MeshCache.
+     * @note `--no-occlusion-culling` draws every cube of the grid.
+     * @note `--no-material-bake` samples and mixes both textures in every
+     *       fragment instead of sampling their baked mix.
+     * @note `--debug-view=off|texcoords|shelf|overdraw` draws the texture
+     *       coordinates, the shelf texture alone or a heatmap of the
+     *       fragments per pixel instead of the mixed textures, with a
+     *       shader variant compiled for the view.
+     * @note `--pipeline-stats[=path]` measures the scene pass with
+     *       pipeline statistics queries where the driver supports them,
+     *       shows the last frame in the window title and writes every
+     *       frame to the CSV file at path, if given.
+     * @note `--memory-report=path` writes the current and peak CPU and GPU
+     *       memory per category as JSON when the application ends.
+     * @note `--gl-debug=off|high|medium|low|notification` sets the least
+     *       severe OpenGL debug message that is logged, `off` disables
+     *       debug output. Debug builds default to `low`, release builds to
+     *       `off`. G cycles the level while the window runs, unless debug
+     *       output was disabled at startup.
+     * @note `--gl-debug-sources=api,window-system,shader-compiler,
+     *       third-party,application,other` logs only the listed debug
+     *       message sources, all by default.
+     * @note `--gl-debug-rate=N` writes at most N debug lines per second,
+     *       20 by default.
+     * @note `--on-demand` only draws a frame when the scene changed, is
+     *       animating or loading, and waits for events otherwise. Nothing
+     *       is drawn while the window is minimized or in the background.
+     * @note `--low-latency[=N]` waits on a fence before reading the input
+     *       of a frame until at most N frames (default 1, at most 4) are
+     *       queued on the GPU.
+     * @note `--frame-delay` also moves the frame rate limit before the
+     *       input is read, starting each frame as late as its predicted
+     *       cost allows. Implies `--low-latency`.
+     * @note `--stream[=port]` serves the displayed frames over TCP (default
+     *       port 7420) to a `hello_3d_viewer`, which sends its key presses
+     *       back.
+     * @note `--batch=path` renders the images of a job file offscreen
+     *       instead of opening the window, see Modes::runBatchRender().
+     * @note `--workers=N` sets the render contexts of a batch, each core
+     *       left over encodes PNG files, the decode threads of the image
+     *       benchmark or the most tile workers of the software benchmark.
+     * @note `--image-benchmark[=path,path...]` decodes and prepares the
+     *       given images, the textures by default, serially and in
+     *       parallel and compares them with the decoding before
+     *       TextureImage, see Modes::runImageBenchmark().
+     * @note `--software-benchmark[=path]` times the software rasterizer
+     *       at every worker count and compares its frame with the PNG at
+     *       path, see Modes::runSoftwareBenchmark().
+     *
+     * @param argc The number of arguments, including the program name.
+     * @param argv The argument strings.
+     * @return The parsed options, defaults for everything not given.
+     * @throws std::invalid_argument If an option is unknown or malformed,
+     *         the stream port is above 65535, the scale bounds are
+     *         inconsistent, there are too many lights, a scene other than
+     *         the cube is selected for the software backend, a batch is
+     *         given another backend or scene than the OpenGL cube, a mesh
+     *         is given anything but the cube scene of a window,
+     *         diagnostics are asked of the software backend or a batch, or
+     *         the overdraw view of dynamic resolution.
+     */
+    LaunchOptions parseArguments(int argc, char* argv[]);
+};
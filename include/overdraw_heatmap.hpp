@@ -0,0 +1,87 @@
+/**
+ * @file overdraw_heatmap.hpp
+ * @brief This header file defines the overdraw view, which shows how many
+ *        fragments every pixel of the scene is shaded with.
+ *
+ * The scene is drawn into a float counter target of the render graph with
+ * additive blending and the OVERDRAW_VIEW shader variant, which outputs 1
+ * per fragment. The depth test is off while counting, so hidden fragments
+ * count as well: the count is the fill-rate cost of a shader that is not
+ * rejected early. The counts are then false-colored into the window.
+ */
+
+#pragma once
+#include <renderer.hpp> // For the heatmap program.
+#include <render_graph.hpp> // For the description of the counter target.
+
+
+namespace Renderer
+{
+    /**
+     * @namespace OverdrawConstants
+     * @brief Contains the formats and the scale of the overdraw view.
+     */
+    namespace OverdrawConstants
+    {
+        // The format of the counts, blendable and exact far beyond any
+        // plausible overdraw.
+        constexpr GLint COUNT_FORMAT = GL_R32F;
+        // The number of fragments per pixel shown red.
+        constexpr float DEFAULT_MAX_LAYERS = 8.0f;
+    };
+
+    /**
+     * @class OverdrawHeatmap
+     * @brief Counts the fragments of the scene per pixel and draws the
+     *        counts as a heatmap.
+     */
+    class OverdrawHeatmap
+    {
+    public:
+        /**
+         * @brief Creates the heatmap program.
+         * @param device The device the counts are rendered on.
+         * @param maxLayers The number of fragments per pixel shown red.
+         * @throws std::runtime_error If the heatmap shaders fail to compile
+         *         or link.
+         */
+        explicit OverdrawHeatmap(Device& device,
+            float maxLayers = OverdrawConstants::DEFAULT_MAX_LAYERS);
+
+        /** @brief Deletes the vertex array. */
+        ~OverdrawHeatmap();
+
+        // Delete copy constructor and copy assignment operator
+        OverdrawHeatmap(const OverdrawHeatmap&) = delete;
+        OverdrawHeatmap& operator=(const OverdrawHeatmap&) = delete;
+
+        /**
+         * @brief Describes the counter target of a window size.
+         */
+        static TargetDesc getTargetDesc(GLsizei width, GLsizei height);
+
+        /**
+         * @brief Clears the bound counter target, and switches to additive
+         *        blending without depth test for the scene.
+         */
+        void begin();
+
+        /** @brief Stops blending after the scene. */
+        void end();
+
+        /**
+         * @brief Draws the counts into the window's framebuffer, which is
+         *        left bound, and restores the depth test.
+         * @param counts The counter target the scene was drawn into.
+         */
+        void draw(GLuint counts);
+
+    private:
+        Device& device_;
+        std::unique_ptr<ShaderProgram> program_;
+        // The heatmap draw has no attributes, but a vertex array must be
+        // bound
+        GLuint vertexArray_;
+        float maxLayers_;
+    };
+}
@@ -0,0 +1,190 @@
+/**
+ * @file pipeline_stats.hpp
+ * @brief This header file defines the measurement of the work a pass gives
+ *        each stage of the pipeline, with the queries of
+ *        ARB_pipeline_statistics_query (core in OpenGL 4.6).
+ *
+ * The counters show where a frame's GPU time can go: how many vertices are
+ * fetched and shaded, how many primitives survive clipping and how many
+ * fragments are shaded. Fragment invocations per pixel above one are
+ * overdraw, which OverdrawHeatmap shows per pixel.
+ */
+
+#pragma once
+#include <device.hpp>   // For the Device the queries are issued on.
+#include <array>        // For the counters of a sample.
+#include <fstream>      // For the per-frame CSV file.
+#include <optional>     // For results that are not yet available.
+#include <string>       // For the summaries.
+#include <vector>       // For the ring of query sets.
+
+
+namespace Renderer
+{
+    /**
+     * @namespace PipelineStatsConstants
+     * @brief Contains the defaults of pipeline statistics.
+     */
+    namespace PipelineStatsConstants
+    {
+        // The passes measured in flight, the GPU runs this many frames
+        // behind at most before a frame is skipped.
+        constexpr std::size_t RING_SIZE = 4;
+    };
+
+    /**
+     * @enum PipelineStat
+     * @brief The counters of a pipeline statistics sample.
+     */
+    enum class PipelineStat : std::uint8_t
+    {
+        VERTICES_SUBMITTED = 0,   ///< Vertices fetched by draws
+        PRIMITIVES_SUBMITTED,     ///< Primitives assembled by draws
+        VERTEX_INVOCATIONS,       ///< Vertex shader runs, after reuse
+        CLIPPING_INPUT,           ///< Primitives entering clipping
+        CLIPPING_OUTPUT,          ///< Primitives leaving clipping
+        FRAGMENT_INVOCATIONS,     ///< Fragment shader runs
+        COUNT,                    ///< The number of counters
+    };
+
+    /**
+     * @brief Gets the column name of a counter.
+     * @param stat The counter.
+     * @return The lower-case name, e.g. `fragment_invocations`.
+     */
+    const char* toString(PipelineStat stat);
+
+    /**
+     * @struct PipelineSample
+     * @brief The counters of one measured pass.
+     */
+    struct PipelineSample
+    {
+        /** @brief The number of passes begun before this one, skipped
+         *         ones included. */
+        std::uint64_t index = 0;
+        std::array<GLuint64, static_cast<std::size_t>(PipelineStat::COUNT)>
+            values{};
+
+        /*** @brief Gets a counter. */
+        GLuint64 get(PipelineStat stat) const
+        {
+            return values[static_cast<std::size_t>(stat)];
+        }
+    };
+
+    /**
+     * @class PipelineStatistics
+     * @brief Measures one pass per frame with a query per counter, reading
+     *        the results back a few frames late like QueryRing.
+     *
+     * A set's queries may become available one at a time, so collect()
+     * keeps the results it read and completes the sample on a later call
+     * instead of waiting for the GPU.
+     */
+    class PipelineStatistics
+    {
+    public:
+        /**
+         * @brief Creates the queries.
+         * @param device The device the queries are issued on. It must
+         *        support the pipeline statistics query targets.
+         * @param size The number of passes in flight.
+         */
+        explicit PipelineStatistics(Device& device,
+            std::size_t size = PipelineStatsConstants::RING_SIZE);
+
+        /** @brief Ends a pass still being measured and deletes the queries. */
+        ~PipelineStatistics();
+
+        // Delete copy constructor and copy assignment operator
+        PipelineStatistics(const PipelineStatistics&) = delete;
+        PipelineStatistics& operator=(const PipelineStatistics&) = delete;
+
+        /** @brief Starts measuring a pass, if a query set is free. */
+        void begin();
+
+        /** @brief Stops measuring the pass started by begin(). */
+        void end();
+
+        /**
+         * @brief Reads the oldest finished measurement.
+         * @return The sample, or nothing if no pass finished since the
+         *         last call.
+         */
+        std::optional<PipelineSample> collect();
+
+    private:
+        /**
+         * @struct QuerySet
+         * @brief The queries of one pass and the results read so far.
+         */
+        struct QuerySet
+        {
+            std::array<GLuint, static_cast<std::size_t>(PipelineStat::COUNT)>
+                queries{};
+            // Bit i is set once the result of queries[i] was read
+            std::uint32_t collected = 0;
+            PipelineSample sample;
+        };
+
+        Device& device_;
+        std::vector<QuerySet> sets_;
+        // Sets are issued at next_ and read back from oldest_
+        std::size_t next_;
+        std::size_t oldest_;
+        std::size_t pending_;
+        std::uint64_t passes_;
+        bool measuring_;
+    };
+
+    /**
+     * @class PipelineStatsLog
+     * @brief Accumulates the samples of a pass for the summary and the
+     *        overlay, and optionally writes each one to a CSV file.
+     *
+     * The CSV has a header line and one line per sample: the pass index,
+     * every counter, the pixels of the target and the fragment invocations
+     * per pixel.
+     */
+    class PipelineStatsLog
+    {
+    public:
+        /**
+         * @brief Opens the CSV file and writes its header.
+         * @param csvPath The file to write, empty to write none.
+         * @throws std::runtime_error If the file cannot be created.
+         */
+        explicit PipelineStatsLog(const std::string& csvPath);
+
+        /**
+         * @brief Adds a sample.
+         * @param sample The counters of the pass.
+         * @param pixels The pixels of the target the pass drew into.
+         */
+        void add(const PipelineSample& sample, std::uint64_t pixels);
+
+        /*** @brief Gets the number of samples added. */
+        std::uint64_t getSampleCount() const { return samples_; }
+
+        /**
+         * @brief Gets the averages per pass, one line.
+         */
+        std::string getSummary() const;
+
+        /**
+         * @brief Gets the counters of the last sample, short enough for a
+         *        window title.
+         */
+        std::string getOverlayText() const;
+
+    private:
+        std::ofstream csv_;
+        std::uint64_t samples_;
+        std::array<double, static_cast<std::size_t>(PipelineStat::COUNT)>
+            sums_;
+        double fragmentsPerPixelSum_;
+        PipelineSample last_;
+        double lastFragmentsPerPixel_;
+    };
+}
@@ -0,0 +1,62 @@
+/**
+ * @file query_ring.hpp
+ * @brief This header file defines a ring of GPU queries whose results are
+ *        read back a few frames late instead of waiting for the GPU.
+ */
+
+#pragma once
+#include <device.hpp>   // For the Device the queries are issued on.
+#include <optional>     // For results that are not yet available.
+#include <vector>       // For the ring of query objects.
+
+
+namespace Renderer
+{
+    /**
+     * @class QueryRing
+     * @brief Measures one span of GPU work per frame with a ring of
+     *        queries of a single target, never waiting for a result.
+     */
+    class QueryRing
+    {
+    public:
+        /**
+         * @brief Creates the queries.
+         * @param device The device the queries are issued on.
+         * @param target The query target, e.g. GL_TIME_ELAPSED.
+         * @param size The number of queries in flight, the GPU runs this
+         *        many spans behind at most before a span is skipped.
+         */
+        QueryRing(Device& device, GLenum target, std::size_t size);
+
+        /** @brief Ends a span still being measured and deletes the queries. */
+        ~QueryRing();
+
+        // Delete copy constructor and copy assignment operator
+        QueryRing(const QueryRing&) = delete;
+        QueryRing& operator=(const QueryRing&) = delete;
+
+        /** @brief Starts measuring a span, if a query is free. */
+        void begin();
+
+        /** @brief Stops measuring the span started by begin(). */
+        void end();
+
+        /**
+         * @brief Reads the oldest finished measurement.
+         * @return The query result, e.g. nanoseconds for GL_TIME_ELAPSED,
+         *         or nothing if no span finished since the last call.
+         */
+        std::optional<GLuint64> collect();
+
+    private:
+        Device& device_;
+        GLenum target_;
+        std::vector<GLuint> queries_;
+        // Queries are issued at next_ and read back from oldest_
+        std::size_t next_;
+        std::size_t oldest_;
+        std::size_t pending_;
+        bool measuring_;
+    };
+}
@@ -0,0 +1,410 @@
+/**
+ * @file render_graph.hpp
+ * @brief This header file defines the render graph, which runs the passes
+ *        of a frame from the resources they declare.
+ *
+ * Every frame the passes are added again, each with the resources it reads
+ * and writes. Compiling the graph culls the passes whose results nothing
+ * uses, checks that every transient target is written before it is read,
+ * and places memory barriers after image and buffer stores. Transient
+ * targets only live from their first to their last pass, so targets with
+ * the same description whose lifetimes do not overlap share one texture or
+ * renderbuffer.
+ *
+ * @note A target shared this way holds whatever its previous user left in
+ *       it, the first pass writing a transient target must clear it.
+ */
+
+#pragma once
+#include <device.hpp>      // For the Device the targets are created on.
+#include <frame_arena.hpp> // For the declarations of a frame.
+#include <cstdint>    // For the byte counts.
+#include <functional> // For the functions of the passes.
+#include <string>     // For the summary.
+#include <vector>     // For the passes, resources and targets.
+
+
+namespace Renderer
+{
+    /**
+     * @namespace RenderGraphConstants
+     * @brief Contains the limits of the render graph.
+     */
+    namespace RenderGraphConstants
+    {
+        // The frames a target may go unused before it is deleted, so that
+        // a pass skipped for a frame does not reallocate its target.
+        constexpr std::uint64_t IDLE_FRAMES = 2;
+    };
+
+    /**
+     * @enum TargetType
+     * @brief The object a transient target is created as.
+     */
+    enum class TargetType : std::uint8_t
+    {
+        TEXTURE = 0,  ///< Single sampled, can be sampled by later passes
+        RENDERBUFFER, ///< Can be multisampled, only attached or blitted
+    };
+
+    /**
+     * @struct TargetDesc
+     * @brief Describes a transient target; targets with equal descriptions
+     *        may share their storage.
+     */
+    struct TargetDesc
+    {
+        TargetType type = TargetType::TEXTURE;
+        /** @brief The sized internal format, e.g. GL_RGBA8. */
+        GLenum format = GL_RGBA8;
+        GLsizei width = 0;
+        GLsizei height = 0;
+        /** @brief The samples of a renderbuffer, 0 for single sampled. */
+        GLsizei samples = 0;
+
+        friend bool operator==(const TargetDesc& lhs, const TargetDesc& rhs)
+        {
+            return lhs.type == rhs.type && lhs.format == rhs.format &&
+                lhs.width == rhs.width && lhs.height == rhs.height &&
+                lhs.samples == rhs.samples;
+        }
+    };
+
+    /**
+     * @brief Gets the memory a target of a description needs.
+     * @throws std::runtime_error If the format is not supported.
+     */
+    std::uint64_t getTargetBytes(const TargetDesc& desc);
+
+    /**
+     * @enum Access
+     * @brief How a pass uses a resource.
+     */
+    enum class Access : std::uint8_t
+    {
+        ATTACHMENT = 0, ///< Rendered into, or blitted from when read
+        SAMPLED,        ///< Read by texture fetches
+        STORAGE,        ///< Image or buffer loads and stores
+        INDIRECT,       ///< Read as the commands of indirect draws
+    };
+
+    /** @brief Identifies a resource during the frame it was declared. */
+    using ResourceId = std::uint32_t;
+
+    class RenderGraph;
+
+    /**
+     * @class PassBuilder
+     * @brief Declares the resources of the pass just added.
+     */
+    class PassBuilder
+    {
+    public:
+        /**
+         * @brief Declares a resource the pass reads.
+         * @throws std::logic_error If another pass was added since.
+         */
+        PassBuilder& read(ResourceId resource, Access access);
+
+        /**
+         * @brief Declares a resource the pass writes.
+         * @throws std::logic_error If another pass was added since.
+         */
+        PassBuilder& write(ResourceId resource, Access access);
+
+        /**
+         * @brief Keeps the pass even if nothing reads what it writes, for
+         *        passes with effects outside the graph.
+         */
+        PassBuilder& setSideEffect();
+
+    private:
+        friend class RenderGraph;
+        PassBuilder(RenderGraph& graph, std::size_t pass) :
+            graph_{ graph }, pass_{ pass } {}
+
+        RenderGraph& graph_;
+        std::size_t pass_;
+    };
+
+    /**
+     * @class PassContext
+     * @brief Gives a running pass the objects behind its resources.
+     */
+    class PassContext
+    {
+    public:
+        /**
+         * @brief Gets the texture or renderbuffer of a transient target.
+         * @throws std::logic_error If the resource is not a transient
+         *         target of this frame.
+         */
+        GLuint getTarget(ResourceId target) const;
+
+        /**
+         * @brief Gets a framebuffer with the targets the pass writes as
+         *        attachments, 0 if it only writes imported resources.
+         * @throws std::runtime_error If the framebuffer is incomplete.
+         */
+        GLuint getFramebuffer() const;
+
+        /**
+         * @brief Gets a framebuffer with only one target attached, to blit
+         *        from.
+         * @throws std::runtime_error If the framebuffer is incomplete.
+         */
+        GLuint getFramebuffer(ResourceId target) const;
+
+    private:
+        friend class RenderGraph;
+        PassContext(RenderGraph& graph, std::size_t pass) :
+            graph_{ graph }, pass_{ pass } {}
+
+        RenderGraph& graph_;
+        std::size_t pass_;
+    };
+
+    /** @brief Records the commands of a pass. */
+    using PassFunction = std::function<void(const PassContext&)>;
+
+    /**
+     * @struct RenderGraphStats
+     * @brief The counters of the last compiled frame and the peaks over
+     *        all frames.
+     */
+    struct RenderGraphStats
+    {
+        std::uint64_t frames = 0;
+        std::size_t passes = 0;
+        std::size_t culledPasses = 0;
+        std::size_t barriers = 0;
+        /** @brief The transient targets of the passes that ran. */
+        std::size_t targets = 0;
+        /** @brief The textures and renderbuffers backing them. */
+        std::size_t physicalTargets = 0;
+        /** @brief The memory of the targets, each with its own storage. */
+        std::uint64_t transientBytes = 0;
+        /** @brief The memory of the targets backing them. */
+        std::uint64_t aliasedBytes = 0;
+        std::uint64_t peakTransientBytes = 0;
+        std::uint64_t peakAliasedBytes = 0;
+    };
+
+    /**
+     * @class RenderGraph
+     * @brief Culls, orders and runs the passes of a frame and allocates
+     *        their transient targets.
+     *
+     * Passes run in the order they are added, so a pass must be added
+     * after the passes writing what it reads. Resources imported into the
+     * graph live outside of it, and the passes writing an imported output,
+     * like the window's framebuffer, are the ones every other pass is kept
+     * for. The declarations of a frame live in the frame arena, and the
+     * objects behind them are reused from frame to frame, so a frame that
+     * declares what the last one did allocates nothing.
+     *
+     * @note Not thread-safe, use it on the thread of its context.
+     */
+    class RenderGraph
+    {
+    public:
+        /**
+         * @param device The device the targets are created on.
+         * @param arena The arena the declarations are kept in, it must not
+         *        be reset between declaring a frame and running it.
+         */
+        RenderGraph(Device& device, FrameArena& arena);
+
+        /** @brief Deletes the targets and framebuffers. */
+        ~RenderGraph();
+
+        // Delete copy constructor and copy assignment operator
+        RenderGraph(const RenderGraph&) = delete;
+        RenderGraph& operator=(const RenderGraph&) = delete;
+
+        /**
+         * @brief Declares a target that only lives during the frame.
+         * @param name The name in error messages, must outlive the frame.
+         * @param desc The description of the target.
+         * @return The resource of the target.
+         */
+        ResourceId createTarget(const char* name, const TargetDesc& desc);
+
+        /**
+         * @brief Declares a resource that lives outside of the graph.
+         * @param name The name in error messages, must outlive the frame.
+         * @param output Whether the resource is a result of the frame, so
+         *        the passes writing it are never culled.
+         * @return The resource.
+         */
+        ResourceId importResource(const char* name, bool output = false);
+
+        /**
+         * @brief Adds a pass, whose resources are declared on the returned
+         *        builder before the next pass is added.
+         * @param name The name in error messages, must outlive the frame.
+         * @param execute Records the commands of the pass.
+         */
+        PassBuilder addPass(const char* name, PassFunction execute);
+
+        /**
+         * @brief Compiles and runs the passes declared since the last call,
+         *        then forgets them.
+         * @throws std::runtime_error If a transient target is read before
+         *         it is written, or a pass writes two color or two depth
+         *         targets.
+         */
+        void execute();
+
+        /**
+         * @brief Creates the targets and framebuffers of the passes
+         *        declared since the last call without running them, then
+         *        forgets them.
+         *
+         * Lets the objects of a frame be created during the setup, so a
+         * frame that declares the same passes later creates nothing.
+         *
+         * @throws std::runtime_error In the cases execute() throws.
+         */
+        void prepare();
+
+        /*** @brief Gets the counters. */
+        const RenderGraphStats& getStats() const { return stats_; }
+
+        /**
+         * @brief Gets the passes and the transient memory, one line.
+         */
+        std::string getSummary() const;
+
+    private:
+        friend class PassBuilder;
+        friend class PassContext;
+
+        // Marks a resource without a target
+        static constexpr std::size_t NO_TARGET = static_cast<std::size_t>(-1);
+
+        /**
+         * @struct Resource
+         * @brief A declared resource and the target it got.
+         */
+        struct Resource
+        {
+            const char* name;
+            bool imported;
+            bool output;
+            TargetDesc desc;
+            // Whether a pass that runs uses the resource, and the first and
+            // last such pass
+            bool used;
+            std::size_t firstPass;
+            std::size_t lastPass;
+            // The index in targets_, NO_TARGET if none
+            std::size_t target;
+        };
+
+        /**
+         * @struct Use
+         * @brief A resource a pass reads or writes.
+         */
+        struct Use
+        {
+            ResourceId resource;
+            Access access;
+            bool write;
+        };
+
+        /**
+         * @struct Pass
+         * @brief A declared pass.
+         */
+        struct Pass
+        {
+            const char* name;
+            PassFunction execute;
+            // The range of the pass's uses in uses_
+            std::size_t firstUse;
+            std::size_t useCount;
+            bool sideEffect;
+            bool culled;
+            // The barriers issued before the pass runs
+            GLbitfield barriers;
+        };
+
+        /**
+         * @struct Target
+         * @brief A texture or renderbuffer backing transient targets.
+         */
+        struct Target
+        {
+            TargetDesc desc;
+            GLuint name;
+            // The first pass of this frame it is free from
+            std::size_t freeFrom;
+            std::uint64_t lastFrame;
+        };
+
+        /**
+         * @struct Framebuffer
+         * @brief A framebuffer with a set of targets attached.
+         */
+        struct Framebuffer
+        {
+            GLuint color;
+            GLuint depth;
+            GLuint name;
+            std::uint64_t lastFrame;
+        };
+
+        /** @brief Declares a use of the pass being declared. */
+        void addUse(std::size_t pass, ResourceId resource, Access access,
+            bool write);
+
+        /** @brief Culls the passes whose writes are not used. */
+        void cull();
+
+        /**
+         * @brief Checks the order of writes and reads and places the
+         *        barriers.
+         */
+        void schedule();
+
+        /** @brief Assigns a target to every transient resource. */
+        void allocate();
+
+        /** @brief Deletes the targets and framebuffers gone idle. */
+        void releaseIdle();
+
+        /** @brief Forgets the declarations of the frame. */
+        void clear();
+
+        /** @brief Creates a target for a description. */
+        GLuint createTargetObject(const TargetDesc& desc);
+
+        /** @brief Gets the target of a transient resource. */
+        const Target& getTargetOf(ResourceId resource) const;
+
+        /**
+         * @brief Gets or creates the framebuffer with a color and a depth
+         *        target, either may be 0.
+         */
+        GLuint getFramebuffer(GLuint color, GLuint depth);
+
+        /** @brief Gets the framebuffer with the attachments of a pass. */
+        GLuint getPassFramebuffer(std::size_t pass);
+
+        Device& device_;
+        FrameArena& arena_;
+        // The declarations and the scratch of compiling them, dropped at
+        // the end of the frame
+        FrameVector<Resource> resources_;
+        FrameVector<Use> uses_;
+        FrameVector<Pass> passes_;
+        std::vector<bool, ArenaAllocator<bool>> required_;
+        FrameVector<GLbitfield> pendingBarriers_;
+        FrameVector<ResourceId> byFirstPass_;
+        // The objects behind the targets, kept from frame to frame
+        std::vector<Target> targets_;
+        std::vector<Framebuffer> framebuffers_;
+        RenderGraphStats stats_;
+    };
+}
@@ -14,6 +14,14 @@
 
 #pragma once
 #include <window.hpp>  // For window attribute constants.
+#include <device.hpp>  // For the Device every OpenGL call goes through.
+#include <gpu_resources.hpp> // For the deferred deletion of textures.
+#include <memory_tracker.hpp> // For accounting the memory of resources.
+#include <frame_arena.hpp> // For the transient data of a frame.
+#include <task_graph.hpp> // For running the startup in parallel.
+#include <dynamic_resolution.hpp> // For rendering at a scaled resolution.
+#include <render_graph.hpp> // For the passes of a frame.
+#include <image_pipeline.hpp> // For images prepared off the context.
 #include <vector>      // For using std::vector to store vertex and index data.
 #include <stdexcept>   // For throwing exceptions like runtime_error.
 #include <fstream>     // For reading shader source files.
@@ -22,6 +30,7 @@
 #include <string>      // For handling std::string operations.
 #include <stb_image.h> // For loading image files into memory for textures.
 #include <array>       // For using std::array for fixed-size arrays.
+#include <cstdint>     // For fixed-width integer types.
 #include <glm/glm.hpp> // OpenGL Mathematics library
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -32,6 +41,17 @@ namespace Env
 {
     constexpr const char* VERTEX_SHADER_PATH = "../../../shaders/shader.vs";
     constexpr const char* FRAG_SHADER_PATH = "../../../shaders/shader.fs";
+    constexpr const char* BAKE_VERTEX_SHADER_PATH = "../../../shaders/bake.vs";
+    constexpr const char* BAKE_FRAG_SHADER_PATH = "../../../shaders/bake.fs";
+    constexpr const char* HEATMAP_FRAG_SHADER_PATH =
+        "../../../shaders/heatmap.fs";
+    constexpr const char* HIZ_COMPUTE_SHADER_PATH = "../../../shaders/hiz.comp";
+    constexpr const char* CULL_COMPUTE_SHADER_PATH =
+        "../../../shaders/cull.comp";
+    constexpr const char* MOVE_LIGHTS_COMPUTE_SHADER_PATH =
+        "../../../shaders/move_lights.comp";
+    constexpr const char* ASSIGN_LIGHTS_COMPUTE_SHADER_PATH =
+        "../../../shaders/assign_lights.comp";
     constexpr const char* SHELF_TEXTURE_PATH = "../../../resources/metal.jpg";
     constexpr const char* DUCKY_TEXTURE_PATH = "../../../resources/rubber-ducky.png";
 };
@@ -57,6 +77,69 @@ namespace VerticeDataVector
 };
 
 
+/**
+ * @namespace Geometry
+ * @brief Static mesh data shared by every rendering backend.
+ **/
+namespace Geometry
+{
+    // The number of vertices in the cube mesh.
+    constexpr GLsizei CUBE_VERTEX_COUNT = 36;
+
+    /**
+     * @brief Interleaved vertex data for a textured unit cube.
+     *
+     * Each vertex is laid out as described by VerticeDataVector:
+     * - 3 floats for position (x, y, z)
+     * - 2 floats for texture coordinates (u, v)
+     */
+    constexpr std::array<float, CUBE_VERTEX_COUNT * VerticeDataVector::STRIDE>
+        CUBE_VERTICES =
+    {
+        -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
+        0.5f, -0.5f, -0.5f, 1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+        0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+       -0.5f,  0.5f, -0.5f, 0.0f, 1.0f,
+       -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
+
+       -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
+        0.5f, -0.5f,  0.5f, 1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f, 1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f, 1.0f, 1.0f,
+       -0.5f,  0.5f,  0.5f, 0.0f, 1.0f,
+       -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
+
+       -0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+       -0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+       -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+       -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+       -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
+       -0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+
+        0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+        0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+        0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+        0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
+        0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+
+       -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+        0.5f, -0.5f, -0.5f, 1.0f, 1.0f,
+        0.5f, -0.5f,  0.5f, 1.0f, 0.0f,
+        0.5f, -0.5f,  0.5f, 1.0f, 0.0f,
+       -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
+       -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
+
+       -0.5f,  0.5f, -0.5f, 0.0f, 1.0f,
+        0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
+        0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+        0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
+       -0.5f,  0.5f,  0.5f, 0.0f, 0.0f,
+       -0.5f,  0.5f, -0.5f, 0.0f, 1.0f
+    };
+};
+
 /**
  * @enum VSLocation
  * @brief Enum class for location attributes in vertex shader
@@ -111,6 +194,9 @@ namespace Renderer
      * This class provides functionality to read an image from a specified file 
      * path and store its data along with metadata such as width, height, 
      * and number of channels.
+     *
+     * @note The pixels are accounted for as MemoryCategory::IMAGE until
+     *       they are released.
      * */
 
     class Image 
@@ -121,13 +207,43 @@ namespace Renderer
          * @throws std::domain_error If the image cannot be read from the path.
          */
         explicit Image(const std::string& imagePath);
+
+        /**
+         * @brief Takes over the pixels of another image, which is left
+         *        without data.
+         */
+        Image(Image&& other) noexcept;
         virtual ~Image();
 
         // Delete copy constructor and copy assignment operator
         Image(const Image&) = delete;
         Image& operator=(const Image&) = delete;
+        Image& operator=(Image&&) = delete;
+
+        /*** @brief Gets the width of the image in pixels. */
+        int getWidth() const { return imgWidth_; }
+        /*** @brief Gets the height of the image in pixels. */
+        int getHeight() const { return imgHeight_; }
+        /*** @brief Gets the number of color channels in the image. */
+        int getNumberOfChannels() const { return imgNumberOfChannels_; }
+        /*** @brief Gets a read-only pointer to the raw image data, null once
+         *         it was released. */
+        const unsigned char* getData() const { return img_; }
 
     protected:
+        /**
+         * @brief Describes an image whose pixels are held elsewhere.
+         * @param width The width of the image in pixels.
+         * @param height The height of the image in pixels.
+         * @param channels The number of color channels.
+         */
+        Image(int width, int height, int channels);
+
+        /**
+         * @brief Frees the pixels, keeping the size and channel count.
+         */
+        void releaseData();
+
 
         /*** @brief The width of the image in pixels.*/
         int imgWidth_;
@@ -157,22 +273,58 @@ namespace Renderer
          * 
          * This constructor takes the path to an image file, loads the image data,
          * and creates an OpenGL texture. It sets texture parameters for wrapping
-         * and filtering, uploads the texture data to the GPU, and generates mipmaps.
+         * and filtering, and uploads the texture data and its mipmaps to the
+         * GPU.
          * 
+         * @param resources The pool the texture is created in.
          * @param imagePath The file path to the image to be loaded as a texture.
          * 
          * @note OpenGL operations performed:
-         * @note - Generates a texture ID using glGenTextures.
+         * @note - Takes a texture ID from the pool, which generates one
+         *         using glGenTextures if it has none to reuse.
          * @note - Binds the texture to the GL_TEXTURE_2D target.
          * @note - Sets texture wrapping parameters (GL_REPEAT for both S and 
          *                                           T axes).
-         * @note - Sets texture filtering parameters (GL_LINEAR_MIPMAP_LINEAR 
-         * for minification, GL_LINEAR for magnification).
-         * @note - Uploads the image data to the GPU using glTexImage2D.
-         * @note - Generates mipmaps for the texture using glGenerateMipmap.
+         * @note - Sets texture filtering parameters
+         *         (GL_NEAREST_MIPMAP_NEAREST for minification, GL_NEAREST
+         *         for magnification).
+         * @note - Uploads the RGBA8 image and the mipmaps filtered on the
+         *         CPU, see TextureImage, level by level using glTexImage2D.
+         * @note - Frees the decoded pixels unless keepPixels is set.
+         * 
+         * @param keepPixels Whether the decoded pixels stay available through
+         *        getData() after the upload, for CPU side use.
          */
-        explicit Texture(const std::string& imagePath);
-        virtual ~Texture() override = default;
+        Texture(GpuResources& resources, const std::string& imagePath,
+            bool keepPixels = false);
+
+        /**
+         * @brief Constructs a Texture object from an image decoded before,
+         *        so the decoding can run off the context thread.
+         *
+         * The image is converted to RGBA8 and its mipmaps are filtered on
+         * the calling thread with the default ImageSettings.
+         *
+         * @param resources The pool the texture is created in.
+         * @param image The decoded image, its pixels move into the texture.
+         * @param keepPixels Whether the decoded pixels stay available.
+         */
+        Texture(GpuResources& resources, Image&& image,
+            bool keepPixels = false);
+
+        /**
+         * @brief Constructs a Texture object from an image prepared before,
+         *        uploading every level of its mipmap chain as it is.
+         * @param resources The pool the texture is created in.
+         * @param image The prepared image, which can be released after.
+         */
+        Texture(GpuResources& resources, const TextureImage& image);
+
+        /**
+         * @brief Releases the texture object, which the pool deletes or
+         *        reuses once the GPU finished the frames drawn with it.
+         */
+        ~Texture() override;
 
         // Delete copy constructor and copy assignment operator
         Texture(const Texture&) = delete;
@@ -184,11 +336,40 @@ namespace Renderer
          */
         unsigned int getTexID() const;
 
+        /*** @brief Gets the handle of the texture in its pool. */
+        TextureHandle getHandle() const { return handle_; }
+
     private:
-        /** @brief Unique identifier of the loaded texture. */
-        // ReSharper disable once CppInconsistentNaming
-        unsigned int texID_;
+        /**
+         * @brief Creates the texture object and uploads the levels.
+         * @param image The prepared levels.
+         */
+        void upload(const TextureImage& image);
+
+        /** @brief The pool that owns the texture object. */
+        GpuResources& resources_;
+        /** @brief The handle of the loaded texture in the pool. */
+        TextureHandle handle_;
     };
+    /**
+     * @struct ShaderSource
+     * @brief The GLSL source code of a shader, read ahead of compiling it.
+     */
+    struct ShaderSource
+    {
+        /** @brief The source code. */
+        std::string code;
+    };
+
+    /**
+     * @brief Reads the GLSL source code of a shader, needs no OpenGL
+     *        context so it can run on any thread.
+     * @param sourcePath The location of the GLSL source code.
+     * @return The source code.
+     * @throws std::domain_error When the file cannot be opened.
+     */
+    ShaderSource loadShaderSource(const std::string& sourcePath);
+
     /**
      * @class Shader
      * @brief A class representing a GLSL shader.
@@ -200,17 +381,25 @@ namespace Renderer
     public:
         /**
          * @brief Initializes source data from the provided source code.
+         * @param device The device that creates and compiles the shader.
          * @param sourcePath The location of the GLSL source code for the shader.
          * @return void This function does not return a value.
          * @throw domain_error When file at given source cannot be opened
         */
-        Shader(const std::string& sourcePath);
+        Shader(Device& device, const std::string& sourcePath);
+
+        /**
+         * @brief Initializes source data from source code read before.
+         * @param device The device that creates and compiles the shader.
+         * @param source The GLSL source code for the shader.
+         */
+        Shader(Device& device, ShaderSource source);
 
         /**
-         * @brief Default virtual destructor.
+         * @brief Gives back the accounted memory of the source code.
          * @return void This function does not return a value.
          */
-        virtual ~Shader() = default;
+        virtual ~Shader();
 
         // Delete copy constructor and copy assignment operator.
         Shader(const Shader&) = delete;  
@@ -252,6 +441,12 @@ namespace Renderer
          */
         void compileShader() const;
 
+        /**
+         * @var device_
+         * @brief The device that owns the shader object.
+         */
+        Device& device_;
+
         /**
          * @var shaderSource_
          * @brief Contains the GLSL source code for the shader.
@@ -280,9 +475,20 @@ namespace Renderer
     public:
         /**
          * @brief Constructs a VertexShader object with the given source code.
+         * @param device The device that creates and compiles the shader.
+         * @param sourcePath The location of the GLSL source code.
          * @return void This function does not return a value.
          */
-        VertexShader();
+        explicit VertexShader(Device& device,
+            const std::string& sourcePath = Env::VERTEX_SHADER_PATH);
+
+        /**
+         * @brief Constructs a VertexShader object from source code read
+         *        before.
+         * @param device The device that creates and compiles the shader.
+         * @param source The GLSL source code.
+         */
+        VertexShader(Device& device, ShaderSource source);
 
         /**
          * @fn VertexShader::~VertexShader()
@@ -301,9 +507,20 @@ namespace Renderer
     public:  
        /**  
         * @brief Constructs a FragmentShader object with the given source code.  
+        * @param device The device that creates and compiles the shader.
+        * @param sourcePath The location of the GLSL source code.
         * @return void This function does not return a value.  
         */  
-       FragmentShader();  
+       explicit FragmentShader(Device& device,
+           const std::string& sourcePath = Env::FRAG_SHADER_PATH);
+
+       /**
+        * @brief Constructs a FragmentShader object from source code read
+        *        before.
+        * @param device The device that creates and compiles the shader.
+        * @param source The GLSL source code.
+        */
+       FragmentShader(Device& device, ShaderSource source);
 
        /**  
         * @fn FragmentShader::~FragmentShader()  
@@ -317,6 +534,33 @@ namespace Renderer
        FragmentShader& operator=(const FragmentShader&) = delete;  
     };
 
+    /**
+     * @class ComputeShader
+     * @brief A class representing a compute shader, which needs an
+     *        OpenGL 4.3 context.
+     */
+    class ComputeShader final : public Shader
+    {
+    public:
+        /**
+         * @brief Constructs a ComputeShader object with the given source code.
+         * @param device The device that creates and compiles the shader.
+         * @param sourcePath The location of the GLSL source code.
+         */
+        ComputeShader(Device& device, const std::string& sourcePath);
+        ~ComputeShader() override = default;
+
+        // Delete copy constructor and copy assignment operator
+        ComputeShader(const ComputeShader&) = delete;
+        ComputeShader& operator=(const ComputeShader&) = delete;
+    };
+
+    /**
+     * @brief Identifies a variant of a shader by the features compiled
+     *        into it, one bit per ShaderFeature.
+     */
+    using PermutationKey = std::uint32_t;
+
     class ShaderProgram
     {
     public:
@@ -330,14 +574,32 @@ namespace Renderer
          * with the error log. After successful linking, the shaders are deleted 
          * as they are no longer needed.
          * 
+         * @param device The device that creates and links the program.
          * @param vertexShaderID The ID of the compiled vertex shader.
          * @param fragShaderID The ID of the compiled fragment shader.
          * 
          * @throws std::runtime_error If the shader program linking fails.
          */
-        ShaderProgram(const unsigned int vertexShaderID, 
+        ShaderProgram(Device& device, const unsigned int vertexShaderID, 
                 const unsigned int fragShaderID);
-        ~ShaderProgram() = default;
+
+        /**
+         * @brief Constructs a compute program from a single compute shader,
+         *        which is deleted after linking.
+         * @param device The device that creates and links the program.
+         * @param computeShaderID The ID of the compiled compute shader.
+         * @throws std::runtime_error If the shader program linking fails.
+         */
+        ShaderProgram(Device& device, const unsigned int computeShaderID);
+
+        /**
+         * @brief Deletes the program object.
+         */
+        ~ShaderProgram();
+
+        // Delete copy constructor and copy assignment operator
+        ShaderProgram(const ShaderProgram&) = delete;
+        ShaderProgram& operator=(const ShaderProgram&) = delete;
 
         /**
          * @fn unsigned int ShaderProgram::getProgramID() const
@@ -359,7 +621,9 @@ namespace Renderer
          * 
          * @tparam T The type of the uniform variable (int, float, bool, 
          *           4x4 matrix).
-         * @param name The name of the uniform variable in the shader program.
+         * @param name The name of the uniform variable in the shader program,
+         *        taken as a C string so that literals are not copied into a
+         *        std::string on every call.
          * @param value The value to set for the uniform variable.
          * 
          * @note The shader program must be bound before calling this function.
@@ -368,23 +632,23 @@ namespace Renderer
          *       operation will have no effect.
          */
         template <typename T>
-        void setUniform(const std::string &name, T value) const
+        void setUniform(const char* name, T value) const
         {
-            GLint location = glGetUniformLocation(shaderProgram_, name.c_str());
+            GLint location = device_.getUniformLocation(shaderProgram_, name);
             if constexpr (std::is_same_v<T, bool>)
             {
-                glUniform1i(location, static_cast<int>(value));
+                device_.uniform1i(location, static_cast<int>(value));
             }
             else if constexpr (std::is_same_v<T, int>)
             {
-                glUniform1i(location, value);
+                device_.uniform1i(location, value);
             }
             else if constexpr (std::is_same_v<T, float>)
             {
-                glUniform1f(location, value);
+                device_.uniform1f(location, value);
             }else if constexpr (std::is_same_v<T, glm::mat4>)
             {
-                glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+                device_.uniformMatrix4fv(location, glm::value_ptr(value));
             }
             else
             {
@@ -393,6 +657,7 @@ namespace Renderer
         }
         
     private:
+        Device& device_;
         unsigned int shaderProgram_;
     };
 
@@ -419,19 +684,19 @@ namespace Renderer
          * indices member is defined with values. 
          * It then uploads the provided vertex and index data to the 
          * GPU and configures the vertex attributes.
+         * @param resources The pool the buffers are created in, on the
+         *        device of the vertex array.
          * */
-        BufferSetup();
+        explicit BufferSetup(GpuResources& resources);
 
         /**
-         * @brief Default destructor for the BufferSetup class.
-         * 
-         * This destructor is defined as the default, meaning it will automatically
-         * clean up any resources managed by the BufferSetup class when an
-         * instance of the class is destroyed.
+         * @brief Deletes the vertex array and releases the buffers to the
+         *        pool.
          */
-        ~BufferSetup() = default;
+        ~BufferSetup();
     
         // Delete copy constructor and copy assignment operator.
+        BufferSetup(const BufferSetup&) = delete;
         BufferSetup& operator=(const BufferSetup&) = delete;
 
         /**
@@ -486,20 +751,29 @@ namespace Renderer
          */
         GLuint getEBOId() const
         { 
-            return ebo_; 
+            return ebo_.isValid() ? resources_.get(ebo_) : 0;
         }
     
     private:
+        /**
+         * @brief The pool that owns the buffers.
+         **/
+        GpuResources& resources_;
+        /**
+         * @brief The device of the vertex array.
+         **/
+        Device& device_;
         /**
          * @brief ID created for Vertex Array Object. 
          **/
         GLuint vao_;
         /**
-         * @brief ID created for Element Buffer Object. 
+         * @brief Handle of the Element Buffer Object, invalid without
+         *        indices.
          **/
-        GLuint ebo_;
+        BufferHandle ebo_;
 
-        GLuint vbo_;
+        BufferHandle vbo_;
 
         /**
          * @brief A vector containing vertex data for a textured rectangle.
@@ -507,51 +781,11 @@ namespace Renderer
          * Each vertex is represented by 8 float values:
          * - 3 floats for position (x, y, z)
          * - 2 floats for texture coordinates (u, v)
+         *
+         * The vector is emptied once the data is uploaded.
          */
-        std::vector<float> vertices_ =
-        {
-            -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
-            0.5f, -0.5f, -0.5f, 1.0f, 0.0f,
-            0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
-            0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
-           -0.5f,  0.5f, -0.5f, 0.0f, 1.0f,
-           -0.5f, -0.5f, -0.5f, 0.0f, 0.0f,
-       
-           -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
-            0.5f, -0.5f,  0.5f, 1.0f, 0.0f,
-            0.5f,  0.5f,  0.5f, 1.0f, 1.0f,
-            0.5f,  0.5f,  0.5f, 1.0f, 1.0f,
-           -0.5f,  0.5f,  0.5f, 0.0f, 1.0f,
-           -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
-       
-           -0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
-           -0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
-           -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
-           -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
-           -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
-           -0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
-       
-            0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
-            0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
-            0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
-            0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
-            0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
-            0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
-       
-           -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
-            0.5f, -0.5f, -0.5f, 1.0f, 1.0f,
-            0.5f, -0.5f,  0.5f, 1.0f, 0.0f,
-            0.5f, -0.5f,  0.5f, 1.0f, 0.0f,
-           -0.5f, -0.5f,  0.5f, 0.0f, 0.0f,
-           -0.5f, -0.5f, -0.5f, 0.0f, 1.0f,
-       
-           -0.5f,  0.5f, -0.5f, 0.0f, 1.0f,
-            0.5f,  0.5f, -0.5f, 1.0f, 1.0f,
-            0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
-            0.5f,  0.5f,  0.5f, 1.0f, 0.0f,
-           -0.5f,  0.5f,  0.5f, 0.0f, 0.0f,
-           -0.5f,  0.5f, -0.5f, 0.0f, 1.0f
-        };
+        std::vector<float> vertices_{ Geometry::CUBE_VERTICES.begin(),
+            Geometry::CUBE_VERTICES.end() };
                     //0, 1, 3, // First triangle: top right, bottom right, bottom left
             //1, 2, 3 // Second triangle: bottom right, bottom left, top left
             //0, 3, 5, // Third triangle: top right, top left, top middle
@@ -567,7 +801,231 @@ namespace Renderer
 
     };
 
-    class GL_State final
+    /**
+     * @struct SceneTransforms
+     * @brief The coordinate transformation matrices of a single frame.
+     */
+    struct SceneTransforms
+    {
+        /** @brief Transforms object vertices into world space. */
+        glm::mat4 model;
+        /** @brief Transforms world space into view (camera) space. */
+        glm::mat4 view;
+        /** @brief Transforms view space into clip space. */
+        glm::mat4 projection;
+    };
+
+    /**
+     * @struct CameraPose
+     * @brief Places the camera on a sphere around the cube, the defaults
+     *        are the view of the interactive window.
+     */
+    struct CameraPose
+    {
+        /** @brief The degrees the camera is turned around the cube. */
+        float yawDegrees = 0.0f;
+        /** @brief The degrees the camera looks down onto the cube. */
+        float pitchDegrees = 0.0f;
+        /** @brief The distance from the camera to the cube. */
+        float distance = 3.0f;
+    };
+
+    /**
+     * @brief Computes the transformations of the spinning cube scene.
+     *
+     * Every backend uses this function so that they draw the scene from the
+     * same transforms for the same point in time.
+     *
+     * @param seconds The time elapsed since the scene started.
+     * @param aspectRatio The width of the viewport divided by its height.
+     * @param camera Where the scene is viewed from.
+     * @return The model, view and projection matrices for the frame.
+     */
+    SceneTransforms computeSceneTransforms(float seconds, float aspectRatio,
+        const CameraPose& camera = CameraPose());
+
+    /**
+     * @enum BackendType
+     * @brief Selects the implementation that renders the scene.
+     */
+    enum class BackendType : std::uint8_t
+    {
+        OPENGL = 0,  ///< Hardware rendering through the OpenGL context
+        SOFTWARE,    ///< Tile-based CPU rasterizer, see SoftwareRenderer
+        NULL_DEVICE, ///< GL_State on a NullDevice, no driver is touched
+    };
+
+    /**
+     * @enum SceneType
+     * @brief Selects the scene the OpenGL backends render.
+     */
+    enum class SceneType : std::uint8_t
+    {
+        CUBE = 0, ///< A single spinning cube
+        GRID,     ///< A dense block of cubes, see GridScene
+        LIGHTS,   ///< Cubes lit by many moving lights, see LightScene
+    };
+
+    /**
+     * @enum DebugView
+     * @brief Replaces the shading of the scene to inspect its inputs.
+     */
+    enum class DebugView : std::uint8_t
+    {
+        OFF = 0,   ///< The mix of both textures
+        TEXCOORDS, ///< The texture coordinates as red and green
+        SHELF,     ///< The shelf texture alone
+        OVERDRAW,  ///< The fragments per pixel, see OverdrawHeatmap
+    };
+
+    /**
+     * @struct SceneSettings
+     * @brief The scene of the OpenGL backends and how it is culled.
+     */
+    struct SceneSettings
+    {
+        /** @brief The rendered scene (`--scene`). */
+        SceneType type = SceneType::CUBE;
+        /** @brief Whether hidden objects of the grid are culled on the GPU
+         *         (`--no-occlusion-culling` disables it). */
+        bool occlusionCulling = true;
+        /** @brief What the fragments show (`--debug-view`). */
+        DebugView debugView = DebugView::OFF;
+        /** @brief Whether the mix of the two textures is baked into one
+         *         texture, see BakedMaterial (`--no-material-bake`
+         *         disables it). */
+        bool bakeMaterial = true;
+        /** @brief An OBJ or glTF mesh drawn in place of the cube, empty for
+         *         the cube (`--mesh`), see MeshCache. */
+        std::string meshPath;
+        /** @brief Whether the scene pass is measured with pipeline
+         *         statistics queries, see PipelineStatistics
+         *         (`--pipeline-stats`). */
+        bool pipelineStatistics = false;
+        /** @brief The CSV file every measured frame is written to, empty
+         *         for none (`--pipeline-stats=path`). */
+        std::string statisticsPath;
+        /** @brief The point lights of the light scene (`--lights`). */
+        unsigned int lightCount = 4096;
+    };
+
+    class BakedMaterial;
+    class GridScene;
+    class LightScene;
+    class Mesh;
+    class OverdrawHeatmap;
+    class PipelineStatistics;
+    class PipelineStatsLog;
+    class ShaderLibrary;
+
+    /**
+     * @class RenderState
+     * @brief Common interface of the rendering backends.
+     *
+     * A render state owns every resource needed to draw the scene and is
+     * created once the window (and its OpenGL context) exists.
+     */
+    class RenderState
+    {
+    public:
+        RenderState() = default;
+        virtual ~RenderState() = default;
+
+        // Delete copy constructor and copy assignment operator
+        RenderState(const RenderState&) = delete;
+        RenderState& operator=(const RenderState&) = delete;
+
+        /**
+         * @brief Renders a single frame of the scene.
+         * @param window The window context where to draw.
+         */
+        virtual void draw(const std::unique_ptr<Window>& window) = 0;
+
+        /**
+         * @brief Adapts the rendering to a new window size.
+         * @param width The new width of the window in pixels.
+         * @param height The new height of the window in pixels.
+         */
+        virtual void resize(unsigned int width, unsigned int height) = 0;
+
+        /**
+         * @brief Gets a summary of the measurements taken while rendering,
+         *        printed when the application ends.
+         * @return The summary, one or more lines that each end in a
+         *         newline, empty if the backend measures nothing.
+         */
+        virtual std::string getSummary() const { return std::string(); }
+
+        /**
+         * @brief Gets whether assets are still loading in the background,
+         *        frames drawn meanwhile use placeholders for them.
+         */
+        virtual bool isLoading() const { return false; }
+
+        /**
+         * @brief Pauses or resumes the animation, a paused scene draws the
+         *        same frame until something else changes.
+         */
+        virtual void setAnimationPaused(bool paused) { (void)paused; }
+
+        /*** @brief Gets whether the animation is paused. */
+        virtual bool isAnimationPaused() const { return false; }
+
+        /**
+         * @brief Marks the displayed frame as outdated, for changes the
+         *        state does not see itself, like the window being shown
+         *        again.
+         */
+        virtual void invalidate() {}
+
+        /**
+         * @brief Gets whether draw() would change what is displayed: the
+         *        scene or the window size changed since the last frame, or
+         *        it is animating or loading.
+         * @return True by default, for backends that do not track changes.
+         */
+        virtual bool needsRedraw() const { return true; }
+
+        /**
+         * @brief Gets the debug log of the OpenGL debug output.
+         * @return nullptr by default, for backends without one.
+         */
+        virtual DebugLog* getDebugLog() const { return nullptr; }
+    };
+
+    /**
+     * @struct StartupStats
+     * @brief How long the startup tasks of a GL_State took, counted from
+     *        the moment they started.
+     */
+    struct StartupStats
+    {
+        /** @brief Milliseconds until the first frame could be drawn. */
+        double firstFrameMs = 0.0;
+        /** @brief Milliseconds until every asset was loaded, 0 while
+         *         assets are loading. */
+        double totalMs = 0.0;
+        /** @brief When each startup task ran. */
+        std::vector<TaskTiming> tasks;
+    };
+
+    /**
+     * @brief Creates the render state of the requested backend.
+     * @param backend The backend that renders the scene.
+     * @param resolution The dynamic resolution settings of the OpenGL
+     *        backends, the software backend renders at the window size.
+     * @param scene The scene of the OpenGL backends, the software backend
+     *        always renders the spinning cube.
+     * @param debugLog The debug messages the OpenGL backend logs.
+     * @return The initialized render state.
+     * @throws std::runtime_error If the backend fails to initialize.
+     */
+    std::unique_ptr<RenderState> createRenderState(BackendType backend,
+        const ResolutionSettings& resolution = ResolutionSettings(),
+        const SceneSettings& scene = SceneSettings(),
+        const DebugLogSettings& debugLog = DebugLogSettings());
+
+    class GL_State final : public RenderState
     {
     public:
         /**
@@ -578,21 +1036,32 @@ namespace Renderer
          * @note This constructor performs the following tasks:
          * @note Sets the size of the OpenGL viewport to match the window 
          *       dimensions.
-         * @note Enables OpenGL debug output and sets a callback for error 
-         *       logging.
          * @note Specifies the clear color for the color buffer.
          * @note Enables depth testing.
          * @note Clears the color buffer to apply the specified clear color.
-         * @note Creates and compiles vertex and fragment shaders, and links 
-         *       them into a shader program.
+         * @note Reads the vertex and fragment shaders and links the
+         *       permutation of them the first frame draws.
          * @note Allocates and uploads vertex data to a GPU buffer.
          * @note Loads textures from file paths specified in the environment 
          *       variables.
+         * @note Loads the mesh replacing the cube, if any, which is drawn
+         *       once uploaded.
+         * @note Creates the overdraw heatmap and the pipeline statistics
+         *       queries when they are enabled.
          *
-         * @throws std::runtime_error If shader creation or linking fails.
+         * @param device The device every OpenGL call is issued to. The state
+         *        takes ownership and keeps it alive longer than the
+         *        resources created on it.
+         * @param resolution The dynamic resolution settings, when enabled
+         *        the scene is rendered offscreen and upscaled.
+         * @param scene The scene to render.
+         * @throws std::runtime_error If shader creation or linking fails,
+         *         or the statistics file cannot be created.
          */
-        GL_State();
-        virtual ~GL_State() = default;
+        explicit GL_State(std::unique_ptr<Device> device,
+            const ResolutionSettings& resolution = ResolutionSettings(),
+            const SceneSettings& scene = SceneSettings());
+        ~GL_State() override;
         /**
          * @brief Renders the scene by drawing the configured buffers and 
          *        textures.
@@ -602,19 +1071,165 @@ namespace Renderer
          * It assumes that the OpenGL context is properly initialized and active.
          * @param window The window context where to draw. 
          */
-        void draw(const std::unique_ptr<Window>& window) const;
-        
+        void draw(const std::unique_ptr<Window>& window) override;
+
+        /**
+         * @brief Sets the viewport, projection and offscreen framebuffers
+         *        to a new window size.
+         */
+        void resize(unsigned int width, unsigned int height) override;
+
+        /**
+         * @brief Summarizes the startup tasks, the material bakes, the
+         *        compiled shader variants, the loaded mesh, the pipeline
+         *        statistics, the occlusion culling of the grid scene and
+         *        the lighting timings of the light scene.
+         */
+        std::string getSummary() const override;
+
+        /**
+         * @brief Gets whether the textures are still loading.
+         */
+        bool isLoading() const override { return startup_ != nullptr; }
+
+        /** @brief Stops or restarts the clock of the animation. */
+        void setAnimationPaused(bool paused) override;
+
+        /*** @brief Gets whether the clock of the animation is stopped. */
+        bool isAnimationPaused() const override { return !clock_.isRunning(); }
+
+        /** @brief Forces the next frame to be drawn. */
+        void invalidate() override { dirty_ = true; }
+
+        /**
+         * @brief Gets whether a frame needs drawing: while animating or
+         *        loading, and after a resize or invalidate().
+         */
+        bool needsRedraw() const override;
+
+        /*** @brief Gets the debug log of the device, nullptr if disabled. */
+        DebugLog* getDebugLog() const override
+        {
+            return device_->getDebugLog();
+        }
+
+        /**
+         * @brief Waits until every asset is loaded and creates the
+         *        transient targets of the frames, see RenderGraph::prepare().
+         * @throws std::runtime_error If an asset fails to load.
+         */
+        void finishLoading();
+
+        /**
+         * @brief Gets the startup timings, complete once isLoading()
+         *        returns false.
+         */
+        const StartupStats& getStartupStats() const { return startupStats_; }
+
+        /**
+         * @brief Gets the device the state issues its calls to.
+         * @return The device owned by the state.
+         */
+        Device& getDevice() const { return *device_; }
+
         // Delete copy constructor and copy assignment operator
         GL_State(const GL_State&) = delete;  
         GL_State& operator=(const GL_State&) = delete;  
     
     private:
-        std::unique_ptr<ShaderProgram> shaderProgram_;
+        /**
+         * @struct FrameResources
+         * @brief The resources of the frame being declared and its time,
+         *        read by the passes so they capture nothing but the state.
+         */
+        struct FrameResources
+        {
+            ResourceId window = 0;
+            ResourceId gridCommands = 0;
+            // The lights in view space and the lists of each cluster
+            ResourceId lights = 0;
+            ResourceId lightClusters = 0;
+            ResourceId material = 0;
+            // The window's framebuffer when the scene is drawn into it
+            ResourceId sceneColor = 0;
+            ResourceId sceneDepth = 0;
+            ResourceId resolvedColor = 0;
+            float seconds = 0.0f;
+            float aspectRatio = 1.0f;
+        };
+
+        /** @brief Adds the passes of the frame to the render graph. */
+        void declarePasses();
+
+        /**
+         * @brief Draws the scene into the targets of the scene pass, with
+         *        the textures and the statistics around it.
+         */
+        void drawScene(const PassContext& pass);
+
+        /** @brief Draws the spinning cube with the bound textures. */
+        void drawCube(float seconds, float aspectRatio);
+
+        /**
+         * @brief Points the baked material at the current textures and
+         *        re-bakes it if they changed.
+         */
+        void bakeMaterial();
+
+        /**
+         * @brief Runs the startup tasks that are ready and, once every
+         *        task has finished, records the timings.
+         */
+        void pollStartup();
+
+        /** @brief The files the startup workers read and decode. */
+        struct StartupAssets;
+
+        std::unique_ptr<Device> device_;
+        // Creates the textures and mesh buffers and retires them once the
+        // frames using them are done, declared before its users
+        std::unique_ptr<GpuResources> resources_;
+        // Runs the passes of a frame and owns their transient targets
+        std::unique_ptr<RenderGraph> graph_;
+        FrameResources frame_;
+        // Compiles the variants of the scene shaders as they are drawn
+        std::unique_ptr<ShaderLibrary> shaders_;
+        // The permutation of the cube's program, see ShaderLibrary
+        PermutationKey cubeFeatures_;
         std::unique_ptr<BufferSetup> myBuffer_;
         std::unique_ptr<Texture> shelfTexture_;
         std::unique_ptr<Texture> duckyTexture_;
+        // The mix of both textures, null when the mix is not baked
+        std::unique_ptr<BakedMaterial> material_;
+        // Renders at a scaled resolution, null when disabled
+        std::unique_ptr<DynamicResolution> resolution_;
+        // Replaces the spinning cube when the grid scene is selected
+        std::unique_ptr<GridScene> grid_;
+        // Replaces the spinning cube when the light scene is selected
+        std::unique_ptr<LightScene> lights_;
+        // Replaces the cube once uploaded, null without a mesh
+        std::unique_ptr<Mesh> mesh_;
+        // Counts the fragments of the overdraw view, null for other views
+        std::unique_ptr<OverdrawHeatmap> heatmap_;
+        // Measure the scene pass, null without --pipeline-stats
+        std::unique_ptr<PipelineStatistics> statistics_;
+        std::unique_ptr<PipelineStatsLog> statisticsLog_;
+        // Times the updates of the statistics in the window title
+        sf::Clock overlayClock_;
+        GLsizei width_;
+        GLsizei height_;
         sf::Clock clock_;
-        
+        // Set when the displayed frame is outdated, cleared by draw()
+        bool dirty_;
+        // Holds the render graph's declarations, reset when draw() starts
+        FrameArena frameArena_;
+        // Bound in place of the textures while they load
+        GLuint placeholderTexture_;
+        StartupStats startupStats_;
+        std::unique_ptr<StartupAssets> assets_;
+        // Runs the startup, null once every task has finished. Declared
+        // last so its workers stop before what they write to is destroyed
+        std::unique_ptr<TaskGraph> startup_;
     };
 
 }
@@ -0,0 +1,139 @@
+/**
+ * @file shader_library.hpp
+ * @brief This header file defines the permutations of the scene shaders.
+ *
+ * The scene is drawn with one vertex and one fragment shader whose
+ * features, like instancing or a debug view, are selected with `#ifdef`
+ * blocks. A permutation is a set of features: its defines are inserted
+ * after the `#version` line before the source is compiled, so every
+ * variant only contains the code it runs instead of branching on uniforms.
+ * Variants are compiled the first time they are drawn and cached by their
+ * permutation key.
+ */
+
+#pragma once
+#include <renderer.hpp>  // For the shader sources and programs.
+#include <cstdint>       // For the feature bits.
+#include <memory>        // For owning the programs.
+#include <string>        // For the preambles.
+#include <unordered_map> // For the programs by permutation key.
+
+
+namespace Renderer
+{
+    /**
+     * @enum ShaderFeature
+     * @brief The features a permutation of the scene shaders can enable,
+     *        each one a `#define` of the same name.
+     */
+    enum class ShaderFeature : std::uint8_t
+    {
+        INSTANCED = 0,  ///< The model matrix is a per-instance attribute
+        SINGLE_TEXTURE, ///< Samples texture1 only, without the mix
+        DEPTH_ONLY,     ///< Writes no color, for depth passes
+        TEXCOORD_VIEW,  ///< Shows the texture coordinates as colors
+        OVERDRAW_VIEW,  ///< Counts the fragments, see OverdrawHeatmap
+        CLUSTERED_LIGHTING, ///< Shades with the lights of the fragment's
+                            ///< cluster, see ClusteredLighting
+        COUNT,          ///< The number of features
+    };
+
+    /**
+     * @brief Gets the bit of a feature in a permutation key.
+     */
+    constexpr PermutationKey featureBit(ShaderFeature feature)
+    {
+        return PermutationKey{ 1 } << static_cast<unsigned int>(feature);
+    }
+
+    /**
+     * @brief Gets the name a feature is defined as in the shaders.
+     */
+    const char* toDefine(ShaderFeature feature);
+
+    /**
+     * @brief Gets the features the scene is shaded with: those of the debug
+     *        view, or a single texture when the texture mix is baked.
+     * @return The permutation bits, 0 for the mix of both textures.
+     */
+    PermutationKey materialFeatures(const SceneSettings& scene);
+
+    /**
+     * @brief Inserts the defines of a permutation into a shader source.
+     *
+     * The defines follow the `#version` line, which must come first, and
+     * are followed by a `#line` directive so that compile errors still
+     * name the line numbers of the file. Features that need a newer GLSL
+     * version, like the storage buffers of clustered lighting, raise the
+     * version of the line, so the other variants keep the version of the
+     * source.
+     *
+     * @param source The GLSL source code.
+     * @param features The permutation key.
+     * @return The source code of the variant.
+     * @throws std::invalid_argument If the source has no `#version` line.
+     */
+    std::string injectDefines(const std::string& source,
+        PermutationKey features);
+
+    /**
+     * @struct ShaderLibraryStats
+     * @brief The variants a library has compiled.
+     */
+    struct ShaderLibraryStats
+    {
+        /** @brief The number of programs compiled and linked. */
+        std::size_t variants = 0;
+        /** @brief The milliseconds spent compiling and linking them. */
+        double compileMs = 0.0;
+    };
+
+    /**
+     * @class ShaderLibrary
+     * @brief Compiles and caches the permutations of a vertex and a
+     *        fragment shader.
+     *
+     * Both stages of a variant are compiled with the same defines, each
+     * stage ignores the features it does not use.
+     */
+    class ShaderLibrary
+    {
+    public:
+        /**
+         * @brief Keeps the sources, no variant is compiled yet.
+         * @param device The device that compiles and links the programs.
+         * @param vertexSource The source code of the vertex shader.
+         * @param fragSource The source code of the fragment shader.
+         */
+        ShaderLibrary(Device& device, ShaderSource vertexSource,
+            ShaderSource fragSource);
+
+        /** @brief Deletes every compiled program. */
+        ~ShaderLibrary();
+
+        // Delete copy constructor and copy assignment operator
+        ShaderLibrary(const ShaderLibrary&) = delete;
+        ShaderLibrary& operator=(const ShaderLibrary&) = delete;
+
+        /**
+         * @brief Gets the program of a permutation, compiling it on first
+         *        use.
+         * @param features The permutation key, featureBit()s combined.
+         * @return The program, valid as long as the library.
+         * @throws std::runtime_error If the variant fails to compile or
+         *         link.
+         */
+        const ShaderProgram& get(PermutationKey features);
+
+        /*** @brief Gets the number and compile time of the variants. */
+        const ShaderLibraryStats& getStats() const { return stats_; }
+
+    private:
+        Device& device_;
+        std::string vertexSource_;
+        std::string fragSource_;
+        std::unordered_map<PermutationKey,
+            std::unique_ptr<ShaderProgram>> programs_;
+        ShaderLibraryStats stats_;
+    };
+}
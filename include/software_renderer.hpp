@@ -0,0 +1,345 @@
+/**
+ * @file software_renderer.hpp
+ * @brief This header file defines a CPU rendering backend that mirrors the
+ *        OpenGL pipeline of shader.vs and shader.fs.
+ *
+ * The SoftwareRenderer transforms the cube on the CPU, bins the resulting
+ * triangles into screen tiles and rasterizes the tiles in parallel on one
+ * worker thread per core. Coverage and depth are evaluated four pixels at a
+ * time with SIMD edge functions, and a hierarchical depth buffer rejects
+ * whole pixel blocks that are already covered by nearer geometry. Like the
+ * GPU, the mipmap level is selected per 2x2 pixel quad from the
+ * differences of the texture coordinates across the quad.
+ *
+ * @note The finished frame is presented through SFML, so the window still
+ *       needs a context but no GPU work is done for the scene itself.
+ */
+
+#pragma once
+#include <renderer.hpp>         // For RenderState, Image and the scene data.
+#include <atomic>               // For the shared tile counter.
+#include <condition_variable>   // For waking up the tile workers.
+#include <mutex>                // For guarding the frame hand-off.
+#include <thread>               // For the tile worker threads.
+
+
+namespace Renderer
+{
+    /**
+     * @namespace SoftwareConstants
+     * @brief Contains the configuration of the software rasterizer.
+     */
+    namespace SoftwareConstants
+    {
+        // The width and height of a screen tile in pixels.
+        constexpr int TILE_SIZE = 64;
+        // The width and height of a hierarchical depth block in pixels.
+        constexpr int HIZ_BLOCK_SIZE = 8;
+        // The number of pixels evaluated by one SIMD edge function step.
+        constexpr int SIMD_WIDTH = 4;
+        // The blend factor between texture1 and texture2, as in shader.fs.
+        constexpr float MIX_FACTOR = 0.78f;
+        // The near plane distance used to clip triangles in clip space.
+        constexpr float NEAR_CLIP_EPSILON = 1e-5f;
+    };
+
+    /**
+     * @class SoftwareTexture
+     * @brief An RGBA8 texture with a box-filtered mipmap chain that can be
+     *        sampled on the CPU.
+     *
+     * Sampling follows the GL state used by Texture: repeat wrapping on both
+     * axes, nearest mipmap selection and nearest filtering within the level,
+     * GL_NEAREST_MIPMAP_NEAREST and GL_NEAREST.
+     */
+    class SoftwareTexture
+    {
+    public:
+        /**
+         * @brief Converts a decoded image to RGBA8 and builds its mipmaps.
+         * @param image The decoded image with 3 or 4 color channels.
+         * @throws std::domain_error If the image has an unsupported number
+         *         of channels.
+         */
+        explicit SoftwareTexture(const Image& image);
+
+        /**
+         * @brief Selects the mipmap level for the texture coordinate
+         *        derivatives of a pixel quad, as GL does for
+         *        GL_NEAREST_MIPMAP_NEAREST.
+         *
+         * The level of detail is log2 of the longer of the two texel
+         * footprints along the screen axes.
+         *
+         * @param dudx The change of u from one pixel to the next in x.
+         * @param dvdx The change of v from one pixel to the next in x.
+         * @param dudy The change of u from one pixel to the next in y.
+         * @param dvdy The change of v from one pixel to the next in y.
+         * @return The index of the mipmap level to sample.
+         */
+        int selectLevel(float dudx, float dvdx, float dudy, float dvdy) const;
+
+        /**
+         * @brief Samples the nearest texel of a level.
+         * @param u The horizontal texture coordinate.
+         * @param v The vertical texture coordinate.
+         * @param level The mipmap level returned by selectLevel.
+         * @param rgba Receives the texel color in the range [0, 255].
+         */
+        void sample(float u, float v, int level, float rgba[4]) const;
+
+        /*** @brief Gets the width of the base level in texels. */
+        int getWidth() const { return levels_.front().width; }
+        /*** @brief Gets the height of the base level in texels. */
+        int getHeight() const { return levels_.front().height; }
+
+    private:
+        /**
+         * @struct MipLevel
+         * @brief A single level of the mipmap chain.
+         */
+        struct MipLevel
+        {
+            int width;
+            int height;
+            std::vector<std::uint8_t> texels;
+        };
+
+        /** @brief The mipmap chain, from the base level down to 1x1. */
+        std::vector<MipLevel> levels_;
+    };
+
+    /**
+     * @class SoftwareRenderer
+     * @brief Renders the scene with a multithreaded tile-based rasterizer.
+     *
+     * Each frame is processed in three steps:
+     * @note The cube vertices are transformed to clip space, clipped against
+     *       the near plane and set up as screen-space edge and attribute
+     *       plane equations.
+     * @note Every triangle is appended to the bin of each tile its bounding
+     *       box overlaps.
+     * @note The worker threads claim tiles from a shared counter, clear them
+     *       and rasterize their bins in submission order, so the output is
+     *       deterministic regardless of the thread count.
+     */
+    class SoftwareRenderer final : public RenderState
+    {
+    public:
+        /**
+         * @brief Loads the textures, allocates the frame buffers and starts
+         *        the tile worker threads.
+         * @param width The width of the rendered image in pixels.
+         * @param height The height of the rendered image in pixels.
+         * @param workerCount The number of tile worker threads, 0 for one
+         *        per hardware thread.
+         * @throws std::domain_error If a texture cannot be loaded.
+         * @note No OpenGL context is needed until the first draw(), so
+         *       renderFrame() also runs headless.
+         */
+        SoftwareRenderer(int width = WindowAttributes::WINDOW_WIDTH,
+            int height = WindowAttributes::WINDOW_HEIGHT,
+            unsigned int workerCount = 0);
+
+        /**
+         * @brief Stops and joins the worker threads.
+         */
+        ~SoftwareRenderer() override;
+
+        // Delete copy constructor and copy assignment operator
+        SoftwareRenderer(const SoftwareRenderer&) = delete;
+        SoftwareRenderer& operator=(const SoftwareRenderer&) = delete;
+
+        /**
+         * @brief Rasterizes the scene on the CPU and presents it.
+         * @param window The window context where to draw.
+         * @throws std::runtime_error If the presentation texture cannot be
+         *         created at the size of the frame.
+         */
+        void draw(const std::unique_ptr<Window>& window) override;
+
+        /**
+         * @brief Reallocates the frame buffers for a new window size.
+         */
+        void resize(unsigned int width, unsigned int height) override;
+
+        /** @brief Stops or restarts the clock of the animation. */
+        void setAnimationPaused(bool paused) override;
+
+        /*** @brief Gets whether the clock of the animation is stopped. */
+        bool isAnimationPaused() const override { return !clock_.isRunning(); }
+
+        /** @brief Forces the next frame to be drawn. */
+        void invalidate() override { dirty_ = true; }
+
+        /**
+         * @brief Gets whether a frame needs drawing: while animating, and
+         *        after a resize or invalidate().
+         */
+        bool needsRedraw() const override
+        {
+            return dirty_ || clock_.isRunning();
+        }
+
+        /**
+         * @brief Rasterizes the scene for a given point in time.
+         *
+         * The result is available through getColorBuffer() once the call
+         * returns.
+         *
+         * @param seconds The time elapsed since the scene started.
+         */
+        void renderFrame(float seconds);
+
+        /**
+         * @brief Gets the tightly packed RGBA8 image of the last frame.
+         *
+         * The first row is the top of the image.
+         */
+        const std::vector<std::uint8_t>& getColorBuffer() const
+        {
+            return presentBuffer_;
+        }
+
+        /*** @brief Gets the number of tile worker threads. */
+        std::size_t getWorkerCount() const { return workers_.size(); }
+
+    private:
+        /**
+         * @struct PlaneEquation
+         * @brief An attribute that varies linearly in screen space,
+         *        evaluated as dx * x + dy * y + c.
+         */
+        struct PlaneEquation
+        {
+            float dx;
+            float dy;
+            float c;
+        };
+
+        /**
+         * @struct RasterTriangle
+         * @brief A triangle set up for rasterization in screen space.
+         */
+        struct RasterTriangle
+        {
+            // Edge functions, positive inside the triangle.
+            PlaneEquation edges[3];
+            // Window-space depth.
+            PlaneEquation depth;
+            // Reciprocal clip-space w, for perspective correction.
+            PlaneEquation invW;
+            // Texture coordinates divided by w.
+            PlaneEquation uOverW;
+            PlaneEquation vOverW;
+            // The nearest depth of the three vertices.
+            float minDepth;
+            // The inclusive pixel bounding box, clamped to the screen.
+            int minX, minY, maxX, maxY;
+        };
+
+        /**
+         * @struct ClipVertex
+         * @brief A vertex after the vertex shader stage.
+         */
+        struct ClipVertex
+        {
+            glm::vec4 position;
+            float u;
+            float v;
+        };
+
+        /**
+         * @brief Sets up and bins a triangle that lies in front of the near
+         *        plane.
+         */
+        void setupTriangle(const ClipVertex& v0, const ClipVertex& v1,
+            const ClipVertex& v2);
+
+        /**
+         * @brief Clips a triangle against the near plane and forwards the
+         *        visible part to setupTriangle.
+         */
+        void clipTriangle(const ClipVertex& v0, const ClipVertex& v1,
+            const ClipVertex& v2);
+
+        /** @brief Sizes the frame, tile and depth buffers to width_ and
+         *         height_. */
+        void allocateFrame();
+
+        /** @brief The body of every worker thread. */
+        void workerLoop();
+
+        /** @brief Claims and renders tiles until none are left. */
+        void processTiles();
+
+        /** @brief Clears and rasterizes every triangle binned to a tile. */
+        void renderTile(int tileIndex);
+
+        /**
+         * @brief Rasterizes one triangle inside a hierarchical depth block.
+         * @return True if any pixel in the block was written.
+         */
+        bool rasterizeBlock(const RasterTriangle& triangle, int blockX,
+            int blockY, int minX, int minY, int maxX, int maxY);
+
+        /**
+         * @brief Selects the mipmap levels of texture1 and texture2 for the
+         *        2x2 pixel quad at an even pixel position.
+         *
+         * The texture coordinates are evaluated at the centers of the
+         * quad's pixels, inside the triangle or not, like the helper
+         * invocations of a GPU, and their differences across the quad are
+         * the derivatives.
+         */
+        void selectQuadLevels(const RasterTriangle& triangle, int quadX,
+            int quadY, int levels[2]) const;
+
+        /** @brief Shades a single covered pixel that passed the depth test
+         *         with the mipmap levels of its quad. */
+        void shadePixel(const RasterTriangle& triangle, int x, int y,
+            float depth, const int levels[2]);
+
+        /** @brief Recomputes the farthest depth stored in a block. */
+        void updateHiZ(int blockX, int blockY);
+
+        // The visible size of the frame.
+        int width_;
+        int height_;
+        // The frame buffer size, padded to whole tiles.
+        int paddedWidth_;
+        int paddedHeight_;
+        int tilesX_;
+        int tilesY_;
+        int blocksX_;
+
+        SoftwareTexture shelfTexture_;
+        SoftwareTexture duckyTexture_;
+
+        // Color and depth buffers with a row pitch of paddedWidth_.
+        std::vector<std::uint8_t> colorBuffer_;
+        std::vector<float> depthBuffer_;
+        // The farthest depth of every HIZ_BLOCK_SIZE block.
+        std::vector<float> hiZBuffer_;
+        // The unpadded color buffer handed to the presentation texture.
+        std::vector<std::uint8_t> presentBuffer_;
+
+        std::vector<RasterTriangle> triangles_;
+        // Indices into triangles_ for every tile, in submission order.
+        std::vector<std::vector<std::uint32_t>> tileBins_;
+
+        std::vector<std::thread> workers_;
+        std::mutex mutex_;
+        std::condition_variable frameStart_;
+        std::condition_variable frameDone_;
+        std::uint64_t frameIndex_;
+        std::size_t busyWorkers_;
+        bool shutdown_;
+        std::atomic<int> nextTile_;
+
+        sf::Texture presentTexture_;
+        sf::Clock clock_;
+        // Set when the displayed frame is outdated, cleared by draw()
+        bool dirty_;
+    };
+}
@@ -0,0 +1,288 @@
+/**
+ * @file stream_protocol.hpp
+ * @brief This header file defines the wire format and the tile codec shared
+ *        by the frame streaming server and the viewer.
+ *
+ * Every message is a little-endian 32 bit payload size, a message type byte
+ * and the payload. The server greets a viewer with a HELLO, then sends a
+ * FRAME for every streamed frame. A frame is split into square tiles and
+ * only the tiles that differ from the last frame sent are included. Each
+ * tile is encoded as the XOR with the viewer's copy of it, so unchanged
+ * pixels become zero bytes, and the XOR is run-length encoded. The viewer
+ * answers every FRAME with an ACK echoing its timestamp, and sends its key
+ * presses back as INPUT messages.
+ *
+ * The codec needs no dependency and encodes a tile in one pass, which keeps
+ * the encoder off the critical path on localhost and in a LAN; frames of
+ * noisy content compress poorly and are bounded by the raw tile size plus
+ * one byte in 128.
+ */
+
+#pragma once
+#include <cstddef> // For the buffer sizes.
+#include <cstdint> // For the fixed width fields.
+#include <vector>  // For the message buffers.
+
+
+namespace Renderer
+{
+    /**
+     * @namespace StreamConstants
+     * @brief Contains the protocol version and limits of frame streaming.
+     */
+    namespace StreamConstants
+    {
+        // Bumped whenever the wire format changes.
+        constexpr std::uint32_t PROTOCOL_VERSION = 1;
+        // The port served and connected to unless given.
+        constexpr unsigned short DEFAULT_PORT = 7420;
+        // The side of a square tile in pixels, edge tiles are cut off.
+        constexpr unsigned int TILE_SIZE = 64;
+        // The bytes per streamed RGBA8 pixel.
+        constexpr std::size_t BYTES_PER_PIXEL = 4;
+        // The bytes of the size and type that precede every payload.
+        constexpr std::size_t HEADER_SIZE = 5;
+        // Larger payloads are rejected as corrupt, above any frame of an
+        // 8K window sent raw. Frames whose RGBA8 pixels would not fit are
+        // rejected too.
+        constexpr std::uint32_t MAX_PAYLOAD_SIZE = 256u << 20;
+    };
+
+    /**
+     * @enum StreamMessage
+     * @brief The type byte of a message.
+     */
+    enum class StreamMessage : std::uint8_t
+    {
+        HELLO = 0, ///< Server: protocol version and tile size
+        FRAME,     ///< Server: the changed tiles of a frame
+        ACK,       ///< Viewer: a frame was displayed
+        INPUT,     ///< Viewer: an input event
+    };
+
+    /**
+     * @enum StreamInputType
+     * @brief The kinds of input events sent back by a viewer.
+     */
+    enum class StreamInputType : std::uint8_t
+    {
+        KEY_PRESSED = 0, ///< A key went down, code is its scancode
+        KEY_RELEASED,    ///< A key went up, code is its scancode
+        CONNECTED,       ///< Not sent: a viewer connected to the server
+    };
+
+    /**
+     * @struct StreamInput
+     * @brief An input event of the viewer.
+     */
+    struct StreamInput
+    {
+        /** @brief Numbers the events of a connection from 1. */
+        std::uint32_t sequence = 0;
+        StreamInputType type = StreamInputType::KEY_PRESSED;
+        /** @brief The `sf::Keyboard::Scancode` of key events. */
+        std::int32_t code = 0;
+    };
+
+    /**
+     * @struct FrameHeader
+     * @brief The fields that precede the tiles of a FRAME.
+     */
+    struct FrameHeader
+    {
+        std::uint64_t frame = 0;
+        /** @brief The microseconds on the server's steady clock at which the
+         *         frame was read back, echoed by the ACK. */
+        std::uint64_t timestamp = 0;
+        /** @brief The last input event applied before the frame was drawn,
+         *         0 for none. */
+        std::uint32_t inputSequence = 0;
+        std::uint32_t width = 0;
+        std::uint32_t height = 0;
+        std::uint32_t tileCount = 0;
+    };
+
+    /**
+     * @struct TileGrid
+     * @brief Splits a frame into tiles, row by row from the first row of the
+     *        pixel data.
+     */
+    struct TileGrid
+    {
+        unsigned int width = 0;
+        unsigned int height = 0;
+        unsigned int columns = 0;
+        unsigned int rows = 0;
+
+        /** @brief Creates the grid of a frame size. */
+        TileGrid(unsigned int frameWidth, unsigned int frameHeight);
+
+        /*** @brief Gets the number of tiles. */
+        std::size_t getTileCount() const
+        {
+            return static_cast<std::size_t>(columns) * rows;
+        }
+
+        /**
+         * @brief Gets the pixel rectangle of a tile.
+         * @param tile The tile index.
+         * @param x, y Receive the first pixel of the tile.
+         * @param tileWidth, tileHeight Receive the size of the tile.
+         */
+        void getRect(std::size_t tile, unsigned int& x, unsigned int& y,
+            unsigned int& tileWidth, unsigned int& tileHeight) const;
+    };
+
+    /**
+     * @brief Gets whether a tile differs between two frames.
+     * @param grid The tiles of both frames.
+     * @param tile The tile index.
+     * @param current, reference The RGBA8 frames, rows tightly packed.
+     */
+    bool isTileChanged(const TileGrid& grid, std::size_t tile,
+        const std::uint8_t* current, const std::uint8_t* reference);
+
+    /**
+     * @brief Appends the encoding of a tile to a buffer and copies the tile
+     *        into the reference frame.
+     * @param grid The tiles of both frames.
+     * @param tile The tile index.
+     * @param current The RGBA8 frame being sent.
+     * @param reference The frame the viewer has, updated to the current tile.
+     * @param scratch Holds the XOR of the tile, reused between calls.
+     * @param out The buffer the encoded bytes are appended to.
+     */
+    void encodeTile(const TileGrid& grid, std::size_t tile,
+        const std::uint8_t* current, std::uint8_t* reference,
+        std::vector<std::uint8_t>& scratch, std::vector<std::uint8_t>& out);
+
+    /**
+     * @brief Applies an encoded tile to a frame.
+     * @param grid The tiles of the frame.
+     * @param tile The tile index.
+     * @param data, size The encoded bytes.
+     * @param frame The RGBA8 frame, holding the previous tile.
+     * @param scratch Holds the decoded XOR, reused between calls.
+     * @return False if the encoding is corrupt.
+     */
+    bool decodeTile(const TileGrid& grid, std::size_t tile,
+        const std::uint8_t* data, std::size_t size, std::uint8_t* frame,
+        std::vector<std::uint8_t>& scratch);
+
+    /**
+     * @class MessageWriter
+     * @brief Builds a message in a reusable buffer.
+     */
+    class MessageWriter
+    {
+    public:
+        /** @brief Clears the buffer and writes the type of a new message. */
+        void begin(StreamMessage type);
+
+        /** @brief Appends a little-endian field. */
+        void writeU8(std::uint8_t value);
+        void writeU32(std::uint32_t value);
+        void writeU64(std::uint64_t value);
+        void writeBytes(const std::uint8_t* data, std::size_t size);
+
+        /** @brief Overwrites four bytes written earlier, for sizes that are
+         *         only known once the data that follows is written. */
+        void patchU32(std::size_t offset, std::uint32_t value);
+
+        /**
+         * @brief Writes the payload size into the header.
+         * @return The message, ready to be sent.
+         */
+        const std::vector<std::uint8_t>& finish();
+
+        /*** @brief Gets the bytes written so far, including the header. */
+        std::size_t getSize() const { return buffer_.size(); }
+
+        /*** @brief Gets the buffer, for encoders that append to it. */
+        std::vector<std::uint8_t>& getBuffer() { return buffer_; }
+
+    private:
+        std::vector<std::uint8_t> buffer_;
+    };
+
+    /**
+     * @class MessageReader
+     * @brief Reads the fields of a received payload.
+     *
+     * Reading past the end sets a failure flag instead of throwing, so a
+     * message is read completely and checked once.
+     */
+    class MessageReader
+    {
+    public:
+        /** @brief Reads a payload from its start. */
+        MessageReader(const std::uint8_t* data, std::size_t size);
+
+        /** @brief Reads a little-endian field, 0 past the end. */
+        std::uint8_t readU8();
+        std::uint32_t readU32();
+        std::uint64_t readU64();
+
+        /**
+         * @brief Skips bytes and returns where they start.
+         * @return The skipped bytes, nullptr if there are not enough left.
+         */
+        const std::uint8_t* readBytes(std::size_t size);
+
+        /*** @brief Gets whether every read was within the payload. */
+        bool isValid() const { return valid_; }
+
+    private:
+        const std::uint8_t* data_;
+        std::size_t size_;
+        std::size_t offset_;
+        bool valid_;
+    };
+
+    /** @brief Writes the fields of a frame header. */
+    void writeFrameHeader(MessageWriter& writer, const FrameHeader& header);
+
+    /**
+     * @brief Reads the fields of a frame header.
+     * @throws std::runtime_error If the frame is empty or its pixels would
+     *         take more than MAX_PAYLOAD_SIZE bytes.
+     */
+    FrameHeader readFrameHeader(MessageReader& reader);
+
+    /** @brief Begins an INPUT message with the fields of an event. */
+    void writeInput(MessageWriter& writer, const StreamInput& input);
+
+    /** @brief Reads the payload of an INPUT message. */
+    StreamInput readInput(MessageReader& reader);
+
+    /**
+     * @class MessageAssembler
+     * @brief Collects the bytes received from a stream socket into whole
+     *        messages.
+     */
+    class MessageAssembler
+    {
+    public:
+        /** @brief Creates an assembler with no bytes received. */
+        MessageAssembler();
+
+        /** @brief Appends received bytes. */
+        void append(const std::uint8_t* data, std::size_t size);
+
+        /**
+         * @brief Takes the next complete message.
+         * @param type Receives the message type.
+         * @param payload Receives the payload, valid until the next call.
+         * @param size Receives the payload size.
+         * @return False if no complete message was received yet.
+         * @throws std::runtime_error If the payload size is corrupt.
+         */
+        bool next(StreamMessage& type, const std::uint8_t*& payload,
+            std::size_t& size);
+
+    private:
+        std::vector<std::uint8_t> buffer_;
+        // The start of the first message not yet taken
+        std::size_t offset_;
+    };
+}
@@ -0,0 +1,221 @@
+/**
+ * @file task_graph.hpp
+ * @brief This header file defines the dependency graph that runs the
+ *        startup work of the renderer.
+ *
+ * Every piece of startup work is a task that runs once all the tasks it
+ * depends on have finished. Worker tasks, like reading files and decoding
+ * images, run in parallel on a pool of threads. Context tasks issue
+ * OpenGL calls, so they run one after another on the thread that owns
+ * the context, whenever it waits on the graph or polls it. The context
+ * thread can wait for the tasks a first frame needs and poll the rest
+ * between frames.
+ */
+
+#pragma once
+#include <chrono>             // For the task timings.
+#include <condition_variable> // For waking up workers and the context.
+#include <cstdint>            // For the task kinds.
+#include <deque>              // For the queues of ready tasks.
+#include <exception>          // For passing task failures on.
+#include <functional>         // For the work of a task.
+#include <initializer_list>   // For the dependencies of a task.
+#include <mutex>              // For guarding the graph state.
+#include <string>             // For the timing report.
+#include <thread>             // For the worker threads.
+#include <vector>             // For the tasks and their dependents.
+
+
+namespace Renderer
+{
+    /**
+     * @namespace TaskGraphConstants
+     * @brief Contains the sizing of the startup worker pool.
+     */
+    namespace TaskGraphConstants
+    {
+        // The most worker threads of a graph, startup has a handful of
+        // files to read and decode.
+        constexpr std::size_t MAX_WORKERS = 4;
+    };
+
+    /**
+     * @enum TaskThread
+     * @brief Where a task runs.
+     */
+    enum class TaskThread : std::uint8_t
+    {
+        WORKER = 0, ///< Any worker thread, must not touch the OpenGL context
+        CONTEXT,    ///< The thread owning the OpenGL context
+    };
+
+    /** @brief Identifies a task of a TaskGraph. */
+    using TaskId = std::size_t;
+
+    /**
+     * @struct TaskTiming
+     * @brief When a task ran, in milliseconds since the graph started.
+     */
+    struct TaskTiming
+    {
+        const char* name;
+        TaskThread thread;
+        double startMs;
+        double endMs;
+    };
+
+    /**
+     * @class TaskGraph
+     * @brief Runs tasks in dependency order on workers and on the context
+     *        thread.
+     *
+     * Tasks are added before start(). A task that throws fails the tasks
+     * that depend on it, and the exception is rethrown on the context
+     * thread by the next wait() or poll().
+     */
+    class TaskGraph
+    {
+    public:
+        TaskGraph();
+
+        /**
+         * @brief Stops the workers once their running tasks return, tasks
+         *        that have not started are abandoned.
+         */
+        ~TaskGraph();
+
+        // Delete copy constructor and copy assignment operator
+        TaskGraph(const TaskGraph&) = delete;
+        TaskGraph& operator=(const TaskGraph&) = delete;
+
+        /**
+         * @brief Adds a task.
+         * @param name The name of the task in the timings, a literal.
+         * @param thread Where the task runs.
+         * @param work The work of the task.
+         * @param dependencies Tasks that must finish before this one runs.
+         * @return The identifier of the new task.
+         * @throws std::logic_error If the graph has started or a dependency
+         *         is unknown.
+         */
+        TaskId add(const char* name, TaskThread thread,
+            std::function<void()> work,
+            std::initializer_list<TaskId> dependencies = {});
+
+        /**
+         * @brief Starts the workers and the tasks without dependencies.
+         * @param workers The number of worker threads, at least one.
+         */
+        void start(std::size_t workers);
+
+        /**
+         * @brief Runs context tasks on the calling thread until a task has
+         *        finished.
+         * @param task The task to wait for.
+         * @throws The exception of a failed task.
+         */
+        void wait(TaskId task);
+
+        /**
+         * @brief Runs the context tasks that are ready, without waiting
+         *        for workers.
+         * @return True once every task has finished.
+         * @throws The exception of a failed task.
+         */
+        bool poll();
+
+        /**
+         * @brief Runs context tasks until every task has finished.
+         * @throws The exception of a failed task.
+         */
+        void waitAll();
+
+        /**
+         * @brief Gets when each finished task ran.
+         * @return The timings in the order the tasks were added, tasks
+         *         that did not run are left out.
+         */
+        std::vector<TaskTiming> getTimings() const;
+
+        /**
+         * @brief Gets the milliseconds from start() until the last task
+         *        finished, or until now while tasks are left.
+         */
+        double getElapsedMs() const;
+
+    private:
+        /**
+         * @enum TaskState
+         * @brief The progress of a task.
+         */
+        enum class TaskState : std::uint8_t
+        {
+            WAITING = 0, ///< Dependencies have not finished
+            READY,       ///< Queued to run
+            RUNNING,     ///< Running on a worker or the context thread
+            DONE,        ///< Finished successfully
+            FAILED,      ///< Threw, or a dependency failed
+        };
+
+        /**
+         * @struct Task
+         * @brief A task and its place in the graph.
+         */
+        struct Task
+        {
+            const char* name;
+            TaskThread thread;
+            std::function<void()> work;
+            std::vector<TaskId> dependents;
+            // The dependencies that have not finished
+            std::size_t remaining;
+            TaskState state;
+            std::chrono::steady_clock::time_point start;
+            std::chrono::steady_clock::time_point end;
+        };
+
+        using Clock = std::chrono::steady_clock;
+
+        /** @brief Runs worker tasks until the graph is destroyed. */
+        void workerLoop();
+
+        /** @brief Queues a task whose dependencies have finished. */
+        void makeReady(TaskId task);
+
+        /**
+         * @brief Runs a task with the lock released and records its end.
+         * @param lock The held lock of mutex_.
+         */
+        void run(TaskId task, std::unique_lock<std::mutex>& lock);
+
+        /** @brief Fails a task and everything that depends on it. */
+        void fail(TaskId task);
+
+        /** @brief Rethrows the first failure, with the lock held. */
+        void rethrowFailure() const;
+
+        std::vector<Task> tasks_;
+        std::deque<TaskId> workerQueue_;
+        std::deque<TaskId> contextQueue_;
+        std::size_t finished_;
+        std::exception_ptr failure_;
+        bool started_;
+        bool stopping_;
+        Clock::time_point start_;
+        Clock::time_point end_;
+
+        mutable std::mutex mutex_;
+        // Signaled when a worker task is queued or the graph stops
+        std::condition_variable workerReady_;
+        // Signaled when a task finishes or a context task is queued
+        std::condition_variable contextReady_;
+        std::vector<std::thread> workers_;
+    };
+
+    /**
+     * @brief Formats task timings as one line per task.
+     * @param timings The timings of a graph.
+     * @return The report, every line ends in a newline.
+     */
+    std::string formatTimings(const std::vector<TaskTiming>& timings);
+}
@@ -0,0 +1,381 @@
+/**
+ * @file trace.hpp
+ * @brief This header file defines the capture and replay of the device
+ *        command stream.
+ *
+ * A TraceRecorder sits between GL_State and the real device and appends
+ * every call, including the data of resource creations, to a compact
+ * binary trace. A TracePlayer issues a recorded trace on another device,
+ * mapping the recorded object names and uniform locations to the ones the
+ * new device returns, so a fixed workload can be benchmarked without any
+ * simulation or asset loading.
+ *
+ * Trace layout, all values in host byte order:
+ * @note Header: TraceFormat::MAGIC followed by TraceFormat::VERSION.
+ * @note Records: a TraceOp byte followed by the arguments of the call.
+ *       Data blocks are stored as a 64-bit size, a byte that is 0 for a
+ *       null pointer and, if it is not 0, the bytes.
+ * @note TraceOp::FRAME_END closes a segment and stores its timestamp in
+ *       microseconds since the recording started. The first segment holds
+ *       the setup (resource creation), every following one a frame.
+ */
+
+#pragma once
+#include <device.hpp>   // For the Device interface.
+#include <chrono>       // For the frame timestamps.
+#include <fstream>      // For writing the trace file.
+#include <memory>       // For owning the wrapped device.
+#include <unordered_map>// For mapping recorded names to replayed ones.
+
+
+namespace Renderer
+{
+    /**
+     * @namespace TraceFormat
+     * @brief Constants that identify a trace file.
+     */
+    namespace TraceFormat
+    {
+        // The identifier at the start of every trace file.
+        constexpr char MAGIC[8] = { 'C', 'U', 'B', 'E', 'T', 'R', 'C', '\0' };
+        // The version of the record layout, bumped on incompatible changes.
+        constexpr std::uint32_t VERSION = 6;
+    };
+
+    /**
+     * @enum TraceOp
+     * @brief The operation code of a trace record, one per Device call.
+     */
+    enum class TraceOp : std::uint8_t
+    {
+        CREATE_VERTEX_ARRAY = 0,
+        BIND_VERTEX_ARRAY,
+        CREATE_BUFFER,
+        BIND_BUFFER,
+        BUFFER_DATA,
+        VERTEX_ATTRIB_POINTER,
+        ENABLE_VERTEX_ATTRIB_ARRAY,
+        CREATE_TEXTURE,
+        ACTIVE_TEXTURE,
+        BIND_TEXTURE,
+        TEX_PARAMETER,
+        TEX_IMAGE_2D,
+        GENERATE_MIPMAP,
+        CREATE_SHADER,
+        SHADER_SOURCE,
+        COMPILE_SHADER,
+        GET_COMPILE_STATUS,
+        DELETE_SHADER,
+        CREATE_PROGRAM,
+        ATTACH_SHADER,
+        LINK_PROGRAM,
+        GET_LINK_STATUS,
+        USE_PROGRAM,
+        GET_UNIFORM_LOCATION,
+        UNIFORM_1I,
+        UNIFORM_1F,
+        UNIFORM_MATRIX_4FV,
+        VIEWPORT,
+        ENABLE,
+        CLEAR_COLOR,
+        CLEAR,
+        DRAW_ARRAYS,
+        DRAW_ELEMENTS,
+        CREATE_FRAMEBUFFER,
+        BIND_FRAMEBUFFER,
+        CREATE_RENDERBUFFER,
+        BIND_RENDERBUFFER,
+        RENDERBUFFER_STORAGE,
+        FRAMEBUFFER_RENDERBUFFER,
+        CHECK_FRAMEBUFFER_STATUS,
+        BLIT_FRAMEBUFFER,
+        CREATE_QUERY,
+        BEGIN_QUERY,
+        END_QUERY,
+        GET_QUERY_RESULT,
+        VERTEX_ATTRIB_DIVISOR,
+        BIND_BUFFER_BASE,
+        BIND_IMAGE_TEXTURE,
+        MULTI_DRAW_ARRAYS_INDIRECT,
+        DISPATCH_COMPUTE,
+        MEMORY_BARRIER,
+        FRAMEBUFFER_TEXTURE_2D,
+        DELETE_VERTEX_ARRAY,
+        DELETE_BUFFER,
+        DELETE_TEXTURE,
+        DELETE_PROGRAM,
+        DELETE_FRAMEBUFFER,
+        DELETE_RENDERBUFFER,
+        DELETE_QUERY,
+        DISABLE,
+        BLEND_FUNC,
+        CREATE_FENCE,
+        IS_FENCE_SIGNALED,
+        DELETE_FENCE,
+        FRAME_END, ///< Closes a segment, see the file description
+    };
+
+    /**
+     * @class TraceRecorder
+     * @brief A device that records every call into a trace file and
+     *        forwards it to the wrapped device.
+     *
+     * Records are staged in memory and written to the file when a segment
+     * ends, so the frame loop does not wait on file I/O.
+     */
+    class TraceRecorder final : public Device
+    {
+    public:
+        /**
+         * @brief Opens the trace file and writes its header.
+         * @param device The device every call is forwarded to.
+         * @param path The path of the trace file to create.
+         * @throws std::runtime_error If the file cannot be created.
+         */
+        TraceRecorder(std::unique_ptr<Device> device, const std::string& path);
+
+        /**
+         * @brief Writes the pending records and closes the file.
+         */
+        ~TraceRecorder() override;
+
+        /**
+         * @brief Closes the current segment.
+         *
+         * Call it once after the setup and then after every frame.
+         */
+        void endFrame();
+
+        /**
+         * @brief Writes the pending records, closes the file and keeps
+         *        forwarding calls without recording them.
+         */
+        void stop();
+
+        /*** @brief Gets whether calls are still being recorded. */
+        bool isRecording() const { return file_.is_open(); }
+
+        /*** @brief Gets the number of segments recorded so far. */
+        std::uint32_t getSegmentCount() const { return segmentCount_; }
+
+        /*** @brief Gets the debug log of the wrapped device. */
+        DebugLog* getDebugLog() const override
+        {
+            return device_->getDebugLog();
+        }
+
+        GLuint createVertexArray() override;
+        void bindVertexArray(GLuint vertexArray) override;
+        void deleteVertexArray(GLuint vertexArray) override;
+        GLuint createBuffer() override;
+        void bindBuffer(GLenum target, GLuint buffer) override;
+        void deleteBuffer(GLuint buffer) override;
+        void bufferData(GLenum target, GLsizeiptr size, const void* data,
+            GLenum usage) override;
+        void vertexAttribPointer(GLuint index, GLint size, GLenum type,
+            GLsizei stride, std::size_t offset) override;
+        void enableVertexAttribArray(GLuint index) override;
+        void vertexAttribDivisor(GLuint index, GLuint divisor) override;
+        void bindBufferBase(GLenum target, GLuint index,
+            GLuint buffer) override;
+
+        GLuint createTexture() override;
+        void activeTexture(GLenum unit) override;
+        void bindTexture(GLenum target, GLuint texture) override;
+        void deleteTexture(GLuint texture) override;
+        void texParameter(GLenum target, GLenum name, GLint value) override;
+        void texImage2D(GLenum target, GLint level, GLint internalFormat,
+            GLsizei width, GLsizei height, GLenum format, GLenum type,
+            const void* pixels) override;
+        void generateMipmap(GLenum target) override;
+        void bindImageTexture(GLuint unit, GLuint texture, GLint level,
+            GLenum access, GLenum format) override;
+
+        GLuint createShader(GLenum type) override;
+        void shaderSource(GLuint shader, const std::string& source) override;
+        void compileShader(GLuint shader) override;
+        bool getCompileStatus(GLuint shader, std::string& infoLog) override;
+        void deleteShader(GLuint shader) override;
+        GLuint createProgram() override;
+        void attachShader(GLuint program, GLuint shader) override;
+        void linkProgram(GLuint program) override;
+        bool getLinkStatus(GLuint program, std::string& infoLog) override;
+        void useProgram(GLuint program) override;
+        void deleteProgram(GLuint program) override;
+
+        GLint getUniformLocation(GLuint program, const char* name) override;
+        void uniform1i(GLint location, GLint value) override;
+        void uniform1f(GLint location, GLfloat value) override;
+        void uniformMatrix4fv(GLint location, const GLfloat* value) override;
+
+        void viewport(GLint x, GLint y, GLsizei width,
+            GLsizei height) override;
+        void enable(GLenum capability) override;
+        void disable(GLenum capability) override;
+        void blendFunc(GLenum sourceFactor, GLenum destFactor) override;
+        void clearColor(GLfloat red, GLfloat green, GLfloat blue,
+            GLfloat alpha) override;
+        void clear(GLbitfield mask) override;
+        void drawArrays(GLenum mode, GLint first, GLsizei count) override;
+        void drawElements(GLenum mode, GLsizei count, GLenum type,
+            std::size_t offset) override;
+        void multiDrawArraysIndirect(GLenum mode, std::size_t offset,
+            GLsizei drawCount, GLsizei stride) override;
+
+        void dispatchCompute(GLuint groupsX, GLuint groupsY,
+            GLuint groupsZ) override;
+        void memoryBarrier(GLbitfield barriers) override;
+
+        GLuint createFramebuffer() override;
+        void bindFramebuffer(GLenum target, GLuint framebuffer) override;
+        void deleteFramebuffer(GLuint framebuffer) override;
+        GLuint createRenderbuffer() override;
+        void bindRenderbuffer(GLuint renderbuffer) override;
+        void deleteRenderbuffer(GLuint renderbuffer) override;
+        void renderbufferStorage(GLsizei samples, GLenum internalFormat,
+            GLsizei width, GLsizei height) override;
+        void framebufferRenderbuffer(GLenum target, GLenum attachment,
+            GLuint renderbuffer) override;
+        void framebufferTexture2D(GLenum target, GLenum attachment,
+            GLuint texture, GLint level) override;
+        GLenum checkFramebufferStatus(GLenum target) override;
+        void blitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1,
+            GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1,
+            GLbitfield mask, GLenum filter) override;
+
+        GLuint createQuery() override;
+        void deleteQuery(GLuint query) override;
+        void beginQuery(GLenum target, GLuint query) override;
+        void endQuery(GLenum target) override;
+        bool getQueryResult(GLuint query, GLuint64& result) override;
+
+        GLuint createFence() override;
+        bool isFenceSignaled(GLuint fence) override;
+        void deleteFence(GLuint fence) override;
+
+    private:
+        /** @brief Appends the bytes of a trivially copyable value. */
+        template <typename T>
+        void write(const T& value)
+        {
+            const char* bytes = reinterpret_cast<const char*>(&value);
+            pending_.insert(pending_.end(), bytes, bytes + sizeof(T));
+        }
+
+        /** @brief Starts a record, returns false if not recording. */
+        bool begin(TraceOp op);
+
+        /** @brief Appends a sized data block, data may be null. */
+        void writeBlock(const void* data, std::size_t size);
+
+        /** @brief Writes the pending records to the file. */
+        void flush();
+
+        std::unique_ptr<Device> device_;
+        std::ofstream file_;
+        // Records of the current segment, not yet written to the file
+        std::vector<char> pending_;
+        std::chrono::steady_clock::time_point start_;
+        std::uint32_t segmentCount_;
+    };
+
+    /**
+     * @class TracePlayer
+     * @brief Loads a trace file and issues its segments on a device.
+     */
+    class TracePlayer
+    {
+    public:
+        /**
+         * @brief Reads and indexes a trace file.
+         * @param path The path of the trace file.
+         * @throws std::runtime_error If the file cannot be read or is not a
+         *         trace of the supported version.
+         */
+        explicit TracePlayer(const std::string& path);
+
+        /*** @brief Gets the number of recorded frames, without the setup. */
+        std::size_t getFrameCount() const { return segments_.size() - 1; }
+
+        /**
+         * @brief Gets the time at which a frame ended during recording.
+         * @param frame The index of the frame, from 0.
+         * @return Microseconds since the end of the setup.
+         */
+        std::uint64_t getFrameTimestamp(std::size_t frame) const;
+
+        /**
+         * @brief Issues the setup segment, creating every resource.
+         * @param device The device to replay on.
+         * @throws std::runtime_error If a shader fails to compile or link.
+         */
+        void replaySetup(Device& device);
+
+        /**
+         * @brief Issues the calls of a single frame.
+         * @param device The device the setup was replayed on.
+         * @param frame The index of the frame, from 0.
+         */
+        void replayFrame(Device& device, std::size_t frame);
+
+    private:
+        /**
+         * @enum ObjectKind
+         * @brief The object types, each numbered on its own by a driver.
+         */
+        enum class ObjectKind : std::uint8_t
+        {
+            VERTEX_ARRAY = 0,
+            BUFFER,
+            TEXTURE,
+            SHADER,
+            PROGRAM,
+            FRAMEBUFFER,
+            RENDERBUFFER,
+            QUERY,
+            FENCE,
+        };
+
+        /**
+         * @struct Segment
+         * @brief The byte range of a segment in the trace data.
+         */
+        struct Segment
+        {
+            std::size_t begin;
+            std::size_t end;
+            std::uint64_t timestamp;
+        };
+
+        /**
+         * @brief Decodes the record at an offset and issues it.
+         * @param device The device to issue the call on, or nullptr to only
+         *        decode the record while indexing.
+         * @param offset The offset of the record in the trace data.
+         * @return The offset of the next record.
+         * @throws std::runtime_error If the record is truncated or unknown.
+         */
+        std::size_t executeRecord(Device* device, std::size_t offset);
+
+        /** @brief Issues every record of a segment. */
+        void replaySegment(Device& device, const Segment& segment);
+
+        /** @brief Gets the key of a recorded name in names_. */
+        static std::uint64_t nameKey(ObjectKind kind, GLuint recorded);
+
+        /** @brief Maps a recorded object name to the replayed one. */
+        GLuint mapName(ObjectKind kind, GLuint recorded) const;
+
+        /** @brief Maps a recorded uniform location of the current program. */
+        GLint mapLocation(GLint recorded) const;
+
+        std::vector<char> data_;
+        std::vector<Segment> segments_;
+        // (kind, recorded name) to the name created during replay, as
+        // names of different kinds overlap
+        std::unordered_map<std::uint64_t, GLuint> names_;
+        // (recorded program, recorded location) to the replayed location
+        std::unordered_map<std::uint64_t, GLint> locations_;
+        GLuint currentProgram_;
+    };
+}
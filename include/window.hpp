@@ -11,6 +11,8 @@ namespace WindowAttributes
     constexpr GLsizei WINDOW_WIDTH{ 1133 };
     constexpr GLsizei WINDOW_HEIGHT{ 755 };
     constexpr const char* WINDOW_TITLE{ "Cube" };
+    // The frame rate the interactive loop is limited to
+    constexpr unsigned int FRAMERATE_LIMIT{ 60 };
     // Configure OpenGL context settings
     inline sf::ContextSettings getSettings() 
     {
@@ -39,10 +41,12 @@ public:
      * OpenGL settings. It also ensures that the OpenGL functions are loaded 
      * and the window is successfully created.
      *
+     * @param settings The settings of the OpenGL context.
      * @throws std::runtime_error If the OpenGL context fails to initialize 
      *         or the window cannot be opened.
      */
-    Window();
+    explicit Window(const sf::ContextSettings& settings =
+        WindowAttributes::getSettings());
     virtual ~Window() override = default;
 
     // Getter for the clock_ member
@@ -0,0 +1,17 @@
+#version 330 core
+
+// Blends the two source textures of a material once, the scene then
+// samples the result instead of both sources
+out vec4 FragColor;
+
+in vec2 TexCoord;
+
+uniform sampler2D texture1;
+uniform sampler2D texture2;
+uniform float mixFactor;
+
+void main()
+{
+    FragColor = mix(textureLod(texture1, TexCoord, 0.0),
+        textureLod(texture2, TexCoord, 0.0), mixFactor);
+}
@@ -0,0 +1,11 @@
+#version 330 core
+
+// Covers the bake target with one triangle, without vertex attributes
+out vec2 TexCoord;
+
+void main()
+{
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+    TexCoord = corner;
+}
@@ -0,0 +1,32 @@
+#version 330 core
+
+// False-colors the fragment counts of the overdraw view: pixels drawn
+// once are blue, then the colors run through cyan, green and yellow to
+// red at maxLayers fragments and more
+out vec4 FragColor;
+
+uniform sampler2D counts;
+uniform float maxLayers;
+
+const vec3 RAMP[5] = vec3[](
+    vec3(0.0, 0.0, 1.0),
+    vec3(0.0, 1.0, 1.0),
+    vec3(0.0, 1.0, 0.0),
+    vec3(1.0, 1.0, 0.0),
+    vec3(1.0, 0.0, 0.0));
+
+void main()
+{
+    // The counts have the size of the target, one texel per pixel
+    float layers = texelFetch(counts, ivec2(gl_FragCoord.xy), 0).r;
+    if (layers < 0.5)
+    {
+        FragColor = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+    float position = 4.0 * clamp((layers - 1.0) / max(maxLayers - 1.0, 1.0),
+        0.0, 1.0);
+    int lower = min(int(position), 3);
+    FragColor = vec4(mix(RAMP[lower], RAMP[lower + 1],
+        position - float(lower)), 1.0);
+}
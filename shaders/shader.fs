@@ -1,12 +1,132 @@
 #version 330 core
+
+// Features are defined by the program's permutation, see shader_library.hpp
+//   SINGLE_TEXTURE  samples texture1 only
+//   DEPTH_ONLY      writes no color, for depth passes
+//   TEXCOORD_VIEW   shows the texture coordinates as colors
+//   OVERDRAW_VIEW   adds one per fragment, see overdraw_heatmap.hpp
+//   CLUSTERED_LIGHTING  lights the texture colors with the point lights of
+//                   the fragment's cluster, see clustered_lighting.hpp
+
+// The weight of texture2 in the mix of the two textures
+#ifndef MIX_FACTOR
+#define MIX_FACTOR 0.78
+#endif
+
+// The light every fragment gets without a point light
+#ifndef AMBIENT
+#define AMBIENT 0.04
+#endif
+
+#ifdef DEPTH_ONLY
+void main()
+{
+}
+#else
 out vec4 FragColor;
 
 in vec2 TexCoord;
 
+#ifdef CLUSTERED_LIGHTING
+in vec3 ViewPosition;
+
+// The lights moved into view space, the range of each cluster's lights in
+// the index list, and the list, written by the compute shaders
+struct Light
+{
+    vec4 position;
+    vec4 color;
+};
+
+layout (std430, binding = 1) readonly buffer ViewLights
+{
+    Light lights[];
+};
+
+layout (std430, binding = 2) readonly buffer Clusters
+{
+    uvec2 clusters[];
+};
+
+layout (std430, binding = 3) readonly buffer LightIndices
+{
+    uint indexCount;
+    uint lightIndices[];
+};
+
+uniform mat4 projection;
+uniform int clusterCountX;
+uniform int clusterCountY;
+uniform int clusterCountZ;
+// Turn the logarithm of the view depth into the slice of the cluster
+uniform float clusterScale;
+uniform float clusterBias;
+
+vec3 lighting()
+{
+    // Flat normals suit the cubes and need no vertex attribute
+    vec3 normal = normalize(cross(dFdx(ViewPosition), dFdy(ViewPosition)));
+
+    // The tile from the projected position and the slice from the depth,
+    // independent of the size of the target
+    vec4 clip = projection * vec4(ViewPosition, 1.0);
+    ivec2 tile = clamp(ivec2((clip.xy / clip.w * 0.5 + 0.5) *
+        vec2(clusterCountX, clusterCountY)), ivec2(0),
+        ivec2(clusterCountX - 1, clusterCountY - 1));
+    int slice = clamp(int(log(-ViewPosition.z) * clusterScale -
+        clusterBias), 0, clusterCountZ - 1);
+    uvec2 range = clusters[tile.x + clusterCountX *
+        (tile.y + clusterCountY * slice)];
+
+    vec3 light = vec3(AMBIENT);
+    for (uint i = 0u; i < range.y; ++i)
+    {
+        Light source = lights[lightIndices[range.x + i]];
+        vec3 toLight = source.position.xyz - ViewPosition;
+        float falloff = clamp(1.0 - dot(toLight, toLight) /
+            (source.position.w * source.position.w), 0.0, 1.0);
+        light += source.color.rgb * falloff * falloff *
+            max(dot(normal, normalize(toLight)), 0.0);
+    }
+    return light;
+}
+#endif
+
+// Applies the lighting of the permutation to a texture color
+vec4 shade(vec4 color)
+{
+#ifdef CLUSTERED_LIGHTING
+    return vec4(color.rgb * lighting(), color.a);
+#else
+    return color;
+#endif
+}
+
+#if defined(OVERDRAW_VIEW)
+void main()
+{
+    FragColor = vec4(1.0);
+}
+#elif defined(TEXCOORD_VIEW)
+void main()
+{
+    FragColor = vec4(TexCoord, 0.0, 1.0);
+}
+#elif defined(SINGLE_TEXTURE)
+uniform sampler2D texture1;
+
+void main()
+{
+    FragColor = shade(texture(texture1, TexCoord));
+}
+#else
 uniform sampler2D texture1;
 uniform sampler2D texture2;
 
 void main()
 {
-    FragColor = mix(texture(texture1, TexCoord), texture(texture2, TexCoord), 0.78);
-}
\ No newline at end of file
+    FragColor = shade(mix(texture(texture1, TexCoord),
+        texture(texture2, TexCoord), MIX_FACTOR));
+}
+#endif
+#endif
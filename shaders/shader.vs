@@ -1,16 +1,34 @@
 #version 330 core
 
+// Features are defined by the program's permutation, see shader_library.hpp
+//   INSTANCED           reads one model matrix per instance instead of a
+//                       uniform
+//   CLUSTERED_LIGHTING  passes the view space position on for the lights
+
 layout (location = 0) in vec3 vertexPosition;
 layout (location = 1) in vec2 texCoord;
+#ifdef INSTANCED
+// One model matrix per instance, a mat4 takes four attribute locations
+layout (location = 2) in mat4 model;
+#else
+uniform mat4 model;
+#endif
 
 out vec2 TexCoord;
+#ifdef CLUSTERED_LIGHTING
+// The lights are moved into view space, see clustered_lighting.hpp
+out vec3 ViewPosition;
+#endif
 
-uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(vertexPosition, 1.0);
+    vec4 viewPosition = view * model * vec4(vertexPosition, 1.0);
+    gl_Position = projection * viewPosition;
     TexCoord = texCoord;
-}
\ No newline at end of file
+#ifdef CLUSTERED_LIGHTING
+    ViewPosition = viewPosition.xyz;
+#endif
+}
@@ -0,0 +1,730 @@
+#include "modes.hpp"
+#include "baked_material.hpp"
+#include "shader_library.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    // The number of jobs between queuing a read and mapping it
+    constexpr std::size_t READBACK_LATENCY = 2;
+    // The pixel buffer objects of a worker, one per job in flight
+    constexpr std::size_t RING_SIZE = READBACK_LATENCY + 1;
+    // The mapped images waiting per encoder before the workers wait
+    constexpr std::size_t QUEUED_PER_ENCODER = 2;
+    // Larger images are rejected, above the renderbuffer limit of most GPUs
+    constexpr unsigned int MAX_IMAGE_SIZE = 16384;
+    // The most render contexts a batch opens
+    constexpr unsigned int MAX_WORKERS = 64;
+    // Waits up to this long for a fence that is late, in nanoseconds
+    constexpr GLuint64 FENCE_TIMEOUT = 1'000'000'000;
+    // The bytes per read back RGBA8 pixel
+    constexpr std::size_t BYTES_PER_PIXEL = 4;
+
+    using Clock = std::chrono::steady_clock;
+
+    double millisecondsBetween(Clock::time_point from, Clock::time_point to)
+    {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    }
+
+    /**
+     * @struct BatchJob
+     * @brief One image of the job file.
+     */
+    struct BatchJob
+    {
+        float seconds = 0.0f;
+        Renderer::CameraPose camera;
+        unsigned int width = 0;
+        unsigned int height = 0;
+        std::string outputPath;
+    };
+
+    // Parses the WIDTHxHEIGHT field of a job, 0 for a malformed size
+    unsigned int parseSize(const std::string& value, unsigned int& height)
+    {
+        const std::size_t separator = value.find('x');
+        if (separator == std::string::npos || separator == 0 ||
+            value.find_first_not_of("0123456789x") != std::string::npos ||
+            value.find('x', separator + 1) != std::string::npos ||
+            separator + 1 == value.size() || value.size() > 11)
+        {
+            return 0;
+        }
+        const unsigned long width = std::stoul(value.substr(0, separator));
+        const unsigned long rows = std::stoul(value.substr(separator + 1));
+        if (width > MAX_IMAGE_SIZE || rows > MAX_IMAGE_SIZE || rows == 0)
+        {
+            return 0;
+        }
+        height = static_cast<unsigned int>(rows);
+        return static_cast<unsigned int>(width);
+    }
+
+    // Reads the jobs of a job file, see Modes::runBatchRender()
+    std::vector<BatchJob> loadJobs(const std::string& path)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            throw std::runtime_error("ERROR::BATCH::CANNOT OPEN JOB FILE " +
+                path);
+        }
+
+        std::vector<BatchJob> jobs;
+        std::string line;
+        for (std::size_t number = 1; std::getline(file, line); ++number)
+        {
+            line.erase(std::min(line.find('#'), line.size()));
+            if (line.find_first_not_of(" \t\r") == std::string::npos)
+            {
+                continue;
+            }
+
+            BatchJob job;
+            std::string size;
+            std::istringstream fields(line);
+            fields >> job.seconds >> job.camera.yawDegrees >>
+                job.camera.pitchDegrees >> job.camera.distance >> size;
+            std::getline(fields >> std::ws, job.outputPath);
+            job.outputPath.erase(job.outputPath.find_last_not_of(" \t\r") + 1);
+            job.width = parseSize(size, job.height);
+            if (job.width == 0 || job.outputPath.empty() ||
+                !(job.camera.distance > 0.0f))
+            {
+                throw std::runtime_error("ERROR::BATCH::LINE " +
+                    std::to_string(number) + " OF " + path +
+                    " IS NOT \"SECONDS YAW PITCH DISTANCE WIDTHxHEIGHT PATH\"");
+            }
+            jobs.push_back(std::move(job));
+        }
+        if (jobs.empty())
+        {
+            throw std::runtime_error("ERROR::BATCH::NO JOBS IN " + path);
+        }
+        return jobs;
+    }
+
+    /**
+     * @struct EncodeItem
+     * @brief A read back image waiting to be written.
+     */
+    struct EncodeItem
+    {
+        std::size_t job = 0;
+        std::vector<std::uint8_t> pixels;
+    };
+
+    /**
+     * @class EncodeQueue
+     * @brief The bounded queue from the render workers to the encoders,
+     *        which also pools the pixel buffers.
+     */
+    class EncodeQueue
+    {
+    public:
+        explicit EncodeQueue(std::size_t capacity) : capacity_{ capacity },
+            closed_{ false }
+        {
+        }
+
+        /** @brief Takes a pooled buffer, empty if none is free. */
+        std::vector<std::uint8_t> acquire()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (free_.empty())
+            {
+                return std::vector<std::uint8_t>();
+            }
+            std::vector<std::uint8_t> pixels = std::move(free_.back());
+            free_.pop_back();
+            return pixels;
+        }
+
+        /** @brief Gives a buffer back to the pool. */
+        void release(std::vector<std::uint8_t>&& pixels)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            free_.push_back(std::move(pixels));
+        }
+
+        /** @brief Queues an image, waiting while the queue is full. */
+        void push(EncodeItem&& item)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notFull_.wait(lock, [this]() {
+                return items_.size() < capacity_; });
+            items_.push_back(std::move(item));
+            notEmpty_.notify_one();
+        }
+
+        /**
+         * @brief Takes the next image, waiting for one.
+         * @return False once the queue is closed and empty.
+         */
+        bool pop(EncodeItem& item)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notEmpty_.wait(lock, [this]() {
+                return closed_ || !items_.empty(); });
+            if (items_.empty())
+            {
+                return false;
+            }
+            item = std::move(items_.front());
+            items_.pop_front();
+            notFull_.notify_one();
+            return true;
+        }
+
+        /** @brief Lets the encoders finish once the queue is drained. */
+        void close()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+            notEmpty_.notify_all();
+        }
+
+    private:
+        const std::size_t capacity_;
+        std::mutex mutex_;
+        std::condition_variable notFull_;
+        std::condition_variable notEmpty_;
+        std::deque<EncodeItem> items_;
+        std::vector<std::vector<std::uint8_t>> free_;
+        bool closed_;
+    };
+
+    /**
+     * @struct BatchShared
+     * @brief What the render workers share: the jobs, the objects of the
+     *        asset context and the encode queue.
+     */
+    struct BatchShared
+    {
+        const std::vector<BatchJob>& jobs;
+        sf::ContextSettings settings;
+        Renderer::DebugLogSettings debugLog;
+        std::string vertexSource;
+        std::string fragSource;
+        Renderer::PermutationKey features = 0;
+        // Bound to the first and second texture unit, 0 for none
+        GLuint firstTexture = 0;
+        GLuint secondTexture = 0;
+        EncodeQueue& queue;
+        // The next job no worker has claimed yet
+        std::atomic<std::size_t> nextJob{ 0 };
+        // Set when a worker failed, the others stop claiming jobs
+        std::atomic<bool> failed{ false };
+    };
+
+    /**
+     * @struct WorkerStats
+     * @brief The work of one render worker.
+     */
+    struct WorkerStats
+    {
+        std::size_t images = 0;
+        // Issuing the draw, the resolve and the read
+        double renderMs = 0.0;
+        // Waiting for reads that were not done two jobs later
+        double readbackWaitMs = 0.0;
+        // Waiting for the encoders to catch up
+        double queueWaitMs = 0.0;
+        std::exception_ptr error;
+    };
+
+    /**
+     * @class BatchWorker
+     * @brief Renders jobs on an offscreen context of its own.
+     *
+     * The scene is drawn into a multisampled framebuffer, like dynamic
+     * resolution does, resolved into a single sampled one and read into
+     * the pixel buffer of the job.
+     */
+    class BatchWorker
+    {
+    public:
+        /**
+         * @brief Creates and activates the context, then compiles the
+         *        program and uploads the cube into it.
+         */
+        BatchWorker(BatchShared& shared, WorkerStats& stats) :
+            shared_{ shared }, stats_{ stats },
+            context_(shared.settings, sf::Vector2u(1, 1)),
+            device_(std::make_unique<Renderer::GlDevice>(shared.debugLog)),
+            shaders_(device_, Renderer::ShaderSource{ shared.vertexSource },
+                Renderer::ShaderSource{ shared.fragSource }),
+            resources_(device_), cube_(resources_), width_{ 0 },
+            height_{ 0 }, slots_(), issued_{ 0 }, collected_{ 0 }
+        {
+            sceneFramebuffer_ = device_.createFramebuffer();
+            sceneColor_ = device_.createRenderbuffer();
+            sceneDepth_ = device_.createRenderbuffer();
+            resolveFramebuffer_ = device_.createFramebuffer();
+            resolveColor_ = device_.createRenderbuffer();
+            for (Slot& slot : slots_)
+            {
+                glGenBuffers(1, &slot.buffer);
+            }
+
+            device_.enable(GL_DEPTH_TEST);
+            device_.clearColor(Renderer::GlConstants::CLEAR_COLOR_RED,
+                Renderer::GlConstants::CLEAR_COLOR_GREEN,
+                Renderer::GlConstants::CLEAR_COLOR_BLUE,
+                Renderer::GlConstants::CLEAR_COLOR_OPACITY);
+            shaders_.get(shared.features);
+        }
+
+        /** @brief Deletes the objects while the context is still active. */
+        ~BatchWorker()
+        {
+            for (Slot& slot : slots_)
+            {
+                if (slot.fence != nullptr)
+                {
+                    glDeleteSync(slot.fence);
+                }
+                glDeleteBuffers(1, &slot.buffer);
+                Renderer::trackRelease(Renderer::MemoryCategory::GPU_BUFFER,
+                    slot.capacity);
+            }
+            device_.deleteFramebuffer(sceneFramebuffer_);
+            device_.deleteFramebuffer(resolveFramebuffer_);
+            device_.deleteRenderbuffer(sceneColor_);
+            device_.deleteRenderbuffer(sceneDepth_);
+            device_.deleteRenderbuffer(resolveColor_);
+        }
+
+        // Delete copy constructor and copy assignment operator
+        BatchWorker(const BatchWorker&) = delete;
+        BatchWorker& operator=(const BatchWorker&) = delete;
+
+        /** @brief Renders jobs until none is left, then drains the reads. */
+        void run()
+        {
+            while (!shared_.failed)
+            {
+                const std::size_t job = shared_.nextJob++;
+                if (job >= shared_.jobs.size())
+                {
+                    break;
+                }
+                if (issued_ - collected_ == RING_SIZE)
+                {
+                    collect();
+                }
+                render(job);
+            }
+            while (collected_ < issued_)
+            {
+                collect();
+            }
+        }
+
+    private:
+        /**
+         * @struct Slot
+         * @brief A pixel buffer object and the fence of its pending read.
+         */
+        struct Slot
+        {
+            GLuint buffer = 0;
+            GLsync fence = nullptr;
+            std::size_t job = 0;
+            std::size_t capacity = 0;
+        };
+
+        // Allocates the framebuffers at the size of a job
+        void allocate(GLsizei width, GLsizei height)
+        {
+            width_ = width;
+            height_ = height;
+            device_.bindRenderbuffer(sceneColor_);
+            device_.renderbufferStorage(Renderer::ResolutionConstants::SAMPLES,
+                GL_RGBA8, width, height);
+            device_.bindRenderbuffer(sceneDepth_);
+            device_.renderbufferStorage(Renderer::ResolutionConstants::SAMPLES,
+                GL_DEPTH24_STENCIL8, width, height);
+            device_.bindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer_);
+            device_.framebufferRenderbuffer(GL_FRAMEBUFFER,
+                GL_COLOR_ATTACHMENT0, sceneColor_);
+            device_.framebufferRenderbuffer(GL_FRAMEBUFFER,
+                GL_DEPTH_STENCIL_ATTACHMENT, sceneDepth_);
+            const GLenum sceneStatus =
+                device_.checkFramebufferStatus(GL_FRAMEBUFFER);
+
+            device_.bindRenderbuffer(resolveColor_);
+            device_.renderbufferStorage(0, GL_RGBA8, width, height);
+            device_.bindFramebuffer(GL_FRAMEBUFFER, resolveFramebuffer_);
+            device_.framebufferRenderbuffer(GL_FRAMEBUFFER,
+                GL_COLOR_ATTACHMENT0, resolveColor_);
+            const GLenum resolveStatus =
+                device_.checkFramebufferStatus(GL_FRAMEBUFFER);
+            device_.bindRenderbuffer(0);
+
+            if (sceneStatus != GL_FRAMEBUFFER_COMPLETE ||
+                resolveStatus != GL_FRAMEBUFFER_COMPLETE)
+            {
+                throw std::runtime_error(
+                    "ERROR::BATCH::FRAMEBUFFER INCOMPLETE");
+            }
+        }
+
+        // Draws a job and queues the read of its pixels
+        void render(std::size_t job)
+        {
+            const Clock::time_point start = Clock::now();
+            const BatchJob& batchJob = shared_.jobs[job];
+            const GLsizei width = static_cast<GLsizei>(batchJob.width);
+            const GLsizei height = static_cast<GLsizei>(batchJob.height);
+            if (width != width_ || height != height_)
+            {
+                allocate(width, height);
+            }
+
+            device_.bindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer_);
+            device_.viewport(0, 0, width, height);
+            device_.clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            device_.activeTexture(Renderer::GlConstants::DEFAULT_TEXTURE);
+            device_.bindTexture(GL_TEXTURE_2D, shared_.firstTexture);
+            device_.activeTexture(Renderer::GlConstants::DEFAULT_TEXTURE + 1);
+            device_.bindTexture(GL_TEXTURE_2D, shared_.secondTexture);
+
+            const Renderer::ShaderProgram& program =
+                shaders_.get(shared_.features);
+            device_.useProgram(program.getProgramID());
+            program.setUniform("texture1",
+                Renderer::GlConstants::DEFAULT_TEXTURE_UNIT);
+            program.setUniform("texture2",
+                Renderer::GlConstants::DEFAULT_TEXTURE_UNIT + 1);
+            const Renderer::SceneTransforms transforms =
+                Renderer::computeSceneTransforms(batchJob.seconds,
+                    static_cast<float>(width) / static_cast<float>(height),
+                    batchJob.camera);
+            program.setUniform("model", transforms.model);
+            program.setUniform("projection", transforms.projection);
+            program.setUniform("view", transforms.view);
+            device_.bindVertexArray(cube_.getVAOId());
+            device_.drawArrays(GL_TRIANGLES, 0, Geometry::CUBE_VERTEX_COUNT);
+
+            // Resolve the samples, then read the resolved frame without
+            // waiting for it
+            device_.bindFramebuffer(GL_READ_FRAMEBUFFER, sceneFramebuffer_);
+            device_.bindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFramebuffer_);
+            device_.blitFramebuffer(0, 0, width, height, 0, 0, width, height,
+                GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            device_.bindFramebuffer(GL_READ_FRAMEBUFFER, resolveFramebuffer_);
+
+            Slot& slot = slots_[issued_ % RING_SIZE];
+            const std::size_t size = static_cast<std::size_t>(width) *
+                static_cast<std::size_t>(height) * BYTES_PER_PIXEL;
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+            if (slot.capacity < size)
+            {
+                glBufferData(GL_PIXEL_PACK_BUFFER,
+                    static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_READ);
+                Renderer::trackAllocation(
+                    Renderer::MemoryCategory::GPU_BUFFER, size);
+                Renderer::trackRelease(Renderer::MemoryCategory::GPU_BUFFER,
+                    slot.capacity);
+                slot.capacity = size;
+            }
+            glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+                nullptr);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            slot.job = job;
+            ++issued_;
+            device_.bindFramebuffer(GL_FRAMEBUFFER, 0);
+
+            // Submit now, the read is mapped once later jobs are issued
+            glFlush();
+            stats_.renderMs += millisecondsBetween(start, Clock::now());
+        }
+
+        // Maps the oldest read and queues its pixels for encoding
+        void collect()
+        {
+            Slot& slot = slots_[collected_ % RING_SIZE];
+            ++collected_;
+            const BatchJob& job = shared_.jobs[slot.job];
+            const std::size_t size = static_cast<std::size_t>(job.width) *
+                job.height * BYTES_PER_PIXEL;
+
+            const Clock::time_point waitStart = Clock::now();
+            const GLenum status = glClientWaitSync(slot.fence,
+                GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+            stats_.readbackWaitMs += millisecondsBetween(waitStart,
+                Clock::now());
+            if (status == GL_WAIT_FAILED || status == GL_TIMEOUT_EXPIRED)
+            {
+                throw std::runtime_error("ERROR::BATCH::READ BACK OF " +
+                    job.outputPath + " TIMED OUT");
+            }
+
+            EncodeItem item;
+            item.job = slot.job;
+            item.pixels = shared_.queue.acquire();
+            item.pixels.resize(size);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+            const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                static_cast<GLsizeiptr>(size), GL_MAP_READ_BIT);
+            bool copied = false;
+            if (mapped != nullptr)
+            {
+                std::memcpy(item.pixels.data(), mapped, size);
+                copied = glUnmapBuffer(GL_PIXEL_PACK_BUFFER) == GL_TRUE;
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            if (!copied)
+            {
+                throw std::runtime_error("ERROR::BATCH::CANNOT MAP " +
+                    job.outputPath);
+            }
+
+            const Clock::time_point pushStart = Clock::now();
+            shared_.queue.push(std::move(item));
+            stats_.queueWaitMs += millisecondsBetween(pushStart, Clock::now());
+            ++stats_.images;
+        }
+
+        BatchShared& shared_;
+        WorkerStats& stats_;
+        // Declared first of the OpenGL members, so it is destroyed last
+        sf::Context context_;
+        Renderer::MemoryTrackingDevice device_;
+        Renderer::ShaderLibrary shaders_;
+        // The buffers of the cube, deleted with the pool after it
+        Renderer::GpuResources resources_;
+        Renderer::BufferSetup cube_;
+        GLuint sceneFramebuffer_;
+        GLuint sceneColor_;
+        GLuint sceneDepth_;
+        GLuint resolveFramebuffer_;
+        GLuint resolveColor_;
+        GLsizei width_;
+        GLsizei height_;
+        std::array<Slot, RING_SIZE> slots_;
+        std::size_t issued_;
+        std::size_t collected_;
+    };
+
+    // Renders jobs on a context of the calling thread, recording a failure
+    void renderWorker(BatchShared& shared, WorkerStats& stats)
+    {
+        try
+        {
+            BatchWorker worker(shared, stats);
+            worker.run();
+        }
+        catch (...)
+        {
+            stats.error = std::current_exception();
+            shared.failed = true;
+        }
+    }
+
+    /**
+     * @struct EncoderStats
+     * @brief The work of one encoder.
+     */
+    struct EncoderStats
+    {
+        std::size_t written = 0;
+        double encodeMs = 0.0;
+        std::vector<std::string> failedPaths;
+    };
+
+    // Writes the queued images as PNG files until the queue is closed
+    void encodeWorker(const std::vector<BatchJob>& jobs, EncodeQueue& queue,
+        EncoderStats& stats)
+    {
+        EncodeItem item;
+        while (queue.pop(item))
+        {
+            const Clock::time_point start = Clock::now();
+            const BatchJob& job = jobs[item.job];
+            // OpenGL returns the rows bottom to top
+            sf::Image image(sf::Vector2u(job.width, job.height),
+                item.pixels.data());
+            image.flipVertically();
+            if (image.saveToFile(job.outputPath))
+            {
+                ++stats.written;
+            }
+            else
+            {
+                stats.failedPaths.push_back(job.outputPath);
+            }
+            stats.encodeMs += millisecondsBetween(start, Clock::now());
+            queue.release(std::move(item.pixels));
+        }
+    }
+}
+
+int Modes::runBatchRender(const Options::LaunchOptions& options)
+{
+    const Clock::time_point start = Clock::now();
+    try
+    {
+        const std::vector<BatchJob> jobs = loadJobs(options.batchPath);
+
+        // Half the cores render and the rest encode, unless told otherwise
+        const unsigned int cores =
+            std::max(std::thread::hardware_concurrency(), 1u);
+        const unsigned int workers = static_cast<unsigned int>(
+            std::min<std::size_t>(std::clamp(options.workers != 0 ?
+                options.workers : cores / 2, 1u, MAX_WORKERS), jobs.size()));
+        const unsigned int encoders = std::max(cores - std::min(cores,
+            workers), 1u);
+
+        // The asset context is active on this thread until the end. The
+        // samples are resolved from offscreen framebuffers instead of a
+        // multisampled default framebuffer
+        sf::ContextSettings settings = WindowAttributes::getSettings();
+        settings.antiAliasingLevel = 0;
+        sf::Context context(settings, sf::Vector2u(1, 1));
+        if (!gladLoadGL())
+        {
+            throw std::runtime_error("ERROR::BATCH::CANNOT LOAD OPENGL");
+        }
+        Renderer::MemoryTrackingDevice device(
+            std::make_unique<Renderer::GlDevice>(options.debugLog));
+
+        // Decode both textures at once and upload them once for every
+        // worker, the contexts of SFML share their objects
+        const Clock::time_point setupStart = Clock::now();
+        std::vector<Renderer::TextureImage> textureImages =
+            Renderer::decodeTextureImages({ Env::SHELF_TEXTURE_PATH,
+                Env::DUCKY_TEXTURE_PATH }, Renderer::ImageSettings(), 2);
+        // The textures live as long as the batch, so their pool only
+        // deletes them at the end
+        Renderer::GpuResources resources(device);
+        Renderer::Texture shelf(resources, textureImages[0]);
+        Renderer::Texture ducky(resources, textureImages[1]);
+        textureImages.clear();
+
+        EncodeQueue queue(encoders * QUEUED_PER_ENCODER);
+        BatchShared shared{ jobs, settings, options.debugLog,
+            Renderer::loadShaderSource(Env::VERTEX_SHADER_PATH).code,
+            Renderer::loadShaderSource(Env::FRAG_SHADER_PATH).code,
+            Renderer::materialFeatures(options.scene), shelf.getTexID(),
+            ducky.getTexID(), queue };
+
+        // Bake the mix once when the scene samples it, like GL_State
+        std::unique_ptr<Renderer::BakedMaterial> material;
+        if (options.scene.bakeMaterial &&
+            options.scene.debugView == Renderer::DebugView::OFF)
+        {
+            material = std::make_unique<Renderer::BakedMaterial>(device);
+            material->setSources(
+                { shelf.getTexID(), shelf.getWidth(), shelf.getHeight(),
+                    shelf.getHandle() },
+                { ducky.getTexID(), ducky.getWidth(), ducky.getHeight(),
+                    ducky.getHandle() });
+            material->bake();
+            shared.firstTexture = material->getTexture();
+            shared.secondTexture = 0;
+        }
+
+        // Other contexts may only use the objects once they are complete
+        glFinish();
+        const double setupMs = millisecondsBetween(setupStart, Clock::now());
+
+        const Clock::time_point renderStart = Clock::now();
+        std::vector<EncoderStats> encoderStats(encoders);
+        std::vector<std::thread> encoderThreads;
+        for (EncoderStats& stats : encoderStats)
+        {
+            encoderThreads.emplace_back(encodeWorker, std::cref(jobs),
+                std::ref(queue), std::ref(stats));
+        }
+        std::vector<WorkerStats> workerStats(workers);
+        std::vector<std::thread> workerThreads;
+        for (WorkerStats& stats : workerStats)
+        {
+            workerThreads.emplace_back(renderWorker, std::ref(shared),
+                std::ref(stats));
+        }
+        for (std::thread& thread : workerThreads)
+        {
+            thread.join();
+        }
+        queue.close();
+        for (std::thread& thread : encoderThreads)
+        {
+            thread.join();
+        }
+        const double renderSeconds = millisecondsBetween(renderStart,
+            Clock::now()) / 1000.0;
+
+        for (const WorkerStats& stats : workerStats)
+        {
+            if (stats.error)
+            {
+                std::rethrow_exception(stats.error);
+            }
+        }
+
+        // Report the throughput and where the workers spent their time
+        WorkerStats total;
+        std::cout << "Batch: " << jobs.size() << " images, " << workers
+            << " render contexts, " << encoders << " encoders\n";
+        std::cout << "  images per worker:";
+        for (const WorkerStats& stats : workerStats)
+        {
+            std::cout << ' ' << stats.images;
+            total.images += stats.images;
+            total.renderMs += stats.renderMs;
+            total.readbackWaitMs += stats.readbackWaitMs;
+            total.queueWaitMs += stats.queueWaitMs;
+        }
+        std::size_t written = 0;
+        double encodeMs = 0.0;
+        std::vector<std::string> failedPaths;
+        for (const EncoderStats& stats : encoderStats)
+        {
+            written += stats.written;
+            encodeMs += stats.encodeMs;
+            failedPaths.insert(failedPaths.end(), stats.failedPaths.begin(),
+                stats.failedPaths.end());
+        }
+        const double images = static_cast<double>(std::max<std::size_t>(
+            total.images, 1));
+        std::cout << "\n  setup: " << setupMs << " ms, rendering: "
+            << renderSeconds << " s, "
+            << static_cast<double>(written) / renderSeconds
+            << " images per second\n";
+        std::cout << "  ms per image: render " << total.renderMs / images
+            << ", read back wait " << total.readbackWaitMs / images
+            << ", encoder queue wait " << total.queueWaitMs / images
+            << ", PNG encode " << encodeMs / images << '\n';
+        std::cout << "  total: " << millisecondsBetween(start, Clock::now())
+            / 1000.0 << " s, " << written << " written, "
+            << failedPaths.size() << " failed\n";
+        for (const std::string& path : failedPaths)
+        {
+            std::cerr << "ERROR::BATCH::CANNOT WRITE " << path << '\n';
+        }
+        return failedPaths.empty() ? 0 : 1;
+    }
+    catch (const std::exception& except)
+    {
+        // A malformed job file, missing assets or a failed worker end the
+        // batch
+        std::cerr << except.what() << '\n';
+        return 1;
+    }
+}
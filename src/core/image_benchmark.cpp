@@ -0,0 +1,216 @@
+#include "modes.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <thread>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Every way runs this many rounds and reports its fastest, the first
+    // one pays for cold file caches
+    constexpr int ROUNDS = 5;
+    // The side of the generated RGB image the kernels are measured on
+    constexpr int GENERATED_SIZE = 4096;
+
+    // The fastest round of a way and the stage times of that round
+    struct Measurement
+    {
+        double wallMs = std::numeric_limits<double>::infinity();
+        Renderer::ImageTimings stages;
+    };
+
+    void addStages(Renderer::ImageTimings& total,
+        const Renderer::ImageTimings& stages)
+    {
+        total.decodeMs += stages.decodeMs;
+        total.convertMs += stages.convertMs;
+        total.mipMs += stages.mipMs;
+    }
+
+    // Runs a way for every round, it returns the stage times of its images
+    Measurement measure(const std::function<Renderer::ImageTimings()>& run)
+    {
+        Measurement best;
+        for (int round = 0; round < ROUNDS; ++round)
+        {
+            const Clock::time_point start = Clock::now();
+            const Renderer::ImageTimings stages = run();
+            const double wallMs = std::chrono::duration<double, std::milli>(
+                Clock::now() - start).count();
+            if (wallMs < best.wallMs)
+            {
+                best.wallMs = wallMs;
+                best.stages = stages;
+            }
+        }
+        return best;
+    }
+
+    void report(const char* name, const Measurement& measurement,
+        double baselineMs)
+    {
+        std::cout << "  " << name << ": " << measurement.wallMs << " ms ("
+            << baselineMs / measurement.wallMs << "x); decode "
+            << measurement.stages.decodeMs << ", convert "
+            << measurement.stages.convertMs << ", mipmaps "
+            << measurement.stages.mipMs << '\n';
+    }
+
+    // Prepares every image one after the other
+    Renderer::ImageTimings prepareSerially(
+        const std::vector<std::string>& paths,
+        const Renderer::ImageSettings& settings)
+    {
+        Renderer::ImageTimings stages;
+        for (const std::string& path : paths)
+        {
+            const Renderer::TextureImage image(path, settings);
+            addStages(stages, image.getTimings());
+        }
+        return stages;
+    }
+
+    // Prepares every image at once on the worker threads
+    Renderer::ImageTimings prepareInParallel(
+        const std::vector<std::string>& paths,
+        const Renderer::ImageSettings& settings, std::size_t workers)
+    {
+        Renderer::ImageTimings stages;
+        for (const Renderer::TextureImage& image :
+            Renderer::decodeTextureImages(paths, settings, workers))
+        {
+            addStages(stages, image.getTimings());
+        }
+        return stages;
+    }
+
+    // Tells whether two images have the same levels, byte for byte
+    bool sameLevels(const Renderer::TextureImage& first,
+        const Renderer::TextureImage& second)
+    {
+        return first.getByteSize() == second.getByteSize() &&
+            std::memcmp(first.getLevelData(0), second.getLevelData(0),
+                first.getByteSize()) == 0;
+    }
+}
+
+int Modes::runImageBenchmark(const Options::LaunchOptions& options)
+{
+    const std::vector<std::string>& paths = options.benchmarkImages;
+    const std::size_t workers = options.workers > 0 ? options.workers :
+        std::max(std::thread::hardware_concurrency(), 1u);
+
+    try
+    {
+        std::cout << "Image benchmark: " << paths.size() << " images, "
+            << std::min(workers, paths.size()) << " threads, SSE2 kernels "
+            << (Renderer::hasImageSimd() ? "on" : "not compiled in") << '\n';
+        for (const std::string& path : paths)
+        {
+            int width = 0;
+            int height = 0;
+            int channels = 0;
+            if (stbi_info(path.c_str(), &width, &height, &channels) == 0)
+            {
+                throw std::domain_error("ERROR::CANNOT LOAD IMAGE " + path);
+            }
+            std::cout << "    " << path << ": " << width << 'x' << height
+                << ", " << channels << " channels\n";
+        }
+
+        // The decoding of the textures before TextureImage, the driver
+        // converted and filtered the mipmaps on upload
+        const Measurement baseline = measure([&paths]() {
+            Renderer::ImageTimings stages;
+            for (const std::string& path : paths)
+            {
+                const Clock::time_point start = Clock::now();
+                const Renderer::Image image(path);
+                stages.decodeMs += std::chrono::duration<double, std::milli>(
+                    Clock::now() - start).count();
+            }
+            return stages;
+        });
+        std::cout << "  time of the fastest of " << ROUNDS << " rounds, "
+            << "speedup over the decoding alone, CPU time of the stages "
+            << "summed over the images (ms)\n";
+        report("decoding alone, serial", baseline, baseline.wallMs);
+
+        Renderer::ImageSettings linear;
+        linear.simd = false;
+        report("box mipmaps, scalar, serial", measure([&]() {
+            return prepareSerially(paths, linear); }), baseline.wallMs);
+        linear.simd = true;
+        report("box mipmaps, SSE2, serial", measure([&]() {
+            return prepareSerially(paths, linear); }), baseline.wallMs);
+        report("box mipmaps, SSE2, parallel", measure([&]() {
+            return prepareInParallel(paths, linear, workers); }),
+            baseline.wallMs);
+
+        Renderer::ImageSettings srgb;
+        srgb.colorSpace = Renderer::ColorSpace::SRGB;
+        srgb.premultiplyAlpha = true;
+        report("sRGB premultiplied box mipmaps, parallel", measure([&]() {
+            return prepareInParallel(paths, srgb, workers); }),
+            baseline.wallMs);
+        srgb.mipFilter = Renderer::MipFilter::KAISER;
+        report("sRGB premultiplied Kaiser mipmaps, parallel", measure([&]() {
+            return prepareInParallel(paths, srgb, workers); }),
+            baseline.wallMs);
+
+        // The kernels alone on an image larger than the textures, with a
+        // pattern that differs in every channel
+        std::vector<unsigned char> generated(
+            static_cast<std::size_t>(GENERATED_SIZE) * GENERATED_SIZE * 3);
+        for (int y = 0; y < GENERATED_SIZE; ++y)
+        {
+            for (int x = 0; x < GENERATED_SIZE; ++x)
+            {
+                unsigned char* pixel = &generated[(static_cast<std::size_t>(
+                    y) * GENERATED_SIZE + x) * 3];
+                pixel[0] = static_cast<unsigned char>(x);
+                pixel[1] = static_cast<unsigned char>(y);
+                pixel[2] = static_cast<unsigned char>(x ^ y);
+            }
+        }
+        std::cout << "  kernels on a generated " << GENERATED_SIZE << 'x'
+            << GENERATED_SIZE << " RGB image, premultiplied box mipmaps "
+            << "(ms)\n";
+        Renderer::ImageSettings kernels;
+        kernels.premultiplyAlpha = true;
+        for (const bool simd : { false, true })
+        {
+            kernels.simd = simd;
+            const Measurement measurement = measure([&]() {
+                return Renderer::TextureImage(generated.data(),
+                    GENERATED_SIZE, GENERATED_SIZE, 3, kernels).getTimings();
+            });
+            std::cout << "    " << (simd ? "SSE2" : "scalar") << ": convert "
+                << measurement.stages.convertMs << ", mipmaps "
+                << measurement.stages.mipMs << '\n';
+        }
+        kernels.simd = false;
+        const Renderer::TextureImage scalar(generated.data(), GENERATED_SIZE,
+            GENERATED_SIZE, 3, kernels);
+        kernels.simd = true;
+        const Renderer::TextureImage vector(generated.data(), GENERATED_SIZE,
+            GENERATED_SIZE, 3, kernels);
+        if (!sameLevels(scalar, vector))
+        {
+            std::cerr << "ERROR::IMAGE_BENCHMARK::KERNELS DISAGREE\n";
+            return 1;
+        }
+    }
+    catch (const std::exception& except)
+    {
+        // Missing images end the run
+        std::cerr << except.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -1,18 +1,147 @@
-#include "renderer.hpp"
+#include "modes.hpp"
+#include "capture.hpp"
+#include "frame_pacer.hpp"
+#include "frame_stream.hpp"
+#include "trace.hpp"
+#include <chrono>
 #include <iostream> 
 
-int main()
+int main(int argc, char* argv[])
 {
-    // Declare unique pointers for the SFML window and OpenGL state
+    // Time to first frame and the startup are measured from here
+    const std::chrono::steady_clock::time_point launchTime =
+        std::chrono::steady_clock::now();
+    const auto millisecondsSinceLaunch = [&launchTime]()
+    {
+        return std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - launchTime).count();
+    };
+
+    // Select the backend and modes from the command line
+    Options::LaunchOptions options;
+    try
+    {
+        options = Options::parseArguments(argc, argv);
+    }
+    catch(const std::invalid_argument& except)
+    {
+        std::cerr << except.what();
+        return 1;
+    }
+
+    // Image decoding is measured on the CPU alone
+    if (options.imageBenchmark)
+    {
+        return Modes::runImageBenchmark(options);
+    }
+
+    // The software rasterizer is measured headless at every worker count
+    if (options.softwareBenchmark)
+    {
+        return Modes::runSoftwareBenchmark(options);
+    }
+
+    // The null backend measures CPU overhead headless, without a window
+    if (options.backend == Renderer::BackendType::NULL_DEVICE)
+    {
+        return Modes::runNullBenchmark(options);
+    }
+
+    // Batches render offscreen, on contexts of their own
+    if (!options.batchPath.empty())
+    {
+        return Modes::runBatchRender(options);
+    }
+
+    // Declare unique pointers for the SFML window and render state
     std::unique_ptr<Window> window;
-    std::unique_ptr<Renderer::GL_State> gl;
+    std::unique_ptr<Renderer::RenderState> gl;
+    // Records the calls of the OpenGL backend when --record is given
+    Renderer::TraceRecorder* recorder = nullptr;
+    // Reads back the displayed frames when --capture is given, restarted
+    // into a numbered output whenever the window changes size
+    std::unique_ptr<Renderer::FrameCapture> capture;
+    std::string capturePath = options.capturePath;
+    unsigned int captureSegment = 0;
+    // Serves the displayed frames to a remote viewer when --stream is given
+    std::unique_ptr<Renderer::FrameStreamServer> stream;
     try
     {
         // Create the SFML window, throws runtime error if fails
-        window = std::make_unique<Window>();
+        sf::ContextSettings settings = WindowAttributes::getSettings();
+        if (options.resolution.enabled)
+        {
+            // The offscreen framebuffer is multisampled instead, a blit
+            // cannot scale into a multisampled window
+            settings.antiAliasingLevel = 0;
+        }
+        window = std::make_unique<Window>(settings);
+
+        // The grid is culled and the lights are assigned with compute
+        // shaders, both scenes are drawn indirectly
+        const sf::ContextSettings& context = window->getSettings();
+        if (options.scene.type != Renderer::SceneType::CUBE &&
+            context.majorVersion * 10 + context.minorVersion < 43)
+        {
+            throw std::runtime_error(
+                "ERROR::THE GRID AND LIGHTS SCENES NEED OPENGL 4.3");
+        }
 
-        // Initialize the OpenGL state 
-        gl = std::make_unique<Renderer::GL_State>();
+        // Pipeline statistics are core in 4.6 and an extension before,
+        // without them the other diagnostics still work
+        if (options.scene.pipelineStatistics &&
+            context.majorVersion * 10 + context.minorVersion < 46 &&
+            !sf::Context::isExtensionAvailable(
+                "GL_ARB_pipeline_statistics_query"))
+        {
+            std::cerr << "Pipeline statistics are not supported by the "
+                "driver, measuring none\n";
+            options.scene.pipelineStatistics = false;
+        }
+
+        // Initialize the render state of the selected backend
+        if (!options.recordPath.empty())
+        {
+            if (options.backend != Renderer::BackendType::OPENGL)
+            {
+                throw std::runtime_error(
+                    "ERROR::RECORDING NEEDS THE OPENGL BACKEND");
+            }
+            auto device = std::make_unique<Renderer::TraceRecorder>(
+                std::make_unique<Renderer::GlDevice>(options.debugLog),
+                options.recordPath);
+            recorder = device.get();
+            auto state = std::make_unique<Renderer::GL_State>(
+                std::make_unique<Renderer::MemoryTrackingDevice>(
+                    std::move(device)), options.resolution, options.scene);
+            // The setup, including every texture upload, is the first
+            // segment of the trace
+            state->finishLoading();
+            gl = std::move(state);
+            recorder->endFrame();
+        }
+        else
+        {
+            gl = Renderer::createRenderState(options.backend,
+                options.resolution, options.scene, options.debugLog);
+        }
+
+        if (!options.capturePath.empty())
+        {
+            const sf::Vector2u size = window->getSize();
+            capture = std::make_unique<Renderer::FrameCapture>(
+                options.capturePath, size.x, size.y,
+                WindowAttributes::FRAMERATE_LIMIT);
+        }
+
+        if (options.stream)
+        {
+            const sf::Vector2u size = window->getSize();
+            stream = std::make_unique<Renderer::FrameStreamServer>(
+                options.streamPort, size.x, size.y);
+            std::cout << "Streaming frames on port " << stream->getPort()
+                << '\n';
+        }
     }
     catch(const std::runtime_error& except)
     {
@@ -20,34 +149,249 @@ int main()
         std::cerr << except.what();
         return 0;
     }
-    // Disallow unlimited fps 
-    window->setFramerateLimit(60);
+    // Disallow unlimited fps, a delayed frame start sleeps for the limit
+    // before reading the input instead of after the swap
+    if (!options.latency.delayFrameStart)
+    {
+        window->setFramerateLimit(WindowAttributes::FRAMERATE_LIMIT);
+    }
+    // Limits the frames in flight and measures the input latency
+    auto pacer = std::make_unique<Renderer::FramePacer>(options.latency,
+        1000.0 / WindowAttributes::FRAMERATE_LIMIT);
+
+    // Writes the frames still in flight and reports the capture
+    const auto finishCapture = [&]()
+    {
+        const Renderer::CaptureStats stats = capture->finish();
+        std::cout << "Captured " << stats.captured << " frames to "
+            << capturePath << ": " << stats.written << " written, "
+            << stats.dropped << " dropped, " << stats.failed << " failed, "
+            << stats.stalls << " read back stalls\n";
+        capture.reset();
+    };
+
+    // Closes the window, finishing the capture and deleting the OpenGL
+    // objects while its context is alive
+    std::string summary;
+    const auto closeWindow = [&]()
+    {
+        if (capture)
+        {
+            finishCapture();
+        }
+        summary = gl->getSummary() + pacer->getSummary();
+        if (stream)
+        {
+            stream->finish();
+            summary += stream->getSummary();
+            stream.reset();
+        }
+        gl.reset();
+        pacer.reset();
+        window->close();
+    };
+
+    // Raises the least severe debug message logged, wrapping around from
+    // off to notifications, if debug output was enabled at startup
+    const auto cycleDebugSeverity = [&]()
+    {
+        Renderer::DebugLog* debugLog = gl->getDebugLog();
+        if (debugLog == nullptr)
+        {
+            return;
+        }
+        static const char* const names[] = { "notification", "low",
+            "medium", "high", "off" };
+        const auto next = static_cast<Renderer::DebugSeverity>(
+            (static_cast<int>(debugLog->getMinimumSeverity()) + 1) %
+            (static_cast<int>(Renderer::DebugSeverity::OFF) + 1));
+        debugLog->setMinimumSeverity(next);
+        std::cout << "GL debug severity: " << names[static_cast<int>(next)]
+            << '\n';
+    };
 
     // Main application loop
+    bool firstFrame = true;
+    bool loading = true;
+    // Background and minimized windows are not drawn in on-demand mode,
+    // unless a background window is streamed to a viewer
+    bool focused = true;
+    bool minimized = false;
+    std::uint64_t framesDrawn = 0;
     while (window->isOpen())
     {
-        while (const std::optional event = window->pollEvent())
+        // With nothing to draw, sleep until an event may change that, or
+        // until the input of a viewer is due to be checked
+        const bool idle = options.onDemand &&
+            ((!focused && !stream) || minimized || !gl->needsRedraw());
+        if (!idle)
+        {
+            // Wait for the GPU before the input is read, not after
+            pacer->beginFrame();
+        }
+        const sf::Time idleTimeout = stream ? sf::milliseconds(
+            Renderer::StreamServerConstants::POLL_INTERVAL_MS) : sf::Time::Zero;
+        for (std::optional event = idle ? window->waitEvent(idleTimeout) :
+            window->pollEvent(); event; event = window->pollEvent())
         {
             if (event->is<sf::Event::Closed>())
             {
-	            window->close();
+	            closeWindow();
+                break;
+            }
+            else if (const auto* resized = event->getIf<sf::Event::Resized>())
+            {
+                // Minimized windows report an empty size, keep the last one
+                minimized = resized->size.x == 0 || resized->size.y == 0;
+                if (!minimized)
+                {
+                    window->setView(sf::View(sf::FloatRect({ 0.0f, 0.0f },
+                        sf::Vector2f(resized->size))));
+                    gl->resize(resized->size.x, resized->size.y);
+                    if (stream)
+                    {
+                        stream->resize(resized->size.x, resized->size.y);
+                    }
+                    if (capture && (capture->getWidth() != resized->size.x ||
+                        capture->getHeight() != resized->size.y))
+                    {
+                        // The frames of a capture all have its size
+                        finishCapture();
+                        capturePath = Renderer::numberCapturePath(
+                            options.capturePath, ++captureSegment);
+                        try
+                        {
+                            capture = std::make_unique<Renderer::FrameCapture>(
+                                capturePath, resized->size.x, resized->size.y,
+                                WindowAttributes::FRAMERATE_LIMIT);
+                        }
+                        catch (const std::runtime_error& except)
+                        {
+                            // Keep rendering without capturing
+                            std::cerr << except.what() << '\n';
+                        }
+                    }
+                }
+            }
+            else if (event->is<sf::Event::FocusLost>())
+            {
+                focused = false;
+            }
+            else if (event->is<sf::Event::FocusGained>())
+            {
+                // The window may have been covered in the meantime
+                focused = true;
+                gl->invalidate();
             }
             else if (const auto* key_pressed = event->getIf<sf::Event::KeyPressed>())
             {
                 if (key_pressed->scancode == sf::Keyboard::Scancode::Escape)
                 {
-	                window->close();
+	                closeWindow();
+                    break;
+                }
+                if (key_pressed->scancode == sf::Keyboard::Scancode::Space)
+                {
+                    gl->setAnimationPaused(!gl->isAnimationPaused());
+                }
+                if (key_pressed->scancode == sf::Keyboard::Scancode::G)
+                {
+                    cycleDebugSeverity();
                 }
             }
         }
-        // Clear the color and depth buffers for the next frame
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if (!window->isOpen())
+        {
+            break;
+        }
+        // Apply the input of the remote viewer like local input
+        Renderer::StreamInput input;
+        while (stream && stream->pollInput(input))
+        {
+            if (input.type == Renderer::StreamInputType::CONNECTED)
+            {
+                // The viewer has no frame yet
+                gl->invalidate();
+            }
+            else if (input.type == Renderer::StreamInputType::KEY_PRESSED &&
+                input.code == static_cast<std::int32_t>(
+                    sf::Keyboard::Scancode::Space))
+            {
+                gl->setAnimationPaused(!gl->isAnimationPaused());
+            }
+            else if (input.type == Renderer::StreamInputType::KEY_PRESSED &&
+                input.code == static_cast<std::int32_t>(
+                    sf::Keyboard::Scancode::G))
+            {
+                cycleDebugSeverity();
+            }
+        }
+        pacer->inputRead();
+        if (options.onDemand &&
+            ((!focused && !stream) || minimized || !gl->needsRedraw()))
+        {
+            continue;
+        }
 
-        // Render the scene using the OpenGL state
+        // Render the scene using the selected backend
         gl->draw(window);
 
+        // Queue the read back of the frame before it is swapped away
+        if (capture)
+        {
+            capture->capture();
+        }
+        if (stream)
+        {
+            stream->capture();
+        }
+
         // Display the rendered frame (swap front and back buffers)
         window->display();
+        pacer->endFrame();
+        ++framesDrawn;
+
+        if (firstFrame)
+        {
+            firstFrame = false;
+            std::cout << "First frame presented after "
+                << millisecondsSinceLaunch() << " ms\n";
+        }
+        if (loading && !gl->isLoading())
+        {
+            loading = false;
+            std::cout << "Startup finished after " << millisecondsSinceLaunch()
+                << " ms\n";
+        }
+
+        if (recorder != nullptr && recorder->isRecording())
+        {
+            recorder->endFrame();
+            if (recorder->getSegmentCount() > options.recordFrames)
+            {
+                recorder->stop();
+                std::cout << "Recorded " << options.recordFrames
+                    << " frames to " << options.recordPath << '\n';
+            }
+        }
+    }
+
+    std::cout << summary;
+    if (options.onDemand)
+    {
+        std::cout << "Drew " << framesDrawn << " frames on demand in "
+            << millisecondsSinceLaunch() / 1000.0 << " s\n";
+    }
+    if (!options.memoryReportPath.empty())
+    {
+        try
+        {
+            Renderer::saveMemoryReport(options.memoryReportPath);
+        }
+        catch (const std::runtime_error& except)
+        {
+            std::cerr << except.what() << '\n';
+        }
     }
 
     // ShaderProgram executed successfully
@@ -0,0 +1,112 @@
+#include "modes.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+    // Frames that may allocate while query rings, caches and the frame
+    // arena settle; every later frame must not touch the heap
+    constexpr unsigned int WARMUP_FRAMES = 16;
+}
+
+int Modes::runNullBenchmark(const Options::LaunchOptions& options)
+{
+    // Keep a handle to the device for its statistics, the state owns it
+    auto ownedDevice = std::make_unique<Renderer::NullDevice>();
+    Renderer::NullDevice& device = *ownedDevice;
+    const std::unique_ptr<Window> noWindow;
+
+    try
+    {
+        Renderer::GL_State state(
+            std::make_unique<Renderer::MemoryTrackingDevice>(
+                std::move(ownedDevice)), options.resolution, options.scene);
+        // Frames are measured with every texture in place
+        state.finishLoading();
+        const Renderer::DeviceStats setupStats = device.getStats();
+        device.resetStats();
+
+        using Clock = std::chrono::steady_clock;
+        std::vector<double> frameTimes;
+        frameTimes.reserve(options.frames);
+        std::uint64_t warmupAllocations = 0;
+        std::uint64_t steadyAllocations = 0;
+        for (unsigned int frame = 0; frame < options.frames; ++frame)
+        {
+            const std::uint64_t allocations = Renderer::getAllocationCount();
+            const Clock::time_point start = Clock::now();
+            state.draw(noWindow);
+            frameTimes.push_back(std::chrono::duration<double, std::micro>(
+                Clock::now() - start).count());
+            (frame < WARMUP_FRAMES ? warmupAllocations : steadyAllocations) +=
+                Renderer::getAllocationCount() - allocations;
+        }
+
+        // Report the setup cost, the frame time distribution and the calls
+        // issued per frame
+        std::sort(frameTimes.begin(), frameTimes.end());
+        double totalTime = 0.0;
+        for (const double frameTime : frameTimes)
+        {
+            totalTime += frameTime;
+        }
+        const Renderer::DeviceStats& stats = device.getStats();
+        const double frames = static_cast<double>(options.frames);
+
+        std::cout << "Null backend: " << options.frames << " frames\n";
+        std::cout << "  setup calls: " << setupStats.totalCalls()
+            << ", uploaded bytes: " << setupStats.uploadedBytes << '\n';
+        const Renderer::StartupStats& startup = state.getStartupStats();
+        std::cout << "  startup (ms): first frame ready after "
+            << startup.firstFrameMs << ", all assets after "
+            << startup.totalMs << '\n' << Renderer::formatTimings(
+                startup.tasks);
+        std::cout << "  CPU time per frame (us): mean " << totalTime / frames
+            << ", median " << frameTimes[frameTimes.size() / 2]
+            << ", p99 " << frameTimes[frameTimes.size() * 99 / 100]
+            << ", max " << frameTimes.back() << '\n';
+        std::cout << "  calls per frame: " << stats.totalCalls() / frames << '\n';
+        for (std::size_t call = 0; call < stats.calls.size(); ++call)
+        {
+            std::cout << "    " << Renderer::toString(
+                static_cast<Renderer::DeviceCall>(call)) << ": "
+                << stats.calls[call] / frames << '\n';
+        }
+        std::cout << "  vertices per frame: " << stats.vertices / frames << '\n';
+        std::cout << "  heap allocations: " << warmupAllocations
+            << " in the first " << std::min(options.frames, WARMUP_FRAMES)
+            << " frames, " << steadyAllocations << " after\n";
+        if (steadyAllocations > 0)
+        {
+            std::cerr << "ERROR::NULL_BENCHMARK::STEADY STATE FRAMES MADE "
+                << steadyAllocations << " HEAP ALLOCATIONS\n";
+            return 1;
+        }
+    }
+    catch (const std::exception& except)
+    {
+        // Validation failures and missing assets end the run
+        std::cerr << except.what() << '\n';
+        return 1;
+    }
+
+    // The state is destroyed, so memory still held was leaked
+    const Renderer::MemoryReport memory = Renderer::getMemoryReport();
+    std::cout << "  peak memory (bytes): CPU " << memory.cpu.peak << ", GPU "
+        << memory.gpu.peak << "; left after teardown: CPU "
+        << memory.cpu.current << ", GPU " << memory.gpu.current << '\n';
+    if (!options.memoryReportPath.empty())
+    {
+        try
+        {
+            Renderer::saveMemoryReport(options.memoryReportPath);
+        }
+        catch (const std::runtime_error& except)
+        {
+            std::cerr << except.what() << '\n';
+            return 1;
+        }
+    }
+    return 0;
+}
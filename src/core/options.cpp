@@ -0,0 +1,414 @@
+#include "options.hpp"
+#include "clustered_lighting.hpp"
+
+namespace
+{
+    // Parses the value of --backend
+    Renderer::BackendType parseBackend(const std::string& value)
+    {
+        if (value == "opengl")
+        {
+            return Renderer::BackendType::OPENGL;
+        }
+        if (value == "software")
+        {
+            return Renderer::BackendType::SOFTWARE;
+        }
+        if (value == "null")
+        {
+            return Renderer::BackendType::NULL_DEVICE;
+        }
+        throw std::invalid_argument("ERROR::UNKNOWN BACKEND " + value);
+    }
+
+    // Parses the value of --scene
+    Renderer::SceneType parseScene(const std::string& value)
+    {
+        if (value == "cube")
+        {
+            return Renderer::SceneType::CUBE;
+        }
+        if (value == "grid")
+        {
+            return Renderer::SceneType::GRID;
+        }
+        if (value == "lights")
+        {
+            return Renderer::SceneType::LIGHTS;
+        }
+        throw std::invalid_argument("ERROR::UNKNOWN SCENE " + value);
+    }
+
+    // Parses the value of --debug-view
+    Renderer::DebugView parseDebugView(const std::string& value)
+    {
+        if (value == "off")
+        {
+            return Renderer::DebugView::OFF;
+        }
+        if (value == "texcoords")
+        {
+            return Renderer::DebugView::TEXCOORDS;
+        }
+        if (value == "shelf")
+        {
+            return Renderer::DebugView::SHELF;
+        }
+        if (value == "overdraw")
+        {
+            return Renderer::DebugView::OVERDRAW;
+        }
+        throw std::invalid_argument("ERROR::UNKNOWN DEBUG VIEW " + value);
+    }
+
+    // Parses the value of --gl-debug
+    Renderer::DebugSeverity parseDebugSeverity(const std::string& value)
+    {
+        if (value == "off")
+        {
+            return Renderer::DebugSeverity::OFF;
+        }
+        if (value == "high")
+        {
+            return Renderer::DebugSeverity::HIGH;
+        }
+        if (value == "medium")
+        {
+            return Renderer::DebugSeverity::MEDIUM;
+        }
+        if (value == "low")
+        {
+            return Renderer::DebugSeverity::LOW;
+        }
+        if (value == "notification")
+        {
+            return Renderer::DebugSeverity::NOTIFICATION;
+        }
+        throw std::invalid_argument("ERROR::UNKNOWN DEBUG SEVERITY " + value);
+    }
+
+    // Parses the comma separated sources of --gl-debug-sources into a mask
+    std::uint32_t parseDebugSources(const std::string& value)
+    {
+        // In the order of GL_DEBUG_SOURCE_API to GL_DEBUG_SOURCE_OTHER
+        static const std::array<const char*,
+            Renderer::DebugLogConstants::SOURCE_COUNT> names{ "api",
+            "window-system", "shader-compiler", "third-party", "application",
+            "other" };
+        std::uint32_t sources = 0;
+        std::size_t start = 0;
+        while (true)
+        {
+            const std::size_t end = value.find(',', start);
+            const std::string name = value.substr(start, end - start);
+            const auto known = std::find(names.begin(), names.end(), name);
+            if (known == names.end())
+            {
+                throw std::invalid_argument(
+                    "ERROR::UNKNOWN DEBUG SOURCE " + name);
+            }
+            sources |= Renderer::debugSourceBit(GL_DEBUG_SOURCE_API +
+                static_cast<GLenum>(known - names.begin()));
+            if (end == std::string::npos)
+            {
+                return sources;
+            }
+            start = end + 1;
+        }
+    }
+
+    // Parses a positive integer option value
+    unsigned int parseCount(const std::string& name, const std::string& value)
+    {
+        try
+        {
+            std::size_t parsed = 0;
+            const unsigned long count = std::stoul(value, &parsed);
+            if (parsed == value.size() && count > 0)
+            {
+                return static_cast<unsigned int>(count);
+            }
+        }
+        catch (const std::exception&)
+        {
+            // Reported below together with other malformed values
+        }
+        throw std::invalid_argument("ERROR::INVALID VALUE FOR " + name + ": " +
+            value);
+    }
+
+    // Parses a positive decimal option value
+    float parsePositive(const std::string& name, const std::string& value)
+    {
+        try
+        {
+            std::size_t parsed = 0;
+            const float number = std::stof(value, &parsed);
+            if (parsed == value.size() && number > 0.0f)
+            {
+                return number;
+            }
+        }
+        catch (const std::exception&)
+        {
+            // Reported below together with other malformed values
+        }
+        throw std::invalid_argument("ERROR::INVALID VALUE FOR " + name + ": " +
+            value);
+    }
+
+    // Splits the comma separated paths of an option value
+    std::vector<std::string> parsePaths(const std::string& name,
+        const std::string& value)
+    {
+        std::vector<std::string> paths;
+        std::size_t start = 0;
+        while (true)
+        {
+            const std::size_t end = value.find(',', start);
+            paths.push_back(value.substr(start, end - start));
+            if (paths.back().empty())
+            {
+                throw std::invalid_argument("ERROR::EMPTY PATH IN " + name +
+                    ": " + value);
+            }
+            if (end == std::string::npos)
+            {
+                return paths;
+            }
+            start = end + 1;
+        }
+    }
+}
+
+Options::LaunchOptions Options::parseArguments(int argc, char* argv[])
+{
+    LaunchOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument(argv[i]);
+        if (argument.rfind("--", 0) != 0)
+        {
+            throw std::invalid_argument("ERROR::UNEXPECTED ARGUMENT " + argument);
+        }
+
+        // Split "--name=value" into its name and value
+        const std::size_t separator = argument.find('=');
+        const std::string name = argument.substr(2, separator - 2);
+        const std::string value = separator == std::string::npos ?
+            std::string() : argument.substr(separator + 1);
+
+        if (name == "backend")
+        {
+            options.backend = parseBackend(value);
+        }
+        else if (name == "frames")
+        {
+            options.frames = parseCount(name, value);
+        }
+        else if (name == "record")
+        {
+            if (value.empty())
+            {
+                throw std::invalid_argument("ERROR::NO PATH FOR " + name);
+            }
+            options.recordPath = value;
+        }
+        else if (name == "capture")
+        {
+            if (value.empty())
+            {
+                throw std::invalid_argument("ERROR::NO PATH FOR " + name);
+            }
+            options.capturePath = value;
+        }
+        else if (name == "memory-report")
+        {
+            if (value.empty())
+            {
+                throw std::invalid_argument("ERROR::NO PATH FOR " + name);
+            }
+            options.memoryReportPath = value;
+        }
+        else if (name == "gl-debug")
+        {
+            options.debugLog.minimumSeverity = parseDebugSeverity(value);
+        }
+        else if (name == "gl-debug-sources")
+        {
+            options.debugLog.sources = parseDebugSources(value);
+        }
+        else if (name == "gl-debug-rate")
+        {
+            options.debugLog.linesPerSecond = parseCount(name, value);
+        }
+        else if (name == "dynamic-resolution")
+        {
+            options.resolution.enabled = true;
+        }
+        else if (name == "min-scale")
+        {
+            options.resolution.minScale = parsePositive(name, value);
+        }
+        else if (name == "max-scale")
+        {
+            options.resolution.maxScale = parsePositive(name, value);
+        }
+        else if (name == "target-ms")
+        {
+            options.resolution.targetMilliseconds = parsePositive(name, value);
+        }
+        else if (name == "scene")
+        {
+            options.scene.type = parseScene(value);
+        }
+        else if (name == "mesh")
+        {
+            if (value.empty())
+            {
+                throw std::invalid_argument("ERROR::NO PATH FOR " + name);
+            }
+            options.scene.meshPath = value;
+        }
+        else if (name == "lights")
+        {
+            options.scene.lightCount = parseCount(name, value);
+        }
+        else if (name == "no-occlusion-culling")
+        {
+            options.scene.occlusionCulling = false;
+        }
+        else if (name == "low-latency")
+        {
+            options.latency.enabled = true;
+            if (!value.empty())
+            {
+                options.latency.framesInFlight = parseCount(name, value);
+            }
+        }
+        else if (name == "frame-delay")
+        {
+            options.latency.enabled = true;
+            options.latency.delayFrameStart = true;
+        }
+        else if (name == "stream")
+        {
+            options.stream = true;
+            if (!value.empty())
+            {
+                const unsigned int port = parseCount(name, value);
+                if (port > 65535)
+                {
+                    throw std::invalid_argument(
+                        "ERROR::INVALID VALUE FOR " + name + ": " + value);
+                }
+                options.streamPort = static_cast<unsigned short>(port);
+            }
+        }
+        else if (name == "batch")
+        {
+            if (value.empty())
+            {
+                throw std::invalid_argument("ERROR::NO PATH FOR " + name);
+            }
+            options.batchPath = value;
+        }
+        else if (name == "image-benchmark")
+        {
+            options.imageBenchmark = true;
+            if (!value.empty())
+            {
+                options.benchmarkImages = parsePaths(name, value);
+            }
+        }
+        else if (name == "software-benchmark")
+        {
+            options.softwareBenchmark = true;
+            options.softwareReferencePath = value;
+        }
+        else if (name == "workers")
+        {
+            options.workers = parseCount(name, value);
+        }
+        else if (name == "on-demand")
+        {
+            options.onDemand = true;
+        }
+        else if (name == "no-material-bake")
+        {
+            options.scene.bakeMaterial = false;
+        }
+        else if (name == "debug-view")
+        {
+            options.scene.debugView = parseDebugView(value);
+        }
+        else if (name == "pipeline-stats")
+        {
+            options.scene.pipelineStatistics = true;
+            options.scene.statisticsPath = value;
+        }
+        else if (name == "record-frames")
+        {
+            options.recordFrames = parseCount(name, value);
+        }
+        else
+        {
+            throw std::invalid_argument("ERROR::UNKNOWN OPTION " + argument);
+        }
+    }
+
+    const Renderer::ResolutionSettings& resolution = options.resolution;
+    if (resolution.minScale > resolution.maxScale || resolution.maxScale > 1.0f)
+    {
+        throw std::invalid_argument(
+            "ERROR::SCALES MUST SATISFY 0 < MIN-SCALE <= MAX-SCALE <= 1");
+    }
+    if (options.latency.framesInFlight >
+        Renderer::LatencyConstants::MAX_FRAMES_IN_FLIGHT)
+    {
+        throw std::invalid_argument(
+            "ERROR::LOW-LATENCY ALLOWS AT MOST 4 FRAMES IN FLIGHT");
+    }
+    if (options.scene.lightCount > Renderer::ClusterConstants::MAX_LIGHTS)
+    {
+        throw std::invalid_argument("ERROR::AT MOST " + std::to_string(
+            Renderer::ClusterConstants::MAX_LIGHTS) + " LIGHTS");
+    }
+    if (options.scene.type != Renderer::SceneType::CUBE &&
+        (options.backend == Renderer::BackendType::SOFTWARE ||
+        options.softwareBenchmark))
+    {
+        throw std::invalid_argument(
+            "ERROR::THE SOFTWARE BACKEND ONLY RENDERS THE CUBE SCENE");
+    }
+    if (!options.batchPath.empty() &&
+        (options.backend != Renderer::BackendType::OPENGL ||
+        options.scene.type != Renderer::SceneType::CUBE))
+    {
+        throw std::invalid_argument(
+            "ERROR::BATCHES ONLY RENDER THE CUBE SCENE WITH OPENGL");
+    }
+    if (!options.scene.meshPath.empty() &&
+        (options.backend == Renderer::BackendType::SOFTWARE ||
+        options.scene.type != Renderer::SceneType::CUBE ||
+        !options.batchPath.empty()))
+    {
+        throw std::invalid_argument(
+            "ERROR::A MESH ONLY REPLACES THE CUBE OF THE OPENGL CUBE SCENE");
+    }
+    const bool diagnostics = options.scene.pipelineStatistics ||
+        options.scene.debugView == Renderer::DebugView::OVERDRAW;
+    if (diagnostics && (options.backend == Renderer::BackendType::SOFTWARE ||
+        !options.batchPath.empty()))
+    {
+        throw std::invalid_argument(
+            "ERROR::DIAGNOSTICS NEED AN OPENGL BACKEND WITHOUT BATCHES");
+    }
+    if (options.scene.debugView == Renderer::DebugView::OVERDRAW &&
+        resolution.enabled)
+    {
+        throw std::invalid_argument(
+            "ERROR::THE OVERDRAW VIEW NEEDS THE FULL RESOLUTION");
+    }
+    return options;
+}
@@ -0,0 +1,174 @@
+#include "modes.hpp"
+#include "software_renderer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // The scene time of the frame compared between thread counts and with
+    // the reference, with the cube turned away from its initial pose
+    constexpr float REFERENCE_SECONDS = 1.25f;
+    // The frames advance by this much scene time, like a 60 Hz window
+    constexpr float FRAME_SECONDS = 1.0f / 60.0f;
+    // A pixel matches the reference if no channel differs by more than
+    // this, which absorbs rounding in the texture blend
+    constexpr int CHANNEL_TOLERANCE = 2;
+    // The fraction of pixels that may exceed the tolerance, for edge
+    // pixels a rasterizer with other rounding covers differently
+    constexpr double MAX_MISMATCH_FRACTION = 0.001;
+
+    // How far a frame is from the reference image
+    struct Difference
+    {
+        int maxChannel = 0;
+        std::size_t mismatched = 0;
+    };
+
+    Difference compare(const std::vector<std::uint8_t>& frame,
+        const std::uint8_t* reference)
+    {
+        Difference difference;
+        for (std::size_t pixel = 0; pixel < frame.size() / 4; ++pixel)
+        {
+            int pixelMax = 0;
+            for (std::size_t c = 0; c < 3; ++c)
+            {
+                pixelMax = std::max(pixelMax, std::abs(
+                    static_cast<int>(frame[pixel * 4 + c]) -
+                    static_cast<int>(reference[pixel * 4 + c])));
+            }
+            difference.maxChannel = std::max(difference.maxChannel,
+                pixelMax);
+            if (pixelMax > CHANNEL_TOLERANCE)
+            {
+                ++difference.mismatched;
+            }
+        }
+        return difference;
+    }
+
+    // Compares the frame with the reference image, or writes the frame as
+    // the reference if there is none yet
+    bool checkReference(const std::string& path,
+        const std::vector<std::uint8_t>& frame, unsigned int width,
+        unsigned int height)
+    {
+        if (!std::filesystem::exists(path))
+        {
+            const sf::Image image(sf::Vector2u(width, height), frame.data());
+            if (!image.saveToFile(path))
+            {
+                std::cerr << "ERROR::SOFTWARE_BENCHMARK::CANNOT WRITE "
+                    << path << '\n';
+                return false;
+            }
+            std::cout << "  wrote the reference " << path << '\n';
+            return true;
+        }
+        sf::Image reference;
+        if (!reference.loadFromFile(path))
+        {
+            std::cerr << "ERROR::SOFTWARE_BENCHMARK::CANNOT READ " << path
+                << '\n';
+            return false;
+        }
+        if (reference.getSize() != sf::Vector2u(width, height))
+        {
+            std::cerr << "ERROR::SOFTWARE_BENCHMARK::REFERENCE IS "
+                << reference.getSize().x << 'x' << reference.getSize().y
+                << ", NOT " << width << 'x' << height << '\n';
+            return false;
+        }
+
+        const Difference difference = compare(frame,
+            reference.getPixelsPtr());
+        const std::size_t pixels = frame.size() / 4;
+        const auto allowed = static_cast<std::size_t>(
+            static_cast<double>(pixels) * MAX_MISMATCH_FRACTION);
+        std::cout << "  " << path << ": largest channel difference "
+            << difference.maxChannel << ", " << difference.mismatched
+            << " of " << pixels << " pixels differ by more than "
+            << CHANNEL_TOLERANCE << " (at most " << allowed
+            << " may)\n";
+        if (difference.mismatched > allowed)
+        {
+            std::cerr << "ERROR::SOFTWARE_BENCHMARK::FRAME DIFFERS FROM "
+                << "THE REFERENCE\n";
+            return false;
+        }
+        return true;
+    }
+}
+
+int Modes::runSoftwareBenchmark(const Options::LaunchOptions& options)
+{
+    const unsigned int maxWorkers = options.workers > 0 ? options.workers :
+        std::max(std::thread::hardware_concurrency(), 1u);
+    const int width = WindowAttributes::WINDOW_WIDTH;
+    const int height = WindowAttributes::WINDOW_HEIGHT;
+
+    try
+    {
+        std::cout << "Software benchmark: " << width << 'x' << height
+            << ", " << options.frames << " frames at 1 to " << maxWorkers
+            << " tile workers\n";
+
+        std::vector<std::uint8_t> firstFrame;
+        double singleWorkerMs = 0.0;
+        for (unsigned int workers = 1; workers <= maxWorkers; ++workers)
+        {
+            Renderer::SoftwareRenderer renderer(width, height, workers);
+
+            // The tiles are rendered in submission order by any worker,
+            // so every worker count must give the same image
+            renderer.renderFrame(REFERENCE_SECONDS);
+            if (workers == 1)
+            {
+                firstFrame = renderer.getColorBuffer();
+            }
+            else if (renderer.getColorBuffer() != firstFrame)
+            {
+                std::cerr << "ERROR::SOFTWARE_BENCHMARK::" << workers
+                    << " WORKERS RENDER ANOTHER IMAGE THAN 1\n";
+                return 1;
+            }
+
+            const Clock::time_point start = Clock::now();
+            for (unsigned int frame = 0; frame < options.frames; ++frame)
+            {
+                renderer.renderFrame(static_cast<float>(frame) *
+                    FRAME_SECONDS);
+            }
+            const double frameMs = std::chrono::duration<double, std::milli>(
+                Clock::now() - start).count() / std::max(options.frames, 1u);
+            if (workers == 1)
+            {
+                singleWorkerMs = frameMs;
+            }
+            std::cout << "  " << workers
+                << (workers == 1 ? " worker: " : " workers: ") << frameMs
+                << " ms per frame, " << 1000.0 / frameMs << " frames/s ("
+                << singleWorkerMs / frameMs << "x)\n";
+        }
+
+        if (!options.softwareReferencePath.empty() &&
+            !checkReference(options.softwareReferencePath, firstFrame,
+                width, height))
+        {
+            return 1;
+        }
+    }
+    catch (const std::exception& except)
+    {
+        // Missing textures end the run
+        std::cerr << except.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
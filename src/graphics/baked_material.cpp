@@ -0,0 +1,112 @@
+#include "baked_material.hpp"
+#include <algorithm>
+
+Renderer::BakedMaterial::BakedMaterial(Device& device, float mixFactor) :
+    device_{ device }, program_{ nullptr }, framebuffer_{ 0 }, texture_{ 0 },
+    vertexArray_{ 0 }, width_{ 0 }, height_{ 0 }, first_(), second_(),
+    mixFactor_{ mixFactor }, dirty_{ true }, bakes_{ 0 }
+{
+    VertexShader vertexShader(device_, Env::BAKE_VERTEX_SHADER_PATH);
+    FragmentShader fragShader(device_, Env::BAKE_FRAG_SHADER_PATH);
+    program_ = std::make_unique<ShaderProgram>(device_,
+        vertexShader.getShaderID(), fragShader.getShaderID());
+
+    framebuffer_ = device_.createFramebuffer();
+    texture_ = device_.createTexture();
+    vertexArray_ = device_.createVertexArray();
+}
+
+Renderer::BakedMaterial::~BakedMaterial()
+{
+    device_.deleteFramebuffer(framebuffer_);
+    device_.deleteTexture(texture_);
+    device_.deleteVertexArray(vertexArray_);
+}
+
+void Renderer::BakedMaterial::setMixFactor(float mixFactor)
+{
+    if (mixFactor != mixFactor_)
+    {
+        mixFactor_ = mixFactor;
+        dirty_ = true;
+    }
+}
+
+void Renderer::BakedMaterial::setSources(const MaterialSource& first,
+    const MaterialSource& second)
+{
+    // Names are recycled once released, so a new texture may have the name
+    // of the one it replaces but never its handle
+    if (first.handle != first_.handle || first.texture != first_.texture ||
+        second.handle != second_.handle || second.texture != second_.texture)
+    {
+        first_ = first;
+        second_ = second;
+        dirty_ = true;
+    }
+}
+
+bool Renderer::BakedMaterial::bake()
+{
+    if (!dirty_)
+    {
+        return false;
+    }
+    const GLsizei width = std::max(first_.width, second_.width);
+    const GLsizei height = std::max(first_.height, second_.height);
+    if (width != width_ || height != height_)
+    {
+        allocate(width, height);
+    }
+
+    device_.bindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    device_.viewport(0, 0, width_, height_);
+    device_.useProgram(program_->getProgramID());
+    device_.activeTexture(GlConstants::DEFAULT_TEXTURE);
+    device_.bindTexture(GL_TEXTURE_2D, first_.texture);
+    device_.activeTexture(GlConstants::DEFAULT_TEXTURE + 1);
+    device_.bindTexture(GL_TEXTURE_2D, second_.texture);
+    program_->setUniform("texture1", GlConstants::DEFAULT_TEXTURE_UNIT);
+    program_->setUniform("texture2", GlConstants::DEFAULT_TEXTURE_UNIT + 1);
+    program_->setUniform("mixFactor", mixFactor_);
+    device_.bindVertexArray(vertexArray_);
+    device_.drawArrays(GL_TRIANGLES, 0, 3);
+    device_.bindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // The mix is linear, the mipmaps of the mix are the mix of the mipmaps
+    device_.activeTexture(GlConstants::DEFAULT_TEXTURE);
+    device_.bindTexture(GL_TEXTURE_2D, texture_);
+    device_.generateMipmap(GL_TEXTURE_2D);
+
+    dirty_ = false;
+    ++bakes_;
+    return true;
+}
+
+void Renderer::BakedMaterial::allocate(GLsizei width, GLsizei height)
+{
+    width_ = width;
+    height_ = height;
+
+    // Sampled like the sources, see Texture
+    device_.activeTexture(GlConstants::DEFAULT_TEXTURE);
+    device_.bindTexture(GL_TEXTURE_2D, texture_);
+    device_.texParameter(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    device_.texParameter(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    device_.texParameter(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+        GL_NEAREST_MIPMAP_NEAREST);
+    device_.texParameter(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    device_.texImage2D(GL_TEXTURE_2D, 0, MaterialConstants::BAKED_FORMAT,
+        width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    device_.bindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+    device_.framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+        texture_, 0);
+    const GLenum status = device_.checkFramebufferStatus(GL_FRAMEBUFFER);
+    device_.bindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        throw std::runtime_error(
+            "ERROR::BAKED_MATERIAL::FRAMEBUFFER INCOMPLETE");
+    }
+}
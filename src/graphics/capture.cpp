@@ -0,0 +1,329 @@
+#include "capture.hpp"
+#include "memory_tracker.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    // Waits up to this long for a fence that is late, in nanoseconds
+    constexpr GLuint64 FENCE_TIMEOUT = 1'000'000'000;
+
+    // Returns the path with the extension removed, if there is one
+    std::string removeExtension(const std::string& path)
+    {
+        const std::size_t dot = path.find_last_of('.');
+        const std::size_t separator = path.find_last_of("/\\");
+        if (dot == std::string::npos ||
+            (separator != std::string::npos && dot < separator))
+        {
+            return path;
+        }
+        return path.substr(0, dot);
+    }
+
+    // Clamps a fixed point color conversion result to a byte
+    std::uint8_t toByte(int value)
+    {
+        return static_cast<std::uint8_t>(std::clamp(value, 0, 255));
+    }
+}
+
+std::string Renderer::numberCapturePath(const std::string& path,
+    unsigned int segment)
+{
+    const std::string stem = removeExtension(path);
+    return stem + '_' + std::to_string(segment) + path.substr(stem.size());
+}
+
+Renderer::FrameCapture::FrameCapture(const std::string& path,
+    unsigned int width, unsigned int height, unsigned int framesPerSecond) :
+    format_{ CaptureFormat::PNG_SEQUENCE }, path_{ path }, width_{ width },
+    height_{ height }, frameSize_{ static_cast<std::size_t>(width) * height *
+    CaptureConstants::BYTES_PER_PIXEL }, frameIndex_{ 0 }, finished_{ false },
+    stopping_{ false }, written_{ 0 }, failed_{ 0 }
+{
+    std::string extension = path.substr(removeExtension(path).size());
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (extension == ".y4m")
+    {
+        format_ = CaptureFormat::Y4M;
+        video_.open(path, std::ios::binary);
+        if (!video_)
+        {
+            throw std::runtime_error("ERROR::CAPTURE::CANNOT CREATE " + path);
+        }
+        // Full range BT.601 with chroma subsampled 2x2, see writeY4m
+        video_ << "YUV4MPEG2 W" << width_ << " H" << height_ << " F"
+            << framesPerSecond << ":1 Ip A1:1 C420jpeg\n";
+    }
+    else
+    {
+        path_ = removeExtension(path);
+    }
+
+    // Allocate the ring of pixel buffers the GPU copies frames into
+    for (Slot& slot : slots_)
+    {
+        glGenBuffers(1, &slot.buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER,
+            static_cast<GLsizeiptr>(frameSize_), nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    trackAllocation(MemoryCategory::GPU_BUFFER,
+        static_cast<std::uint64_t>(frameSize_) * slots_.size());
+
+    // Allocate the staging buffers up front, the frame loop never allocates
+    freeBuffers_.resize(CaptureConstants::STAGING_BUFFERS);
+    for (std::vector<std::uint8_t>& buffer : freeBuffers_)
+    {
+        buffer.resize(frameSize_);
+    }
+    trackAllocation(MemoryCategory::CAPTURE,
+        static_cast<std::uint64_t>(frameSize_) * freeBuffers_.size());
+
+    // A video stream is written in order by one thread, image files are
+    // independent and PNG compression is slow, so encode them in parallel
+    std::size_t writerCount = 1;
+    if (format_ == CaptureFormat::PNG_SEQUENCE)
+    {
+        const std::size_t cores = std::thread::hardware_concurrency();
+        writerCount = std::clamp<std::size_t>(cores > 1 ? cores - 1 : 1, 1,
+            CaptureConstants::STAGING_BUFFERS);
+    }
+    for (std::size_t i = 0; i < writerCount; ++i)
+    {
+        writers_.emplace_back(&FrameCapture::writerLoop, this);
+    }
+}
+
+Renderer::FrameCapture::~FrameCapture()
+{
+    finish();
+}
+
+void Renderer::FrameCapture::capture()
+{
+    // Queue the copy of this frame, it completes while later frames render
+    Slot& current = slots_[frameIndex_ % CaptureConstants::RING_SIZE];
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, current.buffer);
+    glReadPixels(0, 0, static_cast<GLsizei>(width_),
+        static_cast<GLsizei>(height_), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    current.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    current.frame = frameIndex_;
+    ++stats_.captured;
+
+    // Hand over the frame read READBACK_LATENCY frames ago
+    if (frameIndex_ >= CaptureConstants::READBACK_LATENCY)
+    {
+        consume(slots_[(frameIndex_ - CaptureConstants::READBACK_LATENCY) %
+            CaptureConstants::RING_SIZE]);
+    }
+    ++frameIndex_;
+}
+
+void Renderer::FrameCapture::consume(Slot& slot)
+{
+    if (slot.fence == nullptr)
+    {
+        return;
+    }
+
+    // The copy is normally done by now, waiting here is reported as a stall
+    GLenum status = glClientWaitSync(slot.fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED)
+    {
+        ++stats_.stalls;
+        status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+            FENCE_TIMEOUT);
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    std::vector<std::uint8_t> pixels;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!freeBuffers_.empty())
+        {
+            pixels = std::move(freeBuffers_.back());
+            freeBuffers_.pop_back();
+        }
+    }
+    if (pixels.empty() || status == GL_WAIT_FAILED ||
+        status == GL_TIMEOUT_EXPIRED)
+    {
+        // The writers are behind, drop the frame instead of stalling
+        ++stats_.dropped;
+        if (!pixels.empty())
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            freeBuffers_.push_back(std::move(pixels));
+        }
+        return;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+        static_cast<GLsizeiptr>(frameSize_), GL_MAP_READ_BIT);
+    bool copied = false;
+    if (mapped != nullptr)
+    {
+        std::memcpy(pixels.data(), mapped, frameSize_);
+        copied = glUnmapBuffer(GL_PIXEL_PACK_BUFFER) == GL_TRUE;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!copied)
+    {
+        ++stats_.dropped;
+        freeBuffers_.push_back(std::move(pixels));
+        return;
+    }
+    queue_.push_back(PendingFrame{ slot.frame, std::move(pixels) });
+    queueReady_.notify_one();
+}
+
+Renderer::CaptureStats Renderer::FrameCapture::finish()
+{
+    if (finished_)
+    {
+        return stats_;
+    }
+    finished_ = true;
+
+    // Map the frames still in flight, oldest first
+    const std::uint64_t inFlight = std::min<std::uint64_t>(frameIndex_,
+        CaptureConstants::READBACK_LATENCY);
+    for (std::uint64_t frame = frameIndex_ - inFlight; frame < frameIndex_;
+        ++frame)
+    {
+        consume(slots_[frame % CaptureConstants::RING_SIZE]);
+    }
+    for (Slot& slot : slots_)
+    {
+        glDeleteBuffers(1, &slot.buffer);
+    }
+    trackRelease(MemoryCategory::GPU_BUFFER,
+        static_cast<std::uint64_t>(frameSize_) * slots_.size());
+
+    // Let the writers drain the queue and stop
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    queueReady_.notify_all();
+    for (std::thread& writer : writers_)
+    {
+        writer.join();
+    }
+    video_.close();
+
+    // Every staging buffer is back in the pool once the writers stopped
+    trackRelease(MemoryCategory::CAPTURE,
+        static_cast<std::uint64_t>(frameSize_) * freeBuffers_.size());
+    std::vector<std::vector<std::uint8_t>>().swap(freeBuffers_);
+
+    stats_.written = written_;
+    stats_.failed = failed_;
+    return stats_;
+}
+
+void Renderer::FrameCapture::writerLoop()
+{
+    while (true)
+    {
+        PendingFrame pending;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            queueReady_.wait(lock,
+                [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty())
+            {
+                return;
+            }
+            pending = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        const bool success = format_ == CaptureFormat::Y4M ?
+            writeY4m(pending) : writePng(pending);
+        ++(success ? written_ : failed_);
+
+        // Return the buffer to the pool for the next frames
+        std::lock_guard<std::mutex> lock(mutex_);
+        freeBuffers_.push_back(std::move(pending.pixels));
+    }
+}
+
+bool Renderer::FrameCapture::writePng(const PendingFrame& pending) const
+{
+    char number[16];
+    std::snprintf(number, sizeof(number), "_%06llu",
+        static_cast<unsigned long long>(pending.frame));
+
+    // OpenGL returns the rows bottom to top
+    sf::Image image(sf::Vector2u(width_, height_), pending.pixels.data());
+    image.flipVertically();
+    return image.saveToFile(path_ + number + ".png");
+}
+
+bool Renderer::FrameCapture::writeY4m(const PendingFrame& pending)
+{
+    // Convert to planar YUV 4:2:0 with full range BT.601 coefficients in
+    // 8 bit fixed point, flipping the rows on the way
+    const std::size_t chromaWidth = (width_ + 1) / 2;
+    const std::size_t chromaHeight = (height_ + 1) / 2;
+    const std::size_t lumaSize = static_cast<std::size_t>(width_) * height_;
+    yuv_.resize(lumaSize + 2 * chromaWidth * chromaHeight);
+    std::uint8_t* const yPlane = yuv_.data();
+    std::uint8_t* const uPlane = yPlane + lumaSize;
+    std::uint8_t* const vPlane = uPlane + chromaWidth * chromaHeight;
+
+    const auto pixel = [&](std::size_t x, std::size_t y)
+    {
+        x = std::min<std::size_t>(x, width_ - 1);
+        y = std::min<std::size_t>(y, height_ - 1);
+        return pending.pixels.data() + ((height_ - 1 - y) * width_ + x) *
+            CaptureConstants::BYTES_PER_PIXEL;
+    };
+
+    for (std::size_t y = 0; y < height_; ++y)
+    {
+        for (std::size_t x = 0; x < width_; ++x)
+        {
+            const std::uint8_t* rgb = pixel(x, y);
+            yPlane[y * width_ + x] = toByte(
+                (77 * rgb[0] + 150 * rgb[1] + 29 * rgb[2] + 128) >> 8);
+        }
+    }
+    for (std::size_t y = 0; y < chromaHeight; ++y)
+    {
+        for (std::size_t x = 0; x < chromaWidth; ++x)
+        {
+            // Average the 2x2 block, edge pixels are repeated
+            int r = 0, g = 0, b = 0;
+            for (std::size_t i = 0; i < 4; ++i)
+            {
+                const std::uint8_t* rgb = pixel(2 * x + (i & 1), 2 * y + i / 2);
+                r += rgb[0];
+                g += rgb[1];
+                b += rgb[2];
+            }
+            uPlane[y * chromaWidth + x] = toByte(
+                ((-43 * r - 85 * g + 128 * b + 512) >> 10) + 128);
+            vPlane[y * chromaWidth + x] = toByte(
+                ((128 * r - 107 * g - 21 * b + 512) >> 10) + 128);
+        }
+    }
+
+    video_ << "FRAME\n";
+    video_.write(reinterpret_cast<const char*>(yuv_.data()),
+        static_cast<std::streamsize>(yuv_.size()));
+    return static_cast<bool>(video_);
+}
@@ -0,0 +1,184 @@
+#include "clustered_lighting.hpp"
+#include <cmath>
+
+namespace
+{
+    // Divides and rounds up, for work group counts
+    GLuint divideRoundingUp(GLsizei value, GLuint divisor)
+    {
+        return (static_cast<GLuint>(value) + divisor - 1) / divisor;
+    }
+
+    // The indices the list has room for
+    constexpr GLuint INDEX_CAPACITY =
+        Renderer::ClusterConstants::CLUSTER_COUNT *
+        Renderer::ClusterConstants::AVERAGE_LIGHTS_PER_CLUSTER;
+
+    // Adds the measurements of a stage the GPU has finished
+    void collectStage(Renderer::QueryRing& timer, Renderer::StageTiming& stage)
+    {
+        while (const std::optional<GLuint64> nanoseconds = timer.collect())
+        {
+            stage.lastMs = static_cast<double>(*nanoseconds) / 1.0e6;
+            stage.totalMs += stage.lastMs;
+            ++stage.frames;
+        }
+    }
+}
+
+Renderer::ClusteredLighting::ClusteredLighting(Device& device,
+    const std::vector<PointLight>& lights, float nearPlane, float farPlane,
+    bool timeShading) : device_{ device },
+    lightCount_{ static_cast<GLsizei>(lights.size()) },
+    nearPlane_{ nearPlane }, farPlane_{ farPlane }, lightBuffer_{ 0 },
+    viewLightBuffer_{ 0 }, clusterBuffer_{ 0 }, indexBuffer_{ 0 },
+    moveTimer_{ device, GL_TIME_ELAPSED, ClusterConstants::TIMER_QUERIES },
+    assignTimer_{ device, GL_TIME_ELAPSED, ClusterConstants::TIMER_QUERIES },
+    shadeTimer_{ nullptr }, timings_()
+{
+    if (lights.empty() || lights.size() > ClusterConstants::MAX_LIGHTS)
+    {
+        throw std::invalid_argument(
+            "ERROR::CLUSTERED_LIGHTING::UNSUPPORTED LIGHT COUNT");
+    }
+    if (timeShading)
+    {
+        shadeTimer_ = std::make_unique<QueryRing>(device_, GL_TIME_ELAPSED,
+            ClusterConstants::TIMER_QUERIES);
+    }
+
+    ComputeShader moveShader(device_, Env::MOVE_LIGHTS_COMPUTE_SHADER_PATH);
+    moveProgram_ = std::make_unique<ShaderProgram>(device_,
+        moveShader.getShaderID());
+    ComputeShader assignShader(device_,
+        Env::ASSIGN_LIGHTS_COMPUTE_SHADER_PATH);
+    assignProgram_ = std::make_unique<ShaderProgram>(device_,
+        assignShader.getShaderID());
+
+    lightBuffer_ = device_.createBuffer();
+    device_.bindBuffer(GL_SHADER_STORAGE_BUFFER, lightBuffer_);
+    device_.bufferData(GL_SHADER_STORAGE_BUFFER,
+        static_cast<GLsizeiptr>(lights.size() * sizeof(PointLight)),
+        lights.data(), GL_STATIC_DRAW);
+
+    // Written and read on the GPU only
+    viewLightBuffer_ = device_.createBuffer();
+    device_.bindBuffer(GL_SHADER_STORAGE_BUFFER, viewLightBuffer_);
+    device_.bufferData(GL_SHADER_STORAGE_BUFFER,
+        static_cast<GLsizeiptr>(lights.size() * sizeof(PointLight)), nullptr,
+        GL_DYNAMIC_COPY);
+    clusterBuffer_ = device_.createBuffer();
+    device_.bindBuffer(GL_SHADER_STORAGE_BUFFER, clusterBuffer_);
+    device_.bufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(
+        ClusterConstants::CLUSTER_COUNT * 2 * sizeof(GLuint)), nullptr,
+        GL_DYNAMIC_COPY);
+    // The count of the list, then the indices
+    indexBuffer_ = device_.createBuffer();
+    device_.bindBuffer(GL_SHADER_STORAGE_BUFFER, indexBuffer_);
+    device_.bufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(
+        (1 + INDEX_CAPACITY) * sizeof(GLuint)), nullptr, GL_DYNAMIC_COPY);
+    device_.bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+Renderer::ClusteredLighting::~ClusteredLighting()
+{
+    device_.deleteBuffer(lightBuffer_);
+    device_.deleteBuffer(viewLightBuffer_);
+    device_.deleteBuffer(clusterBuffer_);
+    device_.deleteBuffer(indexBuffer_);
+}
+
+void Renderer::ClusteredLighting::move(float seconds, const glm::mat4& view)
+{
+    collectTimings();
+
+    device_.useProgram(moveProgram_->getProgramID());
+    moveProgram_->setUniform("view", view);
+    moveProgram_->setUniform("seconds", seconds);
+    moveProgram_->setUniform("lightCount", static_cast<int>(lightCount_));
+    device_.bindBufferBase(GL_SHADER_STORAGE_BUFFER,
+        ClusterConstants::LIGHTS_BINDING, lightBuffer_);
+    device_.bindBufferBase(GL_SHADER_STORAGE_BUFFER,
+        ClusterConstants::VIEW_LIGHTS_BINDING, viewLightBuffer_);
+    device_.bindBufferBase(GL_SHADER_STORAGE_BUFFER,
+        ClusterConstants::INDICES_BINDING, indexBuffer_);
+    moveTimer_.begin();
+    device_.dispatchCompute(divideRoundingUp(lightCount_,
+        ClusterConstants::MOVE_GROUP_SIZE), 1, 1);
+    moveTimer_.end();
+}
+
+void Renderer::ClusteredLighting::assign(const glm::mat4& projection)
+{
+    device_.useProgram(assignProgram_->getProgramID());
+    assignProgram_->setUniform("lightCount", static_cast<int>(lightCount_));
+    assignProgram_->setUniform("clusterCountX",
+        static_cast<int>(ClusterConstants::CLUSTERS_X));
+    assignProgram_->setUniform("clusterCountY",
+        static_cast<int>(ClusterConstants::CLUSTERS_Y));
+    assignProgram_->setUniform("clusterCountZ",
+        static_cast<int>(ClusterConstants::CLUSTERS_Z));
+    assignProgram_->setUniform("nearPlane", nearPlane_);
+    assignProgram_->setUniform("farPlane", farPlane_);
+    // The diagonal of a perspective projection holds the inverse tangents
+    assignProgram_->setUniform("tanHalfFovX", 1.0f / projection[0][0]);
+    assignProgram_->setUniform("tanHalfFovY", 1.0f / projection[1][1]);
+    assignProgram_->setUniform("indexCapacity",
+        static_cast<int>(INDEX_CAPACITY));
+    device_.bindBufferBase(GL_SHADER_STORAGE_BUFFER,
+        ClusterConstants::VIEW_LIGHTS_BINDING, viewLightBuffer_);
+    device_.bindBufferBase(GL_SHADER_STORAGE_BUFFER,
+        ClusterConstants::CLUSTERS_BINDING, clusterBuffer_);
+    device_.bindBufferBase(GL_SHADER_STORAGE_BUFFER,
+        ClusterConstants::INDICES_BINDING, indexBuffer_);
+    assignTimer_.begin();
+    device_.dispatchCompute(divideRoundingUp(
+        static_cast<GLsizei>(ClusterConstants::CLUSTER_COUNT),
+        ClusterConstants::ASSIGN_GROUP_SIZE), 1, 1);
+    assignTimer_.end();
+}
+
+void Renderer::ClusteredLighting::beginShading(const ShaderProgram& program)
+{
+    // The slice of a view depth d is log(d / near) / log(far / near) times
+    // the slices, split into a scale and a bias of log(d)
+    const float depthRange = std::log(farPlane_ / nearPlane_);
+    const float slices = static_cast<float>(ClusterConstants::CLUSTERS_Z);
+    program.setUniform("clusterCountX",
+        static_cast<int>(ClusterConstants::CLUSTERS_X));
+    program.setUniform("clusterCountY",
+        static_cast<int>(ClusterConstants::CLUSTERS_Y));
+    program.setUniform("clusterCountZ",
+        static_cast<int>(ClusterConstants::CLUSTERS_Z));
+    program.setUniform("clusterScale", slices / depthRange);
+    program.setUniform("clusterBias",
+        slices * std::log(nearPlane_) / depthRange);
+    device_.bindBufferBase(GL_SHADER_STORAGE_BUFFER,
+        ClusterConstants::VIEW_LIGHTS_BINDING, viewLightBuffer_);
+    device_.bindBufferBase(GL_SHADER_STORAGE_BUFFER,
+        ClusterConstants::CLUSTERS_BINDING, clusterBuffer_);
+    device_.bindBufferBase(GL_SHADER_STORAGE_BUFFER,
+        ClusterConstants::INDICES_BINDING, indexBuffer_);
+    if (shadeTimer_)
+    {
+        shadeTimer_->begin();
+    }
+}
+
+void Renderer::ClusteredLighting::endShading()
+{
+    if (shadeTimer_)
+    {
+        shadeTimer_->end();
+    }
+}
+
+void Renderer::ClusteredLighting::collectTimings()
+{
+    collectStage(moveTimer_, timings_.move);
+    collectStage(assignTimer_, timings_.assign);
+    if (shadeTimer_)
+    {
+        collectStage(*shadeTimer_, timings_.shade);
+    }
+}
@@ -0,0 +1,298 @@
+#include "debug_log.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+    static_assert((Renderer::DebugLogConstants::RING_SIZE &
+        (Renderer::DebugLogConstants::RING_SIZE - 1)) == 0,
+        "The ring size must be a power of two");
+
+    // Packs what identifies a message into a key
+    std::uint64_t messageKey(GLenum source, GLenum type, GLuint id)
+    {
+        return (static_cast<std::uint64_t>(source & 0xFFFFu) << 48) |
+            (static_cast<std::uint64_t>(type & 0xFFFFu) << 32) | id;
+    }
+}
+
+Renderer::DebugSeverity Renderer::toDebugSeverity(GLenum severity)
+{
+    switch (severity)
+    {
+    case GL_DEBUG_SEVERITY_NOTIFICATION: return DebugSeverity::NOTIFICATION;
+    case GL_DEBUG_SEVERITY_LOW: return DebugSeverity::LOW;
+    case GL_DEBUG_SEVERITY_MEDIUM: return DebugSeverity::MEDIUM;
+    default: return DebugSeverity::HIGH;
+    }
+}
+
+std::uint32_t Renderer::debugSourceBit(GLenum source)
+{
+    // The sources are consecutive enums
+    if (source < GL_DEBUG_SOURCE_API ||
+        source >= GL_DEBUG_SOURCE_API + DebugLogConstants::SOURCE_COUNT)
+    {
+        return 0;
+    }
+    return 1u << (source - GL_DEBUG_SOURCE_API);
+}
+
+Renderer::DebugMessageRing::DebugMessageRing() :
+    slots_{ std::make_unique<Slot[]>(DebugLogConstants::RING_SIZE) },
+    tail_{ 0 }, head_{ 0 }
+{
+    // A slot is free for the producer at the position equal to its sequence
+    for (std::size_t i = 0; i < DebugLogConstants::RING_SIZE; ++i)
+    {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool Renderer::DebugMessageRing::push(const DebugMessage& message)
+{
+    std::size_t position = tail_.load(std::memory_order_relaxed);
+    while (true)
+    {
+        Slot& slot = slots_[position & (DebugLogConstants::RING_SIZE - 1)];
+        const std::size_t sequence =
+            slot.sequence.load(std::memory_order_acquire);
+        const std::ptrdiff_t difference =
+            static_cast<std::ptrdiff_t>(sequence - position);
+        if (difference == 0)
+        {
+            // Claim the slot, on failure position holds the new tail
+            if (tail_.compare_exchange_weak(position, position + 1,
+                std::memory_order_relaxed))
+            {
+                slot.message = message;
+                slot.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            // The consumer has not read the slot of the previous lap
+            return false;
+        }
+        else
+        {
+            // Another producer claimed the slot first
+            position = tail_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool Renderer::DebugMessageRing::pop(DebugMessage& message)
+{
+    Slot& slot = slots_[head_ & (DebugLogConstants::RING_SIZE - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != head_ + 1)
+    {
+        return false;
+    }
+    message = slot.message;
+    // Free the slot for the producers of the next lap
+    slot.sequence.store(head_ + DebugLogConstants::RING_SIZE,
+        std::memory_order_release);
+    ++head_;
+    return true;
+}
+
+Renderer::DebugLog::DebugLog(const DebugLogSettings& settings) :
+    minimumSeverity_{ settings.minimumSeverity },
+    sources_{ settings.sources }, linesPerSecond_{ settings.linesPerSecond },
+    received_{ 0 }, filtered_{ 0 }, dropped_{ 0 }, repeated_{ 0 },
+    limited_{ 0 }, written_{ 0 },
+    secondStart_{ std::chrono::steady_clock::now() }, linesThisSecond_{ 0 },
+    limitedThisSecond_{ 0 }, stopping_{ false }
+{
+    logger_ = std::thread(&DebugLog::run, this);
+}
+
+Renderer::DebugLog::~DebugLog()
+{
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeUp_.notify_one();
+    logger_.join();
+
+    // Report what the last second repeated and summarize the run
+    report();
+    const DebugLogStats stats = getStats();
+    if (stats.received > 0)
+    {
+        std::fprintf(stderr, "GL DEBUG: %llu messages, %llu filtered, "
+            "%llu repeats, %llu lost in a full ring, %llu lines over the "
+            "rate limit\n",
+            static_cast<unsigned long long>(stats.received),
+            static_cast<unsigned long long>(stats.filtered),
+            static_cast<unsigned long long>(stats.repeated),
+            static_cast<unsigned long long>(stats.dropped),
+            static_cast<unsigned long long>(stats.limited));
+    }
+}
+
+void GLAPIENTRY Renderer::DebugLog::callback(GLenum source, GLenum type,
+    GLuint id, GLenum severity, GLsizei length, const GLchar* message,
+    const void* userParam)
+{
+    static_cast<DebugLog*>(const_cast<void*>(userParam))->receive(source,
+        type, id, severity, length, message);
+}
+
+Renderer::DebugSeverity Renderer::DebugLog::getMinimumSeverity() const
+{
+    return minimumSeverity_.load(std::memory_order_relaxed);
+}
+
+void Renderer::DebugLog::setMinimumSeverity(DebugSeverity severity)
+{
+    minimumSeverity_.store(severity, std::memory_order_relaxed);
+}
+
+Renderer::DebugLogStats Renderer::DebugLog::getStats() const
+{
+    DebugLogStats stats;
+    stats.received = received_.load(std::memory_order_relaxed);
+    stats.filtered = filtered_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.repeated = repeated_.load(std::memory_order_relaxed);
+    stats.limited = limited_.load(std::memory_order_relaxed);
+    stats.written = written_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void Renderer::DebugLog::receive(GLenum source, GLenum type, GLuint id,
+    GLenum severity, GLsizei length, const GLchar* message)
+{
+    received_.fetch_add(1, std::memory_order_relaxed);
+    if (toDebugSeverity(severity) <
+        minimumSeverity_.load(std::memory_order_relaxed) ||
+        (debugSourceBit(source) & sources_) == 0)
+    {
+        filtered_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    DebugMessage entry;
+    entry.source = source;
+    entry.type = type;
+    entry.id = id;
+    entry.severity = severity;
+    // A negative length means the message is null terminated
+    const std::size_t size = length < 0 ? std::strlen(message) :
+        static_cast<std::size_t>(length);
+    const std::size_t kept = std::min(size,
+        DebugLogConstants::MAX_MESSAGE_LENGTH);
+    std::memcpy(entry.text.data(), message, kept);
+    entry.text[kept] = '\0';
+
+    if (!ring_.push(entry))
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void Renderer::DebugLog::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    // Drain at least once, even if stopped before the thread got here
+    do
+    {
+        wakeUp_.wait_for(lock, std::chrono::milliseconds(
+            DebugLogConstants::DRAIN_INTERVAL_MS), [this]() {
+                return stopping_;
+            });
+        // Drain once more after being stopped, for the last messages
+        lock.unlock();
+        drain();
+        lock.lock();
+    } while (!stopping_);
+}
+
+void Renderer::DebugLog::drain()
+{
+    DebugMessage message;
+    while (ring_.pop(message))
+    {
+        const std::uint64_t key = messageKey(message.source, message.type,
+            message.id);
+        const auto known = repeats_.find(key);
+        if (known != repeats_.end())
+        {
+            // Only the first occurrence is written, repeats are counted
+            ++known->second;
+            repeated_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        repeats_.emplace(key, 0);
+        // Errors are always written, the dedupe already bounds them
+        const bool error = message.type == GL_DEBUG_TYPE_ERROR;
+        if (!error && !takeLine())
+        {
+            continue;
+        }
+        std::fprintf(stderr, "GL CALLBACK: %s source = 0x%x, type = 0x%x, "
+            "id = %u, severity = 0x%x, message = %s\n",
+            (error ? "** GL ERROR **" : ""),
+            message.source, message.type, message.id, message.severity,
+            message.text.data());
+        written_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // New messages take the line budget before the reports of repeats
+    const std::chrono::steady_clock::time_point now =
+        std::chrono::steady_clock::now();
+    if (now - secondStart_ >= std::chrono::seconds(1))
+    {
+        report();
+        secondStart_ = now;
+    }
+}
+
+void Renderer::DebugLog::report()
+{
+    if (limitedThisSecond_ > 0)
+    {
+        std::fprintf(stderr, "GL CALLBACK: %llu lines over the limit of %u "
+            "per second were not written\n",
+            static_cast<unsigned long long>(limitedThisSecond_),
+            linesPerSecond_);
+    }
+    linesThisSecond_ = 0;
+    limitedThisSecond_ = 0;
+
+    for (auto& [key, repeats] : repeats_)
+    {
+        if (repeats == 0)
+        {
+            continue;
+        }
+        if (takeLine())
+        {
+            std::fprintf(stderr, "GL CALLBACK: id = %u (source = 0x%x, "
+                "type = 0x%x) repeated %llu times\n",
+                static_cast<GLuint>(key & 0xFFFFFFFFu),
+                static_cast<unsigned int>(key >> 48),
+                static_cast<unsigned int>((key >> 32) & 0xFFFFu),
+                static_cast<unsigned long long>(repeats));
+            written_.fetch_add(1, std::memory_order_relaxed);
+        }
+        repeats = 0;
+    }
+}
+
+bool Renderer::DebugLog::takeLine()
+{
+    if (linesThisSecond_ < linesPerSecond_)
+    {
+        ++linesThisSecond_;
+        return true;
+    }
+    ++limitedThisSecond_;
+    limited_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
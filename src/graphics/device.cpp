@@ -0,0 +1,58 @@
+#include "device.hpp"
+
+const char* Renderer::toString(DeviceCall call)
+{
+    switch (call)
+    {
+    case DeviceCall::BUFFER: return "buffer";
+    case DeviceCall::TEXTURE: return "texture";
+    case DeviceCall::SHADER: return "shader";
+    case DeviceCall::PROGRAM: return "program";
+    case DeviceCall::UNIFORM: return "uniform";
+    case DeviceCall::STATE: return "state";
+    case DeviceCall::DRAW: return "draw";
+    case DeviceCall::COMPUTE: return "compute";
+    case DeviceCall::FRAMEBUFFER: return "framebuffer";
+    case DeviceCall::QUERY: return "query";
+    case DeviceCall::COUNT: break;
+    }
+    return "unknown";
+}
+
+std::uint64_t Renderer::DeviceStats::totalCalls() const
+{
+    std::uint64_t total = 0;
+    for (const std::uint64_t callCount : calls)
+    {
+        total += callCount;
+    }
+    return total;
+}
+
+std::size_t Renderer::pixelSize(GLenum format, GLenum type)
+{
+    std::size_t components = 4;
+    switch (format)
+    {
+    case GL_RED:
+    case GL_DEPTH_COMPONENT: components = 1; break;
+    case GL_RG: components = 2; break;
+    case GL_RGB: components = 3; break;
+    default: break;
+    }
+    return type == GL_FLOAT ? components * sizeof(GLfloat) : components;
+}
+
+std::size_t Renderer::texelSize(GLint internalFormat)
+{
+    switch (internalFormat)
+    {
+    case GL_RED:
+    case GL_R8: return 1;
+    case GL_RG:
+    case GL_RG8: return 2;
+    case GL_RGBA16F: return 8;
+    case GL_RGBA32F: return 16;
+    default: return 4;
+    }
+}
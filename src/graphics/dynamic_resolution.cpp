@@ -0,0 +1,103 @@
+#include "dynamic_resolution.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Scales a window dimension, keeping at least one pixel
+    GLsizei scaleSize(GLsizei size, float scale)
+    {
+        return std::max<GLsizei>(1, static_cast<GLsizei>(
+            std::lround(static_cast<float>(size) * scale)));
+    }
+}
+
+Renderer::ResolutionController::ResolutionController(
+    const ResolutionSettings& settings) : settings_{ settings },
+    scale_{ settings.maxScale }, filtered_{ 0.0 }
+{
+}
+
+float Renderer::ResolutionController::update(double milliseconds)
+{
+    filtered_ = filtered_ == 0.0 ? milliseconds : filtered_ +
+        ResolutionConstants::FILTER_WEIGHT * (milliseconds - filtered_);
+
+    // Frames without measurable GPU work can run at the largest scale
+    if (filtered_ <= 0.0)
+    {
+        scale_ = settings_.maxScale;
+        return scale_;
+    }
+
+    const double ratio = settings_.targetMilliseconds / filtered_;
+    if (std::abs(ratio - 1.0) <= ResolutionConstants::DEAD_BAND)
+    {
+        return scale_;
+    }
+    const float step = std::clamp(static_cast<float>(std::sqrt(ratio)),
+        1.0f - ResolutionConstants::MAX_SCALE_STEP,
+        1.0f + ResolutionConstants::MAX_SCALE_STEP);
+    scale_ = std::clamp(scale_ * step, settings_.minScale, settings_.maxScale);
+    return scale_;
+}
+
+Renderer::DynamicResolution::DynamicResolution(Device& device,
+    const ResolutionSettings& settings, GLsizei width, GLsizei height) :
+    device_{ device }, settings_{ settings }, controller_{ settings },
+    timer_{ device, GL_TIME_ELAPSED,
+    ResolutionConstants::TIMER_QUERIES }, windowWidth_{ width }, windowHeight_{ height },
+    renderWidth_{ width }, renderHeight_{ height }
+{
+}
+
+void Renderer::DynamicResolution::resize(GLsizei width, GLsizei height)
+{
+    windowWidth_ = width;
+    windowHeight_ = height;
+}
+
+Renderer::TargetDesc Renderer::DynamicResolution::getTargetDesc(
+    GLenum format, GLsizei samples) const
+{
+    return { TargetType::RENDERBUFFER, format,
+        scaleSize(windowWidth_, settings_.maxScale),
+        scaleSize(windowHeight_, settings_.maxScale), samples };
+}
+
+void Renderer::DynamicResolution::beginFrame(GLuint sceneFramebuffer)
+{
+    // Measurements arrive a few frames late, use every one that finished
+    while (const std::optional<GLuint64> nanoseconds = timer_.collect())
+    {
+        controller_.update(static_cast<double>(*nanoseconds) / 1.0e6);
+    }
+    renderWidth_ = scaleSize(windowWidth_, controller_.getScale());
+    renderHeight_ = scaleSize(windowHeight_, controller_.getScale());
+
+    device_.bindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer);
+    device_.viewport(0, 0, renderWidth_, renderHeight_);
+    timer_.begin();
+}
+
+void Renderer::DynamicResolution::resolve(GLuint sceneFramebuffer,
+    GLuint resolveFramebuffer)
+{
+    // Resolve the samples at the render size
+    device_.bindFramebuffer(GL_READ_FRAMEBUFFER, sceneFramebuffer);
+    device_.bindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFramebuffer);
+    device_.blitFramebuffer(0, 0, renderWidth_, renderHeight_,
+        0, 0, renderWidth_, renderHeight_, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+}
+
+void Renderer::DynamicResolution::upscale(GLuint resolveFramebuffer)
+{
+    // Stretch the resolved frame over the window with bilinear filtering
+    device_.bindFramebuffer(GL_READ_FRAMEBUFFER, resolveFramebuffer);
+    device_.bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    device_.blitFramebuffer(0, 0, renderWidth_, renderHeight_,
+        0, 0, windowWidth_, windowHeight_, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    timer_.end();
+
+    device_.bindFramebuffer(GL_FRAMEBUFFER, 0);
+}
@@ -0,0 +1,159 @@
+#include "frame_arena.hpp"
+#include "memory_tracker.hpp"
+#include <algorithm>
+#include <cstdlib>
+#ifdef _WIN32
+#include <malloc.h> // For _aligned_malloc.
+#endif
+
+namespace
+{
+    // The heap allocations of each thread, trivially initialized so that
+    // operator new can count before and after the thread's constructors
+    thread_local std::uint64_t allocationCount = 0;
+
+    // Rounds an address up to a power of two alignment
+    std::uintptr_t alignUp(std::uintptr_t address, std::size_t alignment)
+    {
+        const std::uintptr_t mask = static_cast<std::uintptr_t>(alignment) - 1;
+        return (address + mask) & ~mask;
+    }
+
+    // Allocates with the given function, calling the new handler until it
+    // succeeds, as operator new must
+    template <typename Allocate>
+    void* allocateOrThrow(Allocate allocate)
+    {
+        ++allocationCount;
+        while (true)
+        {
+            if (void* memory = allocate())
+            {
+                return memory;
+            }
+            const std::new_handler handler = std::get_new_handler();
+            if (handler == nullptr)
+            {
+                throw std::bad_alloc();
+            }
+            handler();
+        }
+    }
+
+    void* alignedAllocate(std::size_t size, std::align_val_t alignment)
+    {
+        const std::size_t bytes = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+        return _aligned_malloc(std::max(size, bytes), bytes);
+#else
+        // aligned_alloc takes a multiple of the alignment, never zero
+        return std::aligned_alloc(bytes, static_cast<std::size_t>(
+            alignUp(std::max(size, bytes), bytes)));
+#endif
+    }
+
+    void alignedFree(void* memory)
+    {
+#ifdef _WIN32
+        _aligned_free(memory);
+#else
+        std::free(memory);
+#endif
+    }
+}
+
+// The global allocation functions are replaced to count the allocations,
+// the array and nothrow forms call these by default
+void* operator new(std::size_t size)
+{
+    // malloc may return null for zero bytes, operator new must not
+    const std::size_t bytes = std::max<std::size_t>(size, 1);
+    return allocateOrThrow([bytes]() { return std::malloc(bytes); });
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return allocateOrThrow([size, alignment]() {
+        return alignedAllocate(size, alignment);
+    });
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+    alignedFree(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept
+{
+    alignedFree(memory);
+}
+
+std::uint64_t Renderer::getAllocationCount()
+{
+    return allocationCount;
+}
+
+Renderer::FrameArena::FrameArena(std::size_t capacity) : capacity_{ 0 },
+    offset_{ 0 }, used_{ 0 }, peak_{ 0 }
+{
+    allocateBlock(capacity);
+}
+
+Renderer::FrameArena::~FrameArena()
+{
+    trackRelease(MemoryCategory::FRAME_ARENA, capacity_);
+}
+
+void* Renderer::FrameArena::allocate(std::size_t bytes,
+    std::size_t alignment)
+{
+    used_ += bytes;
+    peak_ = std::max(peak_, used_);
+
+    // Align the address, the block itself is only aligned for any scalar
+    const std::uintptr_t base =
+        reinterpret_cast<std::uintptr_t>(block_.get());
+    const std::size_t offset = alignUp(base + offset_, alignment) - base;
+    if (offset + bytes <= capacity_)
+    {
+        offset_ = offset + bytes;
+        return block_.get() + offset;
+    }
+
+    // Overflow to the heap until the next reset grows the block, with room
+    // to align the start
+    overflow_.push_back(std::make_unique<std::byte[]>(bytes + alignment));
+    const std::uintptr_t address =
+        reinterpret_cast<std::uintptr_t>(overflow_.back().get());
+    return reinterpret_cast<void*>(alignUp(address, alignment));
+}
+
+void Renderer::FrameArena::reset()
+{
+    if (!overflow_.empty())
+    {
+        overflow_.clear();
+        // Leave room for the alignment padding of the largest frame
+        allocateBlock(peak_ + peak_ / 4);
+    }
+    offset_ = 0;
+    used_ = 0;
+}
+
+void Renderer::FrameArena::allocateBlock(std::size_t capacity)
+{
+    trackRelease(MemoryCategory::FRAME_ARENA, capacity_);
+    block_ = std::make_unique<std::byte[]>(capacity);
+    capacity_ = capacity;
+    trackAllocation(MemoryCategory::FRAME_ARENA, capacity_);
+}
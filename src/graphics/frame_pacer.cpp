@@ -0,0 +1,151 @@
+#include "frame_pacer.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+    double millisecondsBetween(std::chrono::steady_clock::time_point from,
+        std::chrono::steady_clock::time_point to)
+    {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    }
+}
+
+Renderer::FramePacer::FramePacer(const LatencySettings& settings,
+    double framePeriodMs) : settings_{ settings },
+    framePeriod_{ std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::milli>(framePeriodMs)) },
+    fences_(), frameStart_(), inputTime_(), lastSwap_(), swapped_{ false },
+    predictedCostMs_{ 0.0 }, latenciesMs_(), measuredFrames_{ 0 },
+    maxLatencyMs_{ 0.0 }, fenceWaitMs_{ 0.0 }, delayMs_{ 0.0 },
+    fenceTimeouts_{ 0 }
+{
+    latenciesMs_.reserve(LatencyConstants::LATENCY_SAMPLES);
+    // A delayed start without a limit on the queue would only add latency
+    settings_.enabled = settings_.enabled || settings_.delayFrameStart;
+    settings_.framesInFlight = std::clamp(settings_.framesInFlight, 1u,
+        LatencyConstants::MAX_FRAMES_IN_FLIGHT);
+}
+
+Renderer::FramePacer::~FramePacer()
+{
+    for (const GLsync fence : fences_)
+    {
+        glDeleteSync(fence);
+    }
+}
+
+void Renderer::FramePacer::beginFrame()
+{
+    if (settings_.enabled)
+    {
+        const Clock::time_point waitStart = Clock::now();
+        while (fences_.size() >= settings_.framesInFlight)
+        {
+            waitOldestFence();
+        }
+        fenceWaitMs_ += millisecondsBetween(waitStart, Clock::now());
+    }
+
+    if (settings_.delayFrameStart && swapped_)
+    {
+        // Start as late as the frame can still swap one period after the
+        // last one
+        const Clock::time_point deadline = lastSwap_ + framePeriod_;
+        const double costMs = predictedCostMs_ *
+            LatencyConstants::COST_MARGIN + LatencyConstants::COST_SLACK_MS;
+        const Clock::time_point start = deadline -
+            std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double, std::milli>(costMs));
+        const Clock::time_point now = Clock::now();
+        if (start > now)
+        {
+            std::this_thread::sleep_until(start);
+            delayMs_ += millisecondsBetween(now, Clock::now());
+        }
+    }
+    frameStart_ = Clock::now();
+}
+
+void Renderer::FramePacer::inputRead()
+{
+    inputTime_ = Clock::now();
+}
+
+void Renderer::FramePacer::endFrame()
+{
+    const Clock::time_point now = Clock::now();
+    const double latencyMs = millisecondsBetween(inputTime_, now);
+    if (latenciesMs_.size() < LatencyConstants::LATENCY_SAMPLES)
+    {
+        latenciesMs_.push_back(latencyMs);
+    }
+    else
+    {
+        latenciesMs_[measuredFrames_ % LatencyConstants::LATENCY_SAMPLES] =
+            latencyMs;
+    }
+    ++measuredFrames_;
+    maxLatencyMs_ = std::max(maxLatencyMs_, latencyMs);
+
+    // The first frame also pays for compiling and uploading
+    const double costMs = millisecondsBetween(frameStart_, now);
+    predictedCostMs_ = swapped_ ? predictedCostMs_ +
+        LatencyConstants::COST_WEIGHT * (costMs - predictedCostMs_) : costMs;
+    lastSwap_ = now;
+    swapped_ = true;
+
+    if (settings_.enabled)
+    {
+        fences_.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    }
+}
+
+void Renderer::FramePacer::waitOldestFence()
+{
+    // Flush so the fence is sure to be reached when nothing else flushes
+    const GLenum status = glClientWaitSync(fences_.front(),
+        GL_SYNC_FLUSH_COMMANDS_BIT, LatencyConstants::FENCE_TIMEOUT);
+    if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+    {
+        ++fenceTimeouts_;
+    }
+    glDeleteSync(fences_.front());
+    fences_.pop_front();
+}
+
+std::string Renderer::FramePacer::getSummary() const
+{
+    if (latenciesMs_.empty())
+    {
+        return std::string();
+    }
+    std::vector<double> sorted = latenciesMs_;
+    std::sort(sorted.begin(), sorted.end());
+
+    std::ostringstream summary;
+    summary << std::fixed << std::setprecision(2) << "Input to swap latency ("
+        << (settings_.enabled ? "low latency, " +
+            std::to_string(settings_.framesInFlight) + " frames in flight" +
+            (settings_.delayFrameStart ? ", delayed start" : "") :
+            std::string("default mode"))
+        << ") over " << measuredFrames_ << " frames, ms: median "
+        << sorted[sorted.size() / 2]
+        << ", p90 " << sorted[sorted.size() * 90 / 100]
+        << ", p99 " << sorted[sorted.size() * 99 / 100]
+        << ", max " << maxLatencyMs_;
+    if (measuredFrames_ > sorted.size())
+    {
+        summary << " (percentiles of the last " << sorted.size() << ")";
+    }
+    summary << '\n';
+    if (settings_.enabled)
+    {
+        summary << "  waited " << fenceWaitMs_ << " ms on fences ("
+            << fenceTimeouts_ << " timed out), delayed frame starts by "
+            << delayMs_ << " ms\n";
+    }
+    return summary.str();
+}
@@ -0,0 +1,424 @@
+#include "device.hpp"
+
+Renderer::GlDevice::GlDevice(const DebugLogSettings& debugLog) :
+    nextFence_{ 1 }
+{
+    if (debugLog.minimumSeverity == DebugSeverity::OFF)
+    {
+        // The driver skips generating the messages altogether
+        glDisable(GL_DEBUG_OUTPUT);
+        return;
+    }
+    // Enabled debug logging, the callback only queues the messages for the
+    // logger thread
+    debugLog_ = std::make_unique<DebugLog>(debugLog);
+    glEnable(GL_DEBUG_OUTPUT);
+    glDebugMessageCallback(&DebugLog::callback, debugLog_.get());
+}
+
+Renderer::GlDevice::~GlDevice()
+{
+    for (const auto& [name, sync] : fences_)
+    {
+        glDeleteSync(sync);
+    }
+    if (debugLog_)
+    {
+        // The driver must not call into the log while it is destroyed
+        glDebugMessageCallback(nullptr, nullptr);
+        glDisable(GL_DEBUG_OUTPUT);
+    }
+}
+
+GLuint Renderer::GlDevice::createVertexArray()
+{
+    GLuint vertexArray{ 0 };
+    glGenVertexArrays(1, &vertexArray);
+    return vertexArray;
+}
+
+void Renderer::GlDevice::bindVertexArray(GLuint vertexArray)
+{
+    glBindVertexArray(vertexArray);
+}
+
+void Renderer::GlDevice::deleteVertexArray(GLuint vertexArray)
+{
+    glDeleteVertexArrays(1, &vertexArray);
+}
+
+GLuint Renderer::GlDevice::createBuffer()
+{
+    GLuint buffer{ 0 };
+    glGenBuffers(1, &buffer);
+    return buffer;
+}
+
+void Renderer::GlDevice::bindBuffer(GLenum target, GLuint buffer)
+{
+    glBindBuffer(target, buffer);
+}
+
+void Renderer::GlDevice::deleteBuffer(GLuint buffer)
+{
+    glDeleteBuffers(1, &buffer);
+}
+
+void Renderer::GlDevice::bufferData(GLenum target, GLsizeiptr size,
+    const void* data, GLenum usage)
+{
+    glBufferData(target, size, data, usage);
+}
+
+void Renderer::GlDevice::vertexAttribPointer(GLuint index, GLint size,
+    GLenum type, GLsizei stride, std::size_t offset)
+{
+    glVertexAttribPointer(index, size, type, GL_FALSE, stride,
+        reinterpret_cast<const void*>(offset));
+}
+
+void Renderer::GlDevice::enableVertexAttribArray(GLuint index)
+{
+    glEnableVertexAttribArray(index);
+}
+
+void Renderer::GlDevice::vertexAttribDivisor(GLuint index, GLuint divisor)
+{
+    glVertexAttribDivisor(index, divisor);
+}
+
+void Renderer::GlDevice::bindBufferBase(GLenum target, GLuint index,
+    GLuint buffer)
+{
+    glBindBufferBase(target, index, buffer);
+}
+
+GLuint Renderer::GlDevice::createTexture()
+{
+    GLuint texture{ 0 };
+    glGenTextures(1, &texture);
+    return texture;
+}
+
+void Renderer::GlDevice::activeTexture(GLenum unit)
+{
+    glActiveTexture(unit);
+}
+
+void Renderer::GlDevice::bindTexture(GLenum target, GLuint texture)
+{
+    glBindTexture(target, texture);
+}
+
+void Renderer::GlDevice::deleteTexture(GLuint texture)
+{
+    glDeleteTextures(1, &texture);
+}
+
+void Renderer::GlDevice::texParameter(GLenum target, GLenum name, GLint value)
+{
+    glTexParameteri(target, name, value);
+}
+
+void Renderer::GlDevice::texImage2D(GLenum target, GLint level,
+    GLint internalFormat, GLsizei width, GLsizei height, GLenum format,
+    GLenum type, const void* pixels)
+{
+    glTexImage2D(target, level, internalFormat, width, height, 0, format,
+        type, pixels);
+}
+
+void Renderer::GlDevice::generateMipmap(GLenum target)
+{
+    glGenerateMipmap(target);
+}
+
+void Renderer::GlDevice::bindImageTexture(GLuint unit, GLuint texture,
+    GLint level, GLenum access, GLenum format)
+{
+    glBindImageTexture(unit, texture, level, GL_FALSE, 0, access, format);
+}
+
+GLuint Renderer::GlDevice::createShader(GLenum type)
+{
+    return glCreateShader(type);
+}
+
+void Renderer::GlDevice::shaderSource(GLuint shader, const std::string& source)
+{
+    const GLchar* sourceString = source.c_str();
+    glShaderSource(shader, 1, &sourceString, NULL);
+}
+
+void Renderer::GlDevice::compileShader(GLuint shader)
+{
+    glCompileShader(shader);
+}
+
+bool Renderer::GlDevice::getCompileStatus(GLuint shader, std::string& infoLog)
+{
+    int success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    if (!success)
+    {
+        char log[512];
+        glGetShaderInfoLog(shader, 512, NULL, log);
+        infoLog = log;
+    }
+    return success != 0;
+}
+
+void Renderer::GlDevice::deleteShader(GLuint shader)
+{
+    glDeleteShader(shader);
+}
+
+GLuint Renderer::GlDevice::createProgram()
+{
+    return glCreateProgram();
+}
+
+void Renderer::GlDevice::attachShader(GLuint program, GLuint shader)
+{
+    glAttachShader(program, shader);
+}
+
+void Renderer::GlDevice::linkProgram(GLuint program)
+{
+    glLinkProgram(program);
+}
+
+bool Renderer::GlDevice::getLinkStatus(GLuint program, std::string& infoLog)
+{
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        char log[512];
+        glGetProgramInfoLog(program, 512, NULL, log);
+        infoLog = log;
+    }
+    return success != 0;
+}
+
+void Renderer::GlDevice::useProgram(GLuint program)
+{
+    glUseProgram(program);
+}
+
+void Renderer::GlDevice::deleteProgram(GLuint program)
+{
+    glDeleteProgram(program);
+}
+
+GLint Renderer::GlDevice::getUniformLocation(GLuint program, const char* name)
+{
+    return glGetUniformLocation(program, name);
+}
+
+void Renderer::GlDevice::uniform1i(GLint location, GLint value)
+{
+    glUniform1i(location, value);
+}
+
+void Renderer::GlDevice::uniform1f(GLint location, GLfloat value)
+{
+    glUniform1f(location, value);
+}
+
+void Renderer::GlDevice::uniformMatrix4fv(GLint location, const GLfloat* value)
+{
+    glUniformMatrix4fv(location, 1, GL_FALSE, value);
+}
+
+void Renderer::GlDevice::viewport(GLint x, GLint y, GLsizei width,
+    GLsizei height)
+{
+    glViewport(x, y, width, height);
+}
+
+void Renderer::GlDevice::enable(GLenum capability)
+{
+    glEnable(capability);
+}
+
+void Renderer::GlDevice::disable(GLenum capability)
+{
+    glDisable(capability);
+}
+
+void Renderer::GlDevice::blendFunc(GLenum sourceFactor, GLenum destFactor)
+{
+    glBlendFunc(sourceFactor, destFactor);
+}
+
+void Renderer::GlDevice::clearColor(GLfloat red, GLfloat green, GLfloat blue,
+    GLfloat alpha)
+{
+    glClearColor(red, green, blue, alpha);
+}
+
+void Renderer::GlDevice::clear(GLbitfield mask)
+{
+    glClear(mask);
+}
+
+void Renderer::GlDevice::drawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    glDrawArrays(mode, first, count);
+}
+
+void Renderer::GlDevice::drawElements(GLenum mode, GLsizei count, GLenum type,
+    std::size_t offset)
+{
+    glDrawElements(mode, count, type, reinterpret_cast<const void*>(offset));
+}
+
+void Renderer::GlDevice::multiDrawArraysIndirect(GLenum mode,
+    std::size_t offset, GLsizei drawCount, GLsizei stride)
+{
+    glMultiDrawArraysIndirect(mode, reinterpret_cast<const void*>(offset),
+        drawCount, stride);
+}
+
+void Renderer::GlDevice::dispatchCompute(GLuint groupsX, GLuint groupsY,
+    GLuint groupsZ)
+{
+    glDispatchCompute(groupsX, groupsY, groupsZ);
+}
+
+void Renderer::GlDevice::memoryBarrier(GLbitfield barriers)
+{
+    glMemoryBarrier(barriers);
+}
+
+GLuint Renderer::GlDevice::createFramebuffer()
+{
+    GLuint framebuffer{ 0 };
+    glGenFramebuffers(1, &framebuffer);
+    return framebuffer;
+}
+
+void Renderer::GlDevice::bindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    glBindFramebuffer(target, framebuffer);
+}
+
+void Renderer::GlDevice::deleteFramebuffer(GLuint framebuffer)
+{
+    glDeleteFramebuffers(1, &framebuffer);
+}
+
+GLuint Renderer::GlDevice::createRenderbuffer()
+{
+    GLuint renderbuffer{ 0 };
+    glGenRenderbuffers(1, &renderbuffer);
+    return renderbuffer;
+}
+
+void Renderer::GlDevice::bindRenderbuffer(GLuint renderbuffer)
+{
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+}
+
+void Renderer::GlDevice::deleteRenderbuffer(GLuint renderbuffer)
+{
+    glDeleteRenderbuffers(1, &renderbuffer);
+}
+
+void Renderer::GlDevice::renderbufferStorage(GLsizei samples,
+    GLenum internalFormat, GLsizei width, GLsizei height)
+{
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, internalFormat,
+        width, height);
+}
+
+void Renderer::GlDevice::framebufferRenderbuffer(GLenum target,
+    GLenum attachment, GLuint renderbuffer)
+{
+    glFramebufferRenderbuffer(target, attachment, GL_RENDERBUFFER,
+        renderbuffer);
+}
+
+void Renderer::GlDevice::framebufferTexture2D(GLenum target,
+    GLenum attachment, GLuint texture, GLint level)
+{
+    glFramebufferTexture2D(target, attachment, GL_TEXTURE_2D, texture, level);
+}
+
+GLenum Renderer::GlDevice::checkFramebufferStatus(GLenum target)
+{
+    return glCheckFramebufferStatus(target);
+}
+
+void Renderer::GlDevice::blitFramebuffer(GLint srcX0, GLint srcY0,
+    GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1,
+    GLint dstY1, GLbitfield mask, GLenum filter)
+{
+    glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1,
+        mask, filter);
+}
+
+GLuint Renderer::GlDevice::createQuery()
+{
+    GLuint query{ 0 };
+    glGenQueries(1, &query);
+    return query;
+}
+
+void Renderer::GlDevice::deleteQuery(GLuint query)
+{
+    glDeleteQueries(1, &query);
+}
+
+void Renderer::GlDevice::beginQuery(GLenum target, GLuint query)
+{
+    glBeginQuery(target, query);
+}
+
+void Renderer::GlDevice::endQuery(GLenum target)
+{
+    glEndQuery(target);
+}
+
+bool Renderer::GlDevice::getQueryResult(GLuint query, GLuint64& result)
+{
+    GLint available{ 0 };
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available == 0)
+    {
+        return false;
+    }
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &result);
+    return true;
+}
+
+GLuint Renderer::GlDevice::createFence()
+{
+    // Sync objects are pointers, the name keeps the interface in GLuint
+    const GLuint fence = nextFence_++;
+    fences_.emplace(fence, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    return fence;
+}
+
+bool Renderer::GlDevice::isFenceSignaled(GLuint fence)
+{
+    const auto sync = fences_.find(fence);
+    if (sync == fences_.end())
+    {
+        return false;
+    }
+    const GLenum status = glClientWaitSync(sync->second, 0, 0);
+    return status == GL_ALREADY_SIGNALED ||
+        status == GL_CONDITION_SATISFIED;
+}
+
+void Renderer::GlDevice::deleteFence(GLuint fence)
+{
+    const auto sync = fences_.find(fence);
+    if (sync != fences_.end())
+    {
+        glDeleteSync(sync->second);
+        fences_.erase(sync);
+    }
+}
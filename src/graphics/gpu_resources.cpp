@@ -0,0 +1,161 @@
+#include "gpu_resources.hpp"
+#include <sstream>
+
+Renderer::GpuResources::GpuResources(Device& device) : device_{ device },
+    textures_(), buffers_(), released_(), pending_(), recycledTextures_(),
+    recycledBuffers_(), stats_()
+{
+}
+
+Renderer::GpuResources::~GpuResources()
+{
+    textures_.forEach([this](GLuint name) { destroy(Kind::TEXTURE, name); });
+    buffers_.forEach([this](GLuint name) { destroy(Kind::BUFFER, name); });
+    for (const Released& released : released_)
+    {
+        destroy(released.kind, released.name);
+    }
+    for (const PendingFrame& frame : pending_)
+    {
+        for (const Released& released : frame.names)
+        {
+            destroy(released.kind, released.name);
+        }
+        device_.deleteFence(frame.fence);
+    }
+    for (const GLuint name : recycledTextures_)
+    {
+        destroy(Kind::TEXTURE, name);
+    }
+    for (const GLuint name : recycledBuffers_)
+    {
+        destroy(Kind::BUFFER, name);
+    }
+}
+
+Renderer::TextureHandle Renderer::GpuResources::createTexture()
+{
+    return textures_.insert(acquire(Kind::TEXTURE));
+}
+
+Renderer::BufferHandle Renderer::GpuResources::createBuffer()
+{
+    return buffers_.insert(acquire(Kind::BUFFER));
+}
+
+GLuint Renderer::GpuResources::get(TextureHandle texture) const
+{
+    return textures_.get(texture);
+}
+
+GLuint Renderer::GpuResources::get(BufferHandle buffer) const
+{
+    return buffers_.get(buffer);
+}
+
+void Renderer::GpuResources::release(TextureHandle texture)
+{
+    released_.push_back({ Kind::TEXTURE, textures_.remove(texture) });
+}
+
+void Renderer::GpuResources::release(BufferHandle buffer)
+{
+    released_.push_back({ Kind::BUFFER, buffers_.remove(buffer) });
+}
+
+void Renderer::GpuResources::endFrame()
+{
+    // Most frames release nothing and need no fence
+    if (released_.empty())
+    {
+        return;
+    }
+    // Swap in a list of a collected frame, so the lists keep their
+    // capacity instead of allocating again every time
+    PendingFrame frame{ device_.createFence(), {} };
+    if (!spareNames_.empty())
+    {
+        frame.names = std::move(spareNames_.back());
+        spareNames_.pop_back();
+    }
+    frame.names.swap(released_);
+    pending_.push_back(std::move(frame));
+}
+
+void Renderer::GpuResources::collect()
+{
+    while (!pending_.empty() &&
+        device_.isFenceSignaled(pending_.front().fence))
+    {
+        PendingFrame& frame = pending_.front();
+        for (const Released& released : frame.names)
+        {
+            retire(released);
+        }
+        device_.deleteFence(frame.fence);
+        frame.names.clear();
+        spareNames_.push_back(std::move(frame.names));
+        pending_.pop_front();
+    }
+}
+
+std::string Renderer::GpuResources::getSummary() const
+{
+    std::size_t pending = released_.size();
+    for (const PendingFrame& frame : pending_)
+    {
+        pending += frame.names.size();
+    }
+    std::ostringstream summary;
+    summary << "GPU resources: " << textures_.size() << " textures and "
+        << buffers_.size() << " buffers live, " << pending
+        << " awaiting the GPU, "
+        << recycledTextures_.size() + recycledBuffers_.size()
+        << " names kept for reuse; " << stats_.created << " created, "
+        << stats_.reused << " reused, " << stats_.deleted << " deleted\n";
+    return summary.str();
+}
+
+GLuint Renderer::GpuResources::acquire(Kind kind)
+{
+    std::vector<GLuint>& names = recycled(kind);
+    if (!names.empty())
+    {
+        const GLuint name = names.back();
+        names.pop_back();
+        ++stats_.reused;
+        return name;
+    }
+    ++stats_.created;
+    return kind == Kind::TEXTURE ? device_.createTexture() :
+        device_.createBuffer();
+}
+
+void Renderer::GpuResources::retire(const Released& released)
+{
+    std::vector<GLuint>& names = recycled(released.kind);
+    if (names.size() < GpuResourceConstants::RECYCLED_NAMES)
+    {
+        names.push_back(released.name);
+        return;
+    }
+    destroy(released.kind, released.name);
+}
+
+void Renderer::GpuResources::destroy(Kind kind, GLuint name)
+{
+    if (kind == Kind::TEXTURE)
+    {
+        device_.deleteTexture(name);
+    }
+    else
+    {
+        device_.deleteBuffer(name);
+    }
+    ++stats_.deleted;
+}
+
+std::vector<GLuint>& Renderer::GpuResources::recycled(Kind kind)
+{
+    return kind == Kind::TEXTURE ? recycledTextures_ : recycledBuffers_;
+}
@@ -0,0 +1,151 @@
+#include "grid_scene.hpp"
+#include <cmath>
+
+Renderer::GridScene::GridScene(Device& device, ShaderLibrary& shaders,
+    const SceneSettings& scene, GLsizei width, GLsizei height) :
+    device_{ device }, shaders_{ shaders },
+    features_{ featureBit(ShaderFeature::INSTANCED) |
+    materialFeatures(scene) }, vertexArray_{ 0 },
+    vertexBuffer_{ 0 }, instanceBuffer_{ 0 }, drawAllBuffer_{ 0 },
+    primitives_{ device, GL_PRIMITIVES_GENERATED,
+    GridConstants::PRIMITIVE_QUERIES }, view_{ 1.0f }, projection_{ 1.0f }
+{
+    // Compile the variant of the cubes now rather than in the first frame
+    shaders_.get(features_);
+
+    // Place the cubes in a block centered on the origin
+    constexpr int dimension = GridConstants::DIMENSION;
+    const float offset = 0.5f * static_cast<float>(dimension - 1) *
+        GridConstants::SPACING;
+    std::vector<glm::mat4> models;
+    std::vector<ObjectBounds> bounds;
+    models.reserve(dimension * dimension * dimension);
+    bounds.reserve(models.capacity());
+    for (int z = 0; z < dimension; ++z)
+    {
+        for (int y = 0; y < dimension; ++y)
+        {
+            for (int x = 0; x < dimension; ++x)
+            {
+                const glm::vec3 center = glm::vec3(x, y, z) *
+                    GridConstants::SPACING - glm::vec3(offset);
+                models.push_back(glm::translate(glm::mat4(1.0f), center));
+                bounds.push_back(ObjectBounds{ glm::vec4(center, 1.0f),
+                    glm::vec4(glm::vec3(0.5f), 0.0f) });
+            }
+        }
+    }
+    stats_.objects = models.size();
+
+    vertexArray_ = device_.createVertexArray();
+    device_.bindVertexArray(vertexArray_);
+    vertexBuffer_ = device_.createBuffer();
+    device_.bindBuffer(GL_ARRAY_BUFFER, vertexBuffer_);
+    device_.bufferData(GL_ARRAY_BUFFER, sizeof(Geometry::CUBE_VERTICES),
+        Geometry::CUBE_VERTICES.data(), GlConstants::DRAW_TYPE);
+    constexpr GLsizei vertexStride = VerticeDataVector::STRIDE * sizeof(float);
+    device_.vertexAttribPointer(static_cast<GLuint>(VSLocation::POSITION),
+        VerticeDataVector::POSITION_SIZE, GL_FLOAT, vertexStride,
+        VerticeDataVector::POSITION_LOCATION * sizeof(float));
+    device_.enableVertexAttribArray(static_cast<GLuint>(VSLocation::POSITION));
+    device_.vertexAttribPointer(static_cast<GLuint>(VSLocation::TEXTURE),
+        VerticeDataVector::TEXTURE_SIZE, GL_FLOAT, vertexStride,
+        VerticeDataVector::TEXTURE_LOCATION * sizeof(float));
+    device_.enableVertexAttribArray(static_cast<GLuint>(VSLocation::TEXTURE));
+
+    // The model matrix follows the vertex attributes, one column per
+    // location, and advances once per instance
+    instanceBuffer_ = device_.createBuffer();
+    device_.bindBuffer(GL_ARRAY_BUFFER, instanceBuffer_);
+    device_.bufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(
+        models.size() * sizeof(glm::mat4)), models.data(),
+        GlConstants::DRAW_TYPE);
+    const GLuint modelLocation = static_cast<GLuint>(VSLocation::TEXTURE) + 1;
+    for (GLuint column = 0; column < 4; ++column)
+    {
+        device_.vertexAttribPointer(modelLocation + column, 4, GL_FLOAT,
+            sizeof(glm::mat4), column * sizeof(glm::vec4));
+        device_.enableVertexAttribArray(modelLocation + column);
+        device_.vertexAttribDivisor(modelLocation + column, 1);
+    }
+    device_.bindVertexArray(0);
+
+    if (scene.occlusionCulling)
+    {
+        culler_ = std::make_unique<OcclusionCuller>(device_, shaders_, bounds,
+            Geometry::CUBE_VERTEX_COUNT, width, height);
+    }
+    else
+    {
+        const std::vector<DrawCommand> commands = drawAllCommands(
+            static_cast<GLsizei>(stats_.objects), Geometry::CUBE_VERTEX_COUNT);
+        drawAllBuffer_ = device_.createBuffer();
+        device_.bindBuffer(GL_DRAW_INDIRECT_BUFFER, drawAllBuffer_);
+        device_.bufferData(GL_DRAW_INDIRECT_BUFFER, static_cast<GLsizeiptr>(
+            commands.size() * sizeof(DrawCommand)), commands.data(),
+            GlConstants::DRAW_TYPE);
+        device_.bindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+}
+
+Renderer::GridScene::~GridScene()
+{
+    device_.deleteVertexArray(vertexArray_);
+    device_.deleteBuffer(vertexBuffer_);
+    device_.deleteBuffer(instanceBuffer_);
+    if (drawAllBuffer_ != 0)
+    {
+        device_.deleteBuffer(drawAllBuffer_);
+    }
+}
+
+void Renderer::GridScene::resize(GLsizei width, GLsizei height)
+{
+    if (culler_)
+    {
+        culler_->resize(width, height);
+    }
+}
+
+void Renderer::GridScene::update(float seconds, float aspectRatio)
+{
+    const float angle = glm::radians(GridConstants::ORBIT_SPEED * seconds);
+    const float radius = GridConstants::ORBIT_RADIUS *
+        static_cast<float>(GridConstants::DIMENSION);
+    const glm::vec3 eye(radius * std::sin(angle), GridConstants::ORBIT_HEIGHT *
+        static_cast<float>(GridConstants::DIMENSION), radius * std::cos(angle));
+    view_ = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    projection_ = glm::perspective(glm::radians(45.0f), aspectRatio, 0.1f,
+        1000.0f);
+
+    if (culler_)
+    {
+        culler_->cull(vertexArray_, view_, projection_);
+    }
+}
+
+void Renderer::GridScene::draw()
+{
+    // Count the cubes of frames the GPU has finished
+    while (const std::optional<GLuint64> primitives = primitives_.collect())
+    {
+        stats_.lastDrawn = *primitives / GridConstants::TRIANGLES_PER_CUBE;
+        stats_.drawn += stats_.lastDrawn;
+        ++stats_.frames;
+    }
+
+    const ShaderProgram& program = shaders_.get(features_);
+    device_.useProgram(program.getProgramID());
+    program.setUniform("texture1", GlConstants::DEFAULT_TEXTURE_UNIT);
+    program.setUniform("texture2", GlConstants::DEFAULT_TEXTURE_UNIT + 1);
+    program.setUniform("view", view_);
+    program.setUniform("projection", projection_);
+
+    device_.bindVertexArray(vertexArray_);
+    device_.bindBuffer(GL_DRAW_INDIRECT_BUFFER,
+        culler_ ? culler_->getCommandBuffer() : drawAllBuffer_);
+    primitives_.begin();
+    device_.multiDrawArraysIndirect(GL_TRIANGLES, 0,
+        static_cast<GLsizei>(stats_.objects), 0);
+    primitives_.end();
+}
@@ -0,0 +1,543 @@
+#include "image_pipeline.hpp"
+#include "renderer.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <optional>
+
+// Every x86-64 target has SSE2, use it for the pixel kernels when available
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_PIPELINE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr std::size_t RGBA = Renderer::ImageConstants::CHANNELS;
+
+    double millisecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(
+            Clock::now() - start).count();
+    }
+
+    // Wraps a texel coordinate into [0, size) like GL_REPEAT
+    int wrapRepeat(int coordinate, int size)
+    {
+        const int wrapped = coordinate % size;
+        return wrapped < 0 ? wrapped + size : wrapped;
+    }
+
+    // Rounds a value in [0, 1] to a byte, clamping the overshoot of the
+    // Kaiser filter
+    unsigned char toByte(float value)
+    {
+        return static_cast<unsigned char>(
+            std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    /**
+     * The sRGB transfer function both ways: every byte decoded to linear
+     * light, and linear light quantized finely enough that every byte is
+     * encoded back to itself.
+     */
+    struct SrgbTables
+    {
+        std::array<float, 256> decode;
+        std::array<unsigned char,
+            Renderer::ImageConstants::SRGB_ENCODE_ENTRIES> encode;
+
+        SrgbTables()
+        {
+            for (std::size_t i = 0; i < decode.size(); ++i)
+            {
+                const float c = static_cast<float>(i) / 255.0f;
+                decode[i] = c <= 0.04045f ? c / 12.92f :
+                    std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            for (std::size_t i = 0; i < encode.size(); ++i)
+            {
+                const float l = static_cast<float>(i) /
+                    static_cast<float>(encode.size() - 1);
+                encode[i] = toByte(l <= 0.0031308f ? l * 12.92f :
+                    1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f);
+            }
+        }
+
+        unsigned char toSrgb(float linear) const
+        {
+            const float scale = static_cast<float>(encode.size() - 1);
+            return encode[static_cast<std::size_t>(
+                std::clamp(linear, 0.0f, 1.0f) * scale + 0.5f)];
+        }
+    };
+
+    const SrgbTables& srgbTables()
+    {
+        static const SrgbTables tables;
+        return tables;
+    }
+
+    // The modified Bessel function of order 0 the Kaiser window is built
+    // from, its series converges quickly for the betas in use
+    double besselI0(double x)
+    {
+        double sum = 1.0;
+        double term = 1.0;
+        for (int k = 1; k < 32; ++k)
+        {
+            term *= (x / (2.0 * k)) * (x / (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    // The weights of the source texels around the center of an output
+    // texel: a sinc reducing by 2, windowed by Kaiser, summing to 1
+    using KaiserWeights =
+        std::array<float, Renderer::ImageConstants::KAISER_TAPS>;
+    const KaiserWeights& kaiserWeights()
+    {
+        static const KaiserWeights weights = []() {
+            constexpr int taps = Renderer::ImageConstants::KAISER_TAPS;
+            constexpr double pi = 3.14159265358979323846;
+            const double beta = Renderer::ImageConstants::KAISER_BETA;
+            const double radius = 0.5 * taps;
+            KaiserWeights result{};
+            double total = 0.0;
+            std::array<double, taps> raw{};
+            for (int k = 0; k < taps; ++k)
+            {
+                const double offset = k + 0.5 - radius;
+                const double x = pi * offset / 2.0;
+                const double sinc = std::sin(x) / x;
+                const double t = offset / radius;
+                raw[k] = sinc * besselI0(beta * std::sqrt(1.0 - t * t)) /
+                    besselI0(beta);
+                total += raw[k];
+            }
+            for (int k = 0; k < taps; ++k)
+            {
+                result[k] = static_cast<float>(raw[k] / total);
+            }
+            return result;
+        }();
+        return weights;
+    }
+
+    // Expands packed pixels of 1 to 4 channels to RGBA8
+    void expandToRgba(const unsigned char* source, unsigned char* target,
+        std::size_t pixels, int channels, bool simd)
+    {
+        if (channels == 4)
+        {
+            std::memcpy(target, source, pixels * RGBA);
+            return;
+        }
+
+        std::size_t i = 0;
+#ifdef IMAGE_PIPELINE_SSE2
+        if (simd && channels == 3)
+        {
+            // Four pixels a step from one 16 byte load, shifted so every
+            // pixel starts a 32 bit lane; the load reaches two pixels ahead
+            const __m128i opaque =
+                _mm_set1_epi32(static_cast<int>(0xFF000000u));
+            for (; i + 6 <= pixels; i += 4)
+            {
+                const __m128i rgb = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i*>(source + i * 3));
+                const __m128i first = _mm_unpacklo_epi32(rgb,
+                    _mm_srli_si128(rgb, 3));
+                const __m128i second = _mm_unpacklo_epi32(
+                    _mm_srli_si128(rgb, 6), _mm_srli_si128(rgb, 9));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(target + i * RGBA),
+                    _mm_or_si128(_mm_unpacklo_epi64(first, second), opaque));
+            }
+        }
+#else
+        (void)simd;
+#endif
+        for (; i < pixels; ++i)
+        {
+            const unsigned char* pixel = source + i * channels;
+            unsigned char* texel = target + i * RGBA;
+            // Grey is replicated, the alpha defaults to opaque
+            texel[0] = pixel[0];
+            texel[1] = channels >= 3 ? pixel[1] : pixel[0];
+            texel[2] = channels >= 3 ? pixel[2] : pixel[0];
+            texel[3] = channels == 2 ? pixel[1] :
+                channels == 4 ? pixel[3] : 255;
+        }
+    }
+
+    // Multiplies the color of RGBA8 pixels by their alpha, rounding
+    // c * a / 255 exactly
+    void premultiply(unsigned char* texels, std::size_t pixels, bool simd)
+    {
+        std::size_t i = 0;
+#ifdef IMAGE_PIPELINE_SSE2
+        if (simd)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i half = _mm_set1_epi16(128);
+            // Alpha is multiplied by 255, which leaves it as it is
+            const __m128i alphaLanes =
+                _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+            const auto scale = [&](__m128i channels) {
+                __m128i alpha = _mm_shufflelo_epi16(channels,
+                    _MM_SHUFFLE(3, 3, 3, 3));
+                alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+                const __m128i product = _mm_add_epi16(_mm_mullo_epi16(
+                    channels, _mm_or_si128(alpha, alphaLanes)), half);
+                return _mm_srli_epi16(_mm_add_epi16(product,
+                    _mm_srli_epi16(product, 8)), 8);
+            };
+            for (; i + 4 <= pixels; i += 4)
+            {
+                __m128i* block = reinterpret_cast<__m128i*>(texels + i * RGBA);
+                const __m128i rgba = _mm_loadu_si128(block);
+                _mm_storeu_si128(block, _mm_packus_epi16(
+                    scale(_mm_unpacklo_epi8(rgba, zero)),
+                    scale(_mm_unpackhi_epi8(rgba, zero))));
+            }
+        }
+#else
+        (void)simd;
+#endif
+        for (; i < pixels; ++i)
+        {
+            unsigned char* texel = texels + i * RGBA;
+            for (int c = 0; c < 3; ++c)
+            {
+                const unsigned int product = texel[c] * texel[3] + 128u;
+                texel[c] = static_cast<unsigned char>(
+                    (product + (product >> 8)) >> 8);
+            }
+        }
+    }
+
+    /**
+     * A mipmap level and the one it is filtered into, with the pairs of
+     * source texels of every target texel clamped to the level like
+     * glGenerateMipmap does for odd sizes.
+     */
+    struct Reduction
+    {
+        const unsigned char* source;
+        int sourceWidth;
+        int sourceHeight;
+        unsigned char* target;
+        int width;
+        int height;
+
+        const unsigned char* texel(int x, int y) const
+        {
+            return source + (static_cast<std::size_t>(y) * sourceWidth + x) *
+                RGBA;
+        }
+    };
+
+    // Averages 2x2 texels of linear values
+    void boxLinear(const Reduction& level, bool simd)
+    {
+        for (int y = 0; y < level.height; ++y)
+        {
+            const int y0 = std::min(y * 2, level.sourceHeight - 1);
+            const int y1 = std::min(y * 2 + 1, level.sourceHeight - 1);
+            unsigned char* row = level.target +
+                static_cast<std::size_t>(y) * level.width * RGBA;
+            int x = 0;
+#ifdef IMAGE_PIPELINE_SSE2
+            if (simd && level.sourceWidth >= 2)
+            {
+                // Four target texels from eight source texels of each row,
+                // summed in 16 bit lanes
+                const __m128i zero = _mm_setzero_si128();
+                const __m128i two = _mm_set1_epi16(2);
+                const auto average = [&](__m128i top, __m128i bottom) {
+                    const __m128i low = _mm_add_epi16(
+                        _mm_unpacklo_epi8(top, zero),
+                        _mm_unpacklo_epi8(bottom, zero));
+                    const __m128i high = _mm_add_epi16(
+                        _mm_unpackhi_epi8(top, zero),
+                        _mm_unpackhi_epi8(bottom, zero));
+                    const __m128i sum = _mm_add_epi16(
+                        _mm_unpacklo_epi64(low, high),
+                        _mm_unpackhi_epi64(low, high));
+                    return _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+                };
+                for (; x + 4 <= level.width; x += 4)
+                {
+                    const __m128i* top = reinterpret_cast<const __m128i*>(
+                        level.texel(x * 2, y0));
+                    const __m128i* bottom = reinterpret_cast<const __m128i*>(
+                        level.texel(x * 2, y1));
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(
+                        row + static_cast<std::size_t>(x) * RGBA),
+                        _mm_packus_epi16(
+                            average(_mm_loadu_si128(top),
+                                _mm_loadu_si128(bottom)),
+                            average(_mm_loadu_si128(top + 1),
+                                _mm_loadu_si128(bottom + 1))));
+                }
+            }
+#else
+            (void)simd;
+#endif
+            for (; x < level.width; ++x)
+            {
+                const int x0 = std::min(x * 2, level.sourceWidth - 1);
+                const int x1 = std::min(x * 2 + 1, level.sourceWidth - 1);
+                for (std::size_t c = 0; c < RGBA; ++c)
+                {
+                    const int sum = level.texel(x0, y0)[c] +
+                        level.texel(x1, y0)[c] + level.texel(x0, y1)[c] +
+                        level.texel(x1, y1)[c];
+                    row[static_cast<std::size_t>(x) * RGBA + c] =
+                        static_cast<unsigned char>((sum + 2) / 4);
+                }
+            }
+        }
+    }
+
+    // Averages 2x2 texels in linear light, alpha as stored
+    void boxSrgb(const Reduction& level)
+    {
+        const SrgbTables& srgb = srgbTables();
+        for (int y = 0; y < level.height; ++y)
+        {
+            const int y0 = std::min(y * 2, level.sourceHeight - 1);
+            const int y1 = std::min(y * 2 + 1, level.sourceHeight - 1);
+            for (int x = 0; x < level.width; ++x)
+            {
+                const int x0 = std::min(x * 2, level.sourceWidth - 1);
+                const int x1 = std::min(x * 2 + 1, level.sourceWidth - 1);
+                const unsigned char* texels[4] = { level.texel(x0, y0),
+                    level.texel(x1, y0), level.texel(x0, y1),
+                    level.texel(x1, y1) };
+                unsigned char* target = level.target +
+                    (static_cast<std::size_t>(y) * level.width + x) * RGBA;
+                for (int c = 0; c < 3; ++c)
+                {
+                    float sum = 0.0f;
+                    for (const unsigned char* texel : texels)
+                    {
+                        sum += srgb.decode[texel[c]];
+                    }
+                    target[c] = srgb.toSrgb(0.25f * sum);
+                }
+                const int alpha = texels[0][3] + texels[1][3] +
+                    texels[2][3] + texels[3][3];
+                target[3] = static_cast<unsigned char>((alpha + 2) / 4);
+            }
+        }
+    }
+
+    // Filters the rows and then the columns with the Kaiser weights,
+    // wrapping around the edges like the sampler repeats the texture
+    void kaiser(const Reduction& level, bool srgbColors)
+    {
+        const SrgbTables& srgb = srgbTables();
+        const KaiserWeights& weights = kaiserWeights();
+        constexpr int first = 1 - Renderer::ImageConstants::KAISER_TAPS / 2;
+
+        // Every source row reduced horizontally, in linear light
+        std::vector<float> rows(static_cast<std::size_t>(level.width) *
+            level.sourceHeight * RGBA, 0.0f);
+        for (int y = 0; y < level.sourceHeight; ++y)
+        {
+            for (int x = 0; x < level.width; ++x)
+            {
+                float* sum = &rows[(static_cast<std::size_t>(y) *
+                    level.width + x) * RGBA];
+                for (std::size_t k = 0; k < weights.size(); ++k)
+                {
+                    const unsigned char* texel = level.texel(wrapRepeat(
+                        x * 2 + first + static_cast<int>(k),
+                        level.sourceWidth), y);
+                    for (std::size_t c = 0; c < RGBA; ++c)
+                    {
+                        const float value = srgbColors && c < 3 ?
+                            srgb.decode[texel[c]] : texel[c] / 255.0f;
+                        sum[c] += weights[k] * value;
+                    }
+                }
+            }
+        }
+
+        for (int y = 0; y < level.height; ++y)
+        {
+            for (int x = 0; x < level.width; ++x)
+            {
+                float sum[RGBA] = {};
+                for (std::size_t k = 0; k < weights.size(); ++k)
+                {
+                    const int row = wrapRepeat(
+                        y * 2 + first + static_cast<int>(k),
+                        level.sourceHeight);
+                    const float* texel = &rows[(static_cast<std::size_t>(
+                        row) * level.width + x) * RGBA];
+                    for (std::size_t c = 0; c < RGBA; ++c)
+                    {
+                        sum[c] += weights[k] * texel[c];
+                    }
+                }
+                unsigned char* target = level.target +
+                    (static_cast<std::size_t>(y) * level.width + x) * RGBA;
+                for (std::size_t c = 0; c < RGBA; ++c)
+                {
+                    target[c] = srgbColors && c < 3 ? srgb.toSrgb(sum[c]) :
+                        toByte(sum[c]);
+                }
+            }
+        }
+    }
+}
+
+Renderer::TextureImage::TextureImage(const std::string& imagePath,
+    const ImageSettings& settings) : settings_{ settings }, timings_(),
+    levels_(), pixels_()
+{
+    const Clock::time_point start = Clock::now();
+    // The decoded pixels are only needed until they are converted
+    const Image image(imagePath);
+    timings_.decodeMs = millisecondsSince(start);
+    prepare(image.getData(), image.getWidth(), image.getHeight(),
+        image.getNumberOfChannels());
+}
+
+Renderer::TextureImage::TextureImage(const unsigned char* pixels, int width,
+    int height, int channels, const ImageSettings& settings) :
+    settings_{ settings }, timings_(), levels_(), pixels_()
+{
+    prepare(pixels, width, height, channels);
+}
+
+Renderer::TextureImage::TextureImage(TextureImage&& other) noexcept :
+    settings_{ other.settings_ }, timings_{ other.timings_ },
+    levels_{ std::move(other.levels_) }, pixels_{ std::move(other.pixels_) }
+{
+    // The accounted memory moves along with the pixels
+    other.levels_.clear();
+    other.pixels_.clear();
+}
+
+Renderer::TextureImage::~TextureImage()
+{
+    if (!pixels_.empty())
+    {
+        trackRelease(MemoryCategory::IMAGE, pixels_.size());
+    }
+}
+
+GLint Renderer::TextureImage::getInternalFormat() const
+{
+    return settings_.colorSpace == ColorSpace::SRGB ? GL_SRGB8_ALPHA8 :
+        GL_RGBA8;
+}
+
+void Renderer::TextureImage::prepare(const unsigned char* pixels, int width,
+    int height, int channels)
+{
+    if (channels < 1 || channels > 4)
+    {
+        throw std::domain_error("ERROR::TEXTURE_IMAGE::UNSUPPORTED_CHANNELS "
+            + std::to_string(channels));
+    }
+    if (width <= 0 || height <= 0)
+    {
+        throw std::domain_error("ERROR::TEXTURE_IMAGE::EMPTY_IMAGE");
+    }
+
+    // Lay out every level down to 1x1 first, so the chain is one
+    // allocation
+    std::size_t size = 0;
+    for (int levelWidth = width, levelHeight = height;;
+        levelWidth = std::max(1, levelWidth / 2),
+        levelHeight = std::max(1, levelHeight / 2))
+    {
+        levels_.push_back({ size, levelWidth, levelHeight });
+        size += static_cast<std::size_t>(levelWidth) * levelHeight * RGBA;
+        if (levelWidth == 1 && levelHeight == 1)
+        {
+            break;
+        }
+    }
+    pixels_.resize(size);
+    trackAllocation(MemoryCategory::IMAGE, pixels_.size());
+
+    const Clock::time_point convertStart = Clock::now();
+    const std::size_t basePixels = static_cast<std::size_t>(width) * height;
+    expandToRgba(pixels, pixels_.data(), basePixels, channels,
+        settings_.simd);
+    if (settings_.premultiplyAlpha)
+    {
+        premultiply(pixels_.data(), basePixels, settings_.simd);
+    }
+    timings_.convertMs = millisecondsSince(convertStart);
+
+    // Each level is filtered from the one above it
+    const Clock::time_point mipStart = Clock::now();
+    const bool srgb = settings_.colorSpace == ColorSpace::SRGB;
+    for (std::size_t level = 1; level < levels_.size(); ++level)
+    {
+        const Level& source = levels_[level - 1];
+        const Level& target = levels_[level];
+        const Reduction reduction{ pixels_.data() + source.offset,
+            source.width, source.height, pixels_.data() + target.offset,
+            target.width, target.height };
+        if (settings_.mipFilter == MipFilter::KAISER)
+        {
+            kaiser(reduction, srgb);
+        }
+        else if (srgb)
+        {
+            boxSrgb(reduction);
+        }
+        else
+        {
+            boxLinear(reduction, settings_.simd);
+        }
+    }
+    timings_.mipMs = millisecondsSince(mipStart);
+}
+
+std::vector<Renderer::TextureImage> Renderer::decodeTextureImages(
+    const std::vector<std::string>& imagePaths,
+    const ImageSettings& settings, std::size_t workers)
+{
+    // Each image is decoded, converted and filtered by one task
+    std::vector<std::optional<TextureImage>> decoded(imagePaths.size());
+    TaskGraph graph;
+    for (std::size_t i = 0; i < imagePaths.size(); ++i)
+    {
+        graph.add("decode image", TaskThread::WORKER,
+            [&decoded, &imagePaths, &settings, i]() {
+                decoded[i].emplace(imagePaths[i], settings);
+            });
+    }
+    graph.start(std::min(workers, imagePaths.size()));
+    graph.waitAll();
+
+    std::vector<TextureImage> images;
+    images.reserve(decoded.size());
+    for (std::optional<TextureImage>& image : decoded)
+    {
+        images.push_back(std::move(*image));
+    }
+    return images;
+}
+
+bool Renderer::hasImageSimd()
+{
+#ifdef IMAGE_PIPELINE_SSE2
+    return true;
+#else
+    return false;
+#endif
+}
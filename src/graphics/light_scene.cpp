@@ -0,0 +1,194 @@
+#include "light_scene.hpp"
+#include "occlusion_culling.hpp"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <sstream>
+
+namespace
+{
+    // Adds the average of a stage to the summary
+    void formatStage(std::ostringstream& summary, const char* name,
+        const Renderer::StageTiming& stage)
+    {
+        summary << name << ' ';
+        if (stage.frames == 0)
+        {
+            summary << "not measured";
+            return;
+        }
+        summary << stage.totalMs / static_cast<double>(stage.frames)
+            << " ms";
+    }
+}
+
+Renderer::LightScene::LightScene(Device& device, ShaderLibrary& shaders,
+    const SceneSettings& scene, bool timeShading) : device_{ device },
+    shaders_{ shaders }, features_{ featureBit(ShaderFeature::INSTANCED) |
+    featureBit(ShaderFeature::CLUSTERED_LIGHTING) |
+    materialFeatures(scene) }, instanceCount_{ 0 }, vertexArray_{ 0 },
+    vertexBuffer_{ 0 }, instanceBuffer_{ 0 }, commandBuffer_{ 0 },
+    lighting_{ nullptr }, view_{ 1.0f }, projection_{ 1.0f }
+{
+    // Compile the variant of the cubes now rather than in the first frame
+    shaders_.get(features_);
+
+    std::mt19937 random(LightSceneConstants::SEED);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const auto between = [&random, &unit](float low, float high) {
+        return low + (high - low) * unit(random);
+    };
+
+    // The ground slab comes first, then a cube of random height per cell
+    // of the field, standing on the ground and centered on the origin
+    constexpr int dimension = LightSceneConstants::DIMENSION;
+    const float extent = static_cast<float>(dimension) *
+        LightSceneConstants::SPACING;
+    const float offset = 0.5f * static_cast<float>(dimension - 1) *
+        LightSceneConstants::SPACING;
+    std::vector<glm::mat4> models;
+    models.reserve(1 + dimension * dimension);
+    models.push_back(glm::scale(glm::translate(glm::mat4(1.0f),
+        glm::vec3(0.0f, -0.5f * LightSceneConstants::GROUND_THICKNESS, 0.0f)),
+        glm::vec3(extent, LightSceneConstants::GROUND_THICKNESS, extent)));
+    for (int z = 0; z < dimension; ++z)
+    {
+        for (int x = 0; x < dimension; ++x)
+        {
+            const float height = between(LightSceneConstants::MIN_HEIGHT,
+                LightSceneConstants::MAX_HEIGHT);
+            const glm::vec3 center(static_cast<float>(x) *
+                LightSceneConstants::SPACING - offset, 0.5f * height,
+                static_cast<float>(z) * LightSceneConstants::SPACING - offset);
+            models.push_back(glm::scale(glm::translate(glm::mat4(1.0f),
+                center), glm::vec3(1.0f, height, 1.0f)));
+        }
+    }
+    instanceCount_ = static_cast<GLsizei>(models.size());
+
+    // Scatter the paths of the lights over the field, with saturated
+    // colors so that overlapping lights stay apart
+    std::vector<PointLight> lights(scene.lightCount);
+    for (PointLight& light : lights)
+    {
+        light.position = glm::vec4(between(-0.5f * extent, 0.5f * extent),
+            between(LightSceneConstants::MIN_LIGHT_HEIGHT,
+                LightSceneConstants::MAX_LIGHT_HEIGHT),
+            between(-0.5f * extent, 0.5f * extent),
+            between(LightSceneConstants::MIN_LIGHT_RADIUS,
+                LightSceneConstants::MAX_LIGHT_RADIUS));
+        const glm::vec3 color(unit(random), unit(random), unit(random));
+        const float brightest =
+            std::max(color.x, std::max(color.y, color.z)) + 1.0e-6f;
+        light.color = glm::vec4(color.x / brightest, color.y / brightest,
+            color.z / brightest, between(0.0f, glm::radians(360.0f)));
+    }
+    lighting_ = std::make_unique<ClusteredLighting>(device_, lights,
+        LightSceneConstants::NEAR_PLANE, LightSceneConstants::FAR_PLANE,
+        timeShading);
+
+    vertexArray_ = device_.createVertexArray();
+    device_.bindVertexArray(vertexArray_);
+    vertexBuffer_ = device_.createBuffer();
+    device_.bindBuffer(GL_ARRAY_BUFFER, vertexBuffer_);
+    device_.bufferData(GL_ARRAY_BUFFER, sizeof(Geometry::CUBE_VERTICES),
+        Geometry::CUBE_VERTICES.data(), GlConstants::DRAW_TYPE);
+    constexpr GLsizei vertexStride = VerticeDataVector::STRIDE * sizeof(float);
+    device_.vertexAttribPointer(static_cast<GLuint>(VSLocation::POSITION),
+        VerticeDataVector::POSITION_SIZE, GL_FLOAT, vertexStride,
+        VerticeDataVector::POSITION_LOCATION * sizeof(float));
+    device_.enableVertexAttribArray(static_cast<GLuint>(VSLocation::POSITION));
+    device_.vertexAttribPointer(static_cast<GLuint>(VSLocation::TEXTURE),
+        VerticeDataVector::TEXTURE_SIZE, GL_FLOAT, vertexStride,
+        VerticeDataVector::TEXTURE_LOCATION * sizeof(float));
+    device_.enableVertexAttribArray(static_cast<GLuint>(VSLocation::TEXTURE));
+
+    // The model matrix follows the vertex attributes, like in GridScene
+    instanceBuffer_ = device_.createBuffer();
+    device_.bindBuffer(GL_ARRAY_BUFFER, instanceBuffer_);
+    device_.bufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(
+        models.size() * sizeof(glm::mat4)), models.data(),
+        GlConstants::DRAW_TYPE);
+    const GLuint modelLocation = static_cast<GLuint>(VSLocation::TEXTURE) + 1;
+    for (GLuint column = 0; column < 4; ++column)
+    {
+        device_.vertexAttribPointer(modelLocation + column, 4, GL_FLOAT,
+            sizeof(glm::mat4), column * sizeof(glm::vec4));
+        device_.enableVertexAttribArray(modelLocation + column);
+        device_.vertexAttribDivisor(modelLocation + column, 1);
+    }
+    device_.bindVertexArray(0);
+
+    // Every instance in one draw
+    const DrawCommand command{ static_cast<GLuint>(
+        Geometry::CUBE_VERTEX_COUNT), static_cast<GLuint>(instanceCount_),
+        0, 0 };
+    commandBuffer_ = device_.createBuffer();
+    device_.bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer_);
+    device_.bufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(command), &command,
+        GlConstants::DRAW_TYPE);
+    device_.bindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+Renderer::LightScene::~LightScene()
+{
+    device_.deleteVertexArray(vertexArray_);
+    device_.deleteBuffer(vertexBuffer_);
+    device_.deleteBuffer(instanceBuffer_);
+    device_.deleteBuffer(commandBuffer_);
+}
+
+void Renderer::LightScene::update(float seconds, float aspectRatio)
+{
+    const float extent = static_cast<float>(LightSceneConstants::DIMENSION) *
+        LightSceneConstants::SPACING;
+    const float angle = glm::radians(LightSceneConstants::ORBIT_SPEED *
+        seconds);
+    const float radius = LightSceneConstants::ORBIT_RADIUS * extent;
+    const glm::vec3 eye(radius * std::sin(angle),
+        LightSceneConstants::ORBIT_HEIGHT * extent, radius * std::cos(angle));
+    view_ = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    projection_ = glm::perspective(glm::radians(45.0f), aspectRatio,
+        LightSceneConstants::NEAR_PLANE, LightSceneConstants::FAR_PLANE);
+
+    lighting_->move(seconds, view_);
+}
+
+void Renderer::LightScene::assignLights()
+{
+    lighting_->assign(projection_);
+}
+
+void Renderer::LightScene::draw()
+{
+    const ShaderProgram& program = shaders_.get(features_);
+    device_.useProgram(program.getProgramID());
+    program.setUniform("texture1", GlConstants::DEFAULT_TEXTURE_UNIT);
+    program.setUniform("texture2", GlConstants::DEFAULT_TEXTURE_UNIT + 1);
+    program.setUniform("view", view_);
+    program.setUniform("projection", projection_);
+
+    device_.bindVertexArray(vertexArray_);
+    device_.bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer_);
+    lighting_->beginShading(program);
+    device_.multiDrawArraysIndirect(GL_TRIANGLES, 0, 1, 0);
+    lighting_->endShading();
+}
+
+std::string Renderer::LightScene::getSummary() const
+{
+    const LightingTimings& timings = lighting_->getTimings();
+    std::ostringstream summary;
+    summary << "Light scene: " << lighting_->getLightCount()
+        << " lights over " << instanceCount_ - 1 << " cubes in "
+        << ClusterConstants::CLUSTERS_X << 'x' << ClusterConstants::CLUSTERS_Y
+        << 'x' << ClusterConstants::CLUSTERS_Z << " clusters, GPU time per "
+        "frame: ";
+    formatStage(summary, "move", timings.move);
+    summary << ", ";
+    formatStage(summary, "assign", timings.assign);
+    summary << ", ";
+    formatStage(summary, "shade", timings.shade);
+    summary << " over " << timings.move.frames << " frames\n";
+    return summary.str();
+}
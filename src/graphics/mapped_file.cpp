@@ -0,0 +1,192 @@
+#include "mapped_file.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // The multipliers of the hash, odd 64 bit constants with well mixed bits
+    constexpr std::uint64_t PRIME_1 = 0x9E3779B185EBCA87ull;
+    constexpr std::uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+
+    std::uint64_t rotateLeft(std::uint64_t value, unsigned int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    // Spreads every input bit over the whole hash
+    std::uint64_t avalanche(std::uint64_t hash)
+    {
+        hash ^= hash >> 33;
+        hash *= PRIME_2;
+        hash ^= hash >> 29;
+        hash *= PRIME_1;
+        hash ^= hash >> 32;
+        return hash;
+    }
+}
+
+Renderer::MappedFile::MappedFile() : data_{ nullptr }, size_{ 0 }
+#ifdef _WIN32
+    , file_{ nullptr }, mapping_{ nullptr }
+#endif
+{
+}
+
+Renderer::MappedFile::MappedFile(const std::string& path) : MappedFile()
+{
+#ifdef _WIN32
+    const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ,
+        FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        throw std::runtime_error("ERROR::MAPPED_FILE::CANNOT OPEN " + path);
+    }
+    file_ = file;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        close();
+        throw std::runtime_error("ERROR::MAPPED_FILE::CANNOT READ THE SIZE OF "
+            + path);
+    }
+    size_ = static_cast<std::size_t>(size.QuadPart);
+    // Empty files cannot be mapped, they have no data to point to
+    if (size_ == 0)
+    {
+        return;
+    }
+    mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0,
+        nullptr);
+    const void* view = mapping_ != nullptr ?
+        MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (view == nullptr)
+    {
+        close();
+        throw std::runtime_error("ERROR::MAPPED_FILE::CANNOT MAP " + path);
+    }
+    data_ = static_cast<const std::uint8_t*>(view);
+#else
+    const int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        throw std::runtime_error("ERROR::MAPPED_FILE::CANNOT OPEN " + path);
+    }
+    struct stat status;
+    if (::fstat(file, &status) != 0)
+    {
+        ::close(file);
+        throw std::runtime_error("ERROR::MAPPED_FILE::CANNOT READ THE SIZE OF "
+            + path);
+    }
+    size_ = static_cast<std::size_t>(status.st_size);
+    if (size_ == 0)
+    {
+        ::close(file);
+        return;
+    }
+    void* view = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+    // The mapping keeps its own reference to the file
+    ::close(file);
+    if (view == MAP_FAILED)
+    {
+        size_ = 0;
+        throw std::runtime_error("ERROR::MAPPED_FILE::CANNOT MAP " + path);
+    }
+    // The file is read front to back, by hashing or by uploading it
+    ::madvise(view, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const std::uint8_t*>(view);
+#endif
+}
+
+Renderer::MappedFile::MappedFile(MappedFile&& other) noexcept :
+    data_{ std::exchange(other.data_, nullptr) },
+    size_{ std::exchange(other.size_, 0) }
+#ifdef _WIN32
+    , file_{ std::exchange(other.file_, nullptr) },
+    mapping_{ std::exchange(other.mapping_, nullptr) }
+#endif
+{
+}
+
+Renderer::MappedFile& Renderer::MappedFile::operator=(
+    MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+#ifdef _WIN32
+        file_ = std::exchange(other.file_, nullptr);
+        mapping_ = std::exchange(other.mapping_, nullptr);
+#endif
+    }
+    return *this;
+}
+
+Renderer::MappedFile::~MappedFile()
+{
+    close();
+}
+
+void Renderer::MappedFile::close()
+{
+#ifdef _WIN32
+    if (data_ != nullptr)
+    {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_ != nullptr)
+    {
+        CloseHandle(mapping_);
+    }
+    if (file_ != nullptr)
+    {
+        CloseHandle(file_);
+    }
+    file_ = nullptr;
+    mapping_ = nullptr;
+#else
+    if (data_ != nullptr)
+    {
+        ::munmap(const_cast<std::uint8_t*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+
+std::uint64_t Renderer::hashBytes(const void* data, std::size_t size,
+    std::uint64_t seed)
+{
+    const auto* bytes = static_cast<const std::uint8_t*>(data);
+    std::uint64_t hash = seed + PRIME_1 + size;
+    std::size_t offset = 0;
+    for (; offset + sizeof(std::uint64_t) <= size;
+        offset += sizeof(std::uint64_t))
+    {
+        std::uint64_t word;
+        std::memcpy(&word, bytes + offset, sizeof(word));
+        hash ^= rotateLeft(word * PRIME_2, 31) * PRIME_1;
+        hash = rotateLeft(hash, 27) * PRIME_1 + PRIME_2;
+    }
+    for (; offset < size; ++offset)
+    {
+        hash ^= bytes[offset] * PRIME_1;
+        hash = rotateLeft(hash, 11) * PRIME_2;
+    }
+    return avalanche(hash);
+}
@@ -0,0 +1,626 @@
+#include "memory_tracker.hpp"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+    /**
+     * @struct Counter
+     * @brief The current and peak bytes of a category or total.
+     */
+    struct Counter
+    {
+        std::atomic<std::uint64_t> current{ 0 };
+        std::atomic<std::uint64_t> peak{ 0 };
+    };
+
+    std::array<Counter, static_cast<std::size_t>(
+        Renderer::MemoryCategory::COUNT)> categoryCounters;
+    Counter cpuCounter;
+    Counter gpuCounter;
+
+    void add(Counter& counter, std::uint64_t bytes)
+    {
+        const std::uint64_t current = counter.current.fetch_add(bytes) + bytes;
+        std::uint64_t peak = counter.peak.load();
+        while (current > peak &&
+            !counter.peak.compare_exchange_weak(peak, current))
+        {
+        }
+    }
+
+    Renderer::MemoryUsage read(const Counter& counter)
+    {
+        return Renderer::MemoryUsage{ counter.current.load(),
+            counter.peak.load() };
+    }
+
+    void writeUsage(std::ostream& stream, const Renderer::MemoryUsage& usage)
+    {
+        stream << "{ \"current\": " << usage.current << ", \"peak\": "
+            << usage.peak << " }";
+    }
+}
+
+const char* Renderer::toString(MemoryCategory category)
+{
+    switch (category)
+    {
+    case MemoryCategory::IMAGE: return "image";
+    case MemoryCategory::SHADER_SOURCE: return "shader_source";
+    case MemoryCategory::GEOMETRY: return "geometry";
+    case MemoryCategory::CAPTURE: return "capture";
+    case MemoryCategory::FRAME_ARENA: return "frame_arena";
+    case MemoryCategory::GPU_BUFFER: return "gpu_buffer";
+    case MemoryCategory::GPU_TEXTURE: return "gpu_texture";
+    case MemoryCategory::GPU_RENDERBUFFER: return "gpu_renderbuffer";
+    case MemoryCategory::GPU_PROGRAM: return "gpu_program";
+    default: return "unknown";
+    }
+}
+
+bool Renderer::isGpuMemory(MemoryCategory category)
+{
+    return category >= MemoryCategory::GPU_BUFFER;
+}
+
+void Renderer::trackAllocation(MemoryCategory category, std::uint64_t bytes)
+{
+    add(categoryCounters[static_cast<std::size_t>(category)], bytes);
+    add(isGpuMemory(category) ? gpuCounter : cpuCounter, bytes);
+}
+
+void Renderer::trackRelease(MemoryCategory category, std::uint64_t bytes)
+{
+    categoryCounters[static_cast<std::size_t>(category)].current -= bytes;
+    (isGpuMemory(category) ? gpuCounter : cpuCounter).current -= bytes;
+}
+
+Renderer::MemoryReport Renderer::getMemoryReport()
+{
+    MemoryReport report;
+    for (std::size_t category = 0; category < report.categories.size();
+        ++category)
+    {
+        report.categories[category] = read(categoryCounters[category]);
+    }
+    report.cpu = read(cpuCounter);
+    report.gpu = read(gpuCounter);
+    return report;
+}
+
+void Renderer::writeMemoryReport(std::ostream& stream,
+    const MemoryReport& report)
+{
+    stream << "{\n  \"cpu\": ";
+    writeUsage(stream, report.cpu);
+    stream << ",\n  \"gpu\": ";
+    writeUsage(stream, report.gpu);
+    stream << ",\n  \"categories\": {";
+    for (std::size_t category = 0; category < report.categories.size();
+        ++category)
+    {
+        stream << (category == 0 ? "\n" : ",\n") << "    \"" << toString(
+            static_cast<MemoryCategory>(category)) << "\": ";
+        writeUsage(stream, report.categories[category]);
+    }
+    stream << "\n  }\n}\n";
+}
+
+void Renderer::saveMemoryReport(const std::string& path)
+{
+    std::ofstream file(path);
+    writeMemoryReport(file, getMemoryReport());
+    if (!file)
+    {
+        throw std::runtime_error("ERROR::MEMORY::CANNOT WRITE " + path);
+    }
+}
+
+Renderer::MemoryTrackingDevice::MemoryTrackingDevice(
+    std::unique_ptr<Device> device) : device_{ std::move(device) },
+    boundArrayBuffer_{ 0 }, boundElementBuffer_{ 0 },
+    boundStorageBuffer_{ 0 }, boundIndirectBuffer_{ 0 }, activeUnit_{ 0 },
+    boundTextures_{}, boundRenderbuffer_{ 0 }
+{
+}
+
+GLuint* Renderer::MemoryTrackingDevice::boundBuffer(GLenum target)
+{
+    switch (target)
+    {
+    case GL_ARRAY_BUFFER: return &boundArrayBuffer_;
+    case GL_ELEMENT_ARRAY_BUFFER: return &boundElementBuffer_;
+    case GL_SHADER_STORAGE_BUFFER: return &boundStorageBuffer_;
+    case GL_DRAW_INDIRECT_BUFFER: return &boundIndirectBuffer_;
+    default: return nullptr;
+    }
+}
+
+void Renderer::MemoryTrackingDevice::resize(MemoryCategory category,
+    std::unordered_map<GLuint, std::uint64_t>& sizes, GLuint name,
+    std::uint64_t bytes)
+{
+    std::uint64_t& size = sizes[name];
+    trackRelease(category, size);
+    trackAllocation(category, bytes);
+    size = bytes;
+}
+
+void Renderer::MemoryTrackingDevice::resizeLevel(TextureRecord& record,
+    std::size_t level, std::uint64_t bytes)
+{
+    if (record.levels.size() <= level)
+    {
+        record.levels.resize(level + 1, 0);
+    }
+    trackRelease(MemoryCategory::GPU_TEXTURE, record.levels[level]);
+    trackAllocation(MemoryCategory::GPU_TEXTURE, bytes);
+    record.levels[level] = bytes;
+}
+
+GLuint Renderer::MemoryTrackingDevice::createVertexArray()
+{
+    return device_->createVertexArray();
+}
+
+void Renderer::MemoryTrackingDevice::bindVertexArray(GLuint vertexArray)
+{
+    device_->bindVertexArray(vertexArray);
+}
+
+void Renderer::MemoryTrackingDevice::deleteVertexArray(GLuint vertexArray)
+{
+    device_->deleteVertexArray(vertexArray);
+}
+
+GLuint Renderer::MemoryTrackingDevice::createBuffer()
+{
+    const GLuint buffer = device_->createBuffer();
+    buffers_[buffer] = 0;
+    return buffer;
+}
+
+void Renderer::MemoryTrackingDevice::bindBuffer(GLenum target, GLuint buffer)
+{
+    if (GLuint* bound = boundBuffer(target))
+    {
+        *bound = buffer;
+    }
+    device_->bindBuffer(target, buffer);
+}
+
+void Renderer::MemoryTrackingDevice::deleteBuffer(GLuint buffer)
+{
+    const auto record = buffers_.find(buffer);
+    if (record != buffers_.end())
+    {
+        trackRelease(MemoryCategory::GPU_BUFFER, record->second);
+        buffers_.erase(record);
+    }
+    for (GLuint* bound : { &boundArrayBuffer_, &boundElementBuffer_,
+        &boundStorageBuffer_, &boundIndirectBuffer_ })
+    {
+        if (*bound == buffer)
+        {
+            *bound = 0;
+        }
+    }
+    device_->deleteBuffer(buffer);
+}
+
+void Renderer::MemoryTrackingDevice::bufferData(GLenum target,
+    GLsizeiptr size, const void* data, GLenum usage)
+{
+    const GLuint* bound = boundBuffer(target);
+    if (bound != nullptr && *bound != 0)
+    {
+        resize(MemoryCategory::GPU_BUFFER, buffers_, *bound,
+            static_cast<std::uint64_t>(size));
+    }
+    device_->bufferData(target, size, data, usage);
+}
+
+void Renderer::MemoryTrackingDevice::vertexAttribPointer(GLuint index,
+    GLint size, GLenum type, GLsizei stride, std::size_t offset)
+{
+    device_->vertexAttribPointer(index, size, type, stride, offset);
+}
+
+void Renderer::MemoryTrackingDevice::enableVertexAttribArray(GLuint index)
+{
+    device_->enableVertexAttribArray(index);
+}
+
+void Renderer::MemoryTrackingDevice::vertexAttribDivisor(GLuint index,
+    GLuint divisor)
+{
+    device_->vertexAttribDivisor(index, divisor);
+}
+
+void Renderer::MemoryTrackingDevice::bindBufferBase(GLenum target,
+    GLuint index, GLuint buffer)
+{
+    // An indexed bind also binds the generic target
+    if (GLuint* bound = boundBuffer(target))
+    {
+        *bound = buffer;
+    }
+    device_->bindBufferBase(target, index, buffer);
+}
+
+GLuint Renderer::MemoryTrackingDevice::createTexture()
+{
+    const GLuint texture = device_->createTexture();
+    textures_[texture] = TextureRecord{ {}, 0, 0, 0 };
+    return texture;
+}
+
+void Renderer::MemoryTrackingDevice::activeTexture(GLenum unit)
+{
+    activeUnit_ = std::min<std::size_t>(unit - GL_TEXTURE0,
+        boundTextures_.size() - 1);
+    device_->activeTexture(unit);
+}
+
+void Renderer::MemoryTrackingDevice::bindTexture(GLenum target,
+    GLuint texture)
+{
+    boundTextures_[activeUnit_] = texture;
+    device_->bindTexture(target, texture);
+}
+
+void Renderer::MemoryTrackingDevice::deleteTexture(GLuint texture)
+{
+    const auto record = textures_.find(texture);
+    if (record != textures_.end())
+    {
+        for (const std::uint64_t bytes : record->second.levels)
+        {
+            trackRelease(MemoryCategory::GPU_TEXTURE, bytes);
+        }
+        textures_.erase(record);
+    }
+    std::replace(boundTextures_.begin(), boundTextures_.end(), texture, 0u);
+    device_->deleteTexture(texture);
+}
+
+void Renderer::MemoryTrackingDevice::texParameter(GLenum target, GLenum name,
+    GLint value)
+{
+    device_->texParameter(target, name, value);
+}
+
+void Renderer::MemoryTrackingDevice::texImage2D(GLenum target, GLint level,
+    GLint internalFormat, GLsizei width, GLsizei height, GLenum format,
+    GLenum type, const void* pixels)
+{
+    const auto record = textures_.find(boundTextures_[activeUnit_]);
+    if (record != textures_.end() && level >= 0)
+    {
+        const std::size_t size = texelSize(internalFormat);
+        if (level == 0)
+        {
+            record->second.width = width;
+            record->second.height = height;
+            record->second.texelSize = size;
+        }
+        resizeLevel(record->second, static_cast<std::size_t>(level),
+            static_cast<std::uint64_t>(width) * height * size);
+    }
+    device_->texImage2D(target, level, internalFormat, width, height, format,
+        type, pixels);
+}
+
+void Renderer::MemoryTrackingDevice::generateMipmap(GLenum target)
+{
+    const auto record = textures_.find(boundTextures_[activeUnit_]);
+    if (record != textures_.end())
+    {
+        // Every level down to 1x1 is allocated from level 0
+        TextureRecord& texture = record->second;
+        GLsizei width = texture.width;
+        GLsizei height = texture.height;
+        for (std::size_t level = 1; width > 1 || height > 1; ++level)
+        {
+            width = std::max<GLsizei>(1, width / 2);
+            height = std::max<GLsizei>(1, height / 2);
+            resizeLevel(texture, level, static_cast<std::uint64_t>(width) *
+                height * texture.texelSize);
+        }
+    }
+    device_->generateMipmap(target);
+}
+
+void Renderer::MemoryTrackingDevice::bindImageTexture(GLuint unit,
+    GLuint texture, GLint level, GLenum access, GLenum format)
+{
+    device_->bindImageTexture(unit, texture, level, access, format);
+}
+
+GLuint Renderer::MemoryTrackingDevice::createShader(GLenum type)
+{
+    const GLuint shader = device_->createShader(type);
+    shaders_[shader] = 0;
+    return shader;
+}
+
+void Renderer::MemoryTrackingDevice::shaderSource(GLuint shader,
+    const std::string& source)
+{
+    shaders_[shader] = source.size();
+    device_->shaderSource(shader, source);
+}
+
+void Renderer::MemoryTrackingDevice::compileShader(GLuint shader)
+{
+    device_->compileShader(shader);
+}
+
+bool Renderer::MemoryTrackingDevice::getCompileStatus(GLuint shader,
+    std::string& infoLog)
+{
+    return device_->getCompileStatus(shader, infoLog);
+}
+
+void Renderer::MemoryTrackingDevice::deleteShader(GLuint shader)
+{
+    shaders_.erase(shader);
+    device_->deleteShader(shader);
+}
+
+GLuint Renderer::MemoryTrackingDevice::createProgram()
+{
+    const GLuint program = device_->createProgram();
+    programs_[program] = 0;
+    return program;
+}
+
+void Renderer::MemoryTrackingDevice::attachShader(GLuint program,
+    GLuint shader)
+{
+    const auto source = shaders_.find(shader);
+    const auto record = programs_.find(program);
+    if (source != shaders_.end() && record != programs_.end())
+    {
+        resize(MemoryCategory::GPU_PROGRAM, programs_, program,
+            record->second + source->second);
+    }
+    device_->attachShader(program, shader);
+}
+
+void Renderer::MemoryTrackingDevice::linkProgram(GLuint program)
+{
+    device_->linkProgram(program);
+}
+
+bool Renderer::MemoryTrackingDevice::getLinkStatus(GLuint program,
+    std::string& infoLog)
+{
+    return device_->getLinkStatus(program, infoLog);
+}
+
+void Renderer::MemoryTrackingDevice::useProgram(GLuint program)
+{
+    device_->useProgram(program);
+}
+
+void Renderer::MemoryTrackingDevice::deleteProgram(GLuint program)
+{
+    const auto record = programs_.find(program);
+    if (record != programs_.end())
+    {
+        trackRelease(MemoryCategory::GPU_PROGRAM, record->second);
+        programs_.erase(record);
+    }
+    device_->deleteProgram(program);
+}
+
+GLint Renderer::MemoryTrackingDevice::getUniformLocation(GLuint program,
+    const char* name)
+{
+    return device_->getUniformLocation(program, name);
+}
+
+void Renderer::MemoryTrackingDevice::uniform1i(GLint location, GLint value)
+{
+    device_->uniform1i(location, value);
+}
+
+void Renderer::MemoryTrackingDevice::uniform1f(GLint location, GLfloat value)
+{
+    device_->uniform1f(location, value);
+}
+
+void Renderer::MemoryTrackingDevice::uniformMatrix4fv(GLint location,
+    const GLfloat* value)
+{
+    device_->uniformMatrix4fv(location, value);
+}
+
+void Renderer::MemoryTrackingDevice::viewport(GLint x, GLint y,
+    GLsizei width, GLsizei height)
+{
+    device_->viewport(x, y, width, height);
+}
+
+void Renderer::MemoryTrackingDevice::enable(GLenum capability)
+{
+    device_->enable(capability);
+}
+
+void Renderer::MemoryTrackingDevice::disable(GLenum capability)
+{
+    device_->disable(capability);
+}
+
+void Renderer::MemoryTrackingDevice::blendFunc(GLenum sourceFactor,
+    GLenum destFactor)
+{
+    device_->blendFunc(sourceFactor, destFactor);
+}
+
+void Renderer::MemoryTrackingDevice::clearColor(GLfloat red, GLfloat green,
+    GLfloat blue, GLfloat alpha)
+{
+    device_->clearColor(red, green, blue, alpha);
+}
+
+void Renderer::MemoryTrackingDevice::clear(GLbitfield mask)
+{
+    device_->clear(mask);
+}
+
+void Renderer::MemoryTrackingDevice::drawArrays(GLenum mode, GLint first,
+    GLsizei count)
+{
+    device_->drawArrays(mode, first, count);
+}
+
+void Renderer::MemoryTrackingDevice::drawElements(GLenum mode, GLsizei count,
+    GLenum type, std::size_t offset)
+{
+    device_->drawElements(mode, count, type, offset);
+}
+
+void Renderer::MemoryTrackingDevice::multiDrawArraysIndirect(GLenum mode,
+    std::size_t offset, GLsizei drawCount, GLsizei stride)
+{
+    device_->multiDrawArraysIndirect(mode, offset, drawCount, stride);
+}
+
+void Renderer::MemoryTrackingDevice::dispatchCompute(GLuint groupsX,
+    GLuint groupsY, GLuint groupsZ)
+{
+    device_->dispatchCompute(groupsX, groupsY, groupsZ);
+}
+
+void Renderer::MemoryTrackingDevice::memoryBarrier(GLbitfield barriers)
+{
+    device_->memoryBarrier(barriers);
+}
+
+GLuint Renderer::MemoryTrackingDevice::createFramebuffer()
+{
+    return device_->createFramebuffer();
+}
+
+void Renderer::MemoryTrackingDevice::bindFramebuffer(GLenum target,
+    GLuint framebuffer)
+{
+    device_->bindFramebuffer(target, framebuffer);
+}
+
+void Renderer::MemoryTrackingDevice::deleteFramebuffer(GLuint framebuffer)
+{
+    device_->deleteFramebuffer(framebuffer);
+}
+
+GLuint Renderer::MemoryTrackingDevice::createRenderbuffer()
+{
+    const GLuint renderbuffer = device_->createRenderbuffer();
+    renderbuffers_[renderbuffer] = 0;
+    return renderbuffer;
+}
+
+void Renderer::MemoryTrackingDevice::bindRenderbuffer(GLuint renderbuffer)
+{
+    boundRenderbuffer_ = renderbuffer;
+    device_->bindRenderbuffer(renderbuffer);
+}
+
+void Renderer::MemoryTrackingDevice::deleteRenderbuffer(GLuint renderbuffer)
+{
+    const auto record = renderbuffers_.find(renderbuffer);
+    if (record != renderbuffers_.end())
+    {
+        trackRelease(MemoryCategory::GPU_RENDERBUFFER, record->second);
+        renderbuffers_.erase(record);
+    }
+    if (boundRenderbuffer_ == renderbuffer)
+    {
+        boundRenderbuffer_ = 0;
+    }
+    device_->deleteRenderbuffer(renderbuffer);
+}
+
+void Renderer::MemoryTrackingDevice::renderbufferStorage(GLsizei samples,
+    GLenum internalFormat, GLsizei width, GLsizei height)
+{
+    if (boundRenderbuffer_ != 0)
+    {
+        resize(MemoryCategory::GPU_RENDERBUFFER, renderbuffers_,
+            boundRenderbuffer_, static_cast<std::uint64_t>(width) * height *
+            texelSize(static_cast<GLint>(internalFormat)) *
+            static_cast<std::uint64_t>(std::max<GLsizei>(1, samples)));
+    }
+    device_->renderbufferStorage(samples, internalFormat, width, height);
+}
+
+void Renderer::MemoryTrackingDevice::framebufferRenderbuffer(GLenum target,
+    GLenum attachment, GLuint renderbuffer)
+{
+    device_->framebufferRenderbuffer(target, attachment, renderbuffer);
+}
+
+void Renderer::MemoryTrackingDevice::framebufferTexture2D(GLenum target,
+    GLenum attachment, GLuint texture, GLint level)
+{
+    device_->framebufferTexture2D(target, attachment, texture, level);
+}
+
+GLenum Renderer::MemoryTrackingDevice::checkFramebufferStatus(GLenum target)
+{
+    return device_->checkFramebufferStatus(target);
+}
+
+void Renderer::MemoryTrackingDevice::blitFramebuffer(GLint srcX0,
+    GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0,
+    GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter)
+{
+    device_->blitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1,
+        dstY1, mask, filter);
+}
+
+GLuint Renderer::MemoryTrackingDevice::createQuery()
+{
+    return device_->createQuery();
+}
+
+void Renderer::MemoryTrackingDevice::deleteQuery(GLuint query)
+{
+    device_->deleteQuery(query);
+}
+
+void Renderer::MemoryTrackingDevice::beginQuery(GLenum target, GLuint query)
+{
+    device_->beginQuery(target, query);
+}
+
+void Renderer::MemoryTrackingDevice::endQuery(GLenum target)
+{
+    device_->endQuery(target);
+}
+
+bool Renderer::MemoryTrackingDevice::getQueryResult(GLuint query,
+    GLuint64& result)
+{
+    return device_->getQueryResult(query, result);
+}
+
+GLuint Renderer::MemoryTrackingDevice::createFence()
+{
+    return device_->createFence();
+}
+
+bool Renderer::MemoryTrackingDevice::isFenceSignaled(GLuint fence)
+{
+    return device_->isFenceSignaled(fence);
+}
+
+void Renderer::MemoryTrackingDevice::deleteFence(GLuint fence)
+{
+    device_->deleteFence(fence);
+}
@@ -0,0 +1,358 @@
+#include "mesh.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+namespace
+{
+    // Identifies a mesh cache
+    constexpr char CACHE_MAGIC[8] =
+        { 'C', 'U', 'B', 'E', 'M', 'E', 'S', 'H' };
+    // Written in the byte order of the machine, a cache written on a
+    // machine of the other order reads as stale
+    constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    /**
+     * @struct CacheHeader
+     * @brief The start of a mesh cache. The submesh ranges, the vertices
+     *        and the indices follow at the offsets it records.
+     */
+    struct CacheHeader
+    {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byteOrder;
+        std::uint64_t sourceHash;
+        std::uint64_t vertexSize;
+        std::uint64_t vertexCount;
+        std::uint64_t indexCount;
+        std::uint64_t submeshCount;
+        std::uint64_t submeshOffset;
+        std::uint64_t vertexOffset;
+        std::uint64_t indexOffset;
+        float boundsMin[3];
+        float boundsMax[3];
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    double millisecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(
+            Clock::now() - start).count();
+    }
+
+    // Rounds an offset up to the alignment of the cache streams
+    std::uint64_t alignOffset(std::uint64_t offset)
+    {
+        const std::uint64_t alignment =
+            Renderer::MeshConstants::CACHE_ALIGNMENT;
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    // Gets whether a stream lies within the file and starts aligned
+    bool isStreamValid(std::uint64_t offset, std::uint64_t count,
+        std::uint64_t elementSize, std::uint64_t fileSize)
+    {
+        return offset % Renderer::MeshConstants::CACHE_ALIGNMENT == 0 &&
+            offset <= fileSize && count <= (fileSize - offset) / elementSize;
+    }
+
+    // Gets the lowercase extension of a path, including the dot
+    std::string getExtension(const std::string& path)
+    {
+        std::string extension = std::filesystem::path(path).extension()
+            .string();
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+            [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return extension;
+    }
+
+    // Imports a mesh by the extension of its file
+    Renderer::MeshData importMesh(const std::string& path,
+        const std::uint8_t* data, std::size_t size)
+    {
+        const std::string extension = getExtension(path);
+        if (extension == ".obj")
+        {
+            return Renderer::importObj(reinterpret_cast<const char*>(data),
+                size);
+        }
+        if (extension == ".gltf" || extension == ".glb")
+        {
+            return Renderer::importGltf(path, data, size);
+        }
+        throw std::runtime_error("ERROR::MESH::UNSUPPORTED FORMAT " + path);
+    }
+
+    // Gets the bytes of the imported streams, accounted as geometry
+    std::uint64_t getImportedBytes(const Renderer::MeshData& mesh)
+    {
+        return sizeof(float) * mesh.vertices.size() +
+            sizeof(std::uint32_t) * mesh.indices.size();
+    }
+}
+
+void Renderer::writeMeshCache(const std::string& path, const MeshData& mesh,
+    std::uint64_t sourceHash)
+{
+    CacheHeader header{};
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+    header.version = MeshConstants::CACHE_VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.sourceHash = sourceHash;
+    header.vertexSize = MeshConstants::VERTEX_SIZE;
+    header.vertexCount = mesh.vertices.size() / VerticeDataVector::STRIDE;
+    header.indexCount = mesh.indices.size();
+    header.submeshCount = mesh.submeshes.size();
+    header.submeshOffset = alignOffset(sizeof(CacheHeader));
+    header.vertexOffset = alignOffset(header.submeshOffset +
+        header.submeshCount * sizeof(Submesh));
+    header.indexOffset = alignOffset(header.vertexOffset +
+        header.vertexCount * MeshConstants::VERTEX_SIZE);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        header.boundsMin[axis] = mesh.bounds.min[axis];
+        header.boundsMax[axis] = mesh.bounds.max[axis];
+    }
+
+    // Readers never see a partly written cache, it replaces the old one
+    // once complete
+    const std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        const auto writeAt = [&file](std::uint64_t offset, const void* data,
+            std::uint64_t size) {
+            static const char padding[MeshConstants::CACHE_ALIGNMENT] = {};
+            if (!file)
+            {
+                return;
+            }
+            const std::uint64_t position =
+                static_cast<std::uint64_t>(file.tellp());
+            file.write(padding, static_cast<std::streamsize>(
+                offset - position));
+            file.write(static_cast<const char*>(data),
+                static_cast<std::streamsize>(size));
+        };
+        writeAt(0, &header, sizeof(header));
+        writeAt(header.submeshOffset, mesh.submeshes.data(),
+            header.submeshCount * sizeof(Submesh));
+        writeAt(header.vertexOffset, mesh.vertices.data(),
+            header.vertexCount * MeshConstants::VERTEX_SIZE);
+        writeAt(header.indexOffset, mesh.indices.data(),
+            header.indexCount * sizeof(std::uint32_t));
+        file.close();
+        if (!file)
+        {
+            std::filesystem::remove(temporaryPath);
+            throw std::runtime_error("ERROR::MESH::CANNOT WRITE CACHE " +
+                path);
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error)
+    {
+        std::filesystem::remove(temporaryPath, error);
+        throw std::runtime_error("ERROR::MESH::CANNOT WRITE CACHE " + path);
+    }
+}
+
+Renderer::MeshCache::MeshCache(const std::string& sourcePath) :
+    mapping_(), imported_(), vertices_{ nullptr }, vertexCount_{ 0 },
+    indices_{ nullptr }, indexCount_{ 0 }, submeshes_(), bounds_(), stats_()
+{
+    // The hash covers every file the mesh is imported from, and the
+    // version, so a cache of an older import is converted again
+    Clock::time_point start = Clock::now();
+    const MappedFile source(sourcePath);
+    std::uint64_t sourceHash = hashBytes(source.getData(), source.getSize(),
+        MeshConstants::CACHE_VERSION);
+    stats_.sourceBytes = source.getSize();
+    for (const std::string& dependency : getMeshDependencies(sourcePath,
+        source.getData(), source.getSize()))
+    {
+        const MappedFile file(dependency);
+        sourceHash = hashBytes(file.getData(), file.getSize(), sourceHash);
+        stats_.sourceBytes += file.getSize();
+    }
+    stats_.hashMs = millisecondsSince(start);
+
+    const std::string cachePath = sourcePath + MeshConstants::CACHE_EXTENSION;
+    if (map(cachePath, sourceHash))
+    {
+        stats_.cacheHit = true;
+        return;
+    }
+
+    start = Clock::now();
+    MeshData mesh = importMesh(sourcePath, source.getData(),
+        source.getSize());
+    stats_.importMs = millisecondsSince(start);
+
+    // A source in a read-only location is uploaded from memory, and
+    // imported again next time
+    start = Clock::now();
+    try
+    {
+        writeMeshCache(cachePath, mesh, sourceHash);
+        stats_.cacheWritten = map(cachePath, sourceHash);
+    }
+    catch (const std::runtime_error&)
+    {
+        stats_.cacheWritten = false;
+    }
+    stats_.writeMs = millisecondsSince(start);
+    if (!stats_.cacheWritten)
+    {
+        adopt(std::move(mesh));
+    }
+}
+
+Renderer::MeshCache::~MeshCache()
+{
+    trackRelease(MemoryCategory::GEOMETRY, getImportedBytes(imported_));
+}
+
+bool Renderer::MeshCache::map(const std::string& path,
+    std::uint64_t sourceHash)
+{
+    MappedFile file;
+    try
+    {
+        file = MappedFile(path);
+    }
+    catch (const std::runtime_error&)
+    {
+        return false;
+    }
+
+    CacheHeader header;
+    if (file.getSize() < sizeof(header))
+    {
+        return false;
+    }
+    std::memcpy(&header, file.getData(), sizeof(header));
+    const std::uint64_t size = file.getSize();
+    if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != MeshConstants::CACHE_VERSION ||
+        header.byteOrder != BYTE_ORDER_MARK ||
+        header.sourceHash != sourceHash ||
+        header.vertexSize != MeshConstants::VERTEX_SIZE ||
+        !isStreamValid(header.submeshOffset, header.submeshCount,
+            sizeof(Submesh), size) ||
+        !isStreamValid(header.vertexOffset, header.vertexCount,
+            MeshConstants::VERTEX_SIZE, size) ||
+        !isStreamValid(header.indexOffset, header.indexCount,
+            sizeof(std::uint32_t), size))
+    {
+        return false;
+    }
+
+    // The submesh table is small, the streams stay in the mapping
+    std::vector<Submesh> submeshes(static_cast<std::size_t>(
+        header.submeshCount));
+    std::memcpy(submeshes.data(), file.getData() + header.submeshOffset,
+        submeshes.size() * sizeof(Submesh));
+    for (const Submesh& submesh : submeshes)
+    {
+        if (static_cast<std::uint64_t>(submesh.firstIndex) +
+            submesh.indexCount > header.indexCount)
+        {
+            return false;
+        }
+    }
+
+    vertices_ = file.getData() + header.vertexOffset;
+    vertexCount_ = header.vertexCount;
+    indices_ = file.getData() + header.indexOffset;
+    indexCount_ = header.indexCount;
+    submeshes_ = std::move(submeshes);
+    bounds_.min = glm::vec3(header.boundsMin[0], header.boundsMin[1],
+        header.boundsMin[2]);
+    bounds_.max = glm::vec3(header.boundsMax[0], header.boundsMax[1],
+        header.boundsMax[2]);
+    mapping_ = std::move(file);
+    return true;
+}
+
+void Renderer::MeshCache::adopt(MeshData&& mesh)
+{
+    imported_ = std::move(mesh);
+    trackAllocation(MemoryCategory::GEOMETRY, getImportedBytes(imported_));
+    vertices_ = imported_.vertices.data();
+    vertexCount_ = imported_.vertices.size() / VerticeDataVector::STRIDE;
+    indices_ = imported_.indices.data();
+    indexCount_ = imported_.indices.size();
+    submeshes_ = imported_.submeshes;
+    bounds_ = imported_.bounds;
+}
+
+Renderer::Mesh::Mesh(GpuResources& resources, const MeshCache& cache) :
+    resources_{ resources }, device_{ resources.getDevice() }, vao_{ 0 },
+    vbo_(), ebo_(),
+    vertexCount_{ cache.getVertexCount() },
+    indexCount_{ cache.getIndexCount() },
+    submeshes_(cache.getSubmeshes()), bounds_(cache.getBounds()),
+    loadStats_(cache.getStats()), uploadMs_{ 0.0 }
+{
+    const Clock::time_point start = Clock::now();
+    vao_ = device_.createVertexArray();
+    device_.bindVertexArray(vao_);
+
+    // The driver copies straight out of the mapping, paging the cache in
+    // as it goes
+    vbo_ = resources_.createBuffer();
+    device_.bindBuffer(GL_ARRAY_BUFFER, resources_.get(vbo_));
+    device_.bufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(
+        vertexCount_ * MeshConstants::VERTEX_SIZE), cache.getVertexData(),
+        GlConstants::DRAW_TYPE);
+    ebo_ = resources_.createBuffer();
+    device_.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, resources_.get(ebo_));
+    device_.bufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(
+        indexCount_ * sizeof(std::uint32_t)), cache.getIndexData(),
+        GlConstants::DRAW_TYPE);
+
+    // The attributes of the cube, see BufferSetup::enableVertexAttribute()
+    device_.vertexAttribPointer(static_cast<GLuint>(VSLocation::POSITION),
+        VerticeDataVector::POSITION_SIZE, GL_FLOAT,
+        MeshConstants::VERTEX_SIZE,
+        VerticeDataVector::POSITION_LOCATION * sizeof(float));
+    device_.enableVertexAttribArray(static_cast<GLuint>(VSLocation::POSITION));
+    device_.vertexAttribPointer(static_cast<GLuint>(VSLocation::TEXTURE),
+        VerticeDataVector::TEXTURE_SIZE, GL_FLOAT, MeshConstants::VERTEX_SIZE,
+        VerticeDataVector::TEXTURE_LOCATION * sizeof(float));
+    device_.enableVertexAttribArray(static_cast<GLuint>(VSLocation::TEXTURE));
+    device_.bindVertexArray(0);
+    uploadMs_ = millisecondsSince(start);
+}
+
+Renderer::Mesh::~Mesh()
+{
+    device_.deleteVertexArray(vao_);
+    resources_.release(vbo_);
+    resources_.release(ebo_);
+}
+
+void Renderer::Mesh::draw() const
+{
+    if (indexCount_ == 0)
+    {
+        return;
+    }
+    device_.bindVertexArray(vao_);
+    device_.drawElements(GL_TRIANGLES, static_cast<GLsizei>(indexCount_),
+        GL_UNSIGNED_INT, 0);
+}
+
+glm::mat4 Renderer::Mesh::getFitTransform() const
+{
+    const glm::vec3 extent = bounds_.max - bounds_.min;
+    const float longest = std::max({ extent.x, extent.y, extent.z });
+    const float scale = longest > 0.0f ? 1.0f / longest : 1.0f;
+    return glm::translate(glm::scale(glm::mat4(1.0f), glm::vec3(scale)),
+        -0.5f * (bounds_.min + bounds_.max));
+}
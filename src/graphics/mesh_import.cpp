@@ -0,0 +1,1168 @@
+#include "mesh.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+#include <glm/gtc/quaternion.hpp>
+
+namespace
+{
+    // The deepest nesting of JSON values and glTF nodes accepted
+    constexpr unsigned int MAX_DEPTH = 128;
+    // The header and chunk types of a binary glTF
+    constexpr std::uint32_t GLB_MAGIC = 0x46546C67;
+    constexpr std::uint32_t GLB_JSON_CHUNK = 0x4E4F534A;
+    constexpr std::uint32_t GLB_BIN_CHUNK = 0x004E4942;
+    constexpr std::size_t GLB_HEADER_SIZE = 12;
+    constexpr std::size_t GLB_CHUNK_HEADER_SIZE = 8;
+    // The glTF constants of the accessors and primitives that are read
+    constexpr int GLTF_BYTE = 5120;
+    constexpr int GLTF_UNSIGNED_BYTE = 5121;
+    constexpr int GLTF_SHORT = 5122;
+    constexpr int GLTF_UNSIGNED_SHORT = 5123;
+    constexpr int GLTF_UNSIGNED_INT = 5125;
+    constexpr int GLTF_FLOAT = 5126;
+    constexpr int GLTF_TRIANGLES = 4;
+    // The digits of base64, in the order of their values
+    constexpr const char* BASE64_DIGITS =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    // Grows the bounds of a mesh to contain a position
+    void includeInBounds(Renderer::MeshData& mesh, const glm::vec3& position)
+    {
+        if (mesh.vertices.size() == VerticeDataVector::STRIDE)
+        {
+            mesh.bounds.min = position;
+            mesh.bounds.max = position;
+            return;
+        }
+        mesh.bounds.min = glm::min(mesh.bounds.min, position);
+        mesh.bounds.max = glm::max(mesh.bounds.max, position);
+    }
+
+    // Appends an interleaved vertex, see VerticeDataVector
+    void appendVertex(Renderer::MeshData& mesh, const glm::vec3& position,
+        const glm::vec2& texCoord)
+    {
+        mesh.vertices.insert(mesh.vertices.end(),
+            { position.x, position.y, position.z, texCoord.x, texCoord.y });
+        includeInBounds(mesh, position);
+    }
+
+    // Sets the index count of the open submesh, dropping it if empty
+    void endSubmesh(Renderer::MeshData& mesh)
+    {
+        if (mesh.submeshes.empty())
+        {
+            return;
+        }
+        Renderer::Submesh& submesh = mesh.submeshes.back();
+        submesh.indexCount = static_cast<std::uint32_t>(mesh.indices.size() -
+            submesh.firstIndex);
+        if (submesh.indexCount == 0)
+        {
+            mesh.submeshes.pop_back();
+        }
+    }
+
+    // Opens a submesh at the next index
+    void beginSubmesh(Renderer::MeshData& mesh)
+    {
+        endSubmesh(mesh);
+        Renderer::Submesh submesh;
+        submesh.firstIndex = static_cast<std::uint32_t>(mesh.indices.size());
+        mesh.submeshes.push_back(submesh);
+    }
+
+    // Rejects meshes whose counts do not fit the 32 bit indices
+    void checkIndexRange(std::size_t vertexCount, std::size_t indexCount)
+    {
+        constexpr std::size_t limit = std::numeric_limits<std::uint32_t>::max();
+        if (vertexCount > limit || indexCount > limit)
+        {
+            throw std::runtime_error(
+                "ERROR::MESH::MORE THAN 2^32 VERTICES OR INDICES");
+        }
+    }
+
+    const char* skipSpaces(const char* cursor, const char* end)
+    {
+        while (cursor < end && (*cursor == ' ' || *cursor == '\t'))
+        {
+            ++cursor;
+        }
+        return cursor;
+    }
+
+    // Parses a number after optional spaces, advancing the cursor
+    template <typename T>
+    bool parseNumber(const char*& cursor, const char* end, T& value)
+    {
+        cursor = skipSpaces(cursor, end);
+        if (cursor < end && *cursor == '+')
+        {
+            ++cursor;
+        }
+        const std::from_chars_result result = std::from_chars(cursor, end,
+            value);
+        if (result.ec != std::errc())
+        {
+            return false;
+        }
+        cursor = result.ptr;
+        return true;
+    }
+
+    // Turns a 1-based or negative (relative) OBJ index into a 0-based one
+    std::size_t resolveObjIndex(long index, std::size_t count,
+        std::size_t line)
+    {
+        const long long resolved = index > 0 ? index - 1 :
+            static_cast<long long>(count) + index;
+        if (index == 0 || resolved < 0 ||
+            static_cast<std::size_t>(resolved) >= count)
+        {
+            throw std::runtime_error("ERROR::OBJ::LINE " +
+                std::to_string(line) + " REFERS TO A MISSING VERTEX");
+        }
+        return static_cast<std::size_t>(resolved);
+    }
+
+    /**
+     * @struct JsonValue
+     * @brief A parsed JSON value, as much of JSON as glTF needs.
+     */
+    struct JsonValue
+    {
+        enum class Type : std::uint8_t
+        {
+            NUL = 0, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT,
+        };
+
+        Type type = Type::NUL;
+        bool boolean = false;
+        double number = 0.0;
+        std::string string;
+        // The elements of an array, or the values of an object
+        std::vector<JsonValue> items;
+        // The keys of an object, one per value
+        std::vector<std::string> keys;
+
+        /** @brief Gets the member of an object, null if it has none. */
+        const JsonValue* find(const char* key) const
+        {
+            for (std::size_t member = 0; member < keys.size(); ++member)
+            {
+                if (keys[member] == key)
+                {
+                    return &items[member];
+                }
+            }
+            return nullptr;
+        }
+
+        /** @brief Gets a numeric member, or a default if it is missing. */
+        double getNumber(const char* key, double fallback) const
+        {
+            const JsonValue* value = find(key);
+            return value != nullptr && value->type == Type::NUMBER ?
+                value->number : fallback;
+        }
+
+        /** @brief Gets an index member, -1 if it is missing. */
+        long getIndex(const char* key) const
+        {
+            return static_cast<long>(getNumber(key, -1.0));
+        }
+    };
+
+    /**
+     * @class JsonParser
+     * @brief Parses a JSON document by recursive descent.
+     */
+    class JsonParser
+    {
+    public:
+        JsonParser(const char* text, std::size_t size) : begin_{ text },
+            cursor_{ text }, end_{ text + size }
+        {
+        }
+
+        /** @brief Parses the document, which must hold one value. */
+        JsonValue parse()
+        {
+            JsonValue value = parseValue(0);
+            skipWhitespace();
+            if (cursor_ != end_)
+            {
+                fail();
+            }
+            return value;
+        }
+
+    private:
+        [[noreturn]] void fail() const
+        {
+            throw std::runtime_error("ERROR::GLTF::MALFORMED JSON AT BYTE " +
+                std::to_string(cursor_ - begin_));
+        }
+
+        void skipWhitespace()
+        {
+            while (cursor_ < end_ && (*cursor_ == ' ' || *cursor_ == '\t' ||
+                *cursor_ == '\n' || *cursor_ == '\r'))
+            {
+                ++cursor_;
+            }
+        }
+
+        void expect(char character)
+        {
+            skipWhitespace();
+            if (cursor_ == end_ || *cursor_ != character)
+            {
+                fail();
+            }
+            ++cursor_;
+        }
+
+        // Takes the character after an element: a comma or the closing
+        // bracket, which is returned
+        char next()
+        {
+            skipWhitespace();
+            if (cursor_ == end_ || (*cursor_ != ',' && *cursor_ != '}' &&
+                *cursor_ != ']'))
+            {
+                fail();
+            }
+            return *cursor_++;
+        }
+
+        bool consumeWord(const char* word)
+        {
+            const std::size_t length = std::strlen(word);
+            if (static_cast<std::size_t>(end_ - cursor_) < length ||
+                std::memcmp(cursor_, word, length) != 0)
+            {
+                return false;
+            }
+            cursor_ += length;
+            return true;
+        }
+
+        JsonValue parseValue(unsigned int depth)
+        {
+            if (depth > MAX_DEPTH)
+            {
+                fail();
+            }
+            skipWhitespace();
+            if (cursor_ == end_)
+            {
+                fail();
+            }
+
+            JsonValue value;
+            switch (*cursor_)
+            {
+            case '{':
+                value.type = JsonValue::Type::OBJECT;
+                ++cursor_;
+                skipWhitespace();
+                if (cursor_ < end_ && *cursor_ == '}')
+                {
+                    ++cursor_;
+                    return value;
+                }
+                while (true)
+                {
+                    skipWhitespace();
+                    value.keys.push_back(parseString());
+                    expect(':');
+                    value.items.push_back(parseValue(depth + 1));
+                    if (next() == '}')
+                    {
+                        return value;
+                    }
+                }
+            case '[':
+                value.type = JsonValue::Type::ARRAY;
+                ++cursor_;
+                skipWhitespace();
+                if (cursor_ < end_ && *cursor_ == ']')
+                {
+                    ++cursor_;
+                    return value;
+                }
+                while (true)
+                {
+                    value.items.push_back(parseValue(depth + 1));
+                    if (next() == ']')
+                    {
+                        return value;
+                    }
+                }
+            case '"':
+                value.type = JsonValue::Type::STRING;
+                value.string = parseString();
+                return value;
+            default:
+                break;
+            }
+
+            if (consumeWord("true") || consumeWord("false"))
+            {
+                value.type = JsonValue::Type::BOOLEAN;
+                value.boolean = cursor_[-1] == 'e' && cursor_[-2] == 'u';
+                return value;
+            }
+            if (consumeWord("null"))
+            {
+                return value;
+            }
+            const std::from_chars_result result = std::from_chars(cursor_,
+                end_, value.number);
+            if (result.ec != std::errc())
+            {
+                fail();
+            }
+            value.type = JsonValue::Type::NUMBER;
+            cursor_ = result.ptr;
+            return value;
+        }
+
+        // Appends a code point as UTF-8
+        static void appendUtf8(std::string& text, std::uint32_t codePoint)
+        {
+            if (codePoint < 0x80)
+            {
+                text += static_cast<char>(codePoint);
+            }
+            else if (codePoint < 0x800)
+            {
+                text += static_cast<char>(0xC0 | (codePoint >> 6));
+                text += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+            else if (codePoint < 0x10000)
+            {
+                text += static_cast<char>(0xE0 | (codePoint >> 12));
+                text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                text += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+            else
+            {
+                text += static_cast<char>(0xF0 | (codePoint >> 18));
+                text += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+                text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                text += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+        }
+
+        std::uint32_t parseHex4()
+        {
+            std::uint32_t value = 0;
+            if (end_ - cursor_ < 4 || std::from_chars(cursor_, cursor_ + 4,
+                value, 16).ptr != cursor_ + 4)
+            {
+                fail();
+            }
+            cursor_ += 4;
+            return value;
+        }
+
+        std::string parseString()
+        {
+            if (cursor_ == end_ || *cursor_ != '"')
+            {
+                fail();
+            }
+            ++cursor_;
+            std::string text;
+            while (cursor_ < end_ && *cursor_ != '"')
+            {
+                if (*cursor_ != '\\')
+                {
+                    text += *cursor_++;
+                    continue;
+                }
+                if (++cursor_ == end_)
+                {
+                    fail();
+                }
+                const char escaped = *cursor_++;
+                switch (escaped)
+                {
+                case 'b': text += '\b'; break;
+                case 'f': text += '\f'; break;
+                case 'n': text += '\n'; break;
+                case 'r': text += '\r'; break;
+                case 't': text += '\t'; break;
+                case 'u':
+                {
+                    std::uint32_t codePoint = parseHex4();
+                    // A high surrogate is followed by the low one
+                    if (codePoint >= 0xD800 && codePoint < 0xDC00 &&
+                        consumeWord("\\u"))
+                    {
+                        const std::uint32_t low = parseHex4();
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) +
+                            (low - 0xDC00);
+                    }
+                    appendUtf8(text, codePoint);
+                    break;
+                }
+                default: text += escaped; break;
+                }
+            }
+            if (cursor_ == end_)
+            {
+                fail();
+            }
+            ++cursor_;
+            return text;
+        }
+
+        const char* begin_;
+        const char* cursor_;
+        const char* end_;
+    };
+
+    /**
+     * @struct GltfAsset
+     * @brief The JSON document of a glTF and the bytes of its buffers.
+     */
+    struct GltfAsset
+    {
+        JsonValue document;
+        // The binary chunk of a GLB, in the mapping of the file
+        const std::uint8_t* binaryChunk = nullptr;
+        std::size_t binaryChunkSize = 0;
+    };
+
+    std::uint32_t readU32(const std::uint8_t* bytes)
+    {
+        return static_cast<std::uint32_t>(bytes[0]) |
+            static_cast<std::uint32_t>(bytes[1]) << 8 |
+            static_cast<std::uint32_t>(bytes[2]) << 16 |
+            static_cast<std::uint32_t>(bytes[3]) << 24;
+    }
+
+    // Parses the JSON of a .gltf file or the chunks of a .glb file
+    GltfAsset parseGltf(const std::uint8_t* data, std::size_t size)
+    {
+        GltfAsset asset;
+        if (size < GLB_HEADER_SIZE || readU32(data) != GLB_MAGIC)
+        {
+            asset.document = JsonParser(reinterpret_cast<const char*>(data),
+                size).parse();
+            return asset;
+        }
+
+        // A binary glTF: the JSON chunk, then an optional binary chunk
+        const std::size_t length = std::min<std::size_t>(readU32(data + 8),
+            size);
+        std::size_t offset = GLB_HEADER_SIZE;
+        bool hasJson = false;
+        while (offset + GLB_CHUNK_HEADER_SIZE <= length)
+        {
+            const std::size_t chunkSize = readU32(data + offset);
+            const std::uint32_t chunkType = readU32(data + offset + 4);
+            offset += GLB_CHUNK_HEADER_SIZE;
+            if (chunkSize > length - offset)
+            {
+                break;
+            }
+            if (chunkType == GLB_JSON_CHUNK && !hasJson)
+            {
+                asset.document = JsonParser(reinterpret_cast<const char*>(
+                    data + offset), chunkSize).parse();
+                hasJson = true;
+            }
+            else if (chunkType == GLB_BIN_CHUNK && asset.binaryChunk == nullptr)
+            {
+                asset.binaryChunk = data + offset;
+                asset.binaryChunkSize = chunkSize;
+            }
+            offset += chunkSize;
+        }
+        if (!hasJson)
+        {
+            throw std::runtime_error("ERROR::GLTF::GLB WITHOUT A JSON CHUNK");
+        }
+        return asset;
+    }
+
+    // Decodes the %XX escapes of a relative URI into a path
+    std::string decodeUri(const std::string& uri)
+    {
+        std::string decoded;
+        for (std::size_t i = 0; i < uri.size(); ++i)
+        {
+            unsigned int value = 0;
+            if (uri[i] == '%' && i + 2 < uri.size() && std::from_chars(
+                uri.data() + i + 1, uri.data() + i + 3, value, 16).ptr ==
+                uri.data() + i + 3)
+            {
+                decoded += static_cast<char>(value);
+                i += 2;
+            }
+            else
+            {
+                decoded += uri[i];
+            }
+        }
+        return decoded;
+    }
+
+    // Decodes base64 text, stopping at the padding
+    std::vector<std::uint8_t> decodeBase64(const std::string& text,
+        std::size_t start)
+    {
+        std::vector<std::uint8_t> bytes;
+        bytes.reserve((text.size() - start) * 3 / 4);
+        std::uint32_t bits = 0;
+        int bitCount = 0;
+        for (std::size_t i = start; i < text.size() && text[i] != '='; ++i)
+        {
+            const char* digit = text[i] != '\0' ?
+                std::strchr(BASE64_DIGITS, text[i]) : nullptr;
+            if (digit == nullptr)
+            {
+                throw std::runtime_error("ERROR::GLTF::MALFORMED DATA URI");
+            }
+            bits = (bits << 6) | static_cast<std::uint32_t>(digit -
+                BASE64_DIGITS);
+            bitCount += 6;
+            if (bitCount >= 8)
+            {
+                bitCount -= 8;
+                bytes.push_back(static_cast<std::uint8_t>(bits >> bitCount));
+            }
+        }
+        return bytes;
+    }
+
+    // Reads a whole file into memory
+    std::vector<std::uint8_t> readFile(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+        {
+            throw std::runtime_error("ERROR::GLTF::CANNOT OPEN BUFFER " + path);
+        }
+        std::vector<std::uint8_t> bytes(static_cast<std::size_t>(
+            file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(bytes.data()),
+            static_cast<std::streamsize>(bytes.size()));
+        return bytes;
+    }
+
+    // Gets the paths of the buffers a glTF stores in files of their own
+    std::vector<std::string> getBufferPaths(const std::string& path,
+        const GltfAsset& asset)
+    {
+        std::vector<std::string> paths;
+        const JsonValue* buffers = asset.document.find("buffers");
+        if (buffers == nullptr)
+        {
+            return paths;
+        }
+        const std::filesystem::path directory =
+            std::filesystem::path(path).parent_path();
+        for (const JsonValue& buffer : buffers->items)
+        {
+            const JsonValue* uri = buffer.find("uri");
+            if (uri != nullptr && uri->string.rfind("data:", 0) != 0)
+            {
+                paths.push_back((directory / decodeUri(uri->string))
+                    .string());
+            }
+        }
+        return paths;
+    }
+
+    /**
+     * @struct AccessorView
+     * @brief Where the elements of an accessor are and how to read them.
+     */
+    struct AccessorView
+    {
+        // Null for an accessor without a buffer view, whose elements are 0
+        const std::uint8_t* data = nullptr;
+        std::size_t count = 0;
+        std::size_t stride = 0;
+        int componentType = GLTF_FLOAT;
+        std::size_t components = 1;
+        bool normalized = false;
+    };
+
+    std::size_t getComponentSize(int componentType)
+    {
+        switch (componentType)
+        {
+        case GLTF_BYTE:
+        case GLTF_UNSIGNED_BYTE: return 1;
+        case GLTF_SHORT:
+        case GLTF_UNSIGNED_SHORT: return 2;
+        case GLTF_UNSIGNED_INT:
+        case GLTF_FLOAT: return 4;
+        default:
+            throw std::runtime_error("ERROR::GLTF::UNKNOWN COMPONENT TYPE " +
+                std::to_string(componentType));
+        }
+    }
+
+    std::size_t getComponentCount(const std::string& type)
+    {
+        if (type == "SCALAR") return 1;
+        if (type == "VEC2") return 2;
+        if (type == "VEC3") return 3;
+        if (type == "VEC4") return 4;
+        throw std::runtime_error("ERROR::GLTF::UNSUPPORTED ACCESSOR TYPE " +
+            type);
+    }
+
+    /**
+     * @class GltfReader
+     * @brief Resolves the accessors of a glTF and flattens its nodes into
+     *        a mesh.
+     */
+    class GltfReader
+    {
+    public:
+        GltfReader(const std::string& path, GltfAsset&& asset) :
+            asset_(std::move(asset)), buffers_(), loaded_()
+        {
+            const JsonValue* buffers = asset_.document.find("buffers");
+            if (buffers == nullptr)
+            {
+                return;
+            }
+            const std::vector<std::string> paths = getBufferPaths(path,
+                asset_);
+            std::size_t external = 0;
+            for (const JsonValue& buffer : buffers->items)
+            {
+                const JsonValue* uri = buffer.find("uri");
+                if (uri == nullptr)
+                {
+                    // The binary chunk of a GLB
+                    buffers_.push_back({ asset_.binaryChunk,
+                        asset_.binaryChunkSize });
+                    continue;
+                }
+                if (uri->string.rfind("data:", 0) == 0)
+                {
+                    const std::size_t comma = uri->string.find(";base64,");
+                    if (comma == std::string::npos)
+                    {
+                        throw std::runtime_error(
+                            "ERROR::GLTF::DATA URI IS NOT BASE64");
+                    }
+                    loaded_.push_back(decodeBase64(uri->string, comma + 8));
+                }
+                else
+                {
+                    loaded_.push_back(readFile(paths[external++]));
+                }
+                buffers_.push_back({ loaded_.back().data(),
+                    loaded_.back().size() });
+            }
+        }
+
+        /** @brief Imports the triangles of the default scene. */
+        Renderer::MeshData read()
+        {
+            Renderer::MeshData mesh;
+            const JsonValue& document = asset_.document;
+            const JsonValue* scenes = document.find("scenes");
+            const long scene = static_cast<long>(document.getNumber("scene",
+                0.0));
+            if (scenes != nullptr && scene >= 0 &&
+                static_cast<std::size_t>(scene) < scenes->items.size())
+            {
+                const JsonValue* roots = scenes->items[
+                    static_cast<std::size_t>(scene)].find("nodes");
+                if (roots != nullptr)
+                {
+                    for (const JsonValue& root : roots->items)
+                    {
+                        readNode(mesh, static_cast<long>(root.number),
+                            glm::mat4(1.0f), 0);
+                    }
+                }
+            }
+            else if (const JsonValue* meshes = document.find("meshes"))
+            {
+                // Without a scene every mesh is imported where it is
+                for (std::size_t index = 0; index < meshes->items.size();
+                    ++index)
+                {
+                    readMesh(mesh, meshes->items[index], glm::mat4(1.0f));
+                }
+            }
+            endSubmesh(mesh);
+            checkIndexRange(mesh.vertices.size() / VerticeDataVector::STRIDE,
+                mesh.indices.size());
+            return mesh;
+        }
+
+    private:
+        /**
+         * @struct BufferSpan
+         * @brief The bytes of a buffer.
+         */
+        struct BufferSpan
+        {
+            const std::uint8_t* data;
+            std::size_t size;
+        };
+
+        [[noreturn]] static void fail(const std::string& what)
+        {
+            throw std::runtime_error("ERROR::GLTF::" + what);
+        }
+
+        // Gets an element of a top level array of the document
+        const JsonValue& getElement(const char* array, long index) const
+        {
+            const JsonValue* items = asset_.document.find(array);
+            if (items == nullptr || index < 0 ||
+                static_cast<std::size_t>(index) >= items->items.size())
+            {
+                fail(std::string("MISSING ") + array + " " +
+                    std::to_string(index));
+            }
+            return items->items[static_cast<std::size_t>(index)];
+        }
+
+        // Resolves an accessor to its bytes, checking they are in range
+        AccessorView getAccessor(long index) const
+        {
+            const JsonValue& accessor = getElement("accessors", index);
+            if (accessor.find("sparse") != nullptr)
+            {
+                fail("SPARSE ACCESSORS ARE NOT SUPPORTED");
+            }
+            AccessorView view;
+            view.count = static_cast<std::size_t>(
+                accessor.getNumber("count", 0.0));
+            view.componentType = static_cast<int>(
+                accessor.getNumber("componentType", GLTF_FLOAT));
+            const JsonValue* type = accessor.find("type");
+            view.components = getComponentCount(type != nullptr ?
+                type->string : std::string());
+            const JsonValue* normalized = accessor.find("normalized");
+            view.normalized = normalized != nullptr && normalized->boolean;
+            const std::size_t elementSize = view.components *
+                getComponentSize(view.componentType);
+            view.stride = elementSize;
+
+            const long bufferViewIndex = accessor.getIndex("bufferView");
+            if (bufferViewIndex < 0 || view.count == 0)
+            {
+                return view;
+            }
+            const JsonValue& bufferView = getElement("bufferViews",
+                bufferViewIndex);
+            const long buffer = bufferView.getIndex("buffer");
+            if (buffer < 0 || static_cast<std::size_t>(buffer) >=
+                buffers_.size())
+            {
+                fail("MISSING BUFFER " + std::to_string(buffer));
+            }
+            const BufferSpan& span = buffers_[static_cast<std::size_t>(
+                buffer)];
+            const std::size_t viewOffset = static_cast<std::size_t>(
+                bufferView.getNumber("byteOffset", 0.0));
+            const std::size_t viewLength = static_cast<std::size_t>(
+                bufferView.getNumber("byteLength", 0.0));
+            const std::size_t offset = static_cast<std::size_t>(
+                accessor.getNumber("byteOffset", 0.0));
+            view.stride = std::max(static_cast<std::size_t>(
+                bufferView.getNumber("byteStride", 0.0)), elementSize);
+            // The last element must end within the view, and the view
+            // within the buffer
+            const std::size_t available = offset <= viewLength ?
+                viewLength - offset : 0;
+            if (viewOffset > span.size || viewLength > span.size - viewOffset ||
+                elementSize > available ||
+                view.count - 1 > (available - elementSize) / view.stride)
+            {
+                fail("ACCESSOR " + std::to_string(index) +
+                    " IS OUT OF ITS BUFFER");
+            }
+            view.data = span.data + viewOffset + offset;
+            return view;
+        }
+
+        // Reads a component of an element as a float
+        static float readFloat(const AccessorView& view, std::size_t element,
+            std::size_t component)
+        {
+            if (view.data == nullptr || component >= view.components)
+            {
+                return 0.0f;
+            }
+            const std::uint8_t* bytes = view.data + element * view.stride +
+                component * getComponentSize(view.componentType);
+            switch (view.componentType)
+            {
+            case GLTF_FLOAT:
+            {
+                float value;
+                std::memcpy(&value, bytes, sizeof(value));
+                return value;
+            }
+            case GLTF_UNSIGNED_BYTE:
+                return view.normalized ? *bytes / 255.0f : *bytes;
+            case GLTF_BYTE:
+            {
+                const auto value = static_cast<std::int8_t>(*bytes);
+                return view.normalized ?
+                    std::max(value / 127.0f, -1.0f) : value;
+            }
+            case GLTF_UNSIGNED_SHORT:
+            {
+                std::uint16_t value;
+                std::memcpy(&value, bytes, sizeof(value));
+                return view.normalized ? value / 65535.0f : value;
+            }
+            case GLTF_SHORT:
+            {
+                std::int16_t value;
+                std::memcpy(&value, bytes, sizeof(value));
+                return view.normalized ?
+                    std::max(value / 32767.0f, -1.0f) : value;
+            }
+            default:
+                return 0.0f;
+            }
+        }
+
+        // Reads an index, which are unsigned integers of any width
+        static std::uint32_t readIndex(const AccessorView& view,
+            std::size_t element)
+        {
+            if (view.data == nullptr)
+            {
+                return 0;
+            }
+            const std::uint8_t* bytes = view.data + element * view.stride;
+            switch (view.componentType)
+            {
+            case GLTF_UNSIGNED_BYTE:
+                return *bytes;
+            case GLTF_UNSIGNED_SHORT:
+            {
+                std::uint16_t value;
+                std::memcpy(&value, bytes, sizeof(value));
+                return value;
+            }
+            case GLTF_UNSIGNED_INT:
+            {
+                std::uint32_t value;
+                std::memcpy(&value, bytes, sizeof(value));
+                return value;
+            }
+            default:
+                fail("INDICES MUST BE UNSIGNED INTEGERS");
+            }
+        }
+
+        // Gets the transform of a node relative to its parent
+        static glm::mat4 getLocalTransform(const JsonValue& node)
+        {
+            if (const JsonValue* matrix = node.find("matrix"))
+            {
+                glm::mat4 transform(1.0f);
+                for (std::size_t i = 0; i < 16 && i < matrix->items.size();
+                    ++i)
+                {
+                    // Column-major, like glm
+                    transform[static_cast<int>(i / 4)][static_cast<int>(
+                        i % 4)] = static_cast<float>(matrix->items[i].number);
+                }
+                return transform;
+            }
+            const auto getVector = [&node](const char* key, glm::vec4 value) {
+                if (const JsonValue* items = node.find(key))
+                {
+                    for (std::size_t i = 0; i < 4 && i < items->items.size();
+                        ++i)
+                    {
+                        value[static_cast<int>(i)] =
+                            static_cast<float>(items->items[i].number);
+                    }
+                }
+                return value;
+            };
+            const glm::vec4 translation = getVector("translation",
+                glm::vec4(0.0f));
+            const glm::vec4 rotation = getVector("rotation",
+                glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+            const glm::vec4 scale = getVector("scale", glm::vec4(1.0f));
+            return glm::translate(glm::mat4(1.0f), glm::vec3(translation)) *
+                glm::mat4_cast(glm::quat(rotation.w, rotation.x, rotation.y,
+                    rotation.z)) *
+                glm::scale(glm::mat4(1.0f), glm::vec3(scale));
+        }
+
+        // Imports the mesh of a node and of its children
+        void readNode(Renderer::MeshData& mesh, long index,
+            const glm::mat4& parent, unsigned int depth)
+        {
+            if (depth > MAX_DEPTH)
+            {
+                fail("NODES ARE NESTED TOO DEEP OR IN A CYCLE");
+            }
+            const JsonValue& node = getElement("nodes", index);
+            const glm::mat4 transform = parent * getLocalTransform(node);
+            const long meshIndex = node.getIndex("mesh");
+            if (meshIndex >= 0)
+            {
+                readMesh(mesh, getElement("meshes", meshIndex), transform);
+            }
+            if (const JsonValue* children = node.find("children"))
+            {
+                for (const JsonValue& child : children->items)
+                {
+                    readNode(mesh, static_cast<long>(child.number), transform,
+                        depth + 1);
+                }
+            }
+        }
+
+        // Appends the triangle primitives of a mesh as submeshes
+        void readMesh(Renderer::MeshData& mesh, const JsonValue& source,
+            const glm::mat4& transform)
+        {
+            const JsonValue* primitives = source.find("primitives");
+            if (primitives == nullptr)
+            {
+                return;
+            }
+            for (const JsonValue& primitive : primitives->items)
+            {
+                const JsonValue* attributes = primitive.find("attributes");
+                if (primitive.getNumber("mode", GLTF_TRIANGLES) !=
+                    GLTF_TRIANGLES || attributes == nullptr ||
+                    attributes->find("POSITION") == nullptr)
+                {
+                    continue;
+                }
+                const AccessorView positions = getAccessor(
+                    attributes->getIndex("POSITION"));
+                const AccessorView texCoords =
+                    attributes->find("TEXCOORD_0") != nullptr ?
+                    getAccessor(attributes->getIndex("TEXCOORD_0")) :
+                    AccessorView();
+
+                beginSubmesh(mesh);
+                const std::size_t firstVertex =
+                    mesh.vertices.size() / VerticeDataVector::STRIDE;
+                checkIndexRange(firstVertex + positions.count, 0);
+                mesh.vertices.reserve(mesh.vertices.size() +
+                    positions.count * VerticeDataVector::STRIDE);
+                for (std::size_t vertex = 0; vertex < positions.count;
+                    ++vertex)
+                {
+                    const glm::vec4 position = transform * glm::vec4(
+                        readFloat(positions, vertex, 0),
+                        readFloat(positions, vertex, 1),
+                        readFloat(positions, vertex, 2), 1.0f);
+                    const glm::vec2 texCoord(
+                        vertex < texCoords.count ?
+                            readFloat(texCoords, vertex, 0) : 0.0f,
+                        vertex < texCoords.count ?
+                            readFloat(texCoords, vertex, 1) : 0.0f);
+                    appendVertex(mesh, glm::vec3(position), texCoord);
+                }
+
+                const auto base = static_cast<std::uint32_t>(firstVertex);
+                const long indexAccessor = primitive.getIndex("indices");
+                if (indexAccessor < 0)
+                {
+                    // Unindexed triangles use their vertices in order
+                    for (std::size_t vertex = 0; vertex + 2 < positions.count;
+                        vertex += 3)
+                    {
+                        for (std::size_t corner = 0; corner < 3; ++corner)
+                        {
+                            mesh.indices.push_back(base +
+                                static_cast<std::uint32_t>(vertex + corner));
+                        }
+                    }
+                    continue;
+                }
+                const AccessorView indices = getAccessor(indexAccessor);
+                mesh.indices.reserve(mesh.indices.size() + indices.count);
+                for (std::size_t element = 0; element + 2 < indices.count;
+                    element += 3)
+                {
+                    for (std::size_t corner = 0; corner < 3; ++corner)
+                    {
+                        const std::uint32_t index = readIndex(indices,
+                            element + corner);
+                        if (index >= positions.count)
+                        {
+                            fail("INDEX " + std::to_string(index) +
+                                " REFERS TO A MISSING VERTEX");
+                        }
+                        mesh.indices.push_back(base + index);
+                    }
+                }
+            }
+        }
+
+        GltfAsset asset_;
+        std::vector<BufferSpan> buffers_;
+        // The buffers read from files and data URIs
+        std::vector<std::vector<std::uint8_t>> loaded_;
+    };
+
+    // Gets the lowercase extension of a path, including the dot
+    std::string getExtension(const std::string& path)
+    {
+        std::string extension = std::filesystem::path(path).extension()
+            .string();
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+            [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return extension;
+    }
+}
+
+Renderer::MeshData Renderer::importObj(const char* text, std::size_t size)
+{
+    MeshData mesh;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texCoords;
+    // Maps a position and texture coordinate pair to its merged vertex
+    std::unordered_map<std::uint64_t, std::uint32_t> vertices;
+    // The merged vertices of the face being read
+    std::vector<std::uint32_t> face;
+
+    const char* const end = text + size;
+    const char* cursor = text;
+    std::size_t line = 0;
+    while (cursor < end)
+    {
+        ++line;
+        const char* lineEnd = static_cast<const char*>(
+            std::memchr(cursor, '\n', static_cast<std::size_t>(end - cursor)));
+        lineEnd = lineEnd != nullptr ? lineEnd : end;
+        const char* next = lineEnd + (lineEnd < end ? 1 : 0);
+        const char* field = skipSpaces(cursor, lineEnd);
+        const char* keywordEnd = field;
+        while (keywordEnd < lineEnd && !std::isspace(
+            static_cast<unsigned char>(*keywordEnd)))
+        {
+            ++keywordEnd;
+        }
+        const std::string_view keyword(field, static_cast<std::size_t>(
+            keywordEnd - field));
+        cursor = keywordEnd;
+
+        if (keyword == "v")
+        {
+            glm::vec3 position(0.0f);
+            if (!parseNumber(cursor, lineEnd, position.x) ||
+                !parseNumber(cursor, lineEnd, position.y) ||
+                !parseNumber(cursor, lineEnd, position.z))
+            {
+                throw std::runtime_error("ERROR::OBJ::LINE " +
+                    std::to_string(line) + " IS A MALFORMED POSITION");
+            }
+            positions.push_back(position);
+        }
+        else if (keyword == "vt")
+        {
+            glm::vec2 texCoord(0.0f);
+            parseNumber(cursor, lineEnd, texCoord.x);
+            parseNumber(cursor, lineEnd, texCoord.y);
+            texCoords.push_back(texCoord);
+        }
+        else if (keyword == "f")
+        {
+            face.clear();
+            long position = 0;
+            while (parseNumber(cursor, lineEnd, position))
+            {
+                // v, v/vt, v//vn or v/vt/vn; normals are not used
+                long texCoord = 0;
+                if (cursor < lineEnd && *cursor == '/')
+                {
+                    ++cursor;
+                    if (cursor < lineEnd && *cursor != '/')
+                    {
+                        parseNumber(cursor, lineEnd, texCoord);
+                    }
+                    if (cursor < lineEnd && *cursor == '/')
+                    {
+                        ++cursor;
+                        long normal = 0;
+                        parseNumber(cursor, lineEnd, normal);
+                    }
+                }
+                const std::size_t positionIndex = resolveObjIndex(position,
+                    positions.size(), line);
+                const std::size_t texCoordIndex = texCoord == 0 ? 0 :
+                    resolveObjIndex(texCoord, texCoords.size(), line) + 1;
+                const std::uint64_t key =
+                    static_cast<std::uint64_t>(positionIndex) << 32 |
+                    texCoordIndex;
+                const auto inserted = vertices.emplace(key,
+                    static_cast<std::uint32_t>(vertices.size()));
+                if (inserted.second)
+                {
+                    appendVertex(mesh, positions[positionIndex],
+                        texCoordIndex == 0 ? glm::vec2(0.0f) :
+                        texCoords[texCoordIndex - 1]);
+                }
+                face.push_back(inserted.first->second);
+            }
+            if (mesh.submeshes.empty())
+            {
+                beginSubmesh(mesh);
+            }
+            // Polygons are fanned around their first vertex
+            for (std::size_t corner = 2; corner < face.size(); ++corner)
+            {
+                mesh.indices.insert(mesh.indices.end(),
+                    { face[0], face[corner - 1], face[corner] });
+            }
+        }
+        else if (keyword == "o" || keyword == "g" || keyword == "usemtl")
+        {
+            beginSubmesh(mesh);
+        }
+        cursor = next;
+    }
+    endSubmesh(mesh);
+    checkIndexRange(vertices.size(), mesh.indices.size());
+    return mesh;
+}
+
+Renderer::MeshData Renderer::importGltf(const std::string& path,
+    const std::uint8_t* data, std::size_t size)
+{
+    return GltfReader(path, parseGltf(data, size)).read();
+}
+
+std::vector<std::string> Renderer::getMeshDependencies(
+    const std::string& path, const std::uint8_t* data, std::size_t size)
+{
+    // A .glb holds its buffers, data URIs are part of the file
+    if (getExtension(path) != ".gltf")
+    {
+        return {};
+    }
+    return getBufferPaths(path, parseGltf(data, size));
+}
@@ -0,0 +1,848 @@
+#include "device.hpp"
+#include <optional>
+#include <stdexcept>
+
+Renderer::NullDevice::NullDevice() : nextNames_{}, boundVertexArray_{ 0 },
+boundArrayBuffer_{ 0 }, defaultElementBuffer_{ 0 }, boundStorageBuffer_{ 0 },
+boundIndirectBuffer_{ 0 }, currentProgram_{ 0 }, activeUnit_{ 0 },
+boundTextures_{}, boundDrawFramebuffer_{ 0 }, boundReadFramebuffer_{ 0 },
+boundRenderbuffer_{ 0 }, activeQueries_()
+{
+}
+
+void Renderer::NullDevice::resetStats()
+{
+    stats_ = DeviceStats();
+}
+
+void Renderer::NullDevice::require(bool condition, const char* message) const
+{
+    if (!condition)
+    {
+        throw std::logic_error(std::string("ERROR::NULL_DEVICE::") + message);
+    }
+}
+
+GLuint Renderer::NullDevice::nextName(NameSpace space)
+{
+    // Names start at 1, 0 is the default object of every type
+    return ++nextNames_[static_cast<std::size_t>(space)];
+}
+
+GLuint& Renderer::NullDevice::boundElementBuffer()
+{
+    return boundVertexArray_ == 0 ? defaultElementBuffer_ :
+        vertexArrays_.at(boundVertexArray_).elementBuffer;
+}
+
+GLuint& Renderer::NullDevice::boundBuffer(GLenum target)
+{
+    switch (target)
+    {
+    case GL_ARRAY_BUFFER: return boundArrayBuffer_;
+    case GL_ELEMENT_ARRAY_BUFFER: return boundElementBuffer();
+    case GL_SHADER_STORAGE_BUFFER: return boundStorageBuffer_;
+    case GL_DRAW_INDIRECT_BUFFER: return boundIndirectBuffer_;
+    default:
+        require(false, "UNSUPPORTED BUFFER TARGET");
+        return boundArrayBuffer_;
+    }
+}
+
+GLuint& Renderer::NullDevice::activeQuery(GLenum target)
+{
+    switch (target)
+    {
+    case GL_TIME_ELAPSED:
+    case GL_PRIMITIVES_GENERATED:
+    case GL_VERTICES_SUBMITTED:
+    case GL_PRIMITIVES_SUBMITTED:
+    case GL_VERTEX_SHADER_INVOCATIONS:
+    case GL_FRAGMENT_SHADER_INVOCATIONS:
+    case GL_CLIPPING_INPUT_PRIMITIVES:
+    case GL_CLIPPING_OUTPUT_PRIMITIVES:
+        return activeQueries_[target];
+    default:
+        require(false, "UNSUPPORTED QUERY TARGET");
+        return activeQueries_[GL_TIME_ELAPSED];
+    }
+}
+
+bool Renderer::NullDevice::isQueryActive(GLuint query) const
+{
+    for (const auto& [target, active] : activeQueries_)
+    {
+        (void)target;
+        if (active == query)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Renderer::NullDevice::requireUniformTarget(GLint location) const
+{
+    require(currentProgram_ != 0, "UNIFORM SET WITHOUT A PROGRAM IN USE");
+    require(location >= -1, "INVALID UNIFORM LOCATION");
+}
+
+GLuint Renderer::NullDevice::boundFramebuffer(GLenum target) const
+{
+    require(target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER ||
+        target == GL_READ_FRAMEBUFFER, "UNSUPPORTED FRAMEBUFFER TARGET");
+    return target == GL_READ_FRAMEBUFFER ?
+        boundReadFramebuffer_ : boundDrawFramebuffer_;
+}
+
+GLsizei Renderer::NullDevice::framebufferSamples(GLuint framebuffer) const
+{
+    if (framebuffer == 0)
+    {
+        return 0;
+    }
+    // Textures attached by this device are never multisampled
+    const Attachment& color = framebuffers_.at(framebuffer).color;
+    return color.name == 0 || color.texture ?
+        0 : renderbuffers_.at(color.name).samples;
+}
+
+void Renderer::NullDevice::requireProgram(bool compute,
+    const char* message) const
+{
+    require(currentProgram_ != 0 &&
+        programs_.at(currentProgram_).compute == compute, message);
+}
+
+void Renderer::NullDevice::attach(GLenum target, GLenum attachment,
+    const Attachment& image)
+{
+    const GLuint framebuffer = boundFramebuffer(target);
+    require(framebuffer != 0, "ATTACHMENT TO THE DEFAULT FRAMEBUFFER");
+    FramebufferRecord& record = framebuffers_.at(framebuffer);
+    switch (attachment)
+    {
+    case GL_COLOR_ATTACHMENT0: record.color = image; break;
+    case GL_DEPTH_ATTACHMENT:
+    case GL_DEPTH_STENCIL_ATTACHMENT: record.depth = image; break;
+    default: require(false, "UNSUPPORTED FRAMEBUFFER ATTACHMENT");
+    }
+}
+
+void Renderer::NullDevice::detach(const Attachment& image)
+{
+    for (auto& framebuffer : framebuffers_)
+    {
+        for (Attachment* attachment :
+            { &framebuffer.second.color, &framebuffer.second.depth })
+        {
+            if (attachment->name == image.name &&
+                attachment->texture == image.texture)
+            {
+                *attachment = Attachment{ 0, false };
+            }
+        }
+    }
+}
+
+GLuint Renderer::NullDevice::createVertexArray()
+{
+    count(DeviceCall::BUFFER);
+    const GLuint vertexArray = nextName(NameSpace::VERTEX_ARRAY);
+    vertexArrays_[vertexArray] = VertexArrayRecord{ 0 };
+    return vertexArray;
+}
+
+void Renderer::NullDevice::bindVertexArray(GLuint vertexArray)
+{
+    count(DeviceCall::BUFFER);
+    require(vertexArray == 0 || vertexArrays_.count(vertexArray) != 0,
+        "BIND OF UNKNOWN VERTEX ARRAY");
+    boundVertexArray_ = vertexArray;
+}
+
+void Renderer::NullDevice::deleteVertexArray(GLuint vertexArray)
+{
+    count(DeviceCall::BUFFER);
+    require(vertexArrays_.erase(vertexArray) != 0,
+        "DELETE OF UNKNOWN VERTEX ARRAY");
+    if (boundVertexArray_ == vertexArray)
+    {
+        boundVertexArray_ = 0;
+    }
+}
+
+GLuint Renderer::NullDevice::createBuffer()
+{
+    count(DeviceCall::BUFFER);
+    const GLuint buffer = nextName(NameSpace::BUFFER);
+    buffers_.insert(buffer);
+    return buffer;
+}
+
+void Renderer::NullDevice::bindBuffer(GLenum target, GLuint buffer)
+{
+    count(DeviceCall::BUFFER);
+    require(buffer == 0 || buffers_.count(buffer) != 0,
+        "BIND OF UNKNOWN BUFFER");
+    boundBuffer(target) = buffer;
+}
+
+void Renderer::NullDevice::deleteBuffer(GLuint buffer)
+{
+    count(DeviceCall::BUFFER);
+    require(buffers_.erase(buffer) != 0, "DELETE OF UNKNOWN BUFFER");
+
+    // Deleting a bound object binds 0 in its place. Like in OpenGL, only
+    // the bound vertex array loses its element buffer, the others keep
+    // the object alive
+    for (GLuint* bound : { &boundArrayBuffer_, &boundElementBuffer(),
+        &boundStorageBuffer_, &boundIndirectBuffer_ })
+    {
+        if (*bound == buffer)
+        {
+            *bound = 0;
+        }
+    }
+}
+
+void Renderer::NullDevice::bufferData(GLenum target, GLsizeiptr size,
+    const void* data, GLenum usage)
+{
+    (void)usage;
+    count(DeviceCall::BUFFER);
+    require(boundBuffer(target) != 0, "BUFFER DATA WITHOUT A BOUND BUFFER");
+    require(size >= 0, "NEGATIVE BUFFER SIZE");
+    // Storage allocated without data is not an upload
+    if (data != nullptr)
+    {
+        stats_.uploadedBytes += static_cast<std::uint64_t>(size);
+    }
+}
+
+void Renderer::NullDevice::vertexAttribPointer(GLuint index, GLint size,
+    GLenum type, GLsizei stride, std::size_t offset)
+{
+    (void)index;
+    (void)type;
+    (void)offset;
+    count(DeviceCall::BUFFER);
+    require(boundVertexArray_ != 0, "ATTRIBUTE POINTER WITHOUT A VERTEX ARRAY");
+    require(boundArrayBuffer_ != 0, "ATTRIBUTE POINTER WITHOUT AN ARRAY BUFFER");
+    require(size >= 1 && size <= 4 && stride >= 0, "INVALID ATTRIBUTE LAYOUT");
+}
+
+void Renderer::NullDevice::enableVertexAttribArray(GLuint index)
+{
+    (void)index;
+    count(DeviceCall::BUFFER);
+    require(boundVertexArray_ != 0, "ATTRIBUTE ENABLED WITHOUT A VERTEX ARRAY");
+}
+
+void Renderer::NullDevice::vertexAttribDivisor(GLuint index, GLuint divisor)
+{
+    (void)index;
+    (void)divisor;
+    count(DeviceCall::BUFFER);
+    require(boundVertexArray_ != 0, "ATTRIBUTE DIVISOR WITHOUT A VERTEX ARRAY");
+}
+
+void Renderer::NullDevice::bindBufferBase(GLenum target, GLuint index,
+    GLuint buffer)
+{
+    (void)index;
+    count(DeviceCall::BUFFER);
+    require(target == GL_SHADER_STORAGE_BUFFER,
+        "UNSUPPORTED INDEXED BUFFER TARGET");
+    require(buffer == 0 || buffers_.count(buffer) != 0,
+        "BIND OF UNKNOWN BUFFER");
+    // Like the driver, an indexed bind also binds the generic target
+    boundBuffer(target) = buffer;
+}
+
+GLuint Renderer::NullDevice::createTexture()
+{
+    count(DeviceCall::TEXTURE);
+    const GLuint texture = nextName(NameSpace::TEXTURE);
+    textures_.insert(texture);
+    return texture;
+}
+
+void Renderer::NullDevice::activeTexture(GLenum unit)
+{
+    count(DeviceCall::TEXTURE);
+    require(unit >= GL_TEXTURE0 && unit < GL_TEXTURE0 + boundTextures_.size(),
+        "INVALID TEXTURE UNIT");
+    activeUnit_ = unit - GL_TEXTURE0;
+}
+
+void Renderer::NullDevice::bindTexture(GLenum target, GLuint texture)
+{
+    count(DeviceCall::TEXTURE);
+    require(target == GL_TEXTURE_2D, "UNSUPPORTED TEXTURE TARGET");
+    require(texture == 0 || textures_.count(texture) != 0,
+        "BIND OF UNKNOWN TEXTURE");
+    boundTextures_[activeUnit_] = texture;
+}
+
+void Renderer::NullDevice::deleteTexture(GLuint texture)
+{
+    count(DeviceCall::TEXTURE);
+    require(textures_.erase(texture) != 0, "DELETE OF UNKNOWN TEXTURE");
+    for (GLuint& bound : boundTextures_)
+    {
+        if (bound == texture)
+        {
+            bound = 0;
+        }
+    }
+    detach(Attachment{ texture, true });
+}
+
+void Renderer::NullDevice::texParameter(GLenum target, GLenum name,
+    GLint value)
+{
+    (void)target;
+    (void)name;
+    (void)value;
+    count(DeviceCall::TEXTURE);
+    require(boundTextures_[activeUnit_] != 0,
+        "TEXTURE PARAMETER WITHOUT A BOUND TEXTURE");
+}
+
+void Renderer::NullDevice::texImage2D(GLenum target, GLint level,
+    GLint internalFormat, GLsizei width, GLsizei height, GLenum format,
+    GLenum type, const void* pixels)
+{
+    (void)target;
+    (void)internalFormat;
+    count(DeviceCall::TEXTURE);
+    require(boundTextures_[activeUnit_] != 0,
+        "TEXTURE IMAGE WITHOUT A BOUND TEXTURE");
+    require(level >= 0 && width >= 0 && height >= 0,
+        "INVALID TEXTURE IMAGE SIZE");
+    if (pixels != nullptr)
+    {
+        stats_.uploadedBytes += static_cast<std::uint64_t>(width) * height *
+            pixelSize(format, type);
+    }
+}
+
+void Renderer::NullDevice::generateMipmap(GLenum target)
+{
+    (void)target;
+    count(DeviceCall::TEXTURE);
+    require(boundTextures_[activeUnit_] != 0,
+        "MIPMAP GENERATION WITHOUT A BOUND TEXTURE");
+}
+
+void Renderer::NullDevice::bindImageTexture(GLuint unit, GLuint texture,
+    GLint level, GLenum access, GLenum format)
+{
+    (void)unit;
+    (void)format;
+    count(DeviceCall::TEXTURE);
+    require(texture == 0 || textures_.count(texture) != 0,
+        "IMAGE BIND OF UNKNOWN TEXTURE");
+    require(level >= 0, "INVALID IMAGE LEVEL");
+    require(access == GL_READ_ONLY || access == GL_WRITE_ONLY ||
+        access == GL_READ_WRITE, "INVALID IMAGE ACCESS");
+}
+
+GLuint Renderer::NullDevice::createShader(GLenum type)
+{
+    count(DeviceCall::SHADER);
+    require(type == GL_VERTEX_SHADER || type == GL_FRAGMENT_SHADER ||
+        type == GL_COMPUTE_SHADER, "UNSUPPORTED SHADER TYPE");
+    const GLuint shader = nextName(NameSpace::SHADER_OR_PROGRAM);
+    shaders_[shader] = ShaderRecord{ type, false, false };
+    return shader;
+}
+
+void Renderer::NullDevice::shaderSource(GLuint shader,
+    const std::string& source)
+{
+    count(DeviceCall::SHADER);
+    const auto record = shaders_.find(shader);
+    require(record != shaders_.end(), "SOURCE FOR UNKNOWN SHADER");
+    record->second.hasSource = !source.empty();
+}
+
+void Renderer::NullDevice::compileShader(GLuint shader)
+{
+    count(DeviceCall::SHADER);
+    const auto record = shaders_.find(shader);
+    require(record != shaders_.end(), "COMPILE OF UNKNOWN SHADER");
+    record->second.compiled = record->second.hasSource;
+}
+
+bool Renderer::NullDevice::getCompileStatus(GLuint shader,
+    std::string& infoLog)
+{
+    count(DeviceCall::SHADER);
+    const auto record = shaders_.find(shader);
+    require(record != shaders_.end(), "STATUS OF UNKNOWN SHADER");
+    if (!record->second.compiled)
+    {
+        infoLog = "shader has no source";
+    }
+    return record->second.compiled;
+}
+
+void Renderer::NullDevice::deleteShader(GLuint shader)
+{
+    count(DeviceCall::SHADER);
+    require(shaders_.erase(shader) != 0, "DELETE OF UNKNOWN SHADER");
+}
+
+GLuint Renderer::NullDevice::createProgram()
+{
+    count(DeviceCall::PROGRAM);
+    const GLuint program = nextName(NameSpace::SHADER_OR_PROGRAM);
+    programs_[program] = ProgramRecord{ {}, false, false, {} };
+    return program;
+}
+
+void Renderer::NullDevice::attachShader(GLuint program, GLuint shader)
+{
+    count(DeviceCall::PROGRAM);
+    const auto record = programs_.find(program);
+    require(record != programs_.end(), "ATTACH TO UNKNOWN PROGRAM");
+    require(shaders_.count(shader) != 0, "ATTACH OF UNKNOWN SHADER");
+    record->second.shaders.push_back(shader);
+}
+
+void Renderer::NullDevice::linkProgram(GLuint program)
+{
+    count(DeviceCall::PROGRAM);
+    const auto record = programs_.find(program);
+    require(record != programs_.end(), "LINK OF UNKNOWN PROGRAM");
+
+    // A program needs a compiled vertex and fragment stage to link, or a
+    // compiled compute stage on its own
+    bool hasVertex = false;
+    bool hasFragment = false;
+    bool hasCompute = false;
+    for (const GLuint shader : record->second.shaders)
+    {
+        const ShaderRecord& stage = shaders_.at(shader);
+        hasVertex = hasVertex || (stage.compiled && stage.type == GL_VERTEX_SHADER);
+        hasFragment = hasFragment ||
+            (stage.compiled && stage.type == GL_FRAGMENT_SHADER);
+        hasCompute = hasCompute ||
+            (stage.compiled && stage.type == GL_COMPUTE_SHADER);
+    }
+    record->second.compute = hasCompute;
+    record->second.linked = hasCompute ? !hasVertex && !hasFragment &&
+        record->second.shaders.size() == 1 : hasVertex && hasFragment;
+}
+
+bool Renderer::NullDevice::getLinkStatus(GLuint program, std::string& infoLog)
+{
+    count(DeviceCall::PROGRAM);
+    const auto record = programs_.find(program);
+    require(record != programs_.end(), "STATUS OF UNKNOWN PROGRAM");
+    if (!record->second.linked)
+    {
+        infoLog = "program needs a compiled vertex and fragment shader or "
+            "a single compiled compute shader";
+    }
+    return record->second.linked;
+}
+
+void Renderer::NullDevice::useProgram(GLuint program)
+{
+    count(DeviceCall::PROGRAM);
+    if (program != 0)
+    {
+        const auto record = programs_.find(program);
+        require(record != programs_.end(), "USE OF UNKNOWN PROGRAM");
+        require(record->second.linked, "USE OF UNLINKED PROGRAM");
+    }
+    currentProgram_ = program;
+}
+
+void Renderer::NullDevice::deleteProgram(GLuint program)
+{
+    count(DeviceCall::PROGRAM);
+    require(programs_.erase(program) != 0, "DELETE OF UNKNOWN PROGRAM");
+
+    // The driver keeps the program in use alive until another one is used,
+    // this device stops validating draws against it
+    if (currentProgram_ == program)
+    {
+        currentProgram_ = 0;
+    }
+}
+
+GLint Renderer::NullDevice::getUniformLocation(GLuint program,
+    const char* name)
+{
+    count(DeviceCall::UNIFORM);
+    const auto record = programs_.find(program);
+    require(record != programs_.end(), "UNIFORM LOOKUP IN UNKNOWN PROGRAM");
+    require(record->second.linked, "UNIFORM LOOKUP IN UNLINKED PROGRAM");
+
+    // Without a compiler every name resolves, with a stable location
+    std::unordered_map<std::string, GLint>& uniforms = record->second.uniforms;
+    uniformName_.assign(name);
+    const auto known = uniforms.find(uniformName_);
+    if (known != uniforms.end())
+    {
+        return known->second;
+    }
+    const GLint location = static_cast<GLint>(uniforms.size());
+    uniforms.emplace(uniformName_, location);
+    return location;
+}
+
+void Renderer::NullDevice::uniform1i(GLint location, GLint value)
+{
+    (void)value;
+    count(DeviceCall::UNIFORM);
+    requireUniformTarget(location);
+}
+
+void Renderer::NullDevice::uniform1f(GLint location, GLfloat value)
+{
+    (void)value;
+    count(DeviceCall::UNIFORM);
+    requireUniformTarget(location);
+}
+
+void Renderer::NullDevice::uniformMatrix4fv(GLint location,
+    const GLfloat* value)
+{
+    count(DeviceCall::UNIFORM);
+    requireUniformTarget(location);
+    require(value != nullptr, "NULL MATRIX UNIFORM");
+}
+
+void Renderer::NullDevice::viewport(GLint x, GLint y, GLsizei width,
+    GLsizei height)
+{
+    (void)x;
+    (void)y;
+    count(DeviceCall::STATE);
+    require(width >= 0 && height >= 0, "NEGATIVE VIEWPORT SIZE");
+}
+
+void Renderer::NullDevice::enable(GLenum capability)
+{
+    (void)capability;
+    count(DeviceCall::STATE);
+}
+
+void Renderer::NullDevice::disable(GLenum capability)
+{
+    (void)capability;
+    count(DeviceCall::STATE);
+}
+
+void Renderer::NullDevice::blendFunc(GLenum sourceFactor, GLenum destFactor)
+{
+    (void)sourceFactor;
+    (void)destFactor;
+    count(DeviceCall::STATE);
+}
+
+void Renderer::NullDevice::clearColor(GLfloat red, GLfloat green,
+    GLfloat blue, GLfloat alpha)
+{
+    (void)red;
+    (void)green;
+    (void)blue;
+    (void)alpha;
+    count(DeviceCall::STATE);
+}
+
+void Renderer::NullDevice::clear(GLbitfield mask)
+{
+    count(DeviceCall::STATE);
+    require((mask & ~(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT |
+        GL_STENCIL_BUFFER_BIT)) == 0, "INVALID CLEAR MASK");
+}
+
+void Renderer::NullDevice::drawArrays(GLenum mode, GLint first,
+    GLsizei count)
+{
+    (void)mode;
+    this->count(DeviceCall::DRAW);
+    requireProgram(false, "DRAW WITHOUT A GRAPHICS PROGRAM IN USE");
+    require(boundVertexArray_ != 0, "DRAW WITHOUT A VERTEX ARRAY");
+    require(first >= 0 && count >= 0, "INVALID DRAW RANGE");
+    stats_.vertices += static_cast<std::uint64_t>(count);
+}
+
+void Renderer::NullDevice::drawElements(GLenum mode, GLsizei count,
+    GLenum type, std::size_t offset)
+{
+    (void)mode;
+    (void)offset;
+    this->count(DeviceCall::DRAW);
+    requireProgram(false, "DRAW WITHOUT A GRAPHICS PROGRAM IN USE");
+    require(boundVertexArray_ != 0, "DRAW WITHOUT A VERTEX ARRAY");
+    require(boundElementBuffer() != 0,
+        "INDEXED DRAW WITHOUT AN ELEMENT BUFFER");
+    require(type == GL_UNSIGNED_INT || type == GL_UNSIGNED_SHORT ||
+        type == GL_UNSIGNED_BYTE, "INVALID INDEX TYPE");
+    require(count >= 0, "INVALID DRAW RANGE");
+    stats_.vertices += static_cast<std::uint64_t>(count);
+}
+
+void Renderer::NullDevice::multiDrawArraysIndirect(GLenum mode,
+    std::size_t offset, GLsizei drawCount, GLsizei stride)
+{
+    (void)mode;
+    count(DeviceCall::DRAW);
+    requireProgram(false, "DRAW WITHOUT A GRAPHICS PROGRAM IN USE");
+    require(boundVertexArray_ != 0, "DRAW WITHOUT A VERTEX ARRAY");
+    require(boundIndirectBuffer_ != 0, "INDIRECT DRAW WITHOUT A BUFFER");
+    require(drawCount >= 0 && stride >= 0 && stride % 4 == 0 &&
+        offset % 4 == 0, "INVALID INDIRECT DRAW LAYOUT");
+    // The vertex counts live in GPU memory and are not counted
+}
+
+void Renderer::NullDevice::dispatchCompute(GLuint groupsX, GLuint groupsY,
+    GLuint groupsZ)
+{
+    (void)groupsX;
+    (void)groupsY;
+    (void)groupsZ;
+    count(DeviceCall::COMPUTE);
+    requireProgram(true, "DISPATCH WITHOUT A COMPUTE PROGRAM IN USE");
+}
+
+void Renderer::NullDevice::memoryBarrier(GLbitfield barriers)
+{
+    count(DeviceCall::COMPUTE);
+    require(barriers != 0, "EMPTY MEMORY BARRIER");
+}
+
+GLuint Renderer::NullDevice::createFramebuffer()
+{
+    count(DeviceCall::FRAMEBUFFER);
+    const GLuint framebuffer = nextName(NameSpace::FRAMEBUFFER);
+    framebuffers_[framebuffer] =
+        FramebufferRecord{ { 0, false }, { 0, false } };
+    return framebuffer;
+}
+
+void Renderer::NullDevice::bindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    count(DeviceCall::FRAMEBUFFER);
+    require(framebuffer == 0 || framebuffers_.count(framebuffer) != 0,
+        "BIND OF UNKNOWN FRAMEBUFFER");
+    require(target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER ||
+        target == GL_READ_FRAMEBUFFER, "UNSUPPORTED FRAMEBUFFER TARGET");
+    if (target != GL_READ_FRAMEBUFFER)
+    {
+        boundDrawFramebuffer_ = framebuffer;
+    }
+    if (target != GL_DRAW_FRAMEBUFFER)
+    {
+        boundReadFramebuffer_ = framebuffer;
+    }
+}
+
+void Renderer::NullDevice::deleteFramebuffer(GLuint framebuffer)
+{
+    count(DeviceCall::FRAMEBUFFER);
+    require(framebuffers_.erase(framebuffer) != 0,
+        "DELETE OF UNKNOWN FRAMEBUFFER");
+    if (boundDrawFramebuffer_ == framebuffer)
+    {
+        boundDrawFramebuffer_ = 0;
+    }
+    if (boundReadFramebuffer_ == framebuffer)
+    {
+        boundReadFramebuffer_ = 0;
+    }
+}
+
+GLuint Renderer::NullDevice::createRenderbuffer()
+{
+    count(DeviceCall::FRAMEBUFFER);
+    const GLuint renderbuffer = nextName(NameSpace::RENDERBUFFER);
+    renderbuffers_[renderbuffer] = RenderbufferRecord{ false, 0 };
+    return renderbuffer;
+}
+
+void Renderer::NullDevice::bindRenderbuffer(GLuint renderbuffer)
+{
+    count(DeviceCall::FRAMEBUFFER);
+    require(renderbuffer == 0 || renderbuffers_.count(renderbuffer) != 0,
+        "BIND OF UNKNOWN RENDERBUFFER");
+    boundRenderbuffer_ = renderbuffer;
+}
+
+void Renderer::NullDevice::deleteRenderbuffer(GLuint renderbuffer)
+{
+    count(DeviceCall::FRAMEBUFFER);
+    require(renderbuffers_.erase(renderbuffer) != 0,
+        "DELETE OF UNKNOWN RENDERBUFFER");
+    if (boundRenderbuffer_ == renderbuffer)
+    {
+        boundRenderbuffer_ = 0;
+    }
+    detach(Attachment{ renderbuffer, false });
+}
+
+void Renderer::NullDevice::renderbufferStorage(GLsizei samples,
+    GLenum internalFormat, GLsizei width, GLsizei height)
+{
+    (void)internalFormat;
+    count(DeviceCall::FRAMEBUFFER);
+    require(boundRenderbuffer_ != 0, "STORAGE WITHOUT A BOUND RENDERBUFFER");
+    require(samples >= 0 && width > 0 && height > 0,
+        "INVALID RENDERBUFFER STORAGE");
+    renderbuffers_[boundRenderbuffer_] = RenderbufferRecord{ true, samples };
+}
+
+void Renderer::NullDevice::framebufferRenderbuffer(GLenum target,
+    GLenum attachment, GLuint renderbuffer)
+{
+    count(DeviceCall::FRAMEBUFFER);
+    require(renderbuffer == 0 || renderbuffers_.count(renderbuffer) != 0,
+        "ATTACHMENT OF UNKNOWN RENDERBUFFER");
+    attach(target, attachment, Attachment{ renderbuffer, false });
+}
+
+void Renderer::NullDevice::framebufferTexture2D(GLenum target,
+    GLenum attachment, GLuint texture, GLint level)
+{
+    count(DeviceCall::FRAMEBUFFER);
+    require(texture == 0 || textures_.count(texture) != 0,
+        "ATTACHMENT OF UNKNOWN TEXTURE");
+    require(level >= 0, "INVALID ATTACHMENT LEVEL");
+    attach(target, attachment, Attachment{ texture, true });
+}
+
+GLenum Renderer::NullDevice::checkFramebufferStatus(GLenum target)
+{
+    count(DeviceCall::FRAMEBUFFER);
+    const GLuint framebuffer = boundFramebuffer(target);
+    if (framebuffer == 0)
+    {
+        return GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    // Every renderbuffer needs storage and all attachments the same number
+    // of samples, textures are single sampled
+    const FramebufferRecord& record = framebuffers_.at(framebuffer);
+    if (record.color.name == 0 && record.depth.name == 0)
+    {
+        return GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT;
+    }
+    std::optional<GLsizei> samples;
+    for (const Attachment& attachment : { record.color, record.depth })
+    {
+        if (attachment.name == 0)
+        {
+            continue;
+        }
+        GLsizei attachmentSamples = 0;
+        if (!attachment.texture)
+        {
+            const RenderbufferRecord& storage =
+                renderbuffers_.at(attachment.name);
+            if (!storage.allocated)
+            {
+                return GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT;
+            }
+            attachmentSamples = storage.samples;
+        }
+        if (samples && *samples != attachmentSamples)
+        {
+            return GL_FRAMEBUFFER_INCOMPLETE_MULTISAMPLE;
+        }
+        samples = attachmentSamples;
+    }
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+void Renderer::NullDevice::blitFramebuffer(GLint srcX0, GLint srcY0,
+    GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1,
+    GLint dstY1, GLbitfield mask, GLenum filter)
+{
+    count(DeviceCall::FRAMEBUFFER);
+    require((mask & ~(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT |
+        GL_STENCIL_BUFFER_BIT)) == 0, "INVALID BLIT MASK");
+    require(filter == GL_NEAREST || (filter == GL_LINEAR &&
+        (mask & ~GL_COLOR_BUFFER_BIT) == 0), "INVALID BLIT FILTER");
+    require(framebufferSamples(boundDrawFramebuffer_) == 0,
+        "BLIT INTO A MULTISAMPLED FRAMEBUFFER");
+
+    // Resolving samples cannot scale the image at the same time
+    require(framebufferSamples(boundReadFramebuffer_) == 0 ||
+        (srcX1 - srcX0 == dstX1 - dstX0 && srcY1 - srcY0 == dstY1 - dstY0),
+        "SCALED BLIT FROM A MULTISAMPLED FRAMEBUFFER");
+}
+
+GLuint Renderer::NullDevice::createQuery()
+{
+    count(DeviceCall::QUERY);
+    const GLuint query = nextName(NameSpace::QUERY);
+    queries_.insert(query);
+    return query;
+}
+
+void Renderer::NullDevice::deleteQuery(GLuint query)
+{
+    count(DeviceCall::QUERY);
+    require(queries_.count(query) != 0, "DELETE OF UNKNOWN QUERY");
+    require(!isQueryActive(query), "DELETE OF AN ACTIVE QUERY");
+    queries_.erase(query);
+}
+
+void Renderer::NullDevice::beginQuery(GLenum target, GLuint query)
+{
+    count(DeviceCall::QUERY);
+    require(queries_.count(query) != 0, "BEGIN OF UNKNOWN QUERY");
+    require(!isQueryActive(query), "BEGIN OF AN ACTIVE QUERY");
+    GLuint& active = activeQuery(target);
+    require(active == 0, "QUERY BEGUN WHILE ANOTHER IS ACTIVE");
+    active = query;
+}
+
+void Renderer::NullDevice::endQuery(GLenum target)
+{
+    count(DeviceCall::QUERY);
+    GLuint& active = activeQuery(target);
+    require(active != 0, "END OF A QUERY THAT WAS NOT BEGUN");
+    active = 0;
+}
+
+bool Renderer::NullDevice::getQueryResult(GLuint query, GLuint64& result)
+{
+    count(DeviceCall::QUERY);
+    require(queries_.count(query) != 0, "RESULT OF UNKNOWN QUERY");
+    require(!isQueryActive(query), "RESULT OF AN ACTIVE QUERY");
+
+    // Nothing is executed, so every result is available and zero
+    result = 0;
+    return true;
+}
+
+GLuint Renderer::NullDevice::createFence()
+{
+    count(DeviceCall::QUERY);
+    const GLuint fence = nextName(NameSpace::FENCE);
+    fences_.insert(fence);
+    return fence;
+}
+
+bool Renderer::NullDevice::isFenceSignaled(GLuint fence)
+{
+    count(DeviceCall::QUERY);
+    require(fences_.count(fence) != 0, "WAIT ON UNKNOWN FENCE");
+
+    // Nothing is executed, so every fence is passed at once
+    return true;
+}
+
+void Renderer::NullDevice::deleteFence(GLuint fence)
+{
+    count(DeviceCall::QUERY);
+    require(fences_.erase(fence) != 0, "DELETE OF UNKNOWN FENCE");
+}
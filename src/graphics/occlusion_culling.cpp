@@ -0,0 +1,203 @@
+#include "occlusion_culling.hpp"
+#include <algorithm>
+
+namespace
+{
+    // Divides and rounds up, for work group counts
+    GLuint divideRoundingUp(GLsizei value, GLuint divisor)
+    {
+        return (static_cast<GLuint>(value) + divisor - 1) / divisor;
+    }
+}
+
+std::vector<Renderer::DrawCommand> Renderer::drawAllCommands(
+    GLsizei objectCount, GLsizei vertexCount)
+{
+    std::vector<DrawCommand> commands(static_cast<std::size_t>(objectCount));
+    for (std::size_t i = 0; i < commands.size(); ++i)
+    {
+        commands[i] = DrawCommand{ static_cast<GLuint>(vertexCount), 1, 0,
+            static_cast<GLuint>(i) };
+    }
+    return commands;
+}
+
+Renderer::OcclusionCuller::OcclusionCuller(Device& device,
+    ShaderLibrary& shaders, const std::vector<ObjectBounds>& bounds,
+    GLsizei vertexCount, GLsizei width, GLsizei height) : device_{ device },
+    objectCount_{ static_cast<GLsizei>(bounds.size()) },
+    vertexCount_{ vertexCount }, width_{ width }, height_{ height },
+    shaders_{ shaders }, boundsBuffer_{ 0 }, commandBuffers_{}, current_{ 0 },
+    depthFramebuffer_{ 0 }, depthTexture_{ 0 }, pyramidTexture_{ 0 }
+{
+    // Compile the occluder variant now rather than in the first frame
+    shaders_.get(OcclusionConstants::OCCLUDER_FEATURES);
+    ComputeShader pyramidShader(device_, Env::HIZ_COMPUTE_SHADER_PATH);
+    pyramidProgram_ = std::make_unique<ShaderProgram>(device_,
+        pyramidShader.getShaderID());
+    ComputeShader cullShader(device_, Env::CULL_COMPUTE_SHADER_PATH);
+    cullProgram_ = std::make_unique<ShaderProgram>(device_,
+        cullShader.getShaderID());
+
+    boundsBuffer_ = device_.createBuffer();
+    device_.bindBuffer(GL_SHADER_STORAGE_BUFFER, boundsBuffer_);
+    device_.bufferData(GL_SHADER_STORAGE_BUFFER,
+        static_cast<GLsizeiptr>(bounds.size() * sizeof(ObjectBounds)),
+        bounds.data(), GL_STATIC_DRAW);
+    device_.bindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // Nothing was drawn before the first frame, so everything occludes
+    const std::vector<DrawCommand> commands =
+        drawAllCommands(objectCount_, vertexCount_);
+    for (GLuint& buffer : commandBuffers_)
+    {
+        buffer = device_.createBuffer();
+        device_.bindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+        device_.bufferData(GL_DRAW_INDIRECT_BUFFER,
+            static_cast<GLsizeiptr>(commands.size() * sizeof(DrawCommand)),
+            commands.data(), GL_DYNAMIC_DRAW);
+    }
+    device_.bindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    depthFramebuffer_ = device_.createFramebuffer();
+    depthTexture_ = device_.createTexture();
+    pyramidTexture_ = device_.createTexture();
+    allocate();
+}
+
+Renderer::OcclusionCuller::~OcclusionCuller()
+{
+    device_.deleteBuffer(boundsBuffer_);
+    for (const GLuint buffer : commandBuffers_)
+    {
+        device_.deleteBuffer(buffer);
+    }
+    device_.deleteFramebuffer(depthFramebuffer_);
+    device_.deleteTexture(depthTexture_);
+    device_.deleteTexture(pyramidTexture_);
+}
+
+void Renderer::OcclusionCuller::resize(GLsizei width, GLsizei height)
+{
+    width_ = width;
+    height_ = height;
+    allocate();
+}
+
+void Renderer::OcclusionCuller::allocate()
+{
+    // The depth target of the occluder pass, read with texelFetch only
+    device_.activeTexture(GL_TEXTURE0);
+    device_.bindTexture(GL_TEXTURE_2D, depthTexture_);
+    device_.texParameter(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    device_.texParameter(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    device_.texImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, width_,
+        height_, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+
+    // Halve the size down to a single texel, rounding up so that every
+    // depth texel is covered
+    levelSizes_.clear();
+    GLsizei levelWidth = width_;
+    GLsizei levelHeight = height_;
+    do
+    {
+        levelWidth = std::max<GLsizei>(1, (levelWidth + 1) / 2);
+        levelHeight = std::max<GLsizei>(1, (levelHeight + 1) / 2);
+        levelSizes_.emplace_back(levelWidth, levelHeight);
+    } while (levelWidth > 1 || levelHeight > 1);
+
+    device_.bindTexture(GL_TEXTURE_2D, pyramidTexture_);
+    device_.texParameter(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+        GL_NEAREST_MIPMAP_NEAREST);
+    device_.texParameter(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    device_.texParameter(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+        static_cast<GLint>(levelSizes_.size() - 1));
+    for (std::size_t level = 0; level < levelSizes_.size(); ++level)
+    {
+        device_.texImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), GL_R32F,
+            levelSizes_[level].first, levelSizes_[level].second, GL_RED,
+            GL_FLOAT, nullptr);
+    }
+    device_.bindTexture(GL_TEXTURE_2D, 0);
+
+    device_.bindFramebuffer(GL_FRAMEBUFFER, depthFramebuffer_);
+    device_.framebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+        depthTexture_, 0);
+    const GLenum status = device_.checkFramebufferStatus(GL_FRAMEBUFFER);
+    device_.bindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        throw std::runtime_error(
+            "ERROR::OCCLUSION_CULLING::FRAMEBUFFER INCOMPLETE");
+    }
+}
+
+void Renderer::OcclusionCuller::cull(GLuint vertexArray,
+    const glm::mat4& view, const glm::mat4& projection)
+{
+    const std::size_t previous = current_;
+    current_ = 1 - current_;
+
+    // Draw last frame's visible objects depth only, from this frame's view
+    device_.bindFramebuffer(GL_FRAMEBUFFER, depthFramebuffer_);
+    device_.viewport(0, 0, width_, height_);
+    device_.clear(GL_DEPTH_BUFFER_BIT);
+    const ShaderProgram& occluderProgram =
+        shaders_.get(OcclusionConstants::OCCLUDER_FEATURES);
+    device_.useProgram(occluderProgram.getProgramID());
+    occluderProgram.setUniform("view", view);
+    occluderProgram.setUniform("projection", projection);
+    device_.bindVertexArray(vertexArray);
+    device_.bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffers_[previous]);
+    device_.multiDrawArraysIndirect(GL_TRIANGLES, 0, objectCount_, 0);
+    device_.bindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    buildPyramid();
+
+    // Test every object and write this frame's commands
+    device_.useProgram(cullProgram_->getProgramID());
+    device_.activeTexture(GL_TEXTURE0);
+    device_.bindTexture(GL_TEXTURE_2D, pyramidTexture_);
+    cullProgram_->setUniform("pyramid", 0);
+    cullProgram_->setUniform("levelCount",
+        static_cast<int>(levelSizes_.size()));
+    cullProgram_->setUniform("depthWidth", static_cast<int>(width_));
+    cullProgram_->setUniform("depthHeight", static_cast<int>(height_));
+    cullProgram_->setUniform("objectCount", static_cast<int>(objectCount_));
+    cullProgram_->setUniform("vertexCount", static_cast<int>(vertexCount_));
+    cullProgram_->setUniform("viewProjection", projection * view);
+    device_.bindBufferBase(GL_SHADER_STORAGE_BUFFER,
+        OcclusionConstants::BOUNDS_BINDING, boundsBuffer_);
+    device_.bindBufferBase(GL_SHADER_STORAGE_BUFFER,
+        OcclusionConstants::COMMANDS_BINDING, commandBuffers_[current_]);
+    // The render graph places the barrier before the indirect draws that
+    // read the commands
+    device_.dispatchCompute(divideRoundingUp(objectCount_,
+        OcclusionConstants::CULL_GROUP_SIZE), 1, 1);
+}
+
+void Renderer::OcclusionCuller::buildPyramid()
+{
+    device_.useProgram(pyramidProgram_->getProgramID());
+    device_.activeTexture(GL_TEXTURE0);
+    pyramidProgram_->setUniform("source", 0);
+    for (std::size_t level = 0; level < levelSizes_.size(); ++level)
+    {
+        // Level 0 reduces the depth target, every other level the one below
+        device_.bindTexture(GL_TEXTURE_2D,
+            level == 0 ? depthTexture_ : pyramidTexture_);
+        pyramidProgram_->setUniform("sourceLevel",
+            level == 0 ? 0 : static_cast<int>(level) - 1);
+        device_.bindImageTexture(OcclusionConstants::PYRAMID_IMAGE_UNIT,
+            pyramidTexture_, static_cast<GLint>(level), GL_WRITE_ONLY,
+            GL_R32F);
+        device_.dispatchCompute(
+            divideRoundingUp(levelSizes_[level].first,
+                OcclusionConstants::PYRAMID_GROUP_SIZE),
+            divideRoundingUp(levelSizes_[level].second,
+                OcclusionConstants::PYRAMID_GROUP_SIZE), 1);
+
+        // The next level and the culling read this level with texelFetch
+        device_.memoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+}
@@ -0,0 +1,59 @@
+#include "overdraw_heatmap.hpp"
+
+Renderer::OverdrawHeatmap::OverdrawHeatmap(Device& device, float maxLayers) :
+    device_{ device }, program_{ nullptr }, vertexArray_{ 0 },
+    maxLayers_{ maxLayers }
+{
+    // The full screen triangle of the bake covers the window as well
+    VertexShader vertexShader(device_, Env::BAKE_VERTEX_SHADER_PATH);
+    FragmentShader fragShader(device_, Env::HEATMAP_FRAG_SHADER_PATH);
+    program_ = std::make_unique<ShaderProgram>(device_,
+        vertexShader.getShaderID(), fragShader.getShaderID());
+
+    vertexArray_ = device_.createVertexArray();
+}
+
+Renderer::OverdrawHeatmap::~OverdrawHeatmap()
+{
+    device_.deleteVertexArray(vertexArray_);
+}
+
+Renderer::TargetDesc Renderer::OverdrawHeatmap::getTargetDesc(GLsizei width,
+    GLsizei height)
+{
+    // Read back texel by texel, see heatmap.fs
+    return { TargetType::TEXTURE, OverdrawConstants::COUNT_FORMAT, width,
+        height, 0 };
+}
+
+void Renderer::OverdrawHeatmap::begin()
+{
+    device_.clearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    device_.clear(GL_COLOR_BUFFER_BIT);
+    device_.clearColor(GlConstants::CLEAR_COLOR_RED,
+        GlConstants::CLEAR_COLOR_GREEN, GlConstants::CLEAR_COLOR_BLUE,
+        GlConstants::CLEAR_COLOR_OPACITY);
+
+    // Every fragment adds one, whether or not it ends up visible
+    device_.disable(GL_DEPTH_TEST);
+    device_.enable(GL_BLEND);
+    device_.blendFunc(GL_ONE, GL_ONE);
+}
+
+void Renderer::OverdrawHeatmap::end()
+{
+    device_.disable(GL_BLEND);
+}
+
+void Renderer::OverdrawHeatmap::draw(GLuint counts)
+{
+    device_.bindFramebuffer(GL_FRAMEBUFFER, 0);
+    device_.useProgram(program_->getProgramID());
+    device_.activeTexture(GlConstants::DEFAULT_TEXTURE);
+    device_.bindTexture(GL_TEXTURE_2D, counts);
+    program_->setUniform("counts", GlConstants::DEFAULT_TEXTURE_UNIT);
+    program_->setUniform("maxLayers", maxLayers_);
+    device_.bindVertexArray(vertexArray_);
+    device_.drawArrays(GL_TRIANGLES, 0, 3);
+    device_.enable(GL_DEPTH_TEST);
+}
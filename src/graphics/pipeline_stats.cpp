@@ -0,0 +1,216 @@
+#include "pipeline_stats.hpp"
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    // The query target and the column name of every PipelineStat, in the
+    // order of the enum
+    constexpr GLenum STAT_TARGETS[] = {
+        GL_VERTICES_SUBMITTED,
+        GL_PRIMITIVES_SUBMITTED,
+        GL_VERTEX_SHADER_INVOCATIONS,
+        GL_CLIPPING_INPUT_PRIMITIVES,
+        GL_CLIPPING_OUTPUT_PRIMITIVES,
+        GL_FRAGMENT_SHADER_INVOCATIONS,
+    };
+    constexpr const char* STAT_NAMES[] = {
+        "vertices_submitted",
+        "primitives_submitted",
+        "vertex_invocations",
+        "clipping_input",
+        "clipping_output",
+        "fragment_invocations",
+    };
+    constexpr std::size_t STAT_COUNT =
+        static_cast<std::size_t>(Renderer::PipelineStat::COUNT);
+    static_assert(std::size(STAT_TARGETS) == STAT_COUNT &&
+        std::size(STAT_NAMES) == STAT_COUNT,
+        "Every pipeline statistic needs a target and a name");
+    // The collected bits of a complete set
+    constexpr std::uint32_t ALL_COLLECTED = (1u << STAT_COUNT) - 1;
+}
+
+const char* Renderer::toString(PipelineStat stat)
+{
+    return STAT_NAMES[static_cast<std::size_t>(stat)];
+}
+
+Renderer::PipelineStatistics::PipelineStatistics(Device& device,
+    std::size_t size) : device_{ device }, sets_(size), next_{ 0 },
+    oldest_{ 0 }, pending_{ 0 }, passes_{ 0 }, measuring_{ false }
+{
+    for (QuerySet& set : sets_)
+    {
+        for (GLuint& query : set.queries)
+        {
+            query = device_.createQuery();
+        }
+    }
+}
+
+Renderer::PipelineStatistics::~PipelineStatistics()
+{
+    if (measuring_)
+    {
+        end();
+    }
+    for (const QuerySet& set : sets_)
+    {
+        for (const GLuint query : set.queries)
+        {
+            device_.deleteQuery(query);
+        }
+    }
+}
+
+void Renderer::PipelineStatistics::begin()
+{
+    const std::uint64_t index = passes_++;
+    // Skip the pass rather than reuse queries the GPU has not finished
+    if (pending_ == sets_.size())
+    {
+        return;
+    }
+    QuerySet& set = sets_[next_];
+    set.collected = 0;
+    set.sample = PipelineSample();
+    set.sample.index = index;
+    // Queries of different targets may be active at the same time
+    for (std::size_t stat = 0; stat < STAT_COUNT; ++stat)
+    {
+        device_.beginQuery(STAT_TARGETS[stat], set.queries[stat]);
+    }
+    measuring_ = true;
+}
+
+void Renderer::PipelineStatistics::end()
+{
+    if (!measuring_)
+    {
+        return;
+    }
+    for (std::size_t stat = 0; stat < STAT_COUNT; ++stat)
+    {
+        device_.endQuery(STAT_TARGETS[stat]);
+    }
+    measuring_ = false;
+    next_ = (next_ + 1) % sets_.size();
+    ++pending_;
+}
+
+std::optional<Renderer::PipelineSample>
+Renderer::PipelineStatistics::collect()
+{
+    if (pending_ == 0)
+    {
+        return std::nullopt;
+    }
+    QuerySet& set = sets_[oldest_];
+    for (std::size_t stat = 0; stat < STAT_COUNT; ++stat)
+    {
+        const std::uint32_t bit = 1u << stat;
+        if ((set.collected & bit) == 0 &&
+            device_.getQueryResult(set.queries[stat], set.sample.values[stat]))
+        {
+            set.collected |= bit;
+        }
+    }
+    if (set.collected != ALL_COLLECTED)
+    {
+        return std::nullopt;
+    }
+    oldest_ = (oldest_ + 1) % sets_.size();
+    --pending_;
+    return set.sample;
+}
+
+Renderer::PipelineStatsLog::PipelineStatsLog(const std::string& csvPath) :
+    csv_(), samples_{ 0 }, sums_{}, fragmentsPerPixelSum_{ 0.0 }, last_(),
+    lastFragmentsPerPixel_{ 0.0 }
+{
+    if (csvPath.empty())
+    {
+        return;
+    }
+    csv_.open(csvPath);
+    if (!csv_)
+    {
+        throw std::runtime_error("ERROR::PIPELINE_STATS::CANNOT WRITE " +
+            csvPath);
+    }
+    csv_ << "pass";
+    for (const char* name : STAT_NAMES)
+    {
+        csv_ << ',' << name;
+    }
+    csv_ << ",pixels,fragments_per_pixel\n";
+}
+
+void Renderer::PipelineStatsLog::add(const PipelineSample& sample,
+    std::uint64_t pixels)
+{
+    const double fragmentsPerPixel = pixels == 0 ? 0.0 :
+        static_cast<double>(sample.get(PipelineStat::FRAGMENT_INVOCATIONS)) /
+        static_cast<double>(pixels);
+    for (std::size_t stat = 0; stat < STAT_COUNT; ++stat)
+    {
+        sums_[stat] += static_cast<double>(sample.values[stat]);
+    }
+    fragmentsPerPixelSum_ += fragmentsPerPixel;
+    last_ = sample;
+    lastFragmentsPerPixel_ = fragmentsPerPixel;
+    ++samples_;
+
+    if (csv_.is_open())
+    {
+        csv_ << sample.index;
+        for (const GLuint64 value : sample.values)
+        {
+            csv_ << ',' << value;
+        }
+        csv_ << ',' << pixels << ',' << fragmentsPerPixel << '\n';
+    }
+}
+
+std::string Renderer::PipelineStatsLog::getSummary() const
+{
+    std::ostringstream summary;
+    summary << "Pipeline statistics: ";
+    if (samples_ == 0)
+    {
+        summary << "no pass measured\n";
+        return summary.str();
+    }
+    const auto average = [this](PipelineStat stat)
+    {
+        return sums_[static_cast<std::size_t>(stat)] /
+            static_cast<double>(samples_);
+    };
+    summary << average(PipelineStat::VERTICES_SUBMITTED)
+        << " vertices submitted, "
+        << average(PipelineStat::VERTEX_INVOCATIONS)
+        << " vertex shader invocations, "
+        << average(PipelineStat::CLIPPING_OUTPUT) << " of "
+        << average(PipelineStat::CLIPPING_INPUT)
+        << " primitives left after clipping, "
+        << average(PipelineStat::FRAGMENT_INVOCATIONS)
+        << " fragment shader invocations ("
+        << fragmentsPerPixelSum_ / static_cast<double>(samples_)
+        << " per pixel) per frame over " << samples_ << " frames\n";
+    return summary.str();
+}
+
+std::string Renderer::PipelineStatsLog::getOverlayText() const
+{
+    std::ostringstream text;
+    text.precision(3);
+    text << last_.get(PipelineStat::FRAGMENT_INVOCATIONS) << " fragments ("
+        << lastFragmentsPerPixel_ << "/px), "
+        << last_.get(PipelineStat::VERTEX_INVOCATIONS) << " vertices, "
+        << last_.get(PipelineStat::CLIPPING_OUTPUT) << '/'
+        << last_.get(PipelineStat::CLIPPING_INPUT)
+        << " primitives after clipping";
+    return text.str();
+}
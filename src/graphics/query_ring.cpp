@@ -0,0 +1,59 @@
+#include "query_ring.hpp"
+
+Renderer::QueryRing::QueryRing(Device& device, GLenum target,
+    std::size_t size) : device_{ device }, target_{ target },
+    queries_(size), next_{ 0 }, oldest_{ 0 }, pending_{ 0 },
+    measuring_{ false }
+{
+    for (GLuint& query : queries_)
+    {
+        query = device_.createQuery();
+    }
+}
+
+Renderer::QueryRing::~QueryRing()
+{
+    if (measuring_)
+    {
+        end();
+    }
+    for (const GLuint query : queries_)
+    {
+        device_.deleteQuery(query);
+    }
+}
+
+void Renderer::QueryRing::begin()
+{
+    // Skip the span rather than reuse a query the GPU has not finished
+    if (pending_ == queries_.size())
+    {
+        return;
+    }
+    device_.beginQuery(target_, queries_[next_]);
+    measuring_ = true;
+}
+
+void Renderer::QueryRing::end()
+{
+    if (!measuring_)
+    {
+        return;
+    }
+    device_.endQuery(target_);
+    measuring_ = false;
+    next_ = (next_ + 1) % queries_.size();
+    ++pending_;
+}
+
+std::optional<GLuint64> Renderer::QueryRing::collect()
+{
+    GLuint64 result = 0;
+    if (pending_ == 0 || !device_.getQueryResult(queries_[oldest_], result))
+    {
+        return std::nullopt;
+    }
+    oldest_ = (oldest_ + 1) % queries_.size();
+    --pending_;
+    return result;
+}
@@ -0,0 +1,607 @@
+#include "render_graph.hpp"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    /**
+     * @struct TargetFormat
+     * @brief How a target format is specified and what a texel costs.
+     */
+    struct TargetFormat
+    {
+        GLenum internalFormat;
+        GLenum format;
+        GLenum type;
+        std::uint64_t bytesPerTexel;
+        bool depth;
+    };
+
+    constexpr TargetFormat TARGET_FORMATS[] = {
+        { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, false },
+        { GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 8, false },
+        { GL_R32F, GL_RED, GL_FLOAT, 4, false },
+        { GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 4,
+            true },
+        { GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT, 4, true },
+    };
+
+    const TargetFormat& findFormat(GLenum internalFormat)
+    {
+        for (const TargetFormat& format : TARGET_FORMATS)
+        {
+            if (format.internalFormat == internalFormat)
+            {
+                return format;
+            }
+        }
+        throw std::runtime_error(
+            "ERROR::RENDER_GRAPH::UNSUPPORTED TARGET FORMAT");
+    }
+
+    // The barrier that makes stores visible to a later use
+    GLbitfield barrierFor(Renderer::Access access)
+    {
+        switch (access)
+        {
+        case Renderer::Access::ATTACHMENT:
+            return GL_FRAMEBUFFER_BARRIER_BIT;
+        case Renderer::Access::SAMPLED:
+            return GL_TEXTURE_FETCH_BARRIER_BIT;
+        case Renderer::Access::STORAGE:
+            return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT |
+                GL_SHADER_STORAGE_BARRIER_BIT;
+        case Renderer::Access::INDIRECT:
+            return GL_COMMAND_BARRIER_BIT;
+        }
+        return 0;
+    }
+
+    // The stores of a pass may be used by any later access
+    constexpr GLbitfield ALL_BARRIERS = GL_FRAMEBUFFER_BARRIER_BIT |
+        GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT |
+        GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT;
+
+    std::string toMegabytes(std::uint64_t bytes)
+    {
+        std::ostringstream text;
+        text.precision(3);
+        text << static_cast<double>(bytes) / (1024.0 * 1024.0) << " MiB";
+        return text.str();
+    }
+}
+
+std::uint64_t Renderer::getTargetBytes(const TargetDesc& desc)
+{
+    return static_cast<std::uint64_t>(desc.width) * desc.height *
+        std::max<GLsizei>(desc.samples, 1) *
+        findFormat(desc.format).bytesPerTexel;
+}
+
+Renderer::PassBuilder& Renderer::PassBuilder::read(ResourceId resource,
+    Access access)
+{
+    graph_.addUse(pass_, resource, access, false);
+    return *this;
+}
+
+Renderer::PassBuilder& Renderer::PassBuilder::write(ResourceId resource,
+    Access access)
+{
+    graph_.addUse(pass_, resource, access, true);
+    return *this;
+}
+
+Renderer::PassBuilder& Renderer::PassBuilder::setSideEffect()
+{
+    graph_.passes_[pass_].sideEffect = true;
+    return *this;
+}
+
+GLuint Renderer::PassContext::getTarget(ResourceId target) const
+{
+    return graph_.getTargetOf(target).name;
+}
+
+GLuint Renderer::PassContext::getFramebuffer() const
+{
+    return graph_.getPassFramebuffer(pass_);
+}
+
+GLuint Renderer::PassContext::getFramebuffer(ResourceId target) const
+{
+    const RenderGraph::Target& object = graph_.getTargetOf(target);
+    return findFormat(object.desc.format).depth ?
+        graph_.getFramebuffer(0, object.name) :
+        graph_.getFramebuffer(object.name, 0);
+}
+
+Renderer::RenderGraph::RenderGraph(Device& device, FrameArena& arena) :
+    device_{ device }, arena_{ arena },
+    resources_(ArenaAllocator<Resource>(arena)),
+    uses_(ArenaAllocator<Use>(arena)), passes_(ArenaAllocator<Pass>(arena)),
+    required_(ArenaAllocator<bool>(arena)),
+    pendingBarriers_(ArenaAllocator<GLbitfield>(arena)),
+    byFirstPass_(ArenaAllocator<ResourceId>(arena)), targets_(),
+    framebuffers_(), stats_()
+{
+}
+
+Renderer::RenderGraph::~RenderGraph()
+{
+    for (const Framebuffer& framebuffer : framebuffers_)
+    {
+        device_.deleteFramebuffer(framebuffer.name);
+    }
+    for (const Target& target : targets_)
+    {
+        if (target.desc.type == TargetType::TEXTURE)
+        {
+            device_.deleteTexture(target.name);
+        }
+        else
+        {
+            device_.deleteRenderbuffer(target.name);
+        }
+    }
+}
+
+Renderer::ResourceId Renderer::RenderGraph::createTarget(const char* name,
+    const TargetDesc& desc)
+{
+    // Checks the format while the declaring code is on the stack
+    findFormat(desc.format);
+    resources_.push_back({ name, false, false, desc, false, 0, 0,
+        NO_TARGET });
+    return static_cast<ResourceId>(resources_.size() - 1);
+}
+
+Renderer::ResourceId Renderer::RenderGraph::importResource(const char* name,
+    bool output)
+{
+    resources_.push_back({ name, true, output, TargetDesc(), false, 0, 0,
+        NO_TARGET });
+    return static_cast<ResourceId>(resources_.size() - 1);
+}
+
+Renderer::PassBuilder Renderer::RenderGraph::addPass(const char* name,
+    PassFunction execute)
+{
+    passes_.push_back({ name, std::move(execute), uses_.size(), 0, false,
+        false, 0 });
+    return PassBuilder(*this, passes_.size() - 1);
+}
+
+void Renderer::RenderGraph::addUse(std::size_t pass, ResourceId resource,
+    Access access, bool write)
+{
+    // The uses of a pass are kept contiguous
+    if (pass + 1 != passes_.size())
+    {
+        throw std::logic_error(
+            "ERROR::RENDER_GRAPH::PASS DECLARED AFTER THE NEXT ONE");
+    }
+    if (resource >= resources_.size())
+    {
+        throw std::logic_error("ERROR::RENDER_GRAPH::UNKNOWN RESOURCE");
+    }
+    uses_.push_back({ resource, access, write });
+    ++passes_[pass].useCount;
+}
+
+void Renderer::RenderGraph::execute()
+{
+    try
+    {
+        cull();
+        schedule();
+        allocate();
+        for (std::size_t pass = 0; pass < passes_.size(); ++pass)
+        {
+            if (passes_[pass].culled)
+            {
+                continue;
+            }
+            if (passes_[pass].barriers != 0)
+            {
+                device_.memoryBarrier(passes_[pass].barriers);
+            }
+            passes_[pass].execute(PassContext(*this, pass));
+        }
+        releaseIdle();
+    }
+    catch (...)
+    {
+        clear();
+        throw;
+    }
+    clear();
+}
+
+void Renderer::RenderGraph::prepare()
+{
+    try
+    {
+        cull();
+        schedule();
+        allocate();
+        for (std::size_t pass = 0; pass < passes_.size(); ++pass)
+        {
+            if (passes_[pass].culled)
+            {
+                continue;
+            }
+            // The framebuffers a pass draws into and blits from
+            getPassFramebuffer(pass);
+            const Pass& current = passes_[pass];
+            for (std::size_t use = current.firstUse;
+                use < current.firstUse + current.useCount; ++use)
+            {
+                if (!uses_[use].write &&
+                    uses_[use].access == Access::ATTACHMENT &&
+                    !resources_[uses_[use].resource].imported)
+                {
+                    PassContext(*this, pass).getFramebuffer(
+                        uses_[use].resource);
+                }
+            }
+        }
+    }
+    catch (...)
+    {
+        clear();
+        throw;
+    }
+    clear();
+}
+
+void Renderer::RenderGraph::cull()
+{
+    // Walk back from the passes writing the outputs, keeping whatever wrote
+    // what a kept pass reads
+    required_.assign(resources_.size(), false);
+    stats_.culledPasses = 0;
+    for (std::size_t pass = passes_.size(); pass-- > 0;)
+    {
+        Pass& current = passes_[pass];
+        bool needed = current.sideEffect;
+        for (std::size_t use = current.firstUse;
+            use < current.firstUse + current.useCount; ++use)
+        {
+            const Resource& resource = resources_[uses_[use].resource];
+            needed = needed || (uses_[use].write &&
+                (resource.output || required_[uses_[use].resource]));
+        }
+        current.culled = !needed;
+        if (!needed)
+        {
+            ++stats_.culledPasses;
+            continue;
+        }
+        for (std::size_t use = current.firstUse;
+            use < current.firstUse + current.useCount; ++use)
+        {
+            if (!uses_[use].write)
+            {
+                required_[uses_[use].resource] = true;
+            }
+        }
+    }
+}
+
+void Renderer::RenderGraph::schedule()
+{
+    // required_ now marks the transient resources written so far
+    required_.assign(resources_.size(), false);
+    pendingBarriers_.assign(resources_.size(), 0);
+    stats_.barriers = 0;
+    for (std::size_t pass = 0; pass < passes_.size(); ++pass)
+    {
+        Pass& current = passes_[pass];
+        if (current.culled)
+        {
+            continue;
+        }
+        for (std::size_t use = current.firstUse;
+            use < current.firstUse + current.useCount; ++use)
+        {
+            const ResourceId id = uses_[use].resource;
+            Resource& resource = resources_[id];
+            if (!resource.imported && !uses_[use].write && !required_[id])
+            {
+                throw std::runtime_error(std::string(
+                    "ERROR::RENDER_GRAPH::") + resource.name +
+                    " READ BY " + current.name + " BEFORE IT IS WRITTEN");
+            }
+            if (!resource.used)
+            {
+                resource.used = true;
+                resource.firstPass = pass;
+            }
+            resource.lastPass = pass;
+
+            const GLbitfield needed = pendingBarriers_[id] &
+                barrierFor(uses_[use].access);
+            current.barriers |= needed;
+            pendingBarriers_[id] &= ~needed;
+        }
+        // Writes take effect after the pass, its own reads do not wait
+        for (std::size_t use = current.firstUse;
+            use < current.firstUse + current.useCount; ++use)
+        {
+            if (!uses_[use].write)
+            {
+                continue;
+            }
+            required_[uses_[use].resource] = true;
+            pendingBarriers_[uses_[use].resource] =
+                uses_[use].access == Access::STORAGE ? ALL_BARRIERS : 0;
+        }
+        if (current.barriers != 0)
+        {
+            ++stats_.barriers;
+        }
+    }
+}
+
+void Renderer::RenderGraph::allocate()
+{
+    ++stats_.frames;
+    byFirstPass_.clear();
+    for (ResourceId id = 0; id < resources_.size(); ++id)
+    {
+        if (resources_[id].used && !resources_[id].imported)
+        {
+            byFirstPass_.push_back(id);
+        }
+    }
+    // Sorted in place, a stable sort would allocate from the heap
+    std::sort(byFirstPass_.begin(), byFirstPass_.end(),
+        [this](ResourceId lhs, ResourceId rhs) {
+            return resources_[lhs].firstPass != resources_[rhs].firstPass ?
+                resources_[lhs].firstPass < resources_[rhs].firstPass :
+                lhs < rhs; });
+
+    // Every target starts the frame free
+    for (Target& target : targets_)
+    {
+        target.freeFrom = 0;
+    }
+    stats_.targets = byFirstPass_.size();
+    stats_.transientBytes = 0;
+    stats_.aliasedBytes = 0;
+    stats_.physicalTargets = 0;
+    for (const ResourceId id : byFirstPass_)
+    {
+        Resource& resource = resources_[id];
+        stats_.transientBytes += getTargetBytes(resource.desc);
+
+        // Share a target whose last user ran before this one's first
+        std::size_t chosen = NO_TARGET;
+        for (std::size_t target = 0; target < targets_.size(); ++target)
+        {
+            if (targets_[target].desc == resource.desc &&
+                targets_[target].freeFrom <= resource.firstPass)
+            {
+                chosen = target;
+                break;
+            }
+        }
+        if (chosen == NO_TARGET)
+        {
+            targets_.push_back({ resource.desc,
+                createTargetObject(resource.desc), 0, 0 });
+            chosen = targets_.size() - 1;
+        }
+        Target& target = targets_[chosen];
+        if (target.lastFrame != stats_.frames)
+        {
+            target.lastFrame = stats_.frames;
+            stats_.aliasedBytes += getTargetBytes(target.desc);
+            ++stats_.physicalTargets;
+        }
+        target.freeFrom = resource.lastPass + 1;
+        resource.target = chosen;
+    }
+    stats_.passes = passes_.size() - stats_.culledPasses;
+    stats_.peakTransientBytes = std::max(stats_.peakTransientBytes,
+        stats_.transientBytes);
+    stats_.peakAliasedBytes = std::max(stats_.peakAliasedBytes,
+        stats_.aliasedBytes);
+}
+
+void Renderer::RenderGraph::releaseIdle()
+{
+    const auto idle = [this](std::uint64_t lastFrame) {
+        return lastFrame + RenderGraphConstants::IDLE_FRAMES < stats_.frames;
+    };
+    for (std::size_t target = targets_.size(); target-- > 0;)
+    {
+        if (!idle(targets_[target].lastFrame))
+        {
+            continue;
+        }
+        const GLuint name = targets_[target].name;
+        for (Framebuffer& framebuffer : framebuffers_)
+        {
+            // A framebuffer of a deleted target is never matched again
+            if (framebuffer.color == name || framebuffer.depth == name)
+            {
+                framebuffer.lastFrame = 0;
+            }
+        }
+        if (targets_[target].desc.type == TargetType::TEXTURE)
+        {
+            device_.deleteTexture(name);
+        }
+        else
+        {
+            device_.deleteRenderbuffer(name);
+        }
+        targets_.erase(targets_.begin() +
+            static_cast<std::ptrdiff_t>(target));
+    }
+    for (std::size_t framebuffer = framebuffers_.size(); framebuffer-- > 0;)
+    {
+        if (idle(framebuffers_[framebuffer].lastFrame))
+        {
+            device_.deleteFramebuffer(framebuffers_[framebuffer].name);
+            framebuffers_.erase(framebuffers_.begin() +
+                static_cast<std::ptrdiff_t>(framebuffer));
+        }
+    }
+}
+
+void Renderer::RenderGraph::clear()
+{
+    // Start over with empty vectors, the arena takes their memory back
+    // when it is reset for the next frame
+    resources_ = FrameVector<Resource>(ArenaAllocator<Resource>(arena_));
+    uses_ = FrameVector<Use>(ArenaAllocator<Use>(arena_));
+    passes_ = FrameVector<Pass>(ArenaAllocator<Pass>(arena_));
+    required_ = std::vector<bool, ArenaAllocator<bool>>(
+        ArenaAllocator<bool>(arena_));
+    pendingBarriers_ = FrameVector<GLbitfield>(
+        ArenaAllocator<GLbitfield>(arena_));
+    byFirstPass_ = FrameVector<ResourceId>(ArenaAllocator<ResourceId>(arena_));
+}
+
+std::string Renderer::RenderGraph::getSummary() const
+{
+    std::ostringstream summary;
+    summary << "Render graph: " << stats_.passes << " passes run, "
+        << stats_.culledPasses << " culled, " << stats_.barriers
+        << " with barriers; " << stats_.targets << " transient targets in "
+        << stats_.physicalTargets << " objects, peak transient memory "
+        << toMegabytes(stats_.peakAliasedBytes) << " aliased, "
+        << toMegabytes(stats_.peakTransientBytes) << " without aliasing\n";
+    return summary.str();
+}
+
+GLuint Renderer::RenderGraph::createTargetObject(const TargetDesc& desc)
+{
+    if (desc.type == TargetType::RENDERBUFFER)
+    {
+        const GLuint renderbuffer = device_.createRenderbuffer();
+        device_.bindRenderbuffer(renderbuffer);
+        device_.renderbufferStorage(desc.samples, desc.format, desc.width,
+            desc.height);
+        device_.bindRenderbuffer(0);
+        return renderbuffer;
+    }
+    if (desc.samples > 0)
+    {
+        throw std::runtime_error(
+            "ERROR::RENDER_GRAPH::MULTISAMPLED TEXTURE TARGET");
+    }
+    const TargetFormat& format = findFormat(desc.format);
+    const GLuint texture = device_.createTexture();
+    device_.bindTexture(GL_TEXTURE_2D, texture);
+    device_.texParameter(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    device_.texParameter(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    device_.texImage2D(GL_TEXTURE_2D, 0,
+        static_cast<GLint>(desc.format), desc.width, desc.height,
+        format.format, format.type, nullptr);
+    device_.bindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+const Renderer::RenderGraph::Target& Renderer::RenderGraph::getTargetOf(
+    ResourceId resource) const
+{
+    if (resource >= resources_.size() ||
+        resources_[resource].target == NO_TARGET)
+    {
+        throw std::logic_error("ERROR::RENDER_GRAPH::NOT A TRANSIENT TARGET");
+    }
+    return targets_[resources_[resource].target];
+}
+
+GLuint Renderer::RenderGraph::getFramebuffer(GLuint color, GLuint depth)
+{
+    for (Framebuffer& framebuffer : framebuffers_)
+    {
+        if (framebuffer.lastFrame != 0 && framebuffer.color == color &&
+            framebuffer.depth == depth)
+        {
+            framebuffer.lastFrame = stats_.frames;
+            return framebuffer.name;
+        }
+    }
+
+    const auto attach = [this](GLenum attachment, GLuint name) {
+        for (const Target& target : targets_)
+        {
+            if (target.name != name)
+            {
+                continue;
+            }
+            if (target.desc.type == TargetType::TEXTURE)
+            {
+                device_.framebufferTexture2D(GL_FRAMEBUFFER, attachment,
+                    name, 0);
+            }
+            else
+            {
+                device_.framebufferRenderbuffer(GL_FRAMEBUFFER, attachment,
+                    name);
+            }
+            return;
+        }
+    };
+    const GLuint name = device_.createFramebuffer();
+    device_.bindFramebuffer(GL_FRAMEBUFFER, name);
+    if (color != 0)
+    {
+        attach(GL_COLOR_ATTACHMENT0, color);
+    }
+    if (depth != 0)
+    {
+        // Only the packed format has a stencil
+        for (const Target& target : targets_)
+        {
+            if (target.name == depth)
+            {
+                attach(target.desc.format == GL_DEPTH24_STENCIL8 ?
+                    GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT, depth);
+                break;
+            }
+        }
+    }
+    const GLenum status = device_.checkFramebufferStatus(GL_FRAMEBUFFER);
+    device_.bindFramebuffer(GL_FRAMEBUFFER, 0);
+    framebuffers_.push_back({ color, depth, name, stats_.frames });
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        throw std::runtime_error(
+            "ERROR::RENDER_GRAPH::FRAMEBUFFER INCOMPLETE");
+    }
+    return name;
+}
+
+GLuint Renderer::RenderGraph::getPassFramebuffer(std::size_t pass)
+{
+    GLuint color = 0;
+    GLuint depth = 0;
+    const Pass& current = passes_[pass];
+    for (std::size_t use = current.firstUse;
+        use < current.firstUse + current.useCount; ++use)
+    {
+        const Resource& resource = resources_[uses_[use].resource];
+        if (!uses_[use].write || uses_[use].access != Access::ATTACHMENT ||
+            resource.imported)
+        {
+            continue;
+        }
+        GLuint& slot = findFormat(resource.desc.format).depth ?
+            depth : color;
+        if (slot != 0)
+        {
+            throw std::runtime_error(std::string("ERROR::RENDER_GRAPH::") +
+                current.name + " WRITES TWO TARGETS OF ONE ATTACHMENT");
+        }
+        slot = targets_[resource.target].name;
+    }
+    return color == 0 && depth == 0 ? 0 : getFramebuffer(color, depth);
+}
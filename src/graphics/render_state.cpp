@@ -0,0 +1,22 @@
+#include "software_renderer.hpp"
+
+std::unique_ptr<Renderer::RenderState> Renderer::createRenderState(
+    BackendType backend, const ResolutionSettings& resolution,
+    const SceneSettings& scene, const DebugLogSettings& debugLog)
+{
+    switch (backend)
+    {
+    case BackendType::SOFTWARE:
+        return std::make_unique<SoftwareRenderer>();
+
+    case BackendType::NULL_DEVICE:
+        return std::make_unique<GL_State>(
+            std::make_unique<MemoryTrackingDevice>(
+                std::make_unique<NullDevice>()), resolution, scene);
+
+    case BackendType::OPENGL:
+        break;
+    }
+    return std::make_unique<GL_State>(std::make_unique<MemoryTrackingDevice>(
+        std::make_unique<GlDevice>(debugLog)), resolution, scene);
+}
@@ -1,37 +1,22 @@
 #include "renderer.hpp"
-
-
-/**
- * @fn MessageCallback
- * @brief Callback function for handling OpenGL debug messages.
- *
- * This function is called whenever an OpenGL debug message is generated.
- *
- * @param source Specifies which part of the OpenGL API the message
- *               originated from.
- * @param type Specifies the type of message, such as error, performance
- *             warning, etc.
- * @param id Specifies the ID of the message.
- * @param severity Specifies the severity level of the message.
- * @param length Specifies the length of the message string.
- * @param message A pointer to the message string.
- * @param userParam A pointer to user-supplied data.
- */
-void GLAPIENTRY MessageCallback
-(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
-    const GLchar* message, const void* userParam)
-{
-    // Mark unused params
-    (void)source;
-    (void)id;
-    (void)userParam;
-    (void)severity;
-    (void)length;
-    void(fprintf(stderr, "GL CALLBACK: %s type = 0x%x, severity = 0x%x, message = %s\n",
-        (type == GL_DEBUG_TYPE_ERROR ? "** GL ERROR **" : ""),
-        type, severity, message));
+#include "baked_material.hpp"
+#include "grid_scene.hpp"
+#include "light_scene.hpp"
+#include "mesh.hpp"
+#include "overdraw_heatmap.hpp"
+#include "pipeline_stats.hpp"
+#include "shader_library.hpp"
+#include <algorithm>
+#include <optional>
+#include <thread>
+
+namespace
+{
+    // How often the statistics in the window title are updated, in ms
+    constexpr std::int32_t OVERLAY_INTERVAL_MS = 500;
 }
 
+
 Renderer::Image::Image(const std::string& imagePath)
 {
     // Load the image from the specified file path
@@ -44,59 +29,112 @@ Renderer::Image::Image(const std::string& imagePath)
         // Throw an exception with an error message if the image cannot be loaded
         throw std::domain_error("ERROR::CANNOT LOAD IMAGE " + imagePath);
     }
+    trackAllocation(MemoryCategory::IMAGE, static_cast<std::uint64_t>(
+        imgWidth_) * imgHeight_ * imgNumberOfChannels_);
+}
+
+Renderer::Image::Image(int width, int height, int channels) :
+    imgWidth_{ width }, imgHeight_{ height },
+    imgNumberOfChannels_{ channels }, img_{ nullptr }
+{
+}
+
+Renderer::Image::Image(Image&& other) noexcept :
+    imgWidth_{ other.imgWidth_ }, imgHeight_{ other.imgHeight_ },
+    imgNumberOfChannels_{ other.imgNumberOfChannels_ }, img_{ other.img_ }
+{
+    // The accounted memory moves along with the pixels
+    other.img_ = nullptr;
 }
 
 Renderer::Image::~Image()
 {
+    releaseData();
+}
+
+void Renderer::Image::releaseData()
+{
+    if (img_ == nullptr)
+    {
+        return;
+    }
+
     // Free the image memory
     stbi_image_free(img_);
     img_ = nullptr;
+    trackRelease(MemoryCategory::IMAGE, static_cast<std::uint64_t>(
+        imgWidth_) * imgHeight_ * imgNumberOfChannels_);
+}
+
+Renderer::Texture::Texture(GpuResources& resources,
+    const std::string& imagePath, bool keepPixels) :
+    Texture(resources, Image(imagePath), keepPixels)
+{
+}
+
+Renderer::Texture::Texture(GpuResources& resources, Image&& image,
+    bool keepPixels) : Image(std::move(image)), resources_{ resources }
+{
+    upload(TextureImage(img_, imgWidth_, imgHeight_, imgNumberOfChannels_,
+        ImageSettings()));
+
+    // The driver copied the pixels, the decoded image is no longer needed
+    if (!keepPixels)
+    {
+        releaseData();
+    }
+}
+
+Renderer::Texture::Texture(GpuResources& resources,
+    const TextureImage& image) :
+    Image(image.getWidth(), image.getHeight(), ImageConstants::CHANNELS),
+    resources_{ resources }
+{
+    upload(image);
 }
 
-Renderer::Texture::Texture(const std::string& imagePath) : Image(imagePath)
+void Renderer::Texture::upload(const TextureImage& image)
 {
-    // Generate a texture ID and store it in texID_
-    glGenTextures(1, &texID_);
+    Device& device = resources_.getDevice();
+    // Take a texture ID from the pool and store its handle in handle_
+    handle_ = resources_.createTexture();
 
     // Bind the texture object to the GL_TEXTURE_2D target
-    glBindTexture(GL_TEXTURE_2D, texID_);
+    device.bindTexture(GL_TEXTURE_2D, resources_.get(handle_));
 
     // Set texture wrapping parameters for the S and T axes
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    device.texParameter(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    device.texParameter(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
     // Set texture filtering parameters for minification and magnification
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    device.texParameter(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    device.texParameter(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-    // Image is RGB (no alpha)
-    if (imgNumberOfChannels_ == 3)
+    // Every level was filtered already, RGBA8 rows need no unpack
+    // alignment other than the default
+    for (int level = 0; level < image.getLevelCount(); ++level)
     {
-        // Specify a 2D texture image using the loaded image data
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, imgWidth_, imgHeight_, 0,
-            GL_RGB, GL_UNSIGNED_BYTE, img_);
+        device.texImage2D(GL_TEXTURE_2D, level, image.getInternalFormat(),
+            image.getLevelWidth(level), image.getLevelHeight(level), GL_RGBA,
+            GL_UNSIGNED_BYTE, image.getLevelData(level));
     }
-    else if (imgNumberOfChannels_ == 4)
-    {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, imgWidth_, imgHeight_, 0,
-            GL_RGBA, GL_UNSIGNED_BYTE, img_);
-    }
-
+}
 
-    // Generate mipmaps for the texture
-    glGenerateMipmap(GL_TEXTURE_2D);
+Renderer::Texture::~Texture()
+{
+    resources_.release(handle_);
 }
 
 unsigned int Renderer::Texture::getTexID() const
 {
-    return texID_;
+    return resources_.get(handle_);
 }
 
 
-Renderer::Shader::Shader(const std::string& sourcePath) : shaderID_{ 0 }
+Renderer::ShaderSource Renderer::loadShaderSource(
+    const std::string& sourcePath)
 {
-    // Declare a string to hold the shader source code
-    std::string shaderCode;
+    ShaderSource source;
 
     // Create an ifstream object to read the shader file
     std::ifstream shaderFile;
@@ -119,7 +157,7 @@ Renderer::Shader::Shader(const std::string& sourcePath) : shaderID_{ 0 }
         shaderFile.close();
 
         // Convert the shader source code string to a C-style string
-        shaderSource_ = shaderStream.str();
+        source.code = shaderStream.str();
 
     }
     catch (const std::ifstream::failure& e)
@@ -127,28 +165,39 @@ Renderer::Shader::Shader(const std::string& sourcePath) : shaderID_{ 0 }
         throw std::domain_error(std::string("ERROR::CANNOT OPEN::") +
             sourcePath + " " + e.what());
     }
+    return source;
+}
+
+Renderer::Shader::Shader(Device& device, const std::string& sourcePath) :
+    Shader(device, loadShaderSource(sourcePath))
+{
+}
+
+Renderer::Shader::Shader(Device& device, ShaderSource source) :
+    device_{ device }, shaderSource_{ std::move(source.code) }, shaderID_{ 0 }
+{
+    trackAllocation(MemoryCategory::SHADER_SOURCE, shaderSource_.size());
+}
+
+Renderer::Shader::~Shader()
+{
+    trackRelease(MemoryCategory::SHADER_SOURCE, shaderSource_.size());
 }
 
 void Renderer::Shader::generateID(GLenum shaderType)
 {
-    shaderID_ = glCreateShader(shaderType);
+    shaderID_ = device_.createShader(shaderType);
 }
 
 void Renderer::Shader::checkShaderCompilation(const std::string& shaderType) const
 {
-    // Variable to store the compilation status
-    int success;
-
     // Buffer to store the error log if compilation fails
+    std::string infoLog;
 
-    // Get the compilation status of the shader
-    glGetShaderiv(shaderID_, GL_COMPILE_STATUS, &success);
-
-    // If compilation failed, retrieve and throw the error log
-    if (!success)
+    // Get the compilation status of the shader and, if compilation failed,
+    // throw the error log
+    if (!device_.getCompileStatus(shaderID_, infoLog))
     {
-	    char infoLog[512];
-	    glGetShaderInfoLog(shaderID_, 512, NULL, infoLog);
         throw std::runtime_error(std::string("ERROR::SHADER::") + shaderType +
             std::string("::COMPILATION_FAILED\n ")
             + infoLog);
@@ -158,18 +207,22 @@ void Renderer::Shader::checkShaderCompilation(const std::string& shaderType) con
 // Compiles the shader source code into a shader object
 void Renderer::Shader::compileShader() const
 {
-    // Convert the shader source code to a C-style string
-    const GLchar* source = shaderSource_.c_str();
-
     // Set the source code for the shader object
-    glShaderSource(shaderID_, 1, &source, NULL);
+    device_.shaderSource(shaderID_, shaderSource_);
 
     // Compile the shader object
-    glCompileShader(shaderID_);
+    device_.compileShader(shaderID_);
 }
 
 // Constructor for VertexShader, initializes a vertex shader
-Renderer::VertexShader::VertexShader() : Shader(Env::VERTEX_SHADER_PATH)
+Renderer::VertexShader::VertexShader(Device& device,
+    const std::string& sourcePath) :
+    VertexShader(device, loadShaderSource(sourcePath))
+{
+}
+
+Renderer::VertexShader::VertexShader(Device& device, ShaderSource source) :
+    Shader(device, std::move(source))
 {
     // Generate a shader ID for a vertex shader
     generateID(GL_VERTEX_SHADER);
@@ -182,7 +235,14 @@ Renderer::VertexShader::VertexShader() : Shader(Env::VERTEX_SHADER_PATH)
 }
 
 // Constructor for FragmentShader, initializes a fragment shader
-Renderer::FragmentShader::FragmentShader() : Shader(Env::FRAG_SHADER_PATH)
+Renderer::FragmentShader::FragmentShader(Device& device,
+    const std::string& sourcePath) :
+    FragmentShader(device, loadShaderSource(sourcePath))
+{
+}
+
+Renderer::FragmentShader::FragmentShader(Device& device,
+    ShaderSource source) : Shader(device, std::move(source))
 {
     // Generate a shader ID for a fragment shader
     generateID(GL_FRAGMENT_SHADER);
@@ -194,159 +254,725 @@ Renderer::FragmentShader::FragmentShader() : Shader(Env::FRAG_SHADER_PATH)
     checkShaderCompilation("FRAGMENT");
 }
 
+// Constructor for ComputeShader, initializes a compute shader
+Renderer::ComputeShader::ComputeShader(Device& device,
+    const std::string& sourcePath) : Shader(device, sourcePath)
+{
+    generateID(GL_COMPUTE_SHADER);
+    compileShader();
+    checkShaderCompilation("COMPUTE");
+}
+
 // Constructor for ShaderProgram, links vertex and fragment shaders into a program
-Renderer::ShaderProgram::ShaderProgram(const unsigned int vertexShaderID,
-    const unsigned int fragShaderID)
+Renderer::ShaderProgram::ShaderProgram(Device& device,
+    const unsigned int vertexShaderID, const unsigned int fragShaderID) :
+    device_{ device }
 {
-    int success; // Variable to store the linking status
+    std::string infoLog; // Variable to store the linking log
 
     // Create a shader program
-    shaderProgram_ = glCreateProgram();
+    shaderProgram_ = device_.createProgram();
 
     // Attach the vertex shader to the program
-    glAttachShader(shaderProgram_, vertexShaderID);
+    device_.attachShader(shaderProgram_, vertexShaderID);
 
     // Attach the fragment shader to the program
-    glAttachShader(shaderProgram_, fragShaderID);
+    device_.attachShader(shaderProgram_, fragShaderID);
 
     // Link the shaders into the program
-    glLinkProgram(shaderProgram_);
+    device_.linkProgram(shaderProgram_);
 
     // Check for linking errors
-    glGetProgramiv(shaderProgram_, GL_LINK_STATUS, &success);
-    if (!success)
+    if (!device_.getLinkStatus(shaderProgram_, infoLog))
     {
-	    char infoLog[512];
-	    // Retrieve and throw the error log if linking fails
-        glGetProgramInfoLog(shaderProgram_, 512, NULL, infoLog);
+        // Throw the error log if linking fails
+        device_.deleteProgram(shaderProgram_);
         throw std::runtime_error(std::string("ERROR::SHADER::PROGRAM::LINKING_FAILED\n")
             + infoLog);
     }
 
     // Delete the vertex shader as it is no longer needed
-    glDeleteShader(vertexShaderID);
+    device_.deleteShader(vertexShaderID);
 
     // Delete the fragment shader as it is no longer needed
-    glDeleteShader(fragShaderID);
+    device_.deleteShader(fragShaderID);
+}
+
+// Constructor for ShaderProgram, links a compute shader into a program
+Renderer::ShaderProgram::ShaderProgram(Device& device,
+    const unsigned int computeShaderID) : device_{ device }
+{
+    std::string infoLog;
+    shaderProgram_ = device_.createProgram();
+    device_.attachShader(shaderProgram_, computeShaderID);
+    device_.linkProgram(shaderProgram_);
+    if (!device_.getLinkStatus(shaderProgram_, infoLog))
+    {
+        device_.deleteProgram(shaderProgram_);
+        throw std::runtime_error(std::string("ERROR::SHADER::PROGRAM::LINKING_FAILED\n")
+            + infoLog);
+    }
+    device_.deleteShader(computeShaderID);
+}
+
+Renderer::ShaderProgram::~ShaderProgram()
+{
+    device_.deleteProgram(shaderProgram_);
 }
 
 
-Renderer::GL_State::GL_State() : shaderProgram_{ nullptr }, myBuffer_{ nullptr },
-shelfTexture_{ nullptr }, duckyTexture_{ nullptr }, clock_()
+struct Renderer::GL_State::StartupAssets
 {
+    ShaderSource vertexSource;
+    ShaderSource fragSource;
+    std::optional<TextureImage> shelfImage;
+    std::optional<TextureImage> duckyImage;
+    std::unique_ptr<MeshCache> mesh;
+};
+
+Renderer::GL_State::GL_State(std::unique_ptr<Device> device,
+    const ResolutionSettings& resolution, const SceneSettings& scene) :
+device_{ std::move(device) }, resources_{ nullptr }, graph_{ nullptr },
+frame_(), shaders_{ nullptr },
+cubeFeatures_{ materialFeatures(scene) }, myBuffer_{ nullptr },
+shelfTexture_{ nullptr }, duckyTexture_{ nullptr }, material_{ nullptr },
+resolution_{ nullptr },
+grid_{ nullptr }, lights_{ nullptr }, mesh_{ nullptr }, heatmap_{ nullptr },
+statistics_{ nullptr }, statisticsLog_{ nullptr }, overlayClock_(),
+width_{ WindowAttributes::WINDOW_WIDTH },
+height_{ WindowAttributes::WINDOW_HEIGHT }, clock_(), dirty_{ true },
+frameArena_(),
+placeholderTexture_{ 0 }, startupStats_(), assets_{ nullptr },
+startup_{ nullptr }
+{
+    resources_ = std::make_unique<GpuResources>(*device_);
+    graph_ = std::make_unique<RenderGraph>(*device_, frameArena_);
+
     // Set the size of the initial OpenGL rendering context
-    glViewport(0, 0, WindowAttributes::WINDOW_WIDTH,
-        WindowAttributes::WINDOW_HEIGHT);
+    device_->viewport(0, 0, width_, height_);
 
-    // Enabled debug logging
-    glEnable(GL_DEBUG_OUTPUT);
-    // Determine callback function that is called whenever an error occurs.
-    glDebugMessageCallback(MessageCallback, 0);
-    glEnable(GL_DEPTH_TEST);
+    // Render offscreen at a scale that holds the frame time target
+    if (resolution.enabled)
+    {
+        resolution_ = std::make_unique<DynamicResolution>(*device_,
+            resolution, width_, height_);
+    }
 
+    device_->enable(GL_DEPTH_TEST);
+
+    // The statistics lag a few frames behind, their queries are created
+    // up front so that the first frame is measured as well
+    if (scene.pipelineStatistics)
+    {
+        statistics_ = std::make_unique<PipelineStatistics>(*device_);
+        statisticsLog_ = std::make_unique<PipelineStatsLog>(
+            scene.statisticsPath);
+    }
 
     // Set color buffer clear color 
-    glClearColor
+    device_->clearColor
     (
         Renderer::GlConstants::CLEAR_COLOR_RED,
         Renderer::GlConstants::CLEAR_COLOR_GREEN,
         Renderer::GlConstants::CLEAR_COLOR_BLUE,
         Renderer::GlConstants::CLEAR_COLOR_OPACITY
     );
-    glClear(GL_COLOR_BUFFER_BIT);
+    device_->clear(GL_COLOR_BUFFER_BIT);
+
+    // A single white texel stands in for the textures until they are
+    // decoded and uploaded
+    const std::array<unsigned char, 3> white{ 255, 255, 255 };
+    placeholderTexture_ = device_->createTexture();
+    device_->bindTexture(GL_TEXTURE_2D, placeholderTexture_);
+    device_->texParameter(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    device_->texParameter(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    device_->texImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, GL_RGB,
+        GL_UNSIGNED_BYTE, white.data());
+
+    // Files are read and decoded on workers, which also filter the
+    // mipmaps, while the context thread compiles, links and uploads as soon
+    // as their inputs are ready
+    assets_ = std::make_unique<StartupAssets>();
+    startup_ = std::make_unique<TaskGraph>();
+    const TaskId vertexSource = startup_->add("read vertex shader",
+        TaskThread::WORKER, [this]() {
+            assets_->vertexSource = loadShaderSource(Env::VERTEX_SHADER_PATH);
+        });
+    const TaskId fragSource = startup_->add("read fragment shader",
+        TaskThread::WORKER, [this]() {
+            assets_->fragSource = loadShaderSource(Env::FRAG_SHADER_PATH);
+        });
+    const TaskId shelfImage = startup_->add("decode shelf texture",
+        TaskThread::WORKER, [this]() {
+            assets_->shelfImage.emplace(Env::SHELF_TEXTURE_PATH,
+                ImageSettings());
+        });
+    const TaskId duckyImage = startup_->add("decode ducky texture",
+        TaskThread::WORKER, [this]() {
+            assets_->duckyImage.emplace(Env::DUCKY_TEXTURE_PATH,
+                ImageSettings());
+        });
+
+    // Compile and link the variant the cube is drawn with, if fail throws
+    // runtime error. The grid compiles its own variants
+    const TaskId program = startup_->add("link shader program",
+        TaskThread::CONTEXT, [this, cube = scene.type == SceneType::CUBE]() {
+            shaders_ = std::make_unique<ShaderLibrary>(*device_,
+                std::move(assets_->vertexSource),
+                std::move(assets_->fragSource));
+            if (cube)
+            {
+                shaders_->get(cubeFeatures_);
+            }
+        }, { vertexSource, fragSource });
 
-    // Create shader objects, if fail throws runtime error
-    auto vertexShader = VertexShader();
-    auto fragShader = FragmentShader();
+    // Move vertices data to the GPU buffer
+    const TaskId buffer = startup_->add("upload vertices",
+        TaskThread::CONTEXT, [this]() {
+            myBuffer_ = std::make_unique<BufferSetup>(*resources_);
+        });
+
+    // The textures are not needed for the first frame
+    startup_->add("upload shelf texture", TaskThread::CONTEXT, [this]() {
+            shelfTexture_ = std::make_unique<Texture>(*resources_,
+                *assets_->shelfImage);
+            assets_->shelfImage.reset();
+        }, { shelfImage });
+    startup_->add("upload ducky texture", TaskThread::CONTEXT, [this]() {
+            duckyTexture_ = std::make_unique<Texture>(*resources_,
+                *assets_->duckyImage);
+            assets_->duckyImage.reset();
+        }, { duckyImage });
+
+    // The mix is baked before the first frame, from the placeholders
+    TaskId materialReady = buffer;
+    if (scene.bakeMaterial && scene.debugView == DebugView::OFF)
+    {
+        materialReady = startup_->add("create baked material",
+            TaskThread::CONTEXT, [this]() {
+                material_ = std::make_unique<BakedMaterial>(*device_);
+            });
+    }
 
-    // Use the compiled shaders to get a linked shader program
-    shaderProgram_ = std::make_unique<ShaderProgram>(vertexShader.getShaderID(),
-        fragShader.getShaderID());
+    // The overdraw view replaces the shaded scene from the first frame
+    TaskId heatmapReady = buffer;
+    if (scene.debugView == DebugView::OVERDRAW)
+    {
+        heatmapReady = startup_->add("create overdraw heatmap",
+            TaskThread::CONTEXT, [this]() {
+                heatmap_ = std::make_unique<OverdrawHeatmap>(*device_);
+            });
+    }
 
-    // Move vertices data to the GPU buffer
-    myBuffer_ = std::make_unique<BufferSetup>();
+    TaskId sceneReady = buffer;
+    if (scene.type == SceneType::GRID)
+    {
+        sceneReady = startup_->add("create grid scene", TaskThread::CONTEXT,
+            [this, scene]() {
+                grid_ = std::make_unique<GridScene>(*device_, *shaders_,
+                    scene, width_, height_);
+            }, { program });
+    }
+    else if (scene.type == SceneType::LIGHTS)
+    {
+        // Dynamic resolution times the whole scene pass, and timer queries
+        // cannot nest
+        sceneReady = startup_->add("create light scene", TaskThread::CONTEXT,
+            [this, scene, timeShading = !resolution.enabled]() {
+                lights_ = std::make_unique<LightScene>(*device_, *shaders_,
+                    scene, timeShading);
+            }, { program });
+    }
 
-    // Load a texture
-    shelfTexture_ = std::make_unique<Texture>(Env::SHELF_TEXTURE_PATH);
-    duckyTexture_ = std::make_unique<Texture>(Env::DUCKY_TEXTURE_PATH);
+    // Like the textures, the mesh is drawn once uploaded and the cube
+    // stands in for it until then
+    if (!scene.meshPath.empty())
+    {
+        const TaskId meshCache = startup_->add("load mesh",
+            TaskThread::WORKER, [this, path = scene.meshPath]() {
+                assets_->mesh = std::make_unique<MeshCache>(path);
+            });
+        startup_->add("upload mesh", TaskThread::CONTEXT, [this]() {
+                mesh_ = std::make_unique<Mesh>(*resources_, *assets_->mesh);
+                assets_->mesh.reset();
+            }, { meshCache });
+    }
 
+    const std::size_t cores = std::thread::hardware_concurrency();
+    startup_->start(std::clamp<std::size_t>(cores, 1,
+        TaskGraphConstants::MAX_WORKERS));
+    startup_->wait(program);
+    startup_->wait(buffer);
+    startup_->wait(materialReady);
+    startup_->wait(heatmapReady);
+    startup_->wait(sceneReady);
+    startupStats_.firstFrameMs = startup_->getElapsedMs();
+    pollStartup();
 }
 
-void Renderer::GL_State::draw(const std::unique_ptr<Window>& window) const
+// Defined here, where the scene and diagnostics classes are complete types
+Renderer::GL_State::~GL_State()
 {
-    // Use the shader program for rendering
-    glUseProgram(shaderProgram_->getProgramID());
-
-    // Activate the default texture and bind the shelf texture
-    glActiveTexture(Renderer::GlConstants::DEFAULT_TEXTURE);
-    glBindTexture(GL_TEXTURE_2D, shelfTexture_->getTexID());
-
-    // Activate the next texture unit and bind the ducky texture
-    glActiveTexture(Renderer::GlConstants::DEFAULT_TEXTURE + 1);
-    glBindTexture(GL_TEXTURE_2D, duckyTexture_->getTexID());
+    // Stop the workers before the resources they load into go away
+    startup_.reset();
+    device_->deleteTexture(placeholderTexture_);
+}
 
-    // Set the uniform variables in the shader for the textures
-    // "texture1" corresponds to the shelf texture bound to texture unit 0
-    shaderProgram_->setUniform("texture1",
-                               Renderer::GlConstants::DEFAULT_TEXTURE_UNIT);
+void Renderer::GL_State::finishLoading()
+{
+    if (startup_)
+    {
+        startup_->waitAll();
+        pollStartup();
+    }
+    // Create the transient targets now, so they belong to the setup
+    // rather than to the first frame
+    declarePasses();
+    graph_->prepare();
+}
 
-    // "texture2" corresponds to the ducky texture bound to texture unit 1
-    shaderProgram_->setUniform("texture2",
-                               Renderer::GlConstants::DEFAULT_TEXTURE_UNIT + 1);
+void Renderer::GL_State::pollStartup()
+{
+    if (!startup_->poll())
+    {
+        return;
+    }
+    startupStats_.totalMs = startup_->getElapsedMs();
+    startupStats_.tasks = startup_->getTimings();
+    startup_.reset();
+    assets_.reset();
+}
 
-    glm::mat4 view = glm::mat4(1.0f);
+Renderer::SceneTransforms Renderer::computeSceneTransforms(float seconds,
+    float aspectRatio, const CameraPose& camera)
+{
+    SceneTransforms transforms;
     // The model matrix consists of translations, scaling and/or 
     // rotations we'd like to apply to transform all object's vertices to 
     // the global world space. 
     // This rotates a plane slightly along the negative x-axis.
-    glm::mat4 model = glm::rotate(
+    transforms.model = glm::rotate(
         glm::mat4(1.0f),
-        clock_.getElapsedTime().asSeconds() * glm::radians(50.0f),
+        seconds * glm::radians(50.0f),
         glm::vec3(0.5f, 1.0f, 0.0f));
     // Translate the scene forward (towards negative z) to give impression
-    // of moving forward
-    view = glm::translate(view, glm::vec3(0.0f, 0.0f, -3.0f));
+    // of moving forward, then turn it so the camera orbits the cube
+    transforms.view = glm::translate(glm::mat4(1.0f),
+        glm::vec3(0.0f, 0.0f, -camera.distance));
+    transforms.view = glm::rotate(transforms.view,
+        glm::radians(camera.pitchDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
+    transforms.view = glm::rotate(transforms.view,
+        glm::radians(camera.yawDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
     // Use a perspective projection
-    glm::mat4 projection = glm::perspective(
+    transforms.projection = glm::perspective(
 	    glm::radians(45.0f),
-	    static_cast<float>(WindowAttributes::WINDOW_WIDTH) / static_cast<float>(WindowAttributes::WINDOW_HEIGHT),
+	    aspectRatio,
 	    0.1f,
 	    1000.0f
     );
+    return transforms;
+}
+
+void Renderer::GL_State::draw(const std::unique_ptr<Window>& window)
+{
+    // The previous frame's transient data is no longer needed
+    frameArena_.reset();
+    // Reuse the names of objects the GPU has finished with
+    resources_->collect();
+    if (startup_)
+    {
+        // Upload the textures decoded since the last frame
+        pollStartup();
+    }
+    frame_.seconds = clock_.getElapsedTime().asSeconds();
+    frame_.aspectRatio =
+        static_cast<float>(width_) / static_cast<float>(height_);
+    if (statistics_)
+    {
+        // Log the frames the GPU has finished, a few frames late
+        const std::uint64_t pixels = resolution_ ?
+            resolution_->getRenderPixels() :
+            static_cast<std::uint64_t>(width_) * height_;
+        while (const std::optional<PipelineSample> sample =
+            statistics_->collect())
+        {
+            statisticsLog_->add(*sample, pixels);
+        }
+    }
+
+    declarePasses();
+    graph_->execute();
+    resources_->endFrame();
+    dirty_ = false;
+
+    // There is no text overlay, the window title shows the last frame
+    if (window && statisticsLog_ && statisticsLog_->getSampleCount() > 0 &&
+        overlayClock_.getElapsedTime().asMilliseconds() >= OVERLAY_INTERVAL_MS)
+    {
+        window->setTitle(std::string(WindowAttributes::WINDOW_TITLE) + " - " +
+            statisticsLog_->getOverlayText());
+        overlayClock_.restart();
+    }
+}
+
+void Renderer::GL_State::declarePasses()
+{
+    frame_.window = graph_->importResource("window", true);
+    if (grid_)
+    {
+        // Culling renders into its own target and writes the commands of
+        // the scene's indirect draws
+        frame_.gridCommands = graph_->importResource("grid commands");
+        graph_->addPass("cull grid", [this](const PassContext&) {
+                grid_->update(frame_.seconds, frame_.aspectRatio);
+            }).write(frame_.gridCommands, Access::STORAGE);
+    }
+    if (lights_)
+    {
+        // Moving the lights also empties the index list of the clusters,
+        // which the assignment then fills
+        frame_.lights = graph_->importResource("lights");
+        frame_.lightClusters = graph_->importResource("light clusters");
+        graph_->addPass("move lights", [this](const PassContext&) {
+                lights_->update(frame_.seconds, frame_.aspectRatio);
+            }).write(frame_.lights, Access::STORAGE)
+            .write(frame_.lightClusters, Access::STORAGE);
+        graph_->addPass("assign lights", [this](const PassContext&) {
+                lights_->assignLights();
+            }).read(frame_.lights, Access::STORAGE)
+            .write(frame_.lightClusters, Access::STORAGE);
+    }
+    if (material_)
+    {
+        // Culled along with the scene's sampling of it
+        frame_.material = graph_->importResource("baked material");
+        graph_->addPass("bake material", [this](const PassContext&) {
+                bakeMaterial();
+            }).write(frame_.material, Access::ATTACHMENT);
+    }
+
+    if (resolution_)
+    {
+        frame_.sceneColor = graph_->createTarget("scene color",
+            resolution_->getTargetDesc(GL_RGBA8,
+                ResolutionConstants::SAMPLES));
+        frame_.sceneDepth = graph_->createTarget("scene depth",
+            resolution_->getTargetDesc(GL_DEPTH24_STENCIL8,
+                ResolutionConstants::SAMPLES));
+    }
+    else if (heatmap_)
+    {
+        frame_.sceneColor = graph_->createTarget("overdraw counts",
+            OverdrawHeatmap::getTargetDesc(width_, height_));
+    }
+    else
+    {
+        frame_.sceneColor = frame_.window;
+    }
+    PassBuilder scene = graph_->addPass("scene",
+        [this](const PassContext& pass) { drawScene(pass); });
+    scene.write(frame_.sceneColor, Access::ATTACHMENT);
+    if (resolution_)
+    {
+        scene.write(frame_.sceneDepth, Access::ATTACHMENT);
+    }
+    if (grid_)
+    {
+        scene.read(frame_.gridCommands, Access::INDIRECT);
+    }
+    if (lights_)
+    {
+        scene.read(frame_.lights, Access::STORAGE)
+            .read(frame_.lightClusters, Access::STORAGE);
+    }
+    if (material_)
+    {
+        scene.read(frame_.material, Access::SAMPLED);
+    }
+
+    if (resolution_)
+    {
+        // A scaled blit cannot resolve samples itself
+        frame_.resolvedColor = graph_->createTarget("resolved scene",
+            resolution_->getTargetDesc(GL_RGBA8, 0));
+        graph_->addPass("resolve samples", [this](const PassContext& pass) {
+                resolution_->resolve(pass.getFramebuffer(frame_.sceneColor),
+                    pass.getFramebuffer());
+            }).read(frame_.sceneColor, Access::ATTACHMENT)
+            .write(frame_.resolvedColor, Access::ATTACHMENT);
+        graph_->addPass("upscale", [this](const PassContext& pass) {
+                resolution_->upscale(pass.getFramebuffer(
+                    frame_.resolvedColor));
+            }).read(frame_.resolvedColor, Access::ATTACHMENT)
+            .write(frame_.window, Access::ATTACHMENT);
+    }
+    if (heatmap_)
+    {
+        graph_->addPass("overdraw view", [this](const PassContext& pass) {
+                heatmap_->draw(pass.getTarget(frame_.sceneColor));
+            }).read(frame_.sceneColor, Access::SAMPLED)
+            .write(frame_.window, Access::ATTACHMENT);
+    }
+}
+
+void Renderer::GL_State::drawScene(const PassContext& pass)
+{
+    if (resolution_)
+    {
+        resolution_->beginFrame(pass.getFramebuffer());
+        device_->clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+    else if (heatmap_)
+    {
+        // Counts the fragments in its own target instead
+        device_->bindFramebuffer(GL_FRAMEBUFFER, pass.getFramebuffer());
+        heatmap_->begin();
+    }
+    else
+    {
+        // Clear the color and depth buffers for the next frame
+        device_->clear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    }
+
+    if (material_)
+    {
+        // The baked mix stands in for both textures
+        device_->activeTexture(Renderer::GlConstants::DEFAULT_TEXTURE);
+        device_->bindTexture(GL_TEXTURE_2D, material_->getTexture());
+    }
+    else
+    {
+        // Activate the default texture and bind the shelf texture
+        device_->activeTexture(Renderer::GlConstants::DEFAULT_TEXTURE);
+        device_->bindTexture(GL_TEXTURE_2D, shelfTexture_ ?
+            shelfTexture_->getTexID() : placeholderTexture_);
+
+        // Activate the next texture unit and bind the ducky texture
+        device_->activeTexture(Renderer::GlConstants::DEFAULT_TEXTURE + 1);
+        device_->bindTexture(GL_TEXTURE_2D, duckyTexture_ ?
+            duckyTexture_->getTexID() : placeholderTexture_);
+    }
+
+    if (statistics_)
+    {
+        statistics_->begin();
+    }
+    if (grid_)
+    {
+        grid_->draw();
+    }
+    else if (lights_)
+    {
+        lights_->draw();
+    }
+    else
+    {
+        drawCube(frame_.seconds, frame_.aspectRatio);
+    }
+    if (statistics_)
+    {
+        statistics_->end();
+    }
+    if (heatmap_)
+    {
+        heatmap_->end();
+    }
+}
+
+void Renderer::GL_State::setAnimationPaused(bool paused)
+{
+    if (paused)
+    {
+        clock_.stop();
+    }
+    else
+    {
+        clock_.start();
+    }
+}
+
+bool Renderer::GL_State::needsRedraw() const
+{
+    // Uploads and bakes during loading change the textures of the frame
+    return dirty_ || startup_ != nullptr || clock_.isRunning();
+}
+
+void Renderer::GL_State::bakeMaterial()
+{
+    // The placeholder is replaced as each texture finishes uploading,
+    // which re-bakes the mix
+    const MaterialSource placeholder{ placeholderTexture_, 1, 1,
+        TextureHandle() };
+    const MaterialSource shelf = shelfTexture_ ?
+        MaterialSource{ shelfTexture_->getTexID(), shelfTexture_->getWidth(),
+        shelfTexture_->getHeight(), shelfTexture_->getHandle() } :
+        placeholder;
+    const MaterialSource ducky = duckyTexture_ ?
+        MaterialSource{ duckyTexture_->getTexID(), duckyTexture_->getWidth(),
+        duckyTexture_->getHeight(), duckyTexture_->getHandle() } :
+        placeholder;
+    material_->setSources(shelf, ducky);
+    if (material_->bake() && !resolution_)
+    {
+        // Offscreen rendering sets the viewport for every frame
+        device_->viewport(0, 0, width_, height_);
+    }
+}
+
+void Renderer::GL_State::drawCube(float seconds, float aspectRatio)
+{
+    // Use the variant of the shader program for the debug view
+    const ShaderProgram& shaderProgram = shaders_->get(cubeFeatures_);
+    device_->useProgram(shaderProgram.getProgramID());
+
+    // Set the uniform variables in the shader for the textures
+    // "texture1" corresponds to the shelf texture bound to texture unit 0
+    shaderProgram.setUniform("texture1",
+                             Renderer::GlConstants::DEFAULT_TEXTURE_UNIT);
+
+    // "texture2" corresponds to the ducky texture bound to texture unit 1
+    shaderProgram.setUniform("texture2",
+                             Renderer::GlConstants::DEFAULT_TEXTURE_UNIT + 1);
+
+    const SceneTransforms transforms = computeSceneTransforms(seconds,
+        aspectRatio);
+
     // Set the vertices coordinate transformation matrices in our shader program.
-    shaderProgram_->setUniform("model", model);
-    shaderProgram_->setUniform("projection", projection);
-    shaderProgram_->setUniform("view", view);
+    // A mesh is first fitted into the cube it replaces
+    shaderProgram.setUniform("model", mesh_ ?
+        transforms.model * mesh_->getFitTransform() : transforms.model);
+    shaderProgram.setUniform("projection", transforms.projection);
+    shaderProgram.setUniform("view", transforms.view);
+
+    if (mesh_)
+    {
+        mesh_->draw();
+        return;
+    }
 
     // Bind the Vertex Array Object (VAO) that contains the vertex data
-    glBindVertexArray(myBuffer_->getVAOId());
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+    device_->bindVertexArray(myBuffer_->getVAOId());
+    device_->drawArrays(GL_TRIANGLES, 0, Geometry::CUBE_VERTEX_COUNT);
+}
+
+void Renderer::GL_State::resize(unsigned int width, unsigned int height)
+{
+    width_ = static_cast<GLsizei>(width);
+    height_ = static_cast<GLsizei>(height);
+    if (resolution_)
+    {
+        // The viewport is set for every frame by the offscreen rendering
+        resolution_->resize(width_, height_);
+    }
+    else
+    {
+        device_->viewport(0, 0, width_, height_);
+    }
+    if (grid_)
+    {
+        grid_->resize(width_, height_);
+    }
+    dirty_ = true;
+}
 
+std::string Renderer::GL_State::getSummary() const
+{
+    std::ostringstream summary;
+    summary << "Startup: first frame ready after "
+        << startupStats_.firstFrameMs << " ms, ";
+    if (startup_)
+    {
+        summary << "assets still loading\n";
+    }
+    else
+    {
+        summary << "all assets loaded after " << startupStats_.totalMs
+            << " ms\n" << formatTimings(startupStats_.tasks);
+    }
+    if (material_)
+    {
+        summary << "Baked material: " << material_->getBakeCount()
+            << " bakes\n";
+    }
+    if (shaders_)
+    {
+        const ShaderLibraryStats& shaderStats = shaders_->getStats();
+        summary << "Shader variants: " << shaderStats.variants
+            << " compiled in " << shaderStats.compileMs << " ms\n";
+    }
+    if (statisticsLog_)
+    {
+        summary << statisticsLog_->getSummary();
+    }
+    summary << resources_->getSummary();
+    summary << graph_->getSummary();
+    if (mesh_)
+    {
+        const MeshLoadStats& meshStats = mesh_->getLoadStats();
+        summary << "Mesh: " << mesh_->getVertexCount() << " vertices, "
+            << mesh_->getTriangleCount() << " triangles in "
+            << mesh_->getSubmeshCount() << " submeshes, cache "
+            << (meshStats.cacheHit ? "hit" : meshStats.cacheWritten ?
+                "written" : "not writable") << ", hashed "
+            << meshStats.sourceBytes << " bytes in " << meshStats.hashMs
+            << " ms, imported in " << meshStats.importMs << " ms, written in "
+            << meshStats.writeMs << " ms, uploaded in " << mesh_->getUploadMs()
+            << " ms\n";
+    }
+    if (lights_)
+    {
+        summary << lights_->getSummary();
+    }
+    if (!grid_)
+    {
+        return summary.str();
+    }
+
+    const CullStats& stats = grid_->getStats();
+    summary << "Grid scene, occlusion culling "
+        << (grid_->isCulling() ? "on" : "off") << ": ";
+    if (stats.frames == 0)
+    {
+        summary << "no frame measured\n";
+        return summary.str();
+    }
+    const double drawn = static_cast<double>(stats.drawn) /
+        static_cast<double>(stats.frames);
+    summary << drawn << " of " << stats.objects << " cubes drawn per frame ("
+        << 100.0 * (1.0 - drawn / static_cast<double>(stats.objects))
+        << "% culled) over " << stats.frames << " frames\n";
+    return summary.str();
 }
 
-Renderer::BufferSetup::BufferSetup()
+Renderer::BufferSetup::BufferSetup(GpuResources& resources) :
+resources_{ resources }, device_{ resources.getDevice() }, vao_{ 0 },
+ebo_(), vbo_()
 {
+    const std::uint64_t geometryBytes = sizeof(float) * vertices_.size() +
+        sizeof(unsigned int) * indices_.size();
+    trackAllocation(MemoryCategory::GEOMETRY, geometryBytes);
+
     // Generate and bind the Vertex Array Object (VAO)
-    glGenVertexArrays(1, &vao_);
-    glBindVertexArray(vao_);
+    vao_ = device_.createVertexArray();
+    device_.bindVertexArray(vao_);
 
     // Generate and bind the Vertex Buffer Object (VBO)
-    glGenBuffers(1, &vbo_);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    vbo_ = resources_.createBuffer();
+    device_.bindBuffer(GL_ARRAY_BUFFER, resources_.get(vbo_));
 
     // Upload vertex data to the GPU
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * vertices_.size(),
+    device_.bufferData(GL_ARRAY_BUFFER, sizeof(float) * vertices_.size(),
         vertices_.data(), Renderer::GlConstants::DRAW_TYPE);
 
     // Check if there are indices to set up an Element Buffer Object (EBO)
     if (!indices_.empty())
     {
         // Generate and bind the Element Buffer Object (EBO)
-        glGenBuffers(1, &ebo_);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+        ebo_ = resources_.createBuffer();
+        device_.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, resources_.get(ebo_));
 
         // Upload index data to the GPU
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+        device_.bufferData(GL_ELEMENT_ARRAY_BUFFER,
             indices_.size() * sizeof(unsigned int), indices_.data(),
             Renderer::GlConstants::DRAW_TYPE);
     }
@@ -355,6 +981,21 @@ Renderer::BufferSetup::BufferSetup()
     enableVertexAttribute(VSLocation::POSITION);
     //enableVertexAttribute(Renderer::Vertex::Location::COLOR);
     enableVertexAttribute(VSLocation::TEXTURE);
+
+    // The buffers hold their own copy of the data now
+    std::vector<float>().swap(vertices_);
+    std::vector<unsigned int>().swap(indices_);
+    trackRelease(MemoryCategory::GEOMETRY, geometryBytes);
+}
+
+Renderer::BufferSetup::~BufferSetup()
+{
+    device_.deleteVertexArray(vao_);
+    resources_.release(vbo_);
+    if (ebo_.isValid())
+    {
+        resources_.release(ebo_);
+    }
 }
 
 
@@ -379,11 +1020,10 @@ void Renderer::BufferSetup::enableVertexAttribute(const VSLocation& type)
     }
 
     // Define the vertex attribute pointer for the given type
-    glVertexAttribPointer(static_cast<unsigned int>(type), attribute_size,
-        GL_FLOAT, GL_FALSE,
-        VerticeDataVector::STRIDE * sizeof(float),
-        (void*)(attribute_location * sizeof(float)));
+    device_.vertexAttribPointer(static_cast<unsigned int>(type), attribute_size,
+        GL_FLOAT, VerticeDataVector::STRIDE * sizeof(float),
+        attribute_location * sizeof(float));
 
     // Enable the vertex attribute array for the given type
-    glEnableVertexAttribArray(static_cast<unsigned int>(type));
+    device_.enableVertexAttribArray(static_cast<unsigned int>(type));
 }
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "shader_library.hpp"
+#include "memory_tracker.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace
+{
+    // The defines of every ShaderFeature, in the order of the enum
+    constexpr const char* FEATURE_DEFINES[] = {
+        "INSTANCED",
+        "SINGLE_TEXTURE",
+        "DEPTH_ONLY",
+        "TEXCOORD_VIEW",
+        "OVERDRAW_VIEW",
+        "CLUSTERED_LIGHTING",
+    };
+    static_assert(std::size(FEATURE_DEFINES) ==
+        static_cast<std::size_t>(Renderer::ShaderFeature::COUNT),
+        "Every shader feature needs a define");
+
+    // The GLSL version every ShaderFeature needs at least, 0 for any
+    constexpr int FEATURE_VERSIONS[] = { 0, 0, 0, 0, 0, 430 };
+    static_assert(std::size(FEATURE_VERSIONS) ==
+        static_cast<std::size_t>(Renderer::ShaderFeature::COUNT),
+        "Every shader feature needs a version");
+}
+
+const char* Renderer::toDefine(ShaderFeature feature)
+{
+    return FEATURE_DEFINES[static_cast<std::size_t>(feature)];
+}
+
+Renderer::PermutationKey Renderer::materialFeatures(
+    const SceneSettings& scene)
+{
+    switch (scene.debugView)
+    {
+    case DebugView::TEXCOORDS: return featureBit(ShaderFeature::TEXCOORD_VIEW);
+    case DebugView::SHELF: return featureBit(ShaderFeature::SINGLE_TEXTURE);
+    case DebugView::OVERDRAW: return featureBit(ShaderFeature::OVERDRAW_VIEW);
+    default:
+        // The baked texture is bound in place of the shelf texture
+        return scene.bakeMaterial ?
+            featureBit(ShaderFeature::SINGLE_TEXTURE) : 0;
+    }
+}
+
+std::string Renderer::injectDefines(const std::string& source,
+    PermutationKey features)
+{
+    // Only comments and whitespace may precede the #version line, which
+    // the shaders of the library start with
+    const std::size_t version = source.find("#version");
+    if (version == std::string::npos)
+    {
+        throw std::invalid_argument(
+            "ERROR::SHADER_LIBRARY::SOURCE HAS NO #version LINE");
+    }
+    std::size_t lineEnd = source.find('\n', version);
+    lineEnd = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+    const std::size_t nextLine = 2 + static_cast<std::size_t>(
+        std::count(source.begin(), source.begin() + version, '\n'));
+
+    std::string preamble;
+    if (lineEnd == source.size() && source.back() != '\n')
+    {
+        preamble += '\n';
+    }
+    int requiredVersion = 0;
+    for (std::size_t i = 0;
+        i < static_cast<std::size_t>(ShaderFeature::COUNT); ++i)
+    {
+        if ((features & featureBit(static_cast<ShaderFeature>(i))) != 0)
+        {
+            preamble += "#define ";
+            preamble += FEATURE_DEFINES[i];
+            preamble += '\n';
+            requiredVersion = std::max(requiredVersion, FEATURE_VERSIONS[i]);
+        }
+    }
+    preamble += "#line " + std::to_string(nextLine) + '\n';
+
+    std::string variant = source;
+    variant.insert(lineEnd, preamble);
+
+    // The number of the #version line comes before the inserted preamble,
+    // so replacing it leaves the offsets above valid
+    const std::size_t numberStart = source.find_first_not_of(" \t",
+        version + std::strlen("#version"));
+    std::size_t numberEnd = numberStart == std::string::npos ?
+        std::string::npos : source.find_first_not_of("0123456789", numberStart);
+    numberEnd = std::min(numberEnd, lineEnd);
+    if (numberStart < numberEnd && std::stoi(source.substr(numberStart,
+        numberEnd - numberStart)) < requiredVersion)
+    {
+        variant.replace(numberStart, numberEnd - numberStart,
+            std::to_string(requiredVersion));
+    }
+    return variant;
+}
+
+Renderer::ShaderLibrary::ShaderLibrary(Device& device,
+    ShaderSource vertexSource, ShaderSource fragSource) : device_{ device },
+    vertexSource_{ std::move(vertexSource.code) },
+    fragSource_{ std::move(fragSource.code) }, programs_(), stats_()
+{
+    trackAllocation(MemoryCategory::SHADER_SOURCE,
+        vertexSource_.size() + fragSource_.size());
+}
+
+Renderer::ShaderLibrary::~ShaderLibrary()
+{
+    trackRelease(MemoryCategory::SHADER_SOURCE,
+        vertexSource_.size() + fragSource_.size());
+}
+
+const Renderer::ShaderProgram& Renderer::ShaderLibrary::get(
+    PermutationKey features)
+{
+    const auto cached = programs_.find(features);
+    if (cached != programs_.end())
+    {
+        return *cached->second;
+    }
+
+    const std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    std::unique_ptr<ShaderProgram> program;
+    try
+    {
+        VertexShader vertexShader(device_,
+            ShaderSource{ injectDefines(vertexSource_, features) });
+        FragmentShader fragShader(device_,
+            ShaderSource{ injectDefines(fragSource_, features) });
+        program = std::make_unique<ShaderProgram>(device_,
+            vertexShader.getShaderID(), fragShader.getShaderID());
+    }
+    catch (const std::runtime_error& e)
+    {
+        // Name the variant, the log alone does not tell which one failed
+        throw std::runtime_error("ERROR::SHADER_LIBRARY::VARIANT " +
+            std::to_string(features) + "\n" + e.what());
+    }
+    stats_.compileMs += std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    ++stats_.variants;
+    return *programs_.emplace(features, std::move(program)).first->second;
+}
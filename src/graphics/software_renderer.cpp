@@ -0,0 +1,699 @@
+#include "software_renderer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Every x86-64 target has SSE2, use it for the edge functions when available
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFTWARE_RENDERER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    // The clear color as RGBA8, matching GlConstants
+    constexpr std::uint8_t CLEAR_COLOR[4] =
+    {
+        static_cast<std::uint8_t>(Renderer::GlConstants::CLEAR_COLOR_RED * 255.0f + 0.5f),
+        static_cast<std::uint8_t>(Renderer::GlConstants::CLEAR_COLOR_GREEN * 255.0f + 0.5f),
+        static_cast<std::uint8_t>(Renderer::GlConstants::CLEAR_COLOR_BLUE * 255.0f + 0.5f),
+        255
+    };
+
+    // Rounds a size up to a whole number of tiles
+    int alignToTile(int size)
+    {
+        constexpr int tile = Renderer::SoftwareConstants::TILE_SIZE;
+        return (size + tile - 1) / tile * tile;
+    }
+
+    // Wraps a texel coordinate into [0, size) like GL_REPEAT
+    int wrapRepeat(int coordinate, int size)
+    {
+        const int wrapped = coordinate % size;
+        return wrapped < 0 ? wrapped + size : wrapped;
+    }
+}
+
+Renderer::SoftwareTexture::SoftwareTexture(const Image& image)
+{
+    const int channels = image.getNumberOfChannels();
+    if (channels != 3 && channels != 4)
+    {
+        throw std::domain_error("ERROR::SOFTWARE_TEXTURE::UNSUPPORTED_CHANNELS "
+            + std::to_string(channels));
+    }
+
+    // Expand the decoded image to RGBA8 for the base level
+    MipLevel base{ image.getWidth(), image.getHeight(), {} };
+    const std::size_t texelCount =
+        static_cast<std::size_t>(base.width) * base.height;
+    base.texels.resize(texelCount * 4);
+    const unsigned char* source = image.getData();
+    for (std::size_t i = 0; i < texelCount; ++i)
+    {
+        base.texels[i * 4 + 0] = source[i * channels + 0];
+        base.texels[i * 4 + 1] = source[i * channels + 1];
+        base.texels[i * 4 + 2] = source[i * channels + 2];
+        base.texels[i * 4 + 3] = channels == 4 ? source[i * channels + 3] : 255;
+    }
+    levels_.push_back(std::move(base));
+
+    // Build the mipmap chain with a 2x2 box filter down to a single texel
+    while (levels_.back().width > 1 || levels_.back().height > 1)
+    {
+        const MipLevel& previous = levels_.back();
+        MipLevel next{ std::max(1, previous.width / 2),
+            std::max(1, previous.height / 2), {} };
+        next.texels.resize(static_cast<std::size_t>(next.width) * next.height * 4);
+
+        for (int y = 0; y < next.height; ++y)
+        {
+            const int y0 = std::min(y * 2, previous.height - 1);
+            const int y1 = std::min(y * 2 + 1, previous.height - 1);
+            for (int x = 0; x < next.width; ++x)
+            {
+                const int x0 = std::min(x * 2, previous.width - 1);
+                const int x1 = std::min(x * 2 + 1, previous.width - 1);
+                for (int c = 0; c < 4; ++c)
+                {
+                    const int sum =
+                        previous.texels[(y0 * previous.width + x0) * 4 + c] +
+                        previous.texels[(y0 * previous.width + x1) * 4 + c] +
+                        previous.texels[(y1 * previous.width + x0) * 4 + c] +
+                        previous.texels[(y1 * previous.width + x1) * 4 + c];
+                    next.texels[(y * next.width + x) * 4 + c] =
+                        static_cast<std::uint8_t>((sum + 2) / 4);
+                }
+            }
+        }
+        levels_.push_back(std::move(next));
+    }
+}
+
+int Renderer::SoftwareTexture::selectLevel(float dudx, float dvdx,
+    float dudy, float dvdy) const
+{
+    // The squared texel footprint of a pixel step along x and along y
+    const float width = static_cast<float>(getWidth());
+    const float height = static_cast<float>(getHeight());
+    const auto squared = [width, height](float du, float dv)
+    {
+        return du * du * width * width + dv * dv * height * height;
+    };
+    const float footprintSquared = std::max(squared(dudx, dvdx),
+        squared(dudy, dvdy));
+
+    // Magnification and quads with no usable derivatives sample the base
+    // level, minification the level nearest to the level of detail
+    const float lod = 0.5f * std::log2(footprintSquared);
+    const int lastLevel = static_cast<int>(levels_.size()) - 1;
+    if (!(lod > 0.5f))
+    {
+        return 0;
+    }
+    if (lod >= static_cast<float>(lastLevel))
+    {
+        return lastLevel;
+    }
+    return static_cast<int>(std::ceil(lod + 0.5f)) - 1;
+}
+
+void Renderer::SoftwareTexture::sample(float u, float v, int level,
+    float rgba[4]) const
+{
+    const MipLevel& mip = levels_[level];
+
+    // Take the texel the coordinates fall in, like GL_NEAREST, wrapping
+    // the texel index like GL_REPEAT
+    const int x = wrapRepeat(static_cast<int>(std::floor(u * mip.width)),
+        mip.width);
+    const int y = wrapRepeat(static_cast<int>(std::floor(v * mip.height)),
+        mip.height);
+    const std::uint8_t* texel =
+        &mip.texels[(static_cast<std::size_t>(y) * mip.width + x) * 4];
+    for (int c = 0; c < 4; ++c)
+    {
+        rgba[c] = texel[c];
+    }
+}
+
+Renderer::SoftwareRenderer::SoftwareRenderer(int width, int height,
+    unsigned int workerCount) :
+    width_{ width }, height_{ height }, paddedWidth_{ 0 }, paddedHeight_{ 0 },
+    tilesX_{ 0 }, tilesY_{ 0 }, blocksX_{ 0 },
+    shelfTexture_{ Image(Env::SHELF_TEXTURE_PATH) },
+    duckyTexture_{ Image(Env::DUCKY_TEXTURE_PATH) },
+    frameIndex_{ 0 }, busyWorkers_{ 0 }, shutdown_{ false }, nextTile_{ 0 },
+    dirty_{ true }
+{
+    allocateFrame();
+
+    // Spawn one tile worker per hardware thread unless told otherwise
+    if (workerCount == 0)
+    {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned int i = 0; i < workerCount; ++i)
+    {
+        workers_.emplace_back(&SoftwareRenderer::workerLoop, this);
+    }
+}
+
+void Renderer::SoftwareRenderer::allocateFrame()
+{
+    paddedWidth_ = alignToTile(width_);
+    paddedHeight_ = alignToTile(height_);
+    tilesX_ = paddedWidth_ / SoftwareConstants::TILE_SIZE;
+    tilesY_ = paddedHeight_ / SoftwareConstants::TILE_SIZE;
+    blocksX_ = paddedWidth_ / SoftwareConstants::HIZ_BLOCK_SIZE;
+
+    const std::size_t pixelCount =
+        static_cast<std::size_t>(paddedWidth_) * paddedHeight_;
+    colorBuffer_.resize(pixelCount * 4);
+    depthBuffer_.resize(pixelCount);
+    hiZBuffer_.resize(pixelCount /
+        (SoftwareConstants::HIZ_BLOCK_SIZE * SoftwareConstants::HIZ_BLOCK_SIZE));
+    presentBuffer_.resize(static_cast<std::size_t>(width_) * height_ * 4);
+    tileBins_.resize(static_cast<std::size_t>(tilesX_) * tilesY_);
+}
+
+void Renderer::SoftwareRenderer::resize(unsigned int width,
+    unsigned int height)
+{
+    // The workers only touch the buffers while renderFrame waits for them
+    width_ = static_cast<int>(width);
+    height_ = static_cast<int>(height);
+    allocateFrame();
+    dirty_ = true;
+}
+
+void Renderer::SoftwareRenderer::setAnimationPaused(bool paused)
+{
+    if (paused)
+    {
+        clock_.stop();
+    }
+    else
+    {
+        clock_.start();
+    }
+}
+
+Renderer::SoftwareRenderer::~SoftwareRenderer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutdown_ = true;
+    }
+    frameStart_.notify_all();
+    for (std::thread& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void Renderer::SoftwareRenderer::draw(const std::unique_ptr<Window>& window)
+{
+    renderFrame(clock_.getElapsedTime().asSeconds());
+
+    // Create the texture that carries the finished frame to the window on
+    // the first draw and after a resize, when a context is current
+    const sf::Vector2u size(static_cast<unsigned int>(width_),
+        static_cast<unsigned int>(height_));
+    if (presentTexture_.getSize() != size && !presentTexture_.resize(size))
+    {
+        throw std::runtime_error("ERROR::SOFTWARE_RENDERER::CANNOT CREATE "
+            "PRESENTATION TEXTURE");
+    }
+
+    // Upload the frame and draw it over the whole window
+    presentTexture_.update(presentBuffer_.data());
+    const sf::Sprite sprite(presentTexture_);
+    window->draw(sprite);
+    dirty_ = false;
+}
+
+void Renderer::SoftwareRenderer::renderFrame(float seconds)
+{
+    // Reset the bins, keeping their capacity from the previous frame
+    triangles_.clear();
+    for (std::vector<std::uint32_t>& bin : tileBins_)
+    {
+        bin.clear();
+    }
+
+    // Vertex stage: the same transformation as shader.vs
+    const SceneTransforms transforms = computeSceneTransforms(seconds,
+        static_cast<float>(width_) / static_cast<float>(height_));
+    const glm::mat4 mvp =
+        transforms.projection * transforms.view * transforms.model;
+
+    ClipVertex triangle[3];
+    for (GLsizei vertex = 0; vertex < Geometry::CUBE_VERTEX_COUNT; ++vertex)
+    {
+        const float* data =
+            &Geometry::CUBE_VERTICES[vertex * VerticeDataVector::STRIDE];
+        ClipVertex& clipVertex = triangle[vertex % 3];
+        clipVertex.position = mvp * glm::vec4(
+            data[VerticeDataVector::POSITION_LOCATION],
+            data[VerticeDataVector::POSITION_LOCATION + 1],
+            data[VerticeDataVector::POSITION_LOCATION + 2], 1.0f);
+        clipVertex.u = data[VerticeDataVector::TEXTURE_LOCATION];
+        clipVertex.v = data[VerticeDataVector::TEXTURE_LOCATION + 1];
+
+        if (vertex % 3 == 2)
+        {
+            clipTriangle(triangle[0], triangle[1], triangle[2]);
+        }
+    }
+
+    // Hand the tiles to the workers and wait until all of them are done
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        nextTile_.store(0);
+        busyWorkers_ = workers_.size();
+        ++frameIndex_;
+    }
+    frameStart_.notify_all();
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        frameDone_.wait(lock, [this] { return busyWorkers_ == 0; });
+    }
+
+    // Strip the tile padding from the rows
+    for (int y = 0; y < height_; ++y)
+    {
+        std::memcpy(&presentBuffer_[static_cast<std::size_t>(y) * width_ * 4],
+            &colorBuffer_[static_cast<std::size_t>(y) * paddedWidth_ * 4],
+            static_cast<std::size_t>(width_) * 4);
+    }
+}
+
+void Renderer::SoftwareRenderer::clipTriangle(const ClipVertex& v0,
+    const ClipVertex& v1, const ClipVertex& v2)
+{
+    const ClipVertex* input[3] = { &v0, &v1, &v2 };
+
+    // Signed distances to the near plane (z = -w in clip space)
+    float distance[3];
+    int insideCount = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        distance[i] = input[i]->position.z + input[i]->position.w -
+            SoftwareConstants::NEAR_CLIP_EPSILON;
+        insideCount += distance[i] >= 0.0f ? 1 : 0;
+    }
+
+    if (insideCount == 3)
+    {
+        setupTriangle(v0, v1, v2);
+        return;
+    }
+    if (insideCount == 0)
+    {
+        return;
+    }
+
+    // Sutherland-Hodgman against a single plane yields at most 4 vertices
+    ClipVertex polygon[4];
+    int polygonSize = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        const int j = (i + 1) % 3;
+        if (distance[i] >= 0.0f)
+        {
+            polygon[polygonSize++] = *input[i];
+        }
+        if ((distance[i] >= 0.0f) != (distance[j] >= 0.0f))
+        {
+            const float t = distance[i] / (distance[i] - distance[j]);
+            ClipVertex& clipped = polygon[polygonSize++];
+            clipped.position = input[i]->position +
+                (input[j]->position - input[i]->position) * t;
+            clipped.u = input[i]->u + (input[j]->u - input[i]->u) * t;
+            clipped.v = input[i]->v + (input[j]->v - input[i]->v) * t;
+        }
+    }
+
+    for (int i = 1; i + 1 < polygonSize; ++i)
+    {
+        setupTriangle(polygon[0], polygon[i], polygon[i + 1]);
+    }
+}
+
+void Renderer::SoftwareRenderer::setupTriangle(const ClipVertex& v0,
+    const ClipVertex& v1, const ClipVertex& v2)
+{
+    const ClipVertex* input[3] = { &v0, &v1, &v2 };
+
+    // Perspective division and viewport transformation, with y pointing down
+    float x[3], y[3], z[3], invW[3], uOverW[3], vOverW[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        invW[i] = 1.0f / input[i]->position.w;
+        x[i] = (input[i]->position.x * invW[i] * 0.5f + 0.5f) * width_;
+        y[i] = (0.5f - input[i]->position.y * invW[i] * 0.5f) * height_;
+        z[i] = input[i]->position.z * invW[i] * 0.5f + 0.5f;
+        uOverW[i] = input[i]->u * invW[i];
+        vOverW[i] = input[i]->v * invW[i];
+    }
+
+    // Twice the signed area, degenerate triangles cover no pixels
+    const float area = (x[1] - x[0]) * (y[2] - y[0]) -
+        (x[2] - x[0]) * (y[1] - y[0]);
+    if (std::fabs(area) < 1e-8f)
+    {
+        return;
+    }
+
+    RasterTriangle triangle;
+    triangle.minX = std::max(0, static_cast<int>(std::floor(
+        std::min({ x[0], x[1], x[2] }))));
+    triangle.maxX = std::min(width_ - 1, static_cast<int>(std::ceil(
+        std::max({ x[0], x[1], x[2] }))));
+    triangle.minY = std::max(0, static_cast<int>(std::floor(
+        std::min({ y[0], y[1], y[2] }))));
+    triangle.maxY = std::min(height_ - 1, static_cast<int>(std::ceil(
+        std::max({ y[0], y[1], y[2] }))));
+    if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+    {
+        return;
+    }
+
+    // The edge opposite to vertex i runs from vertex i + 1 to vertex i + 2.
+    // No face culling is enabled in the GL path, so both windings are drawn
+    // by flipping the edges of clockwise triangles.
+    const float orientation = area > 0.0f ? 1.0f : -1.0f;
+    for (int i = 0; i < 3; ++i)
+    {
+        const int a = (i + 1) % 3;
+        const int b = (i + 2) % 3;
+        triangle.edges[i].dx = (y[a] - y[b]) * orientation;
+        triangle.edges[i].dy = (x[b] - x[a]) * orientation;
+        triangle.edges[i].c = ((y[b] - y[a]) * x[a] - (x[b] - x[a]) * y[a]) *
+            orientation;
+    }
+
+    // Attributes that are linear in screen space
+    const auto makePlane = [&](const float value[3])
+    {
+        PlaneEquation plane;
+        plane.dx = ((value[1] - value[0]) * (y[2] - y[0]) -
+            (value[2] - value[0]) * (y[1] - y[0])) / area;
+        plane.dy = ((value[2] - value[0]) * (x[1] - x[0]) -
+            (value[1] - value[0]) * (x[2] - x[0])) / area;
+        plane.c = value[0] - plane.dx * x[0] - plane.dy * y[0];
+        return plane;
+    };
+    triangle.depth = makePlane(z);
+    triangle.invW = makePlane(invW);
+    triangle.uOverW = makePlane(uOverW);
+    triangle.vOverW = makePlane(vOverW);
+    triangle.minDepth = std::min({ z[0], z[1], z[2] });
+
+    // Bin the triangle into every tile its bounding box overlaps
+    const auto index = static_cast<std::uint32_t>(triangles_.size());
+    triangles_.push_back(triangle);
+    for (int ty = triangle.minY / SoftwareConstants::TILE_SIZE;
+        ty <= triangle.maxY / SoftwareConstants::TILE_SIZE; ++ty)
+    {
+        for (int tx = triangle.minX / SoftwareConstants::TILE_SIZE;
+            tx <= triangle.maxX / SoftwareConstants::TILE_SIZE; ++tx)
+        {
+            tileBins_[ty * tilesX_ + tx].push_back(index);
+        }
+    }
+}
+
+void Renderer::SoftwareRenderer::workerLoop()
+{
+    std::uint64_t lastFrame = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            frameStart_.wait(lock,
+                [&] { return shutdown_ || frameIndex_ != lastFrame; });
+            if (shutdown_)
+            {
+                return;
+            }
+            lastFrame = frameIndex_;
+        }
+
+        processTiles();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--busyWorkers_ == 0)
+            {
+                frameDone_.notify_one();
+            }
+        }
+    }
+}
+
+void Renderer::SoftwareRenderer::processTiles()
+{
+    const int tileCount = tilesX_ * tilesY_;
+    for (int tile = nextTile_.fetch_add(1); tile < tileCount;
+        tile = nextTile_.fetch_add(1))
+    {
+        renderTile(tile);
+    }
+}
+
+void Renderer::SoftwareRenderer::renderTile(int tileIndex)
+{
+    constexpr int tileSize = SoftwareConstants::TILE_SIZE;
+    constexpr int blockSize = SoftwareConstants::HIZ_BLOCK_SIZE;
+    const int tileX = (tileIndex % tilesX_) * tileSize;
+    const int tileY = (tileIndex / tilesX_) * tileSize;
+
+    // Clear the color, depth and hierarchical depth of the tile
+    for (int y = tileY; y < tileY + tileSize; ++y)
+    {
+        const std::size_t row = static_cast<std::size_t>(y) * paddedWidth_;
+        std::fill_n(&depthBuffer_[row + tileX], tileSize, 1.0f);
+        std::uint8_t* color = &colorBuffer_[(row + tileX) * 4];
+        for (int x = 0; x < tileSize; ++x)
+        {
+            std::memcpy(color + x * 4, CLEAR_COLOR, 4);
+        }
+    }
+    for (int by = tileY / blockSize; by < (tileY + tileSize) / blockSize; ++by)
+    {
+        std::fill_n(&hiZBuffer_[by * blocksX_ + tileX / blockSize],
+            tileSize / blockSize, 1.0f);
+    }
+
+    for (const std::uint32_t index : tileBins_[tileIndex])
+    {
+        const RasterTriangle& triangle = triangles_[index];
+        const int minX = std::max(triangle.minX, tileX);
+        const int maxX = std::min(triangle.maxX, tileX + tileSize - 1);
+        const int minY = std::max(triangle.minY, tileY);
+        const int maxY = std::min(triangle.maxY, tileY + tileSize - 1);
+
+        for (int by = minY / blockSize; by <= maxY / blockSize; ++by)
+        {
+            for (int bx = minX / blockSize; bx <= maxX / blockSize; ++bx)
+            {
+                // Skip blocks where every stored depth is already nearer
+                // than the nearest point of the triangle
+                if (triangle.minDepth >= hiZBuffer_[by * blocksX_ + bx])
+                {
+                    continue;
+                }
+                if (rasterizeBlock(triangle, bx, by, minX, minY, maxX, maxY))
+                {
+                    updateHiZ(bx, by);
+                }
+            }
+        }
+    }
+}
+
+bool Renderer::SoftwareRenderer::rasterizeBlock(const RasterTriangle& triangle,
+    int blockX, int blockY, int minX, int minY, int maxX, int maxY)
+{
+    constexpr int blockSize = SoftwareConstants::HIZ_BLOCK_SIZE;
+    constexpr int simdWidth = SoftwareConstants::SIMD_WIDTH;
+    const int startY = std::max(blockY * blockSize, minY);
+    const int endY = std::min(blockY * blockSize + blockSize - 1, maxY);
+    const int startX = blockX * blockSize;
+    const int endX = std::min(startX + blockSize - 1, maxX);
+    bool written = false;
+
+    // The mipmap levels of the 2x2 quads of the block, selected when the
+    // first pixel of a quad is shaded
+    constexpr int quadsPerRow = blockSize / 2;
+    int quadLevels[quadsPerRow * quadsPerRow][2];
+    std::uint32_t selectedQuads = 0;
+    static_assert(quadsPerRow * quadsPerRow <= 32,
+        "The selected quads of a block must fit in the mask");
+
+#ifdef SOFTWARE_RENDERER_SSE2
+    const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 zero = _mm_setzero_ps();
+#endif
+
+    for (int y = startY; y <= endY; ++y)
+    {
+        const float centerY = static_cast<float>(y) + 0.5f;
+        float* depthRow = &depthBuffer_[static_cast<std::size_t>(y) * paddedWidth_];
+
+        // Groups of simdWidth pixels that overlap the bounding box
+        const int firstGroup = startX + (std::max(minX, startX) - startX) /
+            simdWidth * simdWidth;
+        for (int groupX = firstGroup; groupX <= endX; groupX += simdWidth)
+        {
+            float depths[simdWidth];
+            int coverage = 0;
+
+#ifdef SOFTWARE_RENDERER_SSE2
+            const __m128 pixelX = _mm_add_ps(
+                _mm_set1_ps(static_cast<float>(groupX)), laneOffsets);
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (const PlaneEquation& edge : triangle.edges)
+            {
+                const __m128 value = _mm_add_ps(
+                    _mm_mul_ps(_mm_set1_ps(edge.dx), pixelX),
+                    _mm_set1_ps(edge.dy * centerY + edge.c));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(value, zero));
+            }
+            if (_mm_movemask_ps(inside) == 0)
+            {
+                continue;
+            }
+
+            const __m128 depth = _mm_add_ps(
+                _mm_mul_ps(_mm_set1_ps(triangle.depth.dx), pixelX),
+                _mm_set1_ps(triangle.depth.dy * centerY + triangle.depth.c));
+            const __m128 stored = _mm_loadu_ps(depthRow + groupX);
+            inside = _mm_and_ps(inside, _mm_cmplt_ps(depth, stored));
+            coverage = _mm_movemask_ps(inside);
+            _mm_storeu_ps(depths, depth);
+#else
+            for (int lane = 0; lane < simdWidth; ++lane)
+            {
+                const float pixelX = static_cast<float>(groupX + lane) + 0.5f;
+                bool inside = true;
+                for (const PlaneEquation& edge : triangle.edges)
+                {
+                    inside = inside &&
+                        edge.dx * pixelX + edge.dy * centerY + edge.c >= 0.0f;
+                }
+                depths[lane] = triangle.depth.dx * pixelX +
+                    triangle.depth.dy * centerY + triangle.depth.c;
+                if (inside && depths[lane] < depthRow[groupX + lane])
+                {
+                    coverage |= 1 << lane;
+                }
+            }
+#endif
+
+            for (int lane = 0; lane < simdWidth; ++lane)
+            {
+                if (coverage & (1 << lane))
+                {
+                    const int x = groupX + lane;
+                    const int quad = (y - blockY * blockSize) / 2 *
+                        quadsPerRow + (x - startX) / 2;
+                    if ((selectedQuads & (1u << quad)) == 0)
+                    {
+                        selectQuadLevels(triangle, x & ~1, y & ~1,
+                            quadLevels[quad]);
+                        selectedQuads |= 1u << quad;
+                    }
+                    shadePixel(triangle, x, y, depths[lane],
+                        quadLevels[quad]);
+                    written = true;
+                }
+            }
+        }
+    }
+    return written;
+}
+
+void Renderer::SoftwareRenderer::selectQuadLevels(
+    const RasterTriangle& triangle, int quadX, int quadY, int levels[2]) const
+{
+    // Perspective-correct texture coordinates at a pixel center
+    const auto texCoords = [&triangle](int x, int y, float& u, float& v)
+    {
+        const float centerX = static_cast<float>(x) + 0.5f;
+        const float centerY = static_cast<float>(y) + 0.5f;
+        const auto evaluate = [&](const PlaneEquation& plane)
+        {
+            return plane.dx * centerX + plane.dy * centerY + plane.c;
+        };
+        const float w = 1.0f / evaluate(triangle.invW);
+        u = evaluate(triangle.uOverW) * w;
+        v = evaluate(triangle.vOverW) * w;
+    };
+
+    // Coarse derivatives from the top left pixel of the quad to its
+    // neighbors, like dFdx and dFdy
+    float u, v, uRight, vRight, uBelow, vBelow;
+    texCoords(quadX, quadY, u, v);
+    texCoords(quadX + 1, quadY, uRight, vRight);
+    texCoords(quadX, quadY + 1, uBelow, vBelow);
+    const float dudx = uRight - u;
+    const float dvdx = vRight - v;
+    const float dudy = uBelow - u;
+    const float dvdy = vBelow - v;
+
+    levels[0] = shelfTexture_.selectLevel(dudx, dvdx, dudy, dvdy);
+    levels[1] = duckyTexture_.selectLevel(dudx, dvdx, dudy, dvdy);
+}
+
+void Renderer::SoftwareRenderer::shadePixel(const RasterTriangle& triangle,
+    int x, int y, float depth, const int levels[2])
+{
+    const float centerX = static_cast<float>(x) + 0.5f;
+    const float centerY = static_cast<float>(y) + 0.5f;
+    const auto evaluate = [&](const PlaneEquation& plane)
+    {
+        return plane.dx * centerX + plane.dy * centerY + plane.c;
+    };
+
+    // Perspective-correct texture coordinates
+    const float w = 1.0f / evaluate(triangle.invW);
+    const float u = evaluate(triangle.uOverW) * w;
+    const float v = evaluate(triangle.vOverW) * w;
+
+    // Fragment stage: the same blend as shader.fs
+    float shelf[4];
+    float ducky[4];
+    shelfTexture_.sample(u, v, levels[0], shelf);
+    duckyTexture_.sample(u, v, levels[1], ducky);
+
+    const std::size_t pixel = static_cast<std::size_t>(y) * paddedWidth_ + x;
+    std::uint8_t* color = &colorBuffer_[pixel * 4];
+    for (int c = 0; c < 3; ++c)
+    {
+        const float mixed = shelf[c] +
+            (ducky[c] - shelf[c]) * SoftwareConstants::MIX_FACTOR;
+        color[c] = static_cast<std::uint8_t>(
+            std::clamp(mixed + 0.5f, 0.0f, 255.0f));
+    }
+    // The window is opaque, so alpha is not blended
+    color[3] = 255;
+    depthBuffer_[pixel] = depth;
+}
+
+void Renderer::SoftwareRenderer::updateHiZ(int blockX, int blockY)
+{
+    constexpr int blockSize = SoftwareConstants::HIZ_BLOCK_SIZE;
+    float farthest = 0.0f;
+    for (int y = blockY * blockSize; y < (blockY + 1) * blockSize; ++y)
+    {
+        const float* row = &depthBuffer_[static_cast<std::size_t>(y) *
+            paddedWidth_ + blockX * blockSize];
+        farthest = std::max(farthest, *std::max_element(row, row + blockSize));
+    }
+    hiZBuffer_[blockY * blocksX_ + blockX] = farthest;
+}
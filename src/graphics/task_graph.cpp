@@ -0,0 +1,268 @@
+#include "task_graph.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    double millisecondsBetween(std::chrono::steady_clock::time_point from,
+        std::chrono::steady_clock::time_point to)
+    {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    }
+}
+
+Renderer::TaskGraph::TaskGraph() : finished_{ 0 }, started_{ false },
+    stopping_{ false }
+{
+}
+
+Renderer::TaskGraph::~TaskGraph()
+{
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    workerReady_.notify_all();
+    for (std::thread& worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+Renderer::TaskId Renderer::TaskGraph::add(const char* name,
+    TaskThread thread, std::function<void()> work,
+    std::initializer_list<TaskId> dependencies)
+{
+    if (started_)
+    {
+        throw std::logic_error("ERROR::TASK_GRAPH::TASK ADDED AFTER START");
+    }
+    const TaskId task = tasks_.size();
+    for (const TaskId dependency : dependencies)
+    {
+        if (dependency >= task)
+        {
+            throw std::logic_error("ERROR::TASK_GRAPH::UNKNOWN DEPENDENCY");
+        }
+        tasks_[dependency].dependents.push_back(task);
+    }
+    tasks_.push_back(Task{ name, thread, std::move(work), {},
+        dependencies.size(), TaskState::WAITING, {}, {} });
+    return task;
+}
+
+void Renderer::TaskGraph::start(std::size_t workers)
+{
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        started_ = true;
+        start_ = Clock::now();
+        end_ = start_;
+        for (TaskId task = 0; task < tasks_.size(); ++task)
+        {
+            if (tasks_[task].remaining == 0)
+            {
+                makeReady(task);
+            }
+        }
+    }
+    for (std::size_t i = 0; i < std::max<std::size_t>(workers, 1); ++i)
+    {
+        workers_.emplace_back(&TaskGraph::workerLoop, this);
+    }
+}
+
+void Renderer::TaskGraph::wait(TaskId task)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        rethrowFailure();
+        if (tasks_.at(task).state == TaskState::DONE)
+        {
+            return;
+        }
+        if (!contextQueue_.empty())
+        {
+            const TaskId next = contextQueue_.front();
+            contextQueue_.pop_front();
+            run(next, lock);
+            continue;
+        }
+        contextReady_.wait(lock);
+    }
+}
+
+bool Renderer::TaskGraph::poll()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!contextQueue_.empty())
+    {
+        rethrowFailure();
+        const TaskId next = contextQueue_.front();
+        contextQueue_.pop_front();
+        run(next, lock);
+    }
+    rethrowFailure();
+    return finished_ == tasks_.size();
+}
+
+void Renderer::TaskGraph::waitAll()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        rethrowFailure();
+        if (finished_ == tasks_.size())
+        {
+            return;
+        }
+        if (!contextQueue_.empty())
+        {
+            const TaskId next = contextQueue_.front();
+            contextQueue_.pop_front();
+            run(next, lock);
+            continue;
+        }
+        contextReady_.wait(lock);
+    }
+}
+
+std::vector<Renderer::TaskTiming> Renderer::TaskGraph::getTimings() const
+{
+    const std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<TaskTiming> timings;
+    for (const Task& task : tasks_)
+    {
+        if (task.state == TaskState::DONE)
+        {
+            timings.push_back(TaskTiming{ task.name, task.thread,
+                millisecondsBetween(start_, task.start),
+                millisecondsBetween(start_, task.end) });
+        }
+    }
+    return timings;
+}
+
+double Renderer::TaskGraph::getElapsedMs() const
+{
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return millisecondsBetween(start_,
+        finished_ == tasks_.size() ? end_ : Clock::now());
+}
+
+void Renderer::TaskGraph::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        workerReady_.wait(lock, [this]() {
+            return stopping_ || !workerQueue_.empty();
+            });
+        if (stopping_)
+        {
+            return;
+        }
+        const TaskId next = workerQueue_.front();
+        workerQueue_.pop_front();
+        run(next, lock);
+    }
+}
+
+void Renderer::TaskGraph::makeReady(TaskId task)
+{
+    tasks_[task].state = TaskState::READY;
+    if (tasks_[task].thread == TaskThread::WORKER)
+    {
+        workerQueue_.push_back(task);
+        workerReady_.notify_one();
+    }
+    else
+    {
+        contextQueue_.push_back(task);
+        contextReady_.notify_all();
+    }
+}
+
+void Renderer::TaskGraph::run(TaskId task, std::unique_lock<std::mutex>& lock)
+{
+    tasks_[task].state = TaskState::RUNNING;
+    tasks_[task].start = Clock::now();
+    // No other thread touches a running task's work
+    std::function<void()>& work = tasks_[task].work;
+    std::exception_ptr failure;
+    lock.unlock();
+    try
+    {
+        work();
+    }
+    catch (...)
+    {
+        failure = std::current_exception();
+    }
+    lock.lock();
+
+    tasks_[task].end = Clock::now();
+    end_ = tasks_[task].end;
+    if (failure)
+    {
+        if (!failure_)
+        {
+            failure_ = failure;
+        }
+        fail(task);
+    }
+    else
+    {
+        tasks_[task].state = TaskState::DONE;
+        ++finished_;
+        for (const TaskId dependent : tasks_[task].dependents)
+        {
+            if (--tasks_[dependent].remaining == 0 &&
+                tasks_[dependent].state == TaskState::WAITING)
+            {
+                makeReady(dependent);
+            }
+        }
+    }
+    // Release what the work captured, on the thread that ran it
+    tasks_[task].work = nullptr;
+    contextReady_.notify_all();
+}
+
+void Renderer::TaskGraph::fail(TaskId task)
+{
+    if (tasks_[task].state == TaskState::FAILED)
+    {
+        return;
+    }
+    tasks_[task].state = TaskState::FAILED;
+    ++finished_;
+    for (const TaskId dependent : tasks_[task].dependents)
+    {
+        fail(dependent);
+    }
+}
+
+void Renderer::TaskGraph::rethrowFailure() const
+{
+    if (failure_)
+    {
+        std::rethrow_exception(failure_);
+    }
+}
+
+std::string Renderer::formatTimings(const std::vector<TaskTiming>& timings)
+{
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(1);
+    for (const TaskTiming& timing : timings)
+    {
+        report << "  " << timing.name << " ("
+            << (timing.thread == TaskThread::WORKER ? "worker" : "context")
+            << "): " << timing.startMs << " - " << timing.endMs << " ms\n";
+    }
+    return report.str();
+}
@@ -0,0 +1,1519 @@
+#include "trace.hpp"
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace
+{
+    // The row alignment GL_UNPACK_ALIGNMENT defaults to
+    constexpr std::size_t UNPACK_ALIGNMENT = 4;
+
+    /**
+     * @brief Reads values from trace data with bounds checking.
+     */
+    class TraceReader
+    {
+    public:
+        TraceReader(const std::vector<char>& data, std::size_t offset) :
+            data_{ data }, offset_{ offset }
+        {
+        }
+
+        template <typename T>
+        T read()
+        {
+            require(sizeof(T));
+            T value;
+            std::memcpy(&value, data_.data() + offset_, sizeof(T));
+            offset_ += sizeof(T);
+            return value;
+        }
+
+        // Returns the bytes of a data block, nullptr for a null block
+        const char* readBlock(std::size_t& size)
+        {
+            size = static_cast<std::size_t>(read<std::uint64_t>());
+            if (read<std::uint8_t>() == 0)
+            {
+                return nullptr;
+            }
+            require(size);
+            const char* block = data_.data() + offset_;
+            offset_ += size;
+            return block;
+        }
+
+        std::size_t getOffset() const { return offset_; }
+
+    private:
+        void require(std::size_t size) const
+        {
+            if (size > data_.size() - offset_)
+            {
+                throw std::runtime_error("ERROR::TRACE::TRUNCATED RECORD");
+            }
+        }
+
+        const std::vector<char>& data_;
+        std::size_t offset_;
+    };
+}
+
+Renderer::TraceRecorder::TraceRecorder(std::unique_ptr<Device> device,
+    const std::string& path) : device_{ std::move(device) },
+    file_(path, std::ios::binary), start_{ std::chrono::steady_clock::now() },
+    segmentCount_{ 0 }
+{
+    if (!file_)
+    {
+        throw std::runtime_error("ERROR::TRACE::CANNOT CREATE " + path);
+    }
+    file_.write(TraceFormat::MAGIC, sizeof(TraceFormat::MAGIC));
+    file_.write(reinterpret_cast<const char*>(&TraceFormat::VERSION),
+        sizeof(TraceFormat::VERSION));
+}
+
+Renderer::TraceRecorder::~TraceRecorder()
+{
+    stop();
+}
+
+void Renderer::TraceRecorder::endFrame()
+{
+    if (!begin(TraceOp::FRAME_END))
+    {
+        return;
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start_);
+    write(static_cast<std::uint64_t>(elapsed.count()));
+    ++segmentCount_;
+    flush();
+}
+
+void Renderer::TraceRecorder::stop()
+{
+    if (isRecording())
+    {
+        flush();
+        file_.close();
+    }
+}
+
+bool Renderer::TraceRecorder::begin(TraceOp op)
+{
+    if (!isRecording())
+    {
+        return false;
+    }
+    write(op);
+    return true;
+}
+
+void Renderer::TraceRecorder::writeBlock(const void* data, std::size_t size)
+{
+    write(static_cast<std::uint64_t>(size));
+    write(static_cast<std::uint8_t>(data != nullptr));
+    if (data != nullptr)
+    {
+        const char* bytes = static_cast<const char*>(data);
+        pending_.insert(pending_.end(), bytes, bytes + size);
+    }
+}
+
+void Renderer::TraceRecorder::flush()
+{
+    file_.write(pending_.data(), static_cast<std::streamsize>(pending_.size()));
+    pending_.clear();
+}
+
+GLuint Renderer::TraceRecorder::createVertexArray()
+{
+    const GLuint vertexArray = device_->createVertexArray();
+    if (begin(TraceOp::CREATE_VERTEX_ARRAY))
+    {
+        write(vertexArray);
+    }
+    return vertexArray;
+}
+
+void Renderer::TraceRecorder::bindVertexArray(GLuint vertexArray)
+{
+    if (begin(TraceOp::BIND_VERTEX_ARRAY))
+    {
+        write(vertexArray);
+    }
+    device_->bindVertexArray(vertexArray);
+}
+
+void Renderer::TraceRecorder::deleteVertexArray(GLuint vertexArray)
+{
+    if (begin(TraceOp::DELETE_VERTEX_ARRAY))
+    {
+        write(vertexArray);
+    }
+    device_->deleteVertexArray(vertexArray);
+}
+
+GLuint Renderer::TraceRecorder::createBuffer()
+{
+    const GLuint buffer = device_->createBuffer();
+    if (begin(TraceOp::CREATE_BUFFER))
+    {
+        write(buffer);
+    }
+    return buffer;
+}
+
+void Renderer::TraceRecorder::bindBuffer(GLenum target, GLuint buffer)
+{
+    if (begin(TraceOp::BIND_BUFFER))
+    {
+        write(target);
+        write(buffer);
+    }
+    device_->bindBuffer(target, buffer);
+}
+
+void Renderer::TraceRecorder::deleteBuffer(GLuint buffer)
+{
+    if (begin(TraceOp::DELETE_BUFFER))
+    {
+        write(buffer);
+    }
+    device_->deleteBuffer(buffer);
+}
+
+void Renderer::TraceRecorder::bufferData(GLenum target, GLsizeiptr size,
+    const void* data, GLenum usage)
+{
+    if (begin(TraceOp::BUFFER_DATA))
+    {
+        write(target);
+        write(usage);
+        writeBlock(data, static_cast<std::size_t>(size));
+    }
+    device_->bufferData(target, size, data, usage);
+}
+
+void Renderer::TraceRecorder::vertexAttribPointer(GLuint index, GLint size,
+    GLenum type, GLsizei stride, std::size_t offset)
+{
+    if (begin(TraceOp::VERTEX_ATTRIB_POINTER))
+    {
+        write(index);
+        write(size);
+        write(type);
+        write(stride);
+        write(static_cast<std::uint64_t>(offset));
+    }
+    device_->vertexAttribPointer(index, size, type, stride, offset);
+}
+
+void Renderer::TraceRecorder::enableVertexAttribArray(GLuint index)
+{
+    if (begin(TraceOp::ENABLE_VERTEX_ATTRIB_ARRAY))
+    {
+        write(index);
+    }
+    device_->enableVertexAttribArray(index);
+}
+
+void Renderer::TraceRecorder::vertexAttribDivisor(GLuint index,
+    GLuint divisor)
+{
+    if (begin(TraceOp::VERTEX_ATTRIB_DIVISOR))
+    {
+        write(index);
+        write(divisor);
+    }
+    device_->vertexAttribDivisor(index, divisor);
+}
+
+void Renderer::TraceRecorder::bindBufferBase(GLenum target, GLuint index,
+    GLuint buffer)
+{
+    if (begin(TraceOp::BIND_BUFFER_BASE))
+    {
+        write(target);
+        write(index);
+        write(buffer);
+    }
+    device_->bindBufferBase(target, index, buffer);
+}
+
+GLuint Renderer::TraceRecorder::createTexture()
+{
+    const GLuint texture = device_->createTexture();
+    if (begin(TraceOp::CREATE_TEXTURE))
+    {
+        write(texture);
+    }
+    return texture;
+}
+
+void Renderer::TraceRecorder::activeTexture(GLenum unit)
+{
+    if (begin(TraceOp::ACTIVE_TEXTURE))
+    {
+        write(unit);
+    }
+    device_->activeTexture(unit);
+}
+
+void Renderer::TraceRecorder::bindTexture(GLenum target, GLuint texture)
+{
+    if (begin(TraceOp::BIND_TEXTURE))
+    {
+        write(target);
+        write(texture);
+    }
+    device_->bindTexture(target, texture);
+}
+
+void Renderer::TraceRecorder::deleteTexture(GLuint texture)
+{
+    if (begin(TraceOp::DELETE_TEXTURE))
+    {
+        write(texture);
+    }
+    device_->deleteTexture(texture);
+}
+
+void Renderer::TraceRecorder::texParameter(GLenum target, GLenum name,
+    GLint value)
+{
+    if (begin(TraceOp::TEX_PARAMETER))
+    {
+        write(target);
+        write(name);
+        write(value);
+    }
+    device_->texParameter(target, name, value);
+}
+
+void Renderer::TraceRecorder::texImage2D(GLenum target, GLint level,
+    GLint internalFormat, GLsizei width, GLsizei height, GLenum format,
+    GLenum type, const void* pixels)
+{
+    if (begin(TraceOp::TEX_IMAGE_2D))
+    {
+        write(target);
+        write(level);
+        write(internalFormat);
+        write(width);
+        write(height);
+        write(format);
+        write(type);
+        // The client images of the renderer are tightly packed
+        writeBlock(pixels, static_cast<std::size_t>(width) * height *
+            pixelSize(format, type));
+    }
+    device_->texImage2D(target, level, internalFormat, width, height, format,
+        type, pixels);
+}
+
+void Renderer::TraceRecorder::generateMipmap(GLenum target)
+{
+    if (begin(TraceOp::GENERATE_MIPMAP))
+    {
+        write(target);
+    }
+    device_->generateMipmap(target);
+}
+
+void Renderer::TraceRecorder::bindImageTexture(GLuint unit, GLuint texture,
+    GLint level, GLenum access, GLenum format)
+{
+    if (begin(TraceOp::BIND_IMAGE_TEXTURE))
+    {
+        write(unit);
+        write(texture);
+        write(level);
+        write(access);
+        write(format);
+    }
+    device_->bindImageTexture(unit, texture, level, access, format);
+}
+
+GLuint Renderer::TraceRecorder::createShader(GLenum type)
+{
+    const GLuint shader = device_->createShader(type);
+    if (begin(TraceOp::CREATE_SHADER))
+    {
+        write(type);
+        write(shader);
+    }
+    return shader;
+}
+
+void Renderer::TraceRecorder::shaderSource(GLuint shader,
+    const std::string& source)
+{
+    if (begin(TraceOp::SHADER_SOURCE))
+    {
+        write(shader);
+        writeBlock(source.data(), source.size());
+    }
+    device_->shaderSource(shader, source);
+}
+
+void Renderer::TraceRecorder::compileShader(GLuint shader)
+{
+    if (begin(TraceOp::COMPILE_SHADER))
+    {
+        write(shader);
+    }
+    device_->compileShader(shader);
+}
+
+bool Renderer::TraceRecorder::getCompileStatus(GLuint shader,
+    std::string& infoLog)
+{
+    if (begin(TraceOp::GET_COMPILE_STATUS))
+    {
+        write(shader);
+    }
+    return device_->getCompileStatus(shader, infoLog);
+}
+
+void Renderer::TraceRecorder::deleteShader(GLuint shader)
+{
+    if (begin(TraceOp::DELETE_SHADER))
+    {
+        write(shader);
+    }
+    device_->deleteShader(shader);
+}
+
+GLuint Renderer::TraceRecorder::createProgram()
+{
+    const GLuint program = device_->createProgram();
+    if (begin(TraceOp::CREATE_PROGRAM))
+    {
+        write(program);
+    }
+    return program;
+}
+
+void Renderer::TraceRecorder::attachShader(GLuint program, GLuint shader)
+{
+    if (begin(TraceOp::ATTACH_SHADER))
+    {
+        write(program);
+        write(shader);
+    }
+    device_->attachShader(program, shader);
+}
+
+void Renderer::TraceRecorder::linkProgram(GLuint program)
+{
+    if (begin(TraceOp::LINK_PROGRAM))
+    {
+        write(program);
+    }
+    device_->linkProgram(program);
+}
+
+bool Renderer::TraceRecorder::getLinkStatus(GLuint program,
+    std::string& infoLog)
+{
+    if (begin(TraceOp::GET_LINK_STATUS))
+    {
+        write(program);
+    }
+    return device_->getLinkStatus(program, infoLog);
+}
+
+void Renderer::TraceRecorder::useProgram(GLuint program)
+{
+    if (begin(TraceOp::USE_PROGRAM))
+    {
+        write(program);
+    }
+    device_->useProgram(program);
+}
+
+void Renderer::TraceRecorder::deleteProgram(GLuint program)
+{
+    if (begin(TraceOp::DELETE_PROGRAM))
+    {
+        write(program);
+    }
+    device_->deleteProgram(program);
+}
+
+GLint Renderer::TraceRecorder::getUniformLocation(GLuint program,
+    const char* name)
+{
+    const GLint location = device_->getUniformLocation(program, name);
+    if (begin(TraceOp::GET_UNIFORM_LOCATION))
+    {
+        write(program);
+        writeBlock(name, std::strlen(name));
+        write(location);
+    }
+    return location;
+}
+
+void Renderer::TraceRecorder::uniform1i(GLint location, GLint value)
+{
+    if (begin(TraceOp::UNIFORM_1I))
+    {
+        write(location);
+        write(value);
+    }
+    device_->uniform1i(location, value);
+}
+
+void Renderer::TraceRecorder::uniform1f(GLint location, GLfloat value)
+{
+    if (begin(TraceOp::UNIFORM_1F))
+    {
+        write(location);
+        write(value);
+    }
+    device_->uniform1f(location, value);
+}
+
+void Renderer::TraceRecorder::uniformMatrix4fv(GLint location,
+    const GLfloat* value)
+{
+    if (begin(TraceOp::UNIFORM_MATRIX_4FV))
+    {
+        write(location);
+        for (int i = 0; i < 16; ++i)
+        {
+            write(value[i]);
+        }
+    }
+    device_->uniformMatrix4fv(location, value);
+}
+
+void Renderer::TraceRecorder::viewport(GLint x, GLint y, GLsizei width,
+    GLsizei height)
+{
+    if (begin(TraceOp::VIEWPORT))
+    {
+        write(x);
+        write(y);
+        write(width);
+        write(height);
+    }
+    device_->viewport(x, y, width, height);
+}
+
+void Renderer::TraceRecorder::enable(GLenum capability)
+{
+    if (begin(TraceOp::ENABLE))
+    {
+        write(capability);
+    }
+    device_->enable(capability);
+}
+
+void Renderer::TraceRecorder::disable(GLenum capability)
+{
+    if (begin(TraceOp::DISABLE))
+    {
+        write(capability);
+    }
+    device_->disable(capability);
+}
+
+void Renderer::TraceRecorder::blendFunc(GLenum sourceFactor,
+    GLenum destFactor)
+{
+    if (begin(TraceOp::BLEND_FUNC))
+    {
+        write(sourceFactor);
+        write(destFactor);
+    }
+    device_->blendFunc(sourceFactor, destFactor);
+}
+
+void Renderer::TraceRecorder::clearColor(GLfloat red, GLfloat green,
+    GLfloat blue, GLfloat alpha)
+{
+    if (begin(TraceOp::CLEAR_COLOR))
+    {
+        write(red);
+        write(green);
+        write(blue);
+        write(alpha);
+    }
+    device_->clearColor(red, green, blue, alpha);
+}
+
+void Renderer::TraceRecorder::clear(GLbitfield mask)
+{
+    if (begin(TraceOp::CLEAR))
+    {
+        write(mask);
+    }
+    device_->clear(mask);
+}
+
+void Renderer::TraceRecorder::drawArrays(GLenum mode, GLint first,
+    GLsizei count)
+{
+    if (begin(TraceOp::DRAW_ARRAYS))
+    {
+        write(mode);
+        write(first);
+        write(count);
+    }
+    device_->drawArrays(mode, first, count);
+}
+
+void Renderer::TraceRecorder::drawElements(GLenum mode, GLsizei count,
+    GLenum type, std::size_t offset)
+{
+    if (begin(TraceOp::DRAW_ELEMENTS))
+    {
+        write(mode);
+        write(count);
+        write(type);
+        write(static_cast<std::uint64_t>(offset));
+    }
+    device_->drawElements(mode, count, type, offset);
+}
+
+void Renderer::TraceRecorder::multiDrawArraysIndirect(GLenum mode,
+    std::size_t offset, GLsizei drawCount, GLsizei stride)
+{
+    if (begin(TraceOp::MULTI_DRAW_ARRAYS_INDIRECT))
+    {
+        write(mode);
+        write(static_cast<std::uint64_t>(offset));
+        write(drawCount);
+        write(stride);
+    }
+    device_->multiDrawArraysIndirect(mode, offset, drawCount, stride);
+}
+
+void Renderer::TraceRecorder::dispatchCompute(GLuint groupsX, GLuint groupsY,
+    GLuint groupsZ)
+{
+    if (begin(TraceOp::DISPATCH_COMPUTE))
+    {
+        write(groupsX);
+        write(groupsY);
+        write(groupsZ);
+    }
+    device_->dispatchCompute(groupsX, groupsY, groupsZ);
+}
+
+void Renderer::TraceRecorder::memoryBarrier(GLbitfield barriers)
+{
+    if (begin(TraceOp::MEMORY_BARRIER))
+    {
+        write(barriers);
+    }
+    device_->memoryBarrier(barriers);
+}
+
+GLuint Renderer::TraceRecorder::createFramebuffer()
+{
+    const GLuint framebuffer = device_->createFramebuffer();
+    if (begin(TraceOp::CREATE_FRAMEBUFFER))
+    {
+        write(framebuffer);
+    }
+    return framebuffer;
+}
+
+void Renderer::TraceRecorder::bindFramebuffer(GLenum target,
+    GLuint framebuffer)
+{
+    if (begin(TraceOp::BIND_FRAMEBUFFER))
+    {
+        write(target);
+        write(framebuffer);
+    }
+    device_->bindFramebuffer(target, framebuffer);
+}
+
+void Renderer::TraceRecorder::deleteFramebuffer(GLuint framebuffer)
+{
+    if (begin(TraceOp::DELETE_FRAMEBUFFER))
+    {
+        write(framebuffer);
+    }
+    device_->deleteFramebuffer(framebuffer);
+}
+
+GLuint Renderer::TraceRecorder::createRenderbuffer()
+{
+    const GLuint renderbuffer = device_->createRenderbuffer();
+    if (begin(TraceOp::CREATE_RENDERBUFFER))
+    {
+        write(renderbuffer);
+    }
+    return renderbuffer;
+}
+
+void Renderer::TraceRecorder::bindRenderbuffer(GLuint renderbuffer)
+{
+    if (begin(TraceOp::BIND_RENDERBUFFER))
+    {
+        write(renderbuffer);
+    }
+    device_->bindRenderbuffer(renderbuffer);
+}
+
+void Renderer::TraceRecorder::deleteRenderbuffer(GLuint renderbuffer)
+{
+    if (begin(TraceOp::DELETE_RENDERBUFFER))
+    {
+        write(renderbuffer);
+    }
+    device_->deleteRenderbuffer(renderbuffer);
+}
+
+void Renderer::TraceRecorder::renderbufferStorage(GLsizei samples,
+    GLenum internalFormat, GLsizei width, GLsizei height)
+{
+    if (begin(TraceOp::RENDERBUFFER_STORAGE))
+    {
+        write(samples);
+        write(internalFormat);
+        write(width);
+        write(height);
+    }
+    device_->renderbufferStorage(samples, internalFormat, width, height);
+}
+
+void Renderer::TraceRecorder::framebufferRenderbuffer(GLenum target,
+    GLenum attachment, GLuint renderbuffer)
+{
+    if (begin(TraceOp::FRAMEBUFFER_RENDERBUFFER))
+    {
+        write(target);
+        write(attachment);
+        write(renderbuffer);
+    }
+    device_->framebufferRenderbuffer(target, attachment, renderbuffer);
+}
+
+void Renderer::TraceRecorder::framebufferTexture2D(GLenum target,
+    GLenum attachment, GLuint texture, GLint level)
+{
+    if (begin(TraceOp::FRAMEBUFFER_TEXTURE_2D))
+    {
+        write(target);
+        write(attachment);
+        write(texture);
+        write(level);
+    }
+    device_->framebufferTexture2D(target, attachment, texture, level);
+}
+
+GLenum Renderer::TraceRecorder::checkFramebufferStatus(GLenum target)
+{
+    if (begin(TraceOp::CHECK_FRAMEBUFFER_STATUS))
+    {
+        write(target);
+    }
+    return device_->checkFramebufferStatus(target);
+}
+
+void Renderer::TraceRecorder::blitFramebuffer(GLint srcX0, GLint srcY0,
+    GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1,
+    GLint dstY1, GLbitfield mask, GLenum filter)
+{
+    if (begin(TraceOp::BLIT_FRAMEBUFFER))
+    {
+        for (const GLint coordinate :
+            { srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1 })
+        {
+            write(coordinate);
+        }
+        write(mask);
+        write(filter);
+    }
+    device_->blitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1,
+        dstY1, mask, filter);
+}
+
+GLuint Renderer::TraceRecorder::createQuery()
+{
+    const GLuint query = device_->createQuery();
+    if (begin(TraceOp::CREATE_QUERY))
+    {
+        write(query);
+    }
+    return query;
+}
+
+void Renderer::TraceRecorder::deleteQuery(GLuint query)
+{
+    if (begin(TraceOp::DELETE_QUERY))
+    {
+        write(query);
+    }
+    device_->deleteQuery(query);
+}
+
+void Renderer::TraceRecorder::beginQuery(GLenum target, GLuint query)
+{
+    if (begin(TraceOp::BEGIN_QUERY))
+    {
+        write(target);
+        write(query);
+    }
+    device_->beginQuery(target, query);
+}
+
+void Renderer::TraceRecorder::endQuery(GLenum target)
+{
+    if (begin(TraceOp::END_QUERY))
+    {
+        write(target);
+    }
+    device_->endQuery(target);
+}
+
+bool Renderer::TraceRecorder::getQueryResult(GLuint query, GLuint64& result)
+{
+    if (begin(TraceOp::GET_QUERY_RESULT))
+    {
+        write(query);
+    }
+    return device_->getQueryResult(query, result);
+}
+
+GLuint Renderer::TraceRecorder::createFence()
+{
+    const GLuint fence = device_->createFence();
+    if (begin(TraceOp::CREATE_FENCE))
+    {
+        write(fence);
+    }
+    return fence;
+}
+
+bool Renderer::TraceRecorder::isFenceSignaled(GLuint fence)
+{
+    if (begin(TraceOp::IS_FENCE_SIGNALED))
+    {
+        write(fence);
+    }
+    return device_->isFenceSignaled(fence);
+}
+
+void Renderer::TraceRecorder::deleteFence(GLuint fence)
+{
+    if (begin(TraceOp::DELETE_FENCE))
+    {
+        write(fence);
+    }
+    device_->deleteFence(fence);
+}
+
+Renderer::TracePlayer::TracePlayer(const std::string& path) :
+    currentProgram_{ 0 }
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("ERROR::TRACE::CANNOT OPEN " + path);
+    }
+    data_.assign(std::istreambuf_iterator<char>(file),
+        std::istreambuf_iterator<char>());
+
+    // Check the header
+    constexpr std::size_t headerSize =
+        sizeof(TraceFormat::MAGIC) + sizeof(TraceFormat::VERSION);
+    std::uint32_t version = 0;
+    if (data_.size() < headerSize ||
+        std::memcmp(data_.data(), TraceFormat::MAGIC,
+            sizeof(TraceFormat::MAGIC)) != 0)
+    {
+        throw std::runtime_error("ERROR::TRACE::NOT A TRACE FILE " + path);
+    }
+    std::memcpy(&version, data_.data() + sizeof(TraceFormat::MAGIC),
+        sizeof(version));
+    if (version != TraceFormat::VERSION)
+    {
+        throw std::runtime_error("ERROR::TRACE::UNSUPPORTED VERSION " +
+            std::to_string(version));
+    }
+
+    // Index the segments by decoding every record once
+    std::size_t offset = headerSize;
+    std::size_t segmentBegin = offset;
+    while (offset < data_.size())
+    {
+        if (static_cast<TraceOp>(data_[offset]) == TraceOp::FRAME_END)
+        {
+            TraceReader reader(data_, offset + 1);
+            const auto timestamp = reader.read<std::uint64_t>();
+            segments_.push_back(Segment{ segmentBegin, offset, timestamp });
+            offset = reader.getOffset();
+            segmentBegin = offset;
+        }
+        else
+        {
+            offset = executeRecord(nullptr, offset);
+        }
+    }
+    if (segments_.empty())
+    {
+        throw std::runtime_error("ERROR::TRACE::NO SETUP SEGMENT IN " + path);
+    }
+}
+
+std::uint64_t Renderer::TracePlayer::getFrameTimestamp(std::size_t frame) const
+{
+    return segments_.at(frame + 1).timestamp - segments_.front().timestamp;
+}
+
+void Renderer::TracePlayer::replaySetup(Device& device)
+{
+    names_.clear();
+    locations_.clear();
+    currentProgram_ = 0;
+    replaySegment(device, segments_.front());
+}
+
+void Renderer::TracePlayer::replayFrame(Device& device, std::size_t frame)
+{
+    replaySegment(device, segments_.at(frame + 1));
+}
+
+void Renderer::TracePlayer::replaySegment(Device& device,
+    const Segment& segment)
+{
+    for (std::size_t offset = segment.begin; offset < segment.end;)
+    {
+        offset = executeRecord(&device, offset);
+    }
+}
+
+std::uint64_t Renderer::TracePlayer::nameKey(ObjectKind kind,
+    GLuint recorded)
+{
+    return (static_cast<std::uint64_t>(kind) << 32) | recorded;
+}
+
+GLuint Renderer::TracePlayer::mapName(ObjectKind kind, GLuint recorded) const
+{
+    if (recorded == 0)
+    {
+        return 0;
+    }
+    const auto name = names_.find(nameKey(kind, recorded));
+    if (name == names_.end())
+    {
+        throw std::runtime_error("ERROR::TRACE::UNKNOWN OBJECT NAME " +
+            std::to_string(recorded));
+    }
+    return name->second;
+}
+
+GLint Renderer::TracePlayer::mapLocation(GLint recorded) const
+{
+    const std::uint64_t key =
+        (static_cast<std::uint64_t>(currentProgram_) << 32) |
+        static_cast<std::uint32_t>(recorded);
+    const auto location = locations_.find(key);
+    return location == locations_.end() ? -1 : location->second;
+}
+
+std::size_t Renderer::TracePlayer::executeRecord(Device* device,
+    std::size_t offset)
+{
+    TraceReader reader(data_, offset);
+    const auto op = reader.read<TraceOp>();
+
+    // Decodes a recorded name and, when replaying, creates its counterpart
+    const auto create = [&](ObjectKind kind, auto createObject)
+    {
+        const auto recorded = reader.read<GLuint>();
+        if (device != nullptr)
+        {
+            names_[nameKey(kind, recorded)] = createObject();
+        }
+    };
+
+    switch (op)
+    {
+    case TraceOp::CREATE_VERTEX_ARRAY:
+        create(ObjectKind::VERTEX_ARRAY,
+            [&] { return device->createVertexArray(); });
+        break;
+
+    case TraceOp::BIND_VERTEX_ARRAY:
+    {
+        const auto vertexArray = reader.read<GLuint>();
+        if (device) device->bindVertexArray(mapName(ObjectKind::VERTEX_ARRAY,
+            vertexArray));
+        break;
+    }
+
+    case TraceOp::CREATE_BUFFER:
+        create(ObjectKind::BUFFER, [&] { return device->createBuffer(); });
+        break;
+
+    case TraceOp::BIND_BUFFER:
+    {
+        const auto target = reader.read<GLenum>();
+        const auto buffer = reader.read<GLuint>();
+        if (device) device->bindBuffer(target, mapName(ObjectKind::BUFFER,
+            buffer));
+        break;
+    }
+
+    case TraceOp::BUFFER_DATA:
+    {
+        const auto target = reader.read<GLenum>();
+        const auto usage = reader.read<GLenum>();
+        std::size_t size = 0;
+        const char* data = reader.readBlock(size);
+        if (device) device->bufferData(target,
+            static_cast<GLsizeiptr>(size), data, usage);
+        break;
+    }
+
+    case TraceOp::VERTEX_ATTRIB_POINTER:
+    {
+        const auto index = reader.read<GLuint>();
+        const auto size = reader.read<GLint>();
+        const auto type = reader.read<GLenum>();
+        const auto stride = reader.read<GLsizei>();
+        const auto attributeOffset = reader.read<std::uint64_t>();
+        if (device) device->vertexAttribPointer(index, size, type, stride,
+            static_cast<std::size_t>(attributeOffset));
+        break;
+    }
+
+    case TraceOp::ENABLE_VERTEX_ATTRIB_ARRAY:
+    {
+        const auto index = reader.read<GLuint>();
+        if (device) device->enableVertexAttribArray(index);
+        break;
+    }
+
+    case TraceOp::CREATE_TEXTURE:
+        create(ObjectKind::TEXTURE, [&] { return device->createTexture(); });
+        break;
+
+    case TraceOp::ACTIVE_TEXTURE:
+    {
+        const auto unit = reader.read<GLenum>();
+        if (device) device->activeTexture(unit);
+        break;
+    }
+
+    case TraceOp::BIND_TEXTURE:
+    {
+        const auto target = reader.read<GLenum>();
+        const auto texture = reader.read<GLuint>();
+        if (device) device->bindTexture(target, mapName(ObjectKind::TEXTURE,
+            texture));
+        break;
+    }
+
+    case TraceOp::TEX_PARAMETER:
+    {
+        const auto target = reader.read<GLenum>();
+        const auto name = reader.read<GLenum>();
+        const auto value = reader.read<GLint>();
+        if (device) device->texParameter(target, name, value);
+        break;
+    }
+
+    case TraceOp::TEX_IMAGE_2D:
+    {
+        const auto target = reader.read<GLenum>();
+        const auto level = reader.read<GLint>();
+        const auto internalFormat = reader.read<GLint>();
+        const auto width = reader.read<GLsizei>();
+        const auto height = reader.read<GLsizei>();
+        const auto format = reader.read<GLenum>();
+        const auto type = reader.read<GLenum>();
+        std::size_t size = 0;
+        const char* pixels = reader.readBlock(size);
+        if (device)
+        {
+            // The driver reads rows padded to the unpack alignment, give it
+            // a buffer that is large enough for that
+            const std::size_t rowSize =
+                static_cast<std::size_t>(width) * pixelSize(format, type);
+            const std::size_t pitch = (rowSize + UNPACK_ALIGNMENT - 1) /
+                UNPACK_ALIGNMENT * UNPACK_ALIGNMENT;
+            std::vector<char> padded;
+            if (pixels != nullptr && pitch != rowSize)
+            {
+                padded.resize(pitch * static_cast<std::size_t>(height));
+                std::memcpy(padded.data(), pixels, size);
+                pixels = padded.data();
+            }
+            device->texImage2D(target, level, internalFormat, width, height,
+                format, type, pixels);
+        }
+        break;
+    }
+
+    case TraceOp::GENERATE_MIPMAP:
+    {
+        const auto target = reader.read<GLenum>();
+        if (device) device->generateMipmap(target);
+        break;
+    }
+
+    case TraceOp::CREATE_SHADER:
+    {
+        const auto type = reader.read<GLenum>();
+        create(ObjectKind::SHADER, [&] { return device->createShader(type); });
+        break;
+    }
+
+    case TraceOp::SHADER_SOURCE:
+    {
+        const auto shader = reader.read<GLuint>();
+        std::size_t size = 0;
+        const char* source = reader.readBlock(size);
+        if (device) device->shaderSource(mapName(ObjectKind::SHADER, shader),
+            std::string(source, size));
+        break;
+    }
+
+    case TraceOp::COMPILE_SHADER:
+    {
+        const auto shader = reader.read<GLuint>();
+        if (device) device->compileShader(mapName(ObjectKind::SHADER, shader));
+        break;
+    }
+
+    case TraceOp::GET_COMPILE_STATUS:
+    {
+        const auto shader = reader.read<GLuint>();
+        std::string infoLog;
+        if (device && !device->getCompileStatus(mapName(ObjectKind::SHADER,
+            shader), infoLog))
+        {
+            throw std::runtime_error(
+                "ERROR::TRACE::SHADER::COMPILATION_FAILED\n" + infoLog);
+        }
+        break;
+    }
+
+    case TraceOp::DELETE_SHADER:
+    {
+        const auto shader = reader.read<GLuint>();
+        if (device) device->deleteShader(mapName(ObjectKind::SHADER, shader));
+        break;
+    }
+
+    case TraceOp::CREATE_PROGRAM:
+        create(ObjectKind::PROGRAM, [&] { return device->createProgram(); });
+        break;
+
+    case TraceOp::ATTACH_SHADER:
+    {
+        const auto program = reader.read<GLuint>();
+        const auto shader = reader.read<GLuint>();
+        if (device) device->attachShader(mapName(ObjectKind::PROGRAM, program),
+            mapName(ObjectKind::SHADER, shader));
+        break;
+    }
+
+    case TraceOp::LINK_PROGRAM:
+    {
+        const auto program = reader.read<GLuint>();
+        if (device) device->linkProgram(mapName(ObjectKind::PROGRAM, program));
+        break;
+    }
+
+    case TraceOp::GET_LINK_STATUS:
+    {
+        const auto program = reader.read<GLuint>();
+        std::string infoLog;
+        if (device && !device->getLinkStatus(mapName(ObjectKind::PROGRAM,
+            program), infoLog))
+        {
+            throw std::runtime_error(
+                "ERROR::TRACE::PROGRAM::LINKING_FAILED\n" + infoLog);
+        }
+        break;
+    }
+
+    case TraceOp::USE_PROGRAM:
+    {
+        const auto program = reader.read<GLuint>();
+        if (device)
+        {
+            device->useProgram(mapName(ObjectKind::PROGRAM, program));
+            currentProgram_ = program;
+        }
+        break;
+    }
+
+    case TraceOp::GET_UNIFORM_LOCATION:
+    {
+        const auto program = reader.read<GLuint>();
+        std::size_t size = 0;
+        const char* name = reader.readBlock(size);
+        const auto recorded = reader.read<GLint>();
+        if (device)
+        {
+            const std::string uniformName(name, size);
+            const std::uint64_t key =
+                (static_cast<std::uint64_t>(program) << 32) |
+                static_cast<std::uint32_t>(recorded);
+            locations_[key] = device->getUniformLocation(
+                mapName(ObjectKind::PROGRAM, program), uniformName.c_str());
+        }
+        break;
+    }
+
+    case TraceOp::UNIFORM_1I:
+    {
+        const auto location = reader.read<GLint>();
+        const auto value = reader.read<GLint>();
+        if (device) device->uniform1i(mapLocation(location), value);
+        break;
+    }
+
+    case TraceOp::UNIFORM_1F:
+    {
+        const auto location = reader.read<GLint>();
+        const auto value = reader.read<GLfloat>();
+        if (device) device->uniform1f(mapLocation(location), value);
+        break;
+    }
+
+    case TraceOp::UNIFORM_MATRIX_4FV:
+    {
+        const auto location = reader.read<GLint>();
+        GLfloat matrix[16];
+        for (GLfloat& value : matrix)
+        {
+            value = reader.read<GLfloat>();
+        }
+        if (device) device->uniformMatrix4fv(mapLocation(location), matrix);
+        break;
+    }
+
+    case TraceOp::VIEWPORT:
+    {
+        const auto x = reader.read<GLint>();
+        const auto y = reader.read<GLint>();
+        const auto width = reader.read<GLsizei>();
+        const auto height = reader.read<GLsizei>();
+        if (device) device->viewport(x, y, width, height);
+        break;
+    }
+
+    case TraceOp::ENABLE:
+    {
+        const auto capability = reader.read<GLenum>();
+        if (device) device->enable(capability);
+        break;
+    }
+
+    case TraceOp::DISABLE:
+    {
+        const auto capability = reader.read<GLenum>();
+        if (device) device->disable(capability);
+        break;
+    }
+
+    case TraceOp::BLEND_FUNC:
+    {
+        const auto sourceFactor = reader.read<GLenum>();
+        const auto destFactor = reader.read<GLenum>();
+        if (device) device->blendFunc(sourceFactor, destFactor);
+        break;
+    }
+
+    case TraceOp::CLEAR_COLOR:
+    {
+        const auto red = reader.read<GLfloat>();
+        const auto green = reader.read<GLfloat>();
+        const auto blue = reader.read<GLfloat>();
+        const auto alpha = reader.read<GLfloat>();
+        if (device) device->clearColor(red, green, blue, alpha);
+        break;
+    }
+
+    case TraceOp::CLEAR:
+    {
+        const auto mask = reader.read<GLbitfield>();
+        if (device) device->clear(mask);
+        break;
+    }
+
+    case TraceOp::DRAW_ARRAYS:
+    {
+        const auto mode = reader.read<GLenum>();
+        const auto first = reader.read<GLint>();
+        const auto count = reader.read<GLsizei>();
+        if (device) device->drawArrays(mode, first, count);
+        break;
+    }
+
+    case TraceOp::DRAW_ELEMENTS:
+    {
+        const auto mode = reader.read<GLenum>();
+        const auto count = reader.read<GLsizei>();
+        const auto type = reader.read<GLenum>();
+        const auto indexOffset = reader.read<std::uint64_t>();
+        if (device) device->drawElements(mode, count, type,
+            static_cast<std::size_t>(indexOffset));
+        break;
+    }
+
+    case TraceOp::CREATE_FRAMEBUFFER:
+        create(ObjectKind::FRAMEBUFFER,
+            [&] { return device->createFramebuffer(); });
+        break;
+
+    case TraceOp::BIND_FRAMEBUFFER:
+    {
+        const auto target = reader.read<GLenum>();
+        const auto framebuffer = reader.read<GLuint>();
+        if (device) device->bindFramebuffer(target, mapName(
+            ObjectKind::FRAMEBUFFER, framebuffer));
+        break;
+    }
+
+    case TraceOp::CREATE_RENDERBUFFER:
+        create(ObjectKind::RENDERBUFFER,
+            [&] { return device->createRenderbuffer(); });
+        break;
+
+    case TraceOp::BIND_RENDERBUFFER:
+    {
+        const auto renderbuffer = reader.read<GLuint>();
+        if (device) device->bindRenderbuffer(mapName(ObjectKind::RENDERBUFFER,
+            renderbuffer));
+        break;
+    }
+
+    case TraceOp::RENDERBUFFER_STORAGE:
+    {
+        const auto samples = reader.read<GLsizei>();
+        const auto internalFormat = reader.read<GLenum>();
+        const auto width = reader.read<GLsizei>();
+        const auto height = reader.read<GLsizei>();
+        if (device) device->renderbufferStorage(samples, internalFormat,
+            width, height);
+        break;
+    }
+
+    case TraceOp::FRAMEBUFFER_RENDERBUFFER:
+    {
+        const auto target = reader.read<GLenum>();
+        const auto attachment = reader.read<GLenum>();
+        const auto renderbuffer = reader.read<GLuint>();
+        if (device) device->framebufferRenderbuffer(target, attachment,
+            mapName(ObjectKind::RENDERBUFFER, renderbuffer));
+        break;
+    }
+
+    case TraceOp::CHECK_FRAMEBUFFER_STATUS:
+    {
+        const auto target = reader.read<GLenum>();
+        if (device && device->checkFramebufferStatus(target) !=
+            GL_FRAMEBUFFER_COMPLETE)
+        {
+            throw std::runtime_error("ERROR::TRACE::FRAMEBUFFER INCOMPLETE");
+        }
+        break;
+    }
+
+    case TraceOp::BLIT_FRAMEBUFFER:
+    {
+        GLint coordinates[8];
+        for (GLint& coordinate : coordinates)
+        {
+            coordinate = reader.read<GLint>();
+        }
+        const auto mask = reader.read<GLbitfield>();
+        const auto filter = reader.read<GLenum>();
+        if (device) device->blitFramebuffer(coordinates[0], coordinates[1],
+            coordinates[2], coordinates[3], coordinates[4], coordinates[5],
+            coordinates[6], coordinates[7], mask, filter);
+        break;
+    }
+
+    case TraceOp::CREATE_QUERY:
+        create(ObjectKind::QUERY, [&] { return device->createQuery(); });
+        break;
+
+    case TraceOp::BEGIN_QUERY:
+    {
+        const auto target = reader.read<GLenum>();
+        const auto query = reader.read<GLuint>();
+        if (device) device->beginQuery(target, mapName(ObjectKind::QUERY,
+            query));
+        break;
+    }
+
+    case TraceOp::END_QUERY:
+    {
+        const auto target = reader.read<GLenum>();
+        if (device) device->endQuery(target);
+        break;
+    }
+
+    case TraceOp::GET_QUERY_RESULT:
+    {
+        // Issued for its cost, the result belongs to the replaying GPU
+        const auto query = reader.read<GLuint>();
+        GLuint64 result = 0;
+        if (device) device->getQueryResult(mapName(ObjectKind::QUERY, query),
+            result);
+        break;
+    }
+
+    case TraceOp::VERTEX_ATTRIB_DIVISOR:
+    {
+        const auto index = reader.read<GLuint>();
+        const auto divisor = reader.read<GLuint>();
+        if (device) device->vertexAttribDivisor(index, divisor);
+        break;
+    }
+
+    case TraceOp::BIND_BUFFER_BASE:
+    {
+        const auto target = reader.read<GLenum>();
+        const auto index = reader.read<GLuint>();
+        const auto buffer = reader.read<GLuint>();
+        if (device) device->bindBufferBase(target, index, mapName(
+            ObjectKind::BUFFER, buffer));
+        break;
+    }
+
+    case TraceOp::BIND_IMAGE_TEXTURE:
+    {
+        const auto unit = reader.read<GLuint>();
+        const auto texture = reader.read<GLuint>();
+        const auto level = reader.read<GLint>();
+        const auto access = reader.read<GLenum>();
+        const auto format = reader.read<GLenum>();
+        if (device) device->bindImageTexture(unit,
+            mapName(ObjectKind::TEXTURE, texture), level, access, format);
+        break;
+    }
+
+    case TraceOp::MULTI_DRAW_ARRAYS_INDIRECT:
+    {
+        const auto mode = reader.read<GLenum>();
+        const auto commandOffset = reader.read<std::uint64_t>();
+        const auto drawCount = reader.read<GLsizei>();
+        const auto stride = reader.read<GLsizei>();
+        if (device) device->multiDrawArraysIndirect(mode,
+            static_cast<std::size_t>(commandOffset), drawCount, stride);
+        break;
+    }
+
+    case TraceOp::DISPATCH_COMPUTE:
+    {
+        const auto groupsX = reader.read<GLuint>();
+        const auto groupsY = reader.read<GLuint>();
+        const auto groupsZ = reader.read<GLuint>();
+        if (device) device->dispatchCompute(groupsX, groupsY, groupsZ);
+        break;
+    }
+
+    case TraceOp::MEMORY_BARRIER:
+    {
+        const auto barriers = reader.read<GLbitfield>();
+        if (device) device->memoryBarrier(barriers);
+        break;
+    }
+
+    case TraceOp::FRAMEBUFFER_TEXTURE_2D:
+    {
+        const auto target = reader.read<GLenum>();
+        const auto attachment = reader.read<GLenum>();
+        const auto texture = reader.read<GLuint>();
+        const auto level = reader.read<GLint>();
+        if (device) device->framebufferTexture2D(target, attachment,
+            mapName(ObjectKind::TEXTURE, texture), level);
+        break;
+    }
+
+    case TraceOp::DELETE_VERTEX_ARRAY:
+    {
+        const auto vertexArray = reader.read<GLuint>();
+        if (device) device->deleteVertexArray(mapName(ObjectKind::VERTEX_ARRAY,
+            vertexArray));
+        break;
+    }
+
+    case TraceOp::DELETE_BUFFER:
+    {
+        const auto buffer = reader.read<GLuint>();
+        if (device) device->deleteBuffer(mapName(ObjectKind::BUFFER, buffer));
+        break;
+    }
+
+    case TraceOp::DELETE_TEXTURE:
+    {
+        const auto texture = reader.read<GLuint>();
+        if (device) device->deleteTexture(mapName(ObjectKind::TEXTURE,
+            texture));
+        break;
+    }
+
+    case TraceOp::DELETE_PROGRAM:
+    {
+        const auto program = reader.read<GLuint>();
+        if (device) device->deleteProgram(mapName(ObjectKind::PROGRAM,
+            program));
+        break;
+    }
+
+    case TraceOp::DELETE_FRAMEBUFFER:
+    {
+        const auto framebuffer = reader.read<GLuint>();
+        if (device) device->deleteFramebuffer(mapName(ObjectKind::FRAMEBUFFER,
+            framebuffer));
+        break;
+    }
+
+    case TraceOp::DELETE_RENDERBUFFER:
+    {
+        const auto renderbuffer = reader.read<GLuint>();
+        if (device) device->deleteRenderbuffer(mapName(ObjectKind::RENDERBUFFER,
+            renderbuffer));
+        break;
+    }
+
+    case TraceOp::DELETE_QUERY:
+    {
+        const auto query = reader.read<GLuint>();
+        if (device) device->deleteQuery(mapName(ObjectKind::QUERY, query));
+        break;
+    }
+
+    case TraceOp::CREATE_FENCE:
+        create(ObjectKind::FENCE, [&] { return device->createFence(); });
+        break;
+
+    case TraceOp::IS_FENCE_SIGNALED:
+    {
+        // Issued for its cost, like the query results
+        const auto fence = reader.read<GLuint>();
+        if (device) device->isFenceSignaled(mapName(ObjectKind::FENCE, fence));
+        break;
+    }
+
+    case TraceOp::DELETE_FENCE:
+    {
+        const auto fence = reader.read<GLuint>();
+        if (device) device->deleteFence(mapName(ObjectKind::FENCE, fence));
+        break;
+    }
+
+    default:
+        throw std::runtime_error("ERROR::TRACE::UNKNOWN RECORD " +
+            std::to_string(static_cast<int>(op)));
+    }
+    return reader.getOffset();
+}
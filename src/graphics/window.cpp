@@ -1,9 +1,9 @@
 #include "window.hpp"
 
-Window::Window() : sf::RenderWindow(sf::VideoMode
-    ({WindowAttributes::WINDOW_WIDTH, WindowAttributes::WINDOW_HEIGHT}), 
-    WindowAttributes::WINDOW_TITLE, sf::State::Windowed, 
-    WindowAttributes::getSettings())
+Window::Window(const sf::ContextSettings& settings) : sf::RenderWindow(
+    sf::VideoMode({WindowAttributes::WINDOW_WIDTH,
+    WindowAttributes::WINDOW_HEIGHT}), WindowAttributes::WINDOW_TITLE,
+    sf::State::Windowed, settings)
 {
      // Check if OpenGL functions are loaded and the window is successfully created
      if (!gladLoadGL() || !isOpen()) 
@@ -0,0 +1,519 @@
+#include "frame_stream.hpp"
+#include "memory_tracker.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    // Waits up to this long for a fence that is late, in nanoseconds
+    constexpr GLuint64 FENCE_TIMEOUT = 1'000'000'000;
+
+    // The frames of the staging buffers and the viewer's copy
+    constexpr std::size_t CPU_FRAMES =
+        Renderer::StreamServerConstants::STAGING_BUFFERS + 1;
+
+    // The bytes of the fields written by writeFrameHeader
+    constexpr std::size_t FRAME_HEADER_SIZE = 8 + 8 + 4 + 4 + 4 + 4;
+
+    double millisecondsBetween(std::chrono::steady_clock::time_point from,
+        std::chrono::steady_clock::time_point to)
+    {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    }
+}
+
+Renderer::FrameStreamServer::FrameStreamServer(unsigned short port,
+    unsigned int width, unsigned int height) : width_{ width },
+    height_{ height }, frameSize_{ static_cast<std::size_t>(width) * height *
+    StreamConstants::BYTES_PER_PIXEL }, slots_(), frameIndex_{ 0 },
+    appliedInput_{ 0 }, epoch_{ Clock::now() }, captured_{ 0 }, stalls_{ 0 },
+    finished_{ false }, listener_(), socket_(), selector_(), port_{ 0 },
+    sendMutex_(), connected_{ false }, viewerReset_{ false }, assembler_(),
+    latenciesMs_(), connections_{ 0 }, mutex_(), queueReady_(), queue_(),
+    freeBuffers_(), inputs_(), dropped_{ 0 }, stopping_{ false },
+    receiver_(), sender_(), grid_(width, height), reference_(),
+    tileScratch_(), writer_(), sent_{ 0 }, tilesSent_{ 0 }, tilesTotal_{ 0 },
+    bytesSent_{ 0 }, rawBytes_{ 0 }, encodeMs_{ 0.0 }, firstSend_(),
+    lastSend_()
+{
+    if (listener_.listen(port) != sf::Socket::Status::Done)
+    {
+        throw std::runtime_error("ERROR::STREAM::CANNOT LISTEN ON PORT " +
+            std::to_string(port));
+    }
+    port_ = listener_.getLocalPort();
+    selector_.add(listener_);
+
+    for (Slot& slot : slots_)
+    {
+        glGenBuffers(1, &slot.buffer);
+    }
+    allocateBuffers();
+
+    // Allocate the staging buffers up front, the frame loop never allocates
+    freeBuffers_.resize(StreamServerConstants::STAGING_BUFFERS);
+    for (std::vector<std::uint8_t>& buffer : freeBuffers_)
+    {
+        buffer.resize(frameSize_);
+    }
+    reference_.resize(frameSize_);
+    trackAllocation(MemoryCategory::CAPTURE,
+        static_cast<std::uint64_t>(frameSize_) * CPU_FRAMES);
+
+    receiver_ = std::thread(&FrameStreamServer::receiveLoop, this);
+    sender_ = std::thread(&FrameStreamServer::senderLoop, this);
+}
+
+Renderer::FrameStreamServer::~FrameStreamServer()
+{
+    finish();
+}
+
+void Renderer::FrameStreamServer::allocateBuffers()
+{
+    for (Slot& slot : slots_)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER,
+            static_cast<GLsizeiptr>(frameSize_), nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    trackAllocation(MemoryCategory::GPU_BUFFER,
+        static_cast<std::uint64_t>(frameSize_) * slots_.size());
+}
+
+void Renderer::FrameStreamServer::capture()
+{
+    // Map the read of READBACK_LATENCY frames ago, the slot after the one
+    // this frame is read into
+    Slot& oldest = slots_[(frameIndex_ + 1) % StreamServerConstants::RING_SIZE];
+    consume(oldest);
+
+    if (connected_)
+    {
+        Slot& current = slots_[frameIndex_ % StreamServerConstants::RING_SIZE];
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, current.buffer);
+        glReadPixels(0, 0, static_cast<GLsizei>(width_),
+            static_cast<GLsizei>(height_), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        current.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        current.frame = frameIndex_;
+        current.timestamp = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                Clock::now() - epoch_).count());
+        current.inputSequence = appliedInput_;
+        ++captured_;
+    }
+    ++frameIndex_;
+}
+
+void Renderer::FrameStreamServer::consume(Slot& slot)
+{
+    if (slot.fence == nullptr)
+    {
+        return;
+    }
+
+    // The copy is normally done by now, waiting here is reported as a stall
+    GLenum status = glClientWaitSync(slot.fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED)
+    {
+        ++stalls_;
+        status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+            FENCE_TIMEOUT);
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+    if (status == GL_WAIT_FAILED || status == GL_TIMEOUT_EXPIRED)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++dropped_;
+        return;
+    }
+
+    // Take a free buffer, or the one of the oldest queued frame, which is
+    // stale now that a newer frame is ready
+    std::vector<std::uint8_t> pixels;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!freeBuffers_.empty())
+        {
+            pixels = std::move(freeBuffers_.back());
+            freeBuffers_.pop_back();
+        }
+        else if (!queue_.empty())
+        {
+            pixels = std::move(queue_.front().pixels);
+            queue_.pop_front();
+            ++dropped_;
+        }
+    }
+    pixels.resize(frameSize_);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+        static_cast<GLsizeiptr>(frameSize_), GL_MAP_READ_BIT);
+    bool copied = false;
+    if (mapped != nullptr)
+    {
+        std::memcpy(pixels.data(), mapped, frameSize_);
+        copied = glUnmapBuffer(GL_PIXEL_PACK_BUFFER) == GL_TRUE;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!copied)
+    {
+        ++dropped_;
+        freeBuffers_.push_back(std::move(pixels));
+        return;
+    }
+    FrameHeader header;
+    header.frame = slot.frame;
+    header.timestamp = slot.timestamp;
+    header.inputSequence = slot.inputSequence;
+    header.width = width_;
+    header.height = height_;
+    queue_.push_back(PendingFrame{ header, std::move(pixels) });
+    queueReady_.notify_one();
+}
+
+void Renderer::FrameStreamServer::resize(unsigned int width,
+    unsigned int height)
+{
+    if (width == width_ && height == height_)
+    {
+        return;
+    }
+    // The reads in flight have the old size
+    for (Slot& slot : slots_)
+    {
+        if (slot.fence != nullptr)
+        {
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+        }
+    }
+    trackRelease(MemoryCategory::GPU_BUFFER,
+        static_cast<std::uint64_t>(frameSize_) * slots_.size());
+    trackRelease(MemoryCategory::CAPTURE,
+        static_cast<std::uint64_t>(frameSize_) * CPU_FRAMES);
+
+    // The staging buffers grow when they are next used
+    width_ = width;
+    height_ = height;
+    frameSize_ = static_cast<std::size_t>(width) * height *
+        StreamConstants::BYTES_PER_PIXEL;
+    allocateBuffers();
+    trackAllocation(MemoryCategory::CAPTURE,
+        static_cast<std::uint64_t>(frameSize_) * CPU_FRAMES);
+}
+
+bool Renderer::FrameStreamServer::pollInput(StreamInput& input)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (inputs_.empty())
+        {
+            return false;
+        }
+        input = inputs_.front();
+        inputs_.pop_front();
+    }
+    // A new viewer numbers its events from 1 again
+    appliedInput_ = input.type == StreamInputType::CONNECTED ?
+        0 : input.sequence;
+    return true;
+}
+
+void Renderer::FrameStreamServer::finish()
+{
+    if (finished_)
+    {
+        return;
+    }
+    finished_ = true;
+
+    // Frames still in flight are not sent, the viewer is disconnected
+    for (Slot& slot : slots_)
+    {
+        if (slot.fence != nullptr)
+        {
+            glDeleteSync(slot.fence);
+        }
+        glDeleteBuffers(1, &slot.buffer);
+    }
+    trackRelease(MemoryCategory::GPU_BUFFER,
+        static_cast<std::uint64_t>(frameSize_) * slots_.size());
+
+    stopping_ = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queueReady_.notify_all();
+    }
+    sender_.join();
+    receiver_.join();
+    disconnect();
+    listener_.close();
+
+    trackRelease(MemoryCategory::CAPTURE,
+        static_cast<std::uint64_t>(frameSize_) * CPU_FRAMES);
+    queue_.clear();
+    std::vector<std::vector<std::uint8_t>>().swap(freeBuffers_);
+    std::vector<std::uint8_t>().swap(reference_);
+}
+
+void Renderer::FrameStreamServer::receiveLoop()
+{
+    std::uint8_t chunk[StreamServerConstants::RECEIVE_CHUNK];
+    while (!stopping_)
+    {
+        if (!selector_.wait(sf::milliseconds(
+            StreamServerConstants::POLL_INTERVAL_MS)))
+        {
+            continue;
+        }
+
+        if (!connected_)
+        {
+            if (!selector_.isReady(listener_) ||
+                listener_.accept(socket_) != sf::Socket::Status::Done)
+            {
+                continue;
+            }
+            // One viewer at a time, the next one connects once it is gone
+            selector_.remove(listener_);
+            selector_.add(socket_);
+            assembler_ = MessageAssembler();
+            {
+                std::lock_guard<std::mutex> lock(sendMutex_);
+                viewerReset_ = true;
+                connected_ = true;
+            }
+            ++connections_;
+            std::lock_guard<std::mutex> lock(mutex_);
+            StreamInput connected;
+            connected.type = StreamInputType::CONNECTED;
+            inputs_.push_back(connected);
+            continue;
+        }
+
+        std::size_t received = 0;
+        const sf::Socket::Status status =
+            socket_.receive(chunk, sizeof(chunk), received);
+        bool valid = status == sf::Socket::Status::Done;
+        if (valid)
+        {
+            try
+            {
+                assembler_.append(chunk, received);
+                StreamMessage type;
+                const std::uint8_t* payload = nullptr;
+                std::size_t size = 0;
+                while (assembler_.next(type, payload, size))
+                {
+                    handleMessage(type, payload, size);
+                }
+            }
+            catch (const std::runtime_error&)
+            {
+                valid = false;
+            }
+        }
+        if (!valid && status != sf::Socket::Status::NotReady &&
+            status != sf::Socket::Status::Partial)
+        {
+            selector_.remove(socket_);
+            disconnect();
+            selector_.add(listener_);
+        }
+    }
+}
+
+void Renderer::FrameStreamServer::handleMessage(StreamMessage type,
+    const std::uint8_t* payload, std::size_t size)
+{
+    MessageReader reader(payload, size);
+    if (type == StreamMessage::ACK)
+    {
+        reader.readU64();
+        const std::uint64_t timestamp = reader.readU64();
+        const std::uint64_t now = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                Clock::now() - epoch_).count());
+        if (reader.isValid() && timestamp <= now)
+        {
+            latenciesMs_.push_back((now - timestamp) / 1000.0);
+        }
+    }
+    else if (type == StreamMessage::INPUT)
+    {
+        const StreamInput input = readInput(reader);
+        if (reader.isValid() && input.type != StreamInputType::CONNECTED)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            inputs_.push_back(input);
+        }
+    }
+}
+
+void Renderer::FrameStreamServer::senderLoop()
+{
+    while (true)
+    {
+        PendingFrame pending;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            queueReady_.wait(lock,
+                [this] { return stopping_ || !queue_.empty(); });
+            if (stopping_)
+            {
+                return;
+            }
+            // Only the newest frame is worth sending
+            while (queue_.size() > 1)
+            {
+                freeBuffers_.push_back(std::move(queue_.front().pixels));
+                queue_.pop_front();
+                ++dropped_;
+            }
+            pending = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        sendFrame(pending);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        freeBuffers_.push_back(std::move(pending.pixels));
+    }
+}
+
+void Renderer::FrameStreamServer::sendFrame(const PendingFrame& pending)
+{
+    // Held while encoding, so a viewer that connects meanwhile gets the
+    // HELLO and the reset reference before any frame
+    std::lock_guard<std::mutex> lock(sendMutex_);
+    if (!connected_)
+    {
+        return;
+    }
+    const FrameHeader& source = pending.header;
+    if (viewerReset_ || source.width != grid_.width ||
+        source.height != grid_.height)
+    {
+        // A new viewer, or one that reallocated its frame, starts from zeros
+        grid_ = TileGrid(source.width, source.height);
+        reference_.assign(pending.pixels.size(), 0);
+    }
+    if (viewerReset_)
+    {
+        viewerReset_ = false;
+        writer_.begin(StreamMessage::HELLO);
+        writer_.writeU32(StreamConstants::PROTOCOL_VERSION);
+        writer_.writeU32(StreamConstants::TILE_SIZE);
+        if (!send(writer_.finish()))
+        {
+            return;
+        }
+    }
+
+    const Clock::time_point encodeStart = Clock::now();
+    writer_.begin(StreamMessage::FRAME);
+    const std::size_t headerOffset = writer_.getSize();
+    writeFrameHeader(writer_, source);
+    std::uint32_t tileCount = 0;
+    for (std::size_t tile = 0; tile < grid_.getTileCount(); ++tile)
+    {
+        if (!isTileChanged(grid_, tile, pending.pixels.data(),
+            reference_.data()))
+        {
+            continue;
+        }
+        // The index and size of the tile precede its encoding
+        writer_.writeU32(static_cast<std::uint32_t>(tile));
+        const std::size_t sizeOffset = writer_.getSize();
+        writer_.writeU32(0);
+        encodeTile(grid_, tile, pending.pixels.data(), reference_.data(),
+            tileScratch_, writer_.getBuffer());
+        writer_.patchU32(sizeOffset, static_cast<std::uint32_t>(
+            writer_.getSize() - sizeOffset - 4));
+        ++tileCount;
+    }
+    // The tile count is the last field of the header
+    writer_.patchU32(headerOffset + FRAME_HEADER_SIZE - 4, tileCount);
+    const std::vector<std::uint8_t>& message = writer_.finish();
+    const Clock::time_point sendStart = Clock::now();
+    encodeMs_ += millisecondsBetween(encodeStart, sendStart);
+    if (!send(message))
+    {
+        return;
+    }
+
+    if (sent_ == 0)
+    {
+        firstSend_ = sendStart;
+    }
+    lastSend_ = Clock::now();
+    ++sent_;
+    tilesSent_ += tileCount;
+    tilesTotal_ += grid_.getTileCount();
+    rawBytes_ += pending.pixels.size();
+}
+
+bool Renderer::FrameStreamServer::send(
+    const std::vector<std::uint8_t>& message)
+{
+    // Blocking sends return once everything is handed to the system
+    if (socket_.send(message.data(), message.size()) !=
+        sf::Socket::Status::Done)
+    {
+        return false;
+    }
+    bytesSent_ += message.size();
+    return true;
+}
+
+void Renderer::FrameStreamServer::disconnect()
+{
+    std::lock_guard<std::mutex> lock(sendMutex_);
+    if (connected_)
+    {
+        socket_.disconnect();
+        connected_ = false;
+    }
+}
+
+std::string Renderer::FrameStreamServer::getSummary() const
+{
+    if (sent_ == 0)
+    {
+        return std::string();
+    }
+    const double seconds = std::max(
+        millisecondsBetween(firstSend_, lastSend_) / 1000.0, 1e-3);
+    std::ostringstream summary;
+    summary << std::fixed << std::setprecision(2) << "Streamed " << sent_
+        << " of " << captured_ << " frames read back on port " << port_
+        << " to " << connections_ << " viewer(s): " << dropped_
+        << " dropped as stale, " << stalls_ << " read back stalls\n"
+        << "  " << 100.0 * tilesSent_ / tilesTotal_ << "% of tiles sent, "
+        << bytesSent_ / 1e6 << " MB for " << rawBytes_ / 1e6
+        << " MB of frames (" << rawBytes_ / std::max(1.0,
+            static_cast<double>(bytesSent_)) << ":1), "
+        << sent_ / seconds << " frames/s, " << bytesSent_ * 8.0 / 1e6 / seconds
+        << " Mbit/s, encoding " << encodeMs_ / sent_ << " ms per frame\n";
+    if (!latenciesMs_.empty())
+    {
+        std::vector<double> sorted = latenciesMs_;
+        std::sort(sorted.begin(), sorted.end());
+        summary << "  read back to viewer acknowledgement over "
+            << sorted.size() << " frames, ms: median "
+            << sorted[sorted.size() / 2]
+            << ", p99 " << sorted[sorted.size() * 99 / 100]
+            << ", max " << sorted.back() << '\n';
+    }
+    return summary.str();
+}
@@ -0,0 +1,368 @@
+#include "stream_protocol.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+    // Control bytes below this start a literal run of control + 1 bytes,
+    // the others repeat the next byte control - LITERAL_LIMIT + MIN_RUN times
+    constexpr std::uint8_t LITERAL_LIMIT = 128;
+    // Shorter repeats are cheaper as literals
+    constexpr std::size_t MIN_RUN = 3;
+    constexpr std::size_t MAX_RUN = 255 - LITERAL_LIMIT + MIN_RUN;
+
+    // Appends the run-length encoding of a byte range
+    void runLengthEncode(const std::uint8_t* data, std::size_t size,
+        std::vector<std::uint8_t>& out)
+    {
+        std::size_t literalStart = 0;
+        const auto flushLiterals = [&](std::size_t end)
+        {
+            while (literalStart < end)
+            {
+                const std::size_t count = std::min<std::size_t>(
+                    end - literalStart, LITERAL_LIMIT);
+                out.push_back(static_cast<std::uint8_t>(count - 1));
+                out.insert(out.end(), data + literalStart,
+                    data + literalStart + count);
+                literalStart += count;
+            }
+        };
+
+        std::size_t i = 0;
+        while (i < size)
+        {
+            std::size_t run = 1;
+            while (i + run < size && run < MAX_RUN && data[i + run] == data[i])
+            {
+                ++run;
+            }
+            if (run >= MIN_RUN)
+            {
+                flushLiterals(i);
+                out.push_back(static_cast<std::uint8_t>(
+                    LITERAL_LIMIT + run - MIN_RUN));
+                out.push_back(data[i]);
+                literalStart = i + run;
+            }
+            i += run;
+        }
+        flushLiterals(size);
+    }
+
+    // Decodes a run-length encoding that must fill the output exactly
+    bool runLengthDecode(const std::uint8_t* data, std::size_t size,
+        std::uint8_t* out, std::size_t outSize)
+    {
+        std::size_t read = 0;
+        std::size_t written = 0;
+        while (read < size)
+        {
+            const std::uint8_t control = data[read++];
+            if (control < LITERAL_LIMIT)
+            {
+                const std::size_t count = control + std::size_t{ 1 };
+                if (read + count > size || written + count > outSize)
+                {
+                    return false;
+                }
+                std::memcpy(out + written, data + read, count);
+                read += count;
+                written += count;
+            }
+            else
+            {
+                const std::size_t count = control - LITERAL_LIMIT + MIN_RUN;
+                if (read >= size || written + count > outSize)
+                {
+                    return false;
+                }
+                std::memset(out + written, data[read++], count);
+                written += count;
+            }
+        }
+        return written == outSize;
+    }
+}
+
+Renderer::TileGrid::TileGrid(unsigned int frameWidth,
+    unsigned int frameHeight) : width{ frameWidth }, height{ frameHeight },
+    columns{ (frameWidth + StreamConstants::TILE_SIZE - 1) /
+        StreamConstants::TILE_SIZE },
+    rows{ (frameHeight + StreamConstants::TILE_SIZE - 1) /
+        StreamConstants::TILE_SIZE }
+{
+}
+
+void Renderer::TileGrid::getRect(std::size_t tile, unsigned int& x,
+    unsigned int& y, unsigned int& tileWidth, unsigned int& tileHeight) const
+{
+    x = static_cast<unsigned int>(tile % columns) * StreamConstants::TILE_SIZE;
+    y = static_cast<unsigned int>(tile / columns) * StreamConstants::TILE_SIZE;
+    tileWidth = std::min(StreamConstants::TILE_SIZE, width - x);
+    tileHeight = std::min(StreamConstants::TILE_SIZE, height - y);
+}
+
+bool Renderer::isTileChanged(const TileGrid& grid, std::size_t tile,
+    const std::uint8_t* current, const std::uint8_t* reference)
+{
+    unsigned int x, y, tileWidth, tileHeight;
+    grid.getRect(tile, x, y, tileWidth, tileHeight);
+    const std::size_t stride = grid.width * StreamConstants::BYTES_PER_PIXEL;
+    const std::size_t rowBytes = tileWidth * StreamConstants::BYTES_PER_PIXEL;
+    std::size_t offset = y * stride + x * StreamConstants::BYTES_PER_PIXEL;
+    for (unsigned int row = 0; row < tileHeight; ++row, offset += stride)
+    {
+        if (std::memcmp(current + offset, reference + offset, rowBytes) != 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Renderer::encodeTile(const TileGrid& grid, std::size_t tile,
+    const std::uint8_t* current, std::uint8_t* reference,
+    std::vector<std::uint8_t>& scratch, std::vector<std::uint8_t>& out)
+{
+    unsigned int x, y, tileWidth, tileHeight;
+    grid.getRect(tile, x, y, tileWidth, tileHeight);
+    const std::size_t stride = grid.width * StreamConstants::BYTES_PER_PIXEL;
+    const std::size_t rowBytes = tileWidth * StreamConstants::BYTES_PER_PIXEL;
+    scratch.resize(rowBytes * tileHeight);
+
+    // XOR with what the viewer has, then take it over as the new reference
+    std::uint8_t* delta = scratch.data();
+    std::size_t offset = y * stride + x * StreamConstants::BYTES_PER_PIXEL;
+    for (unsigned int row = 0; row < tileHeight; ++row, offset += stride)
+    {
+        for (std::size_t i = 0; i < rowBytes; ++i)
+        {
+            delta[i] = current[offset + i] ^ reference[offset + i];
+        }
+        std::memcpy(reference + offset, current + offset, rowBytes);
+        delta += rowBytes;
+    }
+    runLengthEncode(scratch.data(), scratch.size(), out);
+}
+
+bool Renderer::decodeTile(const TileGrid& grid, std::size_t tile,
+    const std::uint8_t* data, std::size_t size, std::uint8_t* frame,
+    std::vector<std::uint8_t>& scratch)
+{
+    if (tile >= grid.getTileCount())
+    {
+        return false;
+    }
+    unsigned int x, y, tileWidth, tileHeight;
+    grid.getRect(tile, x, y, tileWidth, tileHeight);
+    const std::size_t stride = grid.width * StreamConstants::BYTES_PER_PIXEL;
+    const std::size_t rowBytes = tileWidth * StreamConstants::BYTES_PER_PIXEL;
+    scratch.resize(rowBytes * tileHeight);
+    if (!runLengthDecode(data, size, scratch.data(), scratch.size()))
+    {
+        return false;
+    }
+
+    const std::uint8_t* delta = scratch.data();
+    std::size_t offset = y * stride + x * StreamConstants::BYTES_PER_PIXEL;
+    for (unsigned int row = 0; row < tileHeight; ++row, offset += stride)
+    {
+        for (std::size_t i = 0; i < rowBytes; ++i)
+        {
+            frame[offset + i] ^= delta[i];
+        }
+        delta += rowBytes;
+    }
+    return true;
+}
+
+void Renderer::MessageWriter::begin(StreamMessage type)
+{
+    // The payload size is written by finish()
+    buffer_.assign(StreamConstants::HEADER_SIZE - 1, 0);
+    buffer_.push_back(static_cast<std::uint8_t>(type));
+}
+
+void Renderer::MessageWriter::writeU8(std::uint8_t value)
+{
+    buffer_.push_back(value);
+}
+
+void Renderer::MessageWriter::writeU32(std::uint32_t value)
+{
+    for (unsigned int shift = 0; shift < 32; shift += 8)
+    {
+        buffer_.push_back(static_cast<std::uint8_t>(value >> shift));
+    }
+}
+
+void Renderer::MessageWriter::writeU64(std::uint64_t value)
+{
+    for (unsigned int shift = 0; shift < 64; shift += 8)
+    {
+        buffer_.push_back(static_cast<std::uint8_t>(value >> shift));
+    }
+}
+
+void Renderer::MessageWriter::writeBytes(const std::uint8_t* data,
+    std::size_t size)
+{
+    buffer_.insert(buffer_.end(), data, data + size);
+}
+
+void Renderer::MessageWriter::patchU32(std::size_t offset,
+    std::uint32_t value)
+{
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        buffer_[offset + i] = static_cast<std::uint8_t>(value >> (8 * i));
+    }
+}
+
+const std::vector<std::uint8_t>& Renderer::MessageWriter::finish()
+{
+    patchU32(0, static_cast<std::uint32_t>(
+        buffer_.size() - StreamConstants::HEADER_SIZE));
+    return buffer_;
+}
+
+Renderer::MessageReader::MessageReader(const std::uint8_t* data,
+    std::size_t size) : data_{ data }, size_{ size }, offset_{ 0 },
+    valid_{ true }
+{
+}
+
+std::uint8_t Renderer::MessageReader::readU8()
+{
+    const std::uint8_t* bytes = readBytes(1);
+    return bytes != nullptr ? bytes[0] : 0;
+}
+
+std::uint32_t Renderer::MessageReader::readU32()
+{
+    const std::uint8_t* bytes = readBytes(4);
+    std::uint32_t value = 0;
+    for (unsigned int i = 0; bytes != nullptr && i < 4; ++i)
+    {
+        value |= static_cast<std::uint32_t>(bytes[i]) << (8 * i);
+    }
+    return value;
+}
+
+std::uint64_t Renderer::MessageReader::readU64()
+{
+    const std::uint8_t* bytes = readBytes(8);
+    std::uint64_t value = 0;
+    for (unsigned int i = 0; bytes != nullptr && i < 8; ++i)
+    {
+        value |= static_cast<std::uint64_t>(bytes[i]) << (8 * i);
+    }
+    return value;
+}
+
+const std::uint8_t* Renderer::MessageReader::readBytes(std::size_t size)
+{
+    if (!valid_ || size > size_ - offset_)
+    {
+        valid_ = false;
+        return nullptr;
+    }
+    const std::uint8_t* bytes = data_ + offset_;
+    offset_ += size;
+    return bytes;
+}
+
+void Renderer::writeFrameHeader(MessageWriter& writer,
+    const FrameHeader& header)
+{
+    writer.writeU64(header.frame);
+    writer.writeU64(header.timestamp);
+    writer.writeU32(header.inputSequence);
+    writer.writeU32(header.width);
+    writer.writeU32(header.height);
+    writer.writeU32(header.tileCount);
+}
+
+Renderer::FrameHeader Renderer::readFrameHeader(MessageReader& reader)
+{
+    FrameHeader header;
+    header.frame = reader.readU64();
+    header.timestamp = reader.readU64();
+    header.inputSequence = reader.readU32();
+    header.width = reader.readU32();
+    header.height = reader.readU32();
+    header.tileCount = reader.readU32();
+
+    // The receiver allocates the frame at this size before any tile
+    const std::uint64_t frameBytes = static_cast<std::uint64_t>(
+        header.width) * header.height * StreamConstants::BYTES_PER_PIXEL;
+    if (frameBytes == 0 || frameBytes > StreamConstants::MAX_PAYLOAD_SIZE)
+    {
+        throw std::runtime_error("ERROR::STREAM::INVALID FRAME SIZE " +
+            std::to_string(header.width) + "x" +
+            std::to_string(header.height));
+    }
+    return header;
+}
+
+void Renderer::writeInput(MessageWriter& writer, const StreamInput& input)
+{
+    writer.begin(StreamMessage::INPUT);
+    writer.writeU32(input.sequence);
+    writer.writeU8(static_cast<std::uint8_t>(input.type));
+    writer.writeU32(static_cast<std::uint32_t>(input.code));
+}
+
+Renderer::StreamInput Renderer::readInput(MessageReader& reader)
+{
+    StreamInput input;
+    input.sequence = reader.readU32();
+    input.type = static_cast<StreamInputType>(reader.readU8());
+    input.code = static_cast<std::int32_t>(reader.readU32());
+    return input;
+}
+
+Renderer::MessageAssembler::MessageAssembler() : buffer_(), offset_{ 0 }
+{
+}
+
+void Renderer::MessageAssembler::append(const std::uint8_t* data,
+    std::size_t size)
+{
+    // Drop the messages already taken before the buffer grows
+    if (offset_ > 0)
+    {
+        buffer_.erase(buffer_.begin(),
+            buffer_.begin() + static_cast<std::ptrdiff_t>(offset_));
+        offset_ = 0;
+    }
+    buffer_.insert(buffer_.end(), data, data + size);
+}
+
+bool Renderer::MessageAssembler::next(StreamMessage& type,
+    const std::uint8_t*& payload, std::size_t& size)
+{
+    const std::size_t available = buffer_.size() - offset_;
+    if (available < StreamConstants::HEADER_SIZE)
+    {
+        return false;
+    }
+    MessageReader header(buffer_.data() + offset_, available);
+    const std::uint32_t payloadSize = header.readU32();
+    if (payloadSize > StreamConstants::MAX_PAYLOAD_SIZE)
+    {
+        throw std::runtime_error("ERROR::STREAM::MESSAGE TOO LARGE");
+    }
+    if (available - StreamConstants::HEADER_SIZE < payloadSize)
+    {
+        return false;
+    }
+    type = static_cast<StreamMessage>(header.readU8());
+    payload = buffer_.data() + offset_ + StreamConstants::HEADER_SIZE;
+    size = payloadSize;
+    offset_ += StreamConstants::HEADER_SIZE + payloadSize;
+    return true;
+}
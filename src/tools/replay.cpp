@@ -0,0 +1,232 @@
+/**
+ * @file replay.cpp
+ * @brief Replays a recorded command trace and reports per-frame timings.
+ *
+ * Usage: hello_3d_replay <trace> [--paced] [--loops=N] [--frame=K]
+ *        [--csv=path] [--samples=N]
+ * @note `--paced` waits for the recorded frame timestamps instead of
+ *       replaying as fast as possible.
+ * @note `--loops=N` replays the recorded frames N times.
+ * @note `--frame=K` replays only frame K, to isolate a single bad frame.
+ * @note `--csv=path` writes the time of every replayed frame to a file.
+ * @note `--samples=N` sets the MSAA samples of the window, use 0 for traces
+ *       recorded with `--dynamic-resolution`.
+ */
+
+#include <device.hpp>
+#include <trace.hpp>
+#include <window.hpp>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+    /**
+     * @struct ReplayOptions
+     * @brief The configuration of a replay given on the command line.
+     */
+    struct ReplayOptions
+    {
+        std::string tracePath;
+        bool paced = false;
+        unsigned int loops = 1;
+        // Replays every frame when not set
+        std::optional<std::size_t> frame;
+        std::string csvPath;
+        // The antialiasing level of the window the trace is replayed in
+        unsigned int samples =
+            WindowAttributes::getSettings().antiAliasingLevel;
+    };
+
+    // Parses a non-negative integer option value
+    unsigned long parseNumber(const std::string& name, const std::string& value)
+    {
+        try
+        {
+            std::size_t parsed = 0;
+            const unsigned long number = std::stoul(value, &parsed);
+            if (parsed == value.size())
+            {
+                return number;
+            }
+        }
+        catch (const std::exception&)
+        {
+            // Reported below together with other malformed values
+        }
+        throw std::invalid_argument("ERROR::INVALID VALUE FOR " + name + ": " +
+            value);
+    }
+
+    ReplayOptions parseReplayArguments(int argc, char* argv[])
+    {
+        ReplayOptions options;
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string argument(argv[i]);
+            if (argument.rfind("--", 0) != 0)
+            {
+                if (!options.tracePath.empty())
+                {
+                    throw std::invalid_argument("ERROR::UNEXPECTED ARGUMENT " +
+                        argument);
+                }
+                options.tracePath = argument;
+                continue;
+            }
+
+            const std::size_t separator = argument.find('=');
+            const std::string name = argument.substr(2, separator - 2);
+            const std::string value = separator == std::string::npos ?
+                std::string() : argument.substr(separator + 1);
+
+            if (name == "paced")
+            {
+                options.paced = true;
+            }
+            else if (name == "loops")
+            {
+                options.loops = static_cast<unsigned int>(
+                    std::max(1ul, parseNumber(name, value)));
+            }
+            else if (name == "frame")
+            {
+                options.frame = parseNumber(name, value);
+            }
+            else if (name == "samples")
+            {
+                options.samples = static_cast<unsigned int>(
+                    parseNumber(name, value));
+            }
+            else if (name == "csv")
+            {
+                options.csvPath = value;
+            }
+            else
+            {
+                throw std::invalid_argument("ERROR::UNKNOWN OPTION " + argument);
+            }
+        }
+        if (options.tracePath.empty())
+        {
+            throw std::invalid_argument("ERROR::NO TRACE FILE GIVEN");
+        }
+        return options;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    ReplayOptions options;
+    try
+    {
+        options = parseReplayArguments(argc, argv);
+    }
+    catch (const std::invalid_argument& except)
+    {
+        std::cerr << except.what() << '\n';
+        std::cerr << "Usage: " << argv[0] << " <trace> [--paced] [--loops=N] "
+            "[--frame=K] [--csv=path] [--samples=N]\n";
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    std::vector<double> frameTimes;
+    try
+    {
+        Renderer::TracePlayer player(options.tracePath);
+        std::size_t firstFrame = 0;
+        std::size_t frameCount = player.getFrameCount();
+        if (options.frame)
+        {
+            if (*options.frame >= frameCount)
+            {
+                throw std::runtime_error("ERROR::TRACE::FRAME OUT OF RANGE");
+            }
+            firstFrame = *options.frame;
+            frameCount = 1;
+        }
+
+        // The window only provides the context, replay runs unthrottled
+        sf::ContextSettings settings = WindowAttributes::getSettings();
+        settings.antiAliasingLevel = options.samples;
+        Window window(settings);
+        window.setVerticalSyncEnabled(false);
+        Renderer::GlDevice device;
+        player.replaySetup(device);
+
+        frameTimes.reserve(frameCount * options.loops);
+        const Clock::time_point replayStart = Clock::now();
+        for (unsigned int loop = 0; loop < options.loops && window.isOpen();
+            ++loop)
+        {
+            const Clock::time_point loopStart = Clock::now();
+            for (std::size_t frame = firstFrame;
+                frame < firstFrame + frameCount && window.isOpen(); ++frame)
+            {
+                while (const std::optional event = window.pollEvent())
+                {
+                    if (event->is<sf::Event::Closed>())
+                    {
+                        window.close();
+                    }
+                }
+                if (options.paced)
+                {
+                    // Keep the recorded distance to the first replayed frame
+                    std::this_thread::sleep_until(loopStart +
+                        std::chrono::microseconds(
+                            player.getFrameTimestamp(frame) -
+                            player.getFrameTimestamp(firstFrame)));
+                }
+
+                const Clock::time_point start = Clock::now();
+                player.replayFrame(device, frame);
+                window.display();
+                frameTimes.push_back(std::chrono::duration<double,
+                    std::milli>(Clock::now() - start).count());
+            }
+        }
+        const double totalTime = std::chrono::duration<double>(
+            Clock::now() - replayStart).count();
+
+        if (!options.csvPath.empty())
+        {
+            std::ofstream csv(options.csvPath);
+            csv << "frame,ms\n";
+            for (std::size_t i = 0; i < frameTimes.size(); ++i)
+            {
+                csv << firstFrame + i % frameCount << ',' << frameTimes[i]
+                    << '\n';
+            }
+        }
+
+        if (frameTimes.empty())
+        {
+            std::cout << "No frames replayed\n";
+            return 0;
+        }
+        std::vector<double> sorted = frameTimes;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0.0;
+        for (const double frameTime : sorted)
+        {
+            sum += frameTime;
+        }
+        std::cout << "Replayed " << sorted.size() << " frames of "
+            << options.tracePath << " in " << totalTime << " s\n";
+        std::cout << "  frame time (ms): mean " << sum / sorted.size()
+            << ", median " << sorted[sorted.size() / 2]
+            << ", p99 " << sorted[sorted.size() * 99 / 100]
+            << ", max " << sorted.back() << '\n';
+    }
+    catch (const std::exception& except)
+    {
+        std::cerr << except.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
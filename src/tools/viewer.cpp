@@ -0,0 +1,500 @@
+/**
+ * @file viewer.cpp
+ * @brief Displays the frames streamed by `hello_3d --stream`, sends the key
+ *        presses back and reports the throughput and latency of the stream.
+ *
+ * Usage: hello_3d_viewer [--host=address] [--port=N] [--frames=N]
+ * @note `--host=address` connects to another machine than this one.
+ * @note `--port=N` connects to another port than the default 7420.
+ * @note `--frames=N` disconnects after N frames, for scripted runs.
+ *
+ * Frames are received and decoded on a background thread, the window shows
+ * the newest one and acknowledges it. Escape closes the viewer, every
+ * other key is sent to the renderer.
+ */
+
+#include <stream_protocol.hpp>
+#include <SFML/Graphics.hpp>
+#include <SFML/Network.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // The milliseconds the threads wait before checking whether to stop
+    constexpr std::int32_t POLL_INTERVAL_MS = 5;
+    // The bytes read from the socket at once
+    constexpr std::size_t RECEIVE_CHUNK = 1 << 16;
+
+    /**
+     * @struct ViewerOptions
+     * @brief The configuration of the viewer given on the command line.
+     */
+    struct ViewerOptions
+    {
+        std::string host = "127.0.0.1";
+        unsigned short port = Renderer::StreamConstants::DEFAULT_PORT;
+        // Runs until the window is closed when 0
+        unsigned long frames = 0;
+    };
+
+    // Parses a non-negative integer option value
+    unsigned long parseNumber(const std::string& name, const std::string& value)
+    {
+        try
+        {
+            std::size_t parsed = 0;
+            const unsigned long number = std::stoul(value, &parsed);
+            if (parsed == value.size())
+            {
+                return number;
+            }
+        }
+        catch (const std::exception&)
+        {
+            // Reported below together with other malformed values
+        }
+        throw std::invalid_argument("ERROR::INVALID VALUE FOR " + name + ": " +
+            value);
+    }
+
+    ViewerOptions parseViewerArguments(int argc, char* argv[])
+    {
+        ViewerOptions options;
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string argument(argv[i]);
+            if (argument.rfind("--", 0) != 0)
+            {
+                throw std::invalid_argument("ERROR::UNEXPECTED ARGUMENT " +
+                    argument);
+            }
+
+            const std::size_t separator = argument.find('=');
+            const std::string name = argument.substr(2, separator - 2);
+            const std::string value = separator == std::string::npos ?
+                std::string() : argument.substr(separator + 1);
+
+            if (name == "host" && !value.empty())
+            {
+                options.host = value;
+            }
+            else if (name == "port")
+            {
+                const unsigned long port = parseNumber(name, value);
+                if (port == 0 || port > 65535)
+                {
+                    throw std::invalid_argument("ERROR::INVALID VALUE FOR " +
+                        name + ": " + value);
+                }
+                options.port = static_cast<unsigned short>(port);
+            }
+            else if (name == "frames")
+            {
+                options.frames = parseNumber(name, value);
+            }
+            else
+            {
+                throw std::invalid_argument("ERROR::UNKNOWN OPTION " + argument);
+            }
+        }
+        return options;
+    }
+
+    /**
+     * @class StreamReceiver
+     * @brief Receives the messages of the server on a background thread and
+     *        applies the tiles of every frame to a copy of the frame.
+     */
+    class StreamReceiver
+    {
+    public:
+        explicit StreamReceiver(sf::TcpSocket& socket) : socket_{ socket },
+            mutex_(), frameReady_(), frame_(), grid_(0, 0), header_(),
+            newFrame_{ false }, framesReceived_{ 0 }, bytesReceived_{ 0 },
+            error_(), stopping_{ false }, closed_{ false }, thread_()
+        {
+            thread_ = std::thread(&StreamReceiver::receiveLoop, this);
+        }
+
+        ~StreamReceiver()
+        {
+            stopping_ = true;
+            thread_.join();
+        }
+
+        // Delete copy constructor and copy assignment operator
+        StreamReceiver(const StreamReceiver&) = delete;
+        StreamReceiver& operator=(const StreamReceiver&) = delete;
+
+        /**
+         * @brief Waits a little for a frame newer than the last one taken.
+         * @param take Called with the header and pixels of the frame while
+         *        the receiver cannot change them.
+         * @return False if no new frame arrived.
+         */
+        template <typename Take>
+        bool takeFrame(Take&& take)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            frameReady_.wait_for(lock,
+                std::chrono::milliseconds(POLL_INTERVAL_MS),
+                [this] { return newFrame_ || closed_; });
+            if (!newFrame_)
+            {
+                return false;
+            }
+            newFrame_ = false;
+            take(header_, frame_);
+            return true;
+        }
+
+        /*** @brief Gets whether the connection ended. */
+        bool isClosed() const { return closed_; }
+
+        /*** @brief Gets why the connection ended, empty if the server left. */
+        std::string getError() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return error_;
+        }
+
+        /*** @brief Gets the number of frames received. */
+        std::uint64_t getFramesReceived() const { return framesReceived_; }
+
+        /*** @brief Gets the number of bytes received. */
+        std::uint64_t getBytesReceived() const { return bytesReceived_; }
+
+    private:
+        void receiveLoop()
+        {
+            sf::SocketSelector selector;
+            selector.add(socket_);
+            Renderer::MessageAssembler assembler;
+            std::vector<std::uint8_t> chunk(RECEIVE_CHUNK);
+            std::vector<std::uint8_t> scratch;
+            while (!stopping_)
+            {
+                if (!selector.wait(sf::milliseconds(POLL_INTERVAL_MS)))
+                {
+                    continue;
+                }
+                std::size_t received = 0;
+                if (socket_.receive(chunk.data(), chunk.size(), received) !=
+                    sf::Socket::Status::Done)
+                {
+                    close(std::string());
+                    return;
+                }
+                bytesReceived_ += received;
+                try
+                {
+                    assembler.append(chunk.data(), received);
+                    Renderer::StreamMessage type;
+                    const std::uint8_t* payload = nullptr;
+                    std::size_t size = 0;
+                    while (assembler.next(type, payload, size))
+                    {
+                        handleMessage(type, payload, size, scratch);
+                    }
+                }
+                catch (const std::exception& except)
+                {
+                    // Protocol errors, and frames too large to allocate,
+                    // end the connection rather than the thread
+                    close(except.what());
+                    return;
+                }
+            }
+        }
+
+        void handleMessage(Renderer::StreamMessage type,
+            const std::uint8_t* payload, std::size_t size,
+            std::vector<std::uint8_t>& scratch)
+        {
+            Renderer::MessageReader reader(payload, size);
+            if (type == Renderer::StreamMessage::HELLO)
+            {
+                const std::uint32_t version = reader.readU32();
+                const std::uint32_t tileSize = reader.readU32();
+                if (version != Renderer::StreamConstants::PROTOCOL_VERSION ||
+                    tileSize != Renderer::StreamConstants::TILE_SIZE)
+                {
+                    throw std::runtime_error(
+                        "ERROR::STREAM::UNSUPPORTED PROTOCOL VERSION " +
+                        std::to_string(version));
+                }
+                // The server sends the first frame against a blank one
+                std::lock_guard<std::mutex> lock(mutex_);
+                std::fill(frame_.begin(), frame_.end(), std::uint8_t{ 0 });
+                return;
+            }
+            if (type != Renderer::StreamMessage::FRAME)
+            {
+                return;
+            }
+
+            const Renderer::FrameHeader header =
+                Renderer::readFrameHeader(reader);
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (header.width != grid_.width || header.height != grid_.height)
+            {
+                // The server restarts from a blank frame of the new size
+                grid_ = Renderer::TileGrid(header.width, header.height);
+                frame_.assign(static_cast<std::size_t>(header.width) *
+                    header.height * Renderer::StreamConstants::BYTES_PER_PIXEL,
+                    0);
+            }
+            for (std::uint32_t i = 0; i < header.tileCount; ++i)
+            {
+                const std::uint32_t tile = reader.readU32();
+                const std::uint32_t tileSize = reader.readU32();
+                const std::uint8_t* data = reader.readBytes(tileSize);
+                if (data == nullptr || !Renderer::decodeTile(grid_, tile, data,
+                    tileSize, frame_.data(), scratch))
+                {
+                    throw std::runtime_error("ERROR::STREAM::CORRUPT FRAME " +
+                        std::to_string(header.frame));
+                }
+            }
+            header_ = header;
+            newFrame_ = true;
+            ++framesReceived_;
+            frameReady_.notify_one();
+        }
+
+        void close(const std::string& error)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            error_ = error;
+            closed_ = true;
+            frameReady_.notify_one();
+        }
+
+        sf::TcpSocket& socket_;
+        mutable std::mutex mutex_;
+        std::condition_variable frameReady_;
+        // The newest frame, rows bottom to top as read back by OpenGL
+        std::vector<std::uint8_t> frame_;
+        Renderer::TileGrid grid_;
+        Renderer::FrameHeader header_;
+        bool newFrame_;
+        std::atomic<std::uint64_t> framesReceived_;
+        std::atomic<std::uint64_t> bytesReceived_;
+        std::string error_;
+        std::atomic<bool> stopping_;
+        std::atomic<bool> closed_;
+        std::thread thread_;
+    };
+
+    // Prints the median, p99 and maximum of a set of samples
+    void printPercentiles(std::vector<double> samples)
+    {
+        std::sort(samples.begin(), samples.end());
+        std::cout << "median " << samples[samples.size() / 2]
+            << ", p99 " << samples[samples.size() * 99 / 100]
+            << ", max " << samples.back() << '\n';
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    ViewerOptions options;
+    try
+    {
+        options = parseViewerArguments(argc, argv);
+    }
+    catch (const std::invalid_argument& except)
+    {
+        std::cerr << except.what() << '\n';
+        std::cerr << "Usage: " << argv[0] << " [--host=address] [--port=N] "
+            "[--frames=N]\n";
+        return 1;
+    }
+
+    const std::optional<sf::IpAddress> address =
+        sf::IpAddress::resolve(options.host);
+    sf::TcpSocket socket;
+    if (!address || socket.connect(*address, options.port, sf::seconds(5.0f))
+        != sf::Socket::Status::Done)
+    {
+        std::cerr << "ERROR::VIEWER::CANNOT CONNECT TO " << options.host << ':'
+            << options.port << '\n';
+        return 1;
+    }
+
+    // Times of the frames shown and of the inputs not yet seen in a frame
+    std::vector<double> frameIntervalsMs;
+    std::vector<double> inputLatenciesMs;
+    std::map<std::uint32_t, Clock::time_point> pendingInputs;
+    std::uint32_t inputSequence = 0;
+    std::uint64_t framesShown = 0;
+    Clock::time_point firstFrame;
+    Clock::time_point lastFrame;
+    std::string error;
+    try
+    {
+        StreamReceiver receiver(socket);
+        Renderer::MessageWriter writer;
+        sf::Texture texture;
+        std::optional<sf::Sprite> sprite;
+        // The window is created with the size of the first frame
+        std::optional<sf::RenderWindow> window;
+
+        while (!receiver.isClosed() && (!window || window->isOpen()) &&
+            (options.frames == 0 || framesShown < options.frames))
+        {
+            while (window)
+            {
+                const std::optional event = window->pollEvent();
+                if (!event)
+                {
+                    break;
+                }
+                if (event->is<sf::Event::Closed>())
+                {
+                    window->close();
+                    break;
+                }
+                const auto* pressed = event->getIf<sf::Event::KeyPressed>();
+                const auto* released = event->getIf<sf::Event::KeyReleased>();
+                if (pressed != nullptr &&
+                    pressed->scancode == sf::Keyboard::Scancode::Escape)
+                {
+                    window->close();
+                    break;
+                }
+                if (pressed == nullptr && released == nullptr)
+                {
+                    continue;
+                }
+                Renderer::StreamInput input;
+                input.sequence = ++inputSequence;
+                input.type = pressed != nullptr ?
+                    Renderer::StreamInputType::KEY_PRESSED :
+                    Renderer::StreamInputType::KEY_RELEASED;
+                input.code = static_cast<std::int32_t>(pressed != nullptr ?
+                    pressed->scancode : released->scancode);
+                Renderer::writeInput(writer, input);
+                const std::vector<std::uint8_t>& message = writer.finish();
+                socket.send(message.data(), message.size());
+                pendingInputs.emplace(input.sequence, Clock::now());
+            }
+            if (window && !window->isOpen())
+            {
+                break;
+            }
+
+            Renderer::FrameHeader header;
+            const bool received = receiver.takeFrame(
+                [&](const Renderer::FrameHeader& frameHeader,
+                    const std::vector<std::uint8_t>& pixels)
+                {
+                    header = frameHeader;
+                    const sf::Vector2u size(header.width, header.height);
+                    if (texture.getSize() != size)
+                    {
+                        if (!texture.resize(size))
+                        {
+                            throw std::runtime_error(
+                                "ERROR::VIEWER::CANNOT CREATE TEXTURE");
+                        }
+                        sprite.emplace(texture);
+                        // OpenGL reads the rows bottom to top
+                        sprite->setScale({ 1.0f, -1.0f });
+                        sprite->setPosition(
+                            { 0.0f, static_cast<float>(header.height) });
+                    }
+                    texture.update(pixels.data());
+                });
+            if (!received)
+            {
+                continue;
+            }
+
+            const sf::Vector2f size(static_cast<float>(header.width),
+                static_cast<float>(header.height));
+            if (!window)
+            {
+                window.emplace(sf::VideoMode(texture.getSize()),
+                    "Cube viewer", sf::State::Windowed, sf::ContextSettings());
+                window->setVerticalSyncEnabled(false);
+            }
+            // Fit the frame to the window, also after the server resized
+            window->setView(sf::View(sf::FloatRect({ 0.0f, 0.0f }, size)));
+            window->clear();
+            // The alpha of the frame is whatever the server's framebuffer had
+            window->draw(*sprite, sf::RenderStates(sf::BlendNone));
+            window->display();
+
+            const Clock::time_point now = Clock::now();
+            writer.begin(Renderer::StreamMessage::ACK);
+            writer.writeU64(header.frame);
+            writer.writeU64(header.timestamp);
+            const std::vector<std::uint8_t>& ack = writer.finish();
+            socket.send(ack.data(), ack.size());
+
+            // Inputs the frame was drawn after are now visible
+            while (!pendingInputs.empty() &&
+                pendingInputs.begin()->first <= header.inputSequence)
+            {
+                inputLatenciesMs.push_back(std::chrono::duration<double,
+                    std::milli>(now - pendingInputs.begin()->second).count());
+                pendingInputs.erase(pendingInputs.begin());
+            }
+            if (framesShown == 0)
+            {
+                firstFrame = now;
+            }
+            else
+            {
+                frameIntervalsMs.push_back(std::chrono::duration<double,
+                    std::milli>(now - lastFrame).count());
+            }
+            lastFrame = now;
+            ++framesShown;
+        }
+        socket.disconnect();
+        error = receiver.getError();
+
+        const double seconds = std::max(std::chrono::duration<double>(
+            lastFrame - firstFrame).count(), 1e-3);
+        std::cout << "Showed " << framesShown << " of "
+            << receiver.getFramesReceived() << " frames received from "
+            << options.host << ':' << options.port << ", "
+            << receiver.getBytesReceived() / 1e6 << " MB at "
+            << receiver.getBytesReceived() * 8.0 / 1e6 / seconds
+            << " Mbit/s\n";
+    }
+    catch (const std::exception& except)
+    {
+        std::cerr << except.what() << '\n';
+        return 1;
+    }
+
+    if (!frameIntervalsMs.empty())
+    {
+        std::cout << "  frame interval (ms): ";
+        printPercentiles(frameIntervalsMs);
+    }
+    if (!inputLatenciesMs.empty())
+    {
+        std::cout << "  input to display over " << inputLatenciesMs.size()
+            << " key events (ms): ";
+        printPercentiles(inputLatenciesMs);
+    }
+    if (!error.empty())
+    {
+        std::cerr << error << '\n';
+        return 1;
+    }
+    return 0;
+}